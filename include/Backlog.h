@@ -0,0 +1,119 @@
+/**
+ * Backlog.h - Store-and-forward telemetry backlog interface
+ * 
+ * Copyright (C) 2025 Michael Garcia, M&E Design
+ * Based on original .ino by Geoff Mcintyre of Mr.Industries (https://mr.industries/)
+ * 
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ * 
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU General Public License for more details.
+ * 
+ * You should have received a copy of the GNU General Public License
+ * along with this program. If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#pragma once
+#include <Arduino.h>
+#include "FlashRing.h"
+#include "ReportFilter.h"
+
+/**
+ * Store-and-forward telemetry backlog
+ *
+ * Every sample taken by SensorTask that passes the report-by-exception
+ * filter (ReportFilter.h) is appended here, and CommsTask sends
+ * from here (drainBacklog() in LoRaLink), so a sample is only discarded
+ * once the radio has reported it sent. While LoRa is down the samples
+ * pile up: the newest BACKLOG_RAM_CAPACITY stay in RAM and older ones
+ * spill to the "backlog" flash partition one full page at a time. When
+ * the link returns the backlog is drained, oldest or newest first, in
+ * multi-sample frames.
+ *
+ * Flash pages are a FlashRing (see FlashRing.h) holding up to
+ * BACKLOG_SAMPLES_PER_PAGE samples. A bitmap after the samples, outside
+ * the page CRC, has one bit per sample that is cleared in place once the
+ * sample is sent, so partially drained pages need no rewrite and the
+ * backlog survives a reboot. When the flash ring is full the oldest
+ * sector is reclaimed and its unsent samples are counted as lost.
+ *
+ * Only one batch is out at a time: backlogPeek() takes it, then
+ * backlogCommit() or backlogAbort() settles it when the radio reports
+ * the frame sent or failed.
+ *
+ * All functions are thread-safe.
+ */
+
+#define BACKLOG_PARTITION_LABEL "backlog"
+#define BACKLOG_PARTITION_SUBTYPE 0x41
+#define BACKLOG_PAGE_MAGIC 0x4C42        // "BL"
+#define BACKLOG_RAM_CAPACITY 64          // Samples, about a minute at 1 Hz
+#define BACKLOG_SAMPLE_SIZE 16           // Bytes per sample in flash
+#define BACKLOG_SAMPLES_PER_PAGE 14
+#define BACKLOG_BATCH_MAX 12             // Samples per drained frame (TELEMETRY_MAX_BATCH_SAMPLES)
+
+typedef enum {
+  BACKLOG_OLDEST_FIRST = 0,   // Complete history in order
+  BACKLOG_NEWEST_FIRST = 1    // Freshest data first after an outage
+} BacklogOrder;
+
+#define BACKLOG_DEFAULT_ORDER BACKLOG_OLDEST_FIRST
+
+struct BacklogSample {
+  SensorSample sample;
+  uint16_t sequence;
+  bool earlierBoot;           // Sampled before the last reboot; timestamp is void
+};
+
+struct BacklogStats {
+  bool flashReady;
+  uint32_t ramDepth;
+  uint32_t flashDepth;
+  uint32_t maxDepth;
+  uint32_t flashCapacity;     // Samples
+  uint32_t captured;
+  uint32_t sent;
+  uint32_t spilled;           // Samples moved from RAM to flash
+  uint32_t lost;              // Overwritten in flash or dropped without flash
+  uint32_t aborted;           // Batches returned after a failed transmission
+  uint32_t lastDrainSamples;  // Most recent catch-up after an outage
+  uint32_t lastDrainMs;
+};
+
+bool initBacklog();
+
+// Queue the published SensorData snapshot (SensorTask, after each pass);
+// samples inside the deadbands of the last reported one are dropped here
+bool captureBacklogSample();
+// Queue a sample taken before this boot (DutyCycle.h); it bypasses the
+// report filter and goes out with an unknown age
+bool adoptBacklogSample(const SensorSample* sample);
+// Sequence number for the next frame; shared with manual sends
+uint16_t nextTelemetrySequence();
+
+size_t backlogDepth();
+// Age of the oldest unsent sample; UINT32_MAX while anything is in flash
+uint32_t backlogOldestAgeMs();
+size_t backlogPeek(BacklogSample* out, size_t maxSamples);
+void backlogCommit();
+void backlogAbort();
+
+// Move everything in RAM to flash (before a restart)
+bool flushBacklog();
+
+void setBacklogOrder(BacklogOrder order);
+BacklogOrder getBacklogOrder();
+const char* backlogOrderName(BacklogOrder order);
+
+void getBacklogStats(BacklogStats* stats);
+void printBacklogStats();
+
+// Report-by-exception settings and counters
+void setReportDeadbands(const ReportDeadbands* deadbands);
+void getReportFilter(ReportFilter* filter);
+void printReportFilter();
@@ -0,0 +1,39 @@
+/**
+ * Bench.h - On-target micro-benchmarks
+ * 
+ * Copyright (C) 2025 Michael Garcia, M&E Design
+ * Based on original .ino by Geoff Mcintyre of Mr.Industries (https://mr.industries/)
+ * 
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ * 
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU General Public License for more details.
+ * 
+ * You should have received a copy of the GNU General Public License
+ * along with this program. If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#pragma once
+#include <Arduino.h>
+
+/**
+ * On-target micro-benchmarks
+ *
+ * Benchmarks are registered in a table in Bench.cpp and run from the
+ * serial console with "bench [name]". Timing uses the CPU cycle counter,
+ * so results are comparable between the ESP32 and the host build.
+ */
+
+#define BENCH_DEFAULT_ITERATIONS 1000
+
+void runBenchmark(const char* name);
+void listBenchmarks();
+
+// Timing helpers shared by benchmark implementations
+uint32_t benchCycles();
+void benchReport(const char* label, uint32_t elapsedCycles, uint32_t iterations);
@@ -36,4 +36,18 @@ void cmdSend(const char *args);
 void cmdStatus(const char *args);
 void cmdLora(const char *args);
 void cmdReset(const char *args);
+void cmdFrame(const char *args);
+void cmdBench(const char *args);
+void cmdPeers(const char *args);
+void cmdLog(const char *args);
+void cmdStorage(const char *args);
+void cmdBacklog(const char *args);
+void cmdBatch(const char *args);
+void cmdDeadband(const char *args);
+void cmdHistory(const char *args);
+void cmdSampling(const char *args);
+void cmdLight(const char *args);
+void cmdI2c(const char *args);
+void cmdPower(const char *args);
+void cmdDuty(const char *args);
 void cmdHelp(const char *args);
\ No newline at end of file
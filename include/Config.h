@@ -22,15 +22,16 @@
 #include <Arduino.h>
 #include <EEPROM.h>
 
-#define EEPROM_SIZE 64
+#define EEPROM_SIZE 256
 #define MAC_ADDRESS_SIZE 6
 #define EEPROM_MAC_ADDR 0
 #define EEPROM_INIT_FLAG 48
+#define EEPROM_PEER_TABLE_ADDR 64  // See PeerTable.cpp for the layout
+#define EEPROM_DUTY_CONFIG_ADDR 224  // See DutyCycle.cpp for the layout
 
 void initializeConfig();
 void printMacAddress(uint8_t* mac);
-void saveMacToEEPROM(uint8_t* mac);
 bool loadMacFromEEPROM(uint8_t* mac);
+void clearLegacyMacInEEPROM();
 bool parseMacAddress(const char* macStr, uint8_t* mac);
 void configureMacAddress();
-void setMacAddress(uint8_t* mac);
\ No newline at end of file
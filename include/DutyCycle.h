@@ -0,0 +1,98 @@
+/**
+ * DutyCycle.h - Duty-cycled deep sleep mode
+ * 
+ * Copyright (C) 2025 Michael Garcia, M&E Design
+ * Based on original .ino by Geoff Mcintyre of Mr.Industries (https://mr.industries/)
+ * 
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ * 
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU General Public License for more details.
+ * 
+ * You should have received a copy of the GNU General Public License
+ * along with this program. If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#pragma once
+#include <Arduino.h>
+
+/**
+ * Duty-cycled deep sleep mode
+ *
+ * For battery nodes that only need a reading every minute or so: instead
+ * of running the FreeRTOS tasks between samples, the node spends that
+ * time in deep sleep and the timer wakes it for each sample. setup() hands
+ * such a wake to runDutyCycle() before any other initialization (no
+ * banner, no start-up delay, no WiFi): it brings up the I2C sensors
+ * without the bus scan, takes one sample, appends it to a backlog in RTC
+ * memory and sleeps again.
+ *
+ * The radio is only started when the backlog holds the configured batch
+ * or when a sample moves past the report-by-exception deadbands
+ * (ReportFilter.h, whose reference sample also lives in RTC memory). The
+ * whole backlog then goes out in batch frames, waiting for each to finish,
+ * and the radio sleeps along with the chip. A frame that fails stays in
+ * the backlog for the next wake; when the backlog is full the oldest
+ * sample is dropped.
+ *
+ * Samples are unfiltered, since the signal filters' state does not
+ * survive deep sleep, and carry no ESP-NOW readings. Their timestamps
+ * come from a duty clock kept in RTC memory that advances by each wake's
+ * awake time and sleep; it misses the bootloader's few tens of ms per
+ * wake, so reported ages run short by that much per period.
+ *
+ * Pressing BOOT (DUTY_WAKE_PIN) while the node sleeps wakes it into the
+ * normal firmware, which hands the samples left in RTC memory to the
+ * store-and-forward backlog (Backlog.h). The mode is kept in EEPROM, so
+ * any other reset returns to duty cycling until "duty off".
+ */
+
+#define DUTY_DEFAULT_PERIOD_S 60
+#define DUTY_MIN_PERIOD_S 5
+#define DUTY_MAX_PERIOD_S 3600
+#define DUTY_DEFAULT_BATCH 8            // Samples per transmission, up to BACKLOG_BATCH_MAX
+#define DUTY_BACKLOG_CAPACITY 32        // Samples kept in RTC memory
+#define DUTY_MIN_SLEEP_MS 1000          // When a wake overruns the period
+#define DUTY_WAKE_PIN 0                 // BOOT button, low while pressed
+#define DUTY_TX_DRAIN_TIMEOUT_MS 2000   // Queued LoRa frames before "duty on" sleeps
+
+struct DutyCycleConfig {
+  bool enabled;
+  uint16_t periodSeconds;
+  uint8_t batchSamples;
+};
+
+// Kept in RTC memory; reset when duty cycling is turned on
+struct DutyCycleStats {
+  uint32_t cycles;            // Timer wakes
+  uint32_t frames;            // Batch frames sent
+  uint32_t sendFailures;      // Wakes whose transmission failed
+  uint32_t dropped;           // Samples lost to a full RTC backlog
+  uint32_t lastAwakeMs;       // App start to deep sleep
+  uint32_t maxAwakeMs;
+  uint64_t totalAwakeMs;
+  uint8_t pending;            // Samples in RTC memory
+};
+
+// setup(), after initializeConfig(): true if this boot is a duty cycle,
+// i.e. the mode is on and the node was not woken by the BOOT button
+bool dutyCycleBoot();
+// Sample, transmit if due and go back to deep sleep
+[[noreturn]] void runDutyCycle();
+// Normal boot, after initBacklog(): queue the samples left in RTC memory
+size_t adoptDutyCycleSamples();
+
+void getDutyCycleConfig(DutyCycleConfig* config);
+// Validates and saves the settings; does not start or stop anything
+bool setDutyCycleConfig(const DutyCycleConfig* config);
+// From the normal firmware: settle the radio and the logs, then deep sleep
+// until the first timer wake
+[[noreturn]] void startDutyCycle();
+
+void getDutyCycleStats(DutyCycleStats* stats);
+void printDutyCycleStats();
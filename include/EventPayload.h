@@ -0,0 +1,79 @@
+/**
+ * EventPayload.h - Reference-counted fixed-block payloads for events
+ * 
+ * Copyright (C) 2025 Michael Garcia, M&E Design
+ * Based on original .ino by Geoff Mcintyre of Mr.Industries (https://mr.industries/)
+ * 
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ * 
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU General Public License for more details.
+ * 
+ * You should have received a copy of the GNU General Public License
+ * along with this program. If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#pragma once
+#include <Arduino.h>
+#include <type_traits>
+
+/**
+ * Event payload pool
+ *
+ * Fixed-size blocks that events carry by handle, so a sample, a peer
+ * reading or a command argument travels through the event bus without
+ * heap allocation and without being copied into every subscriber's queue.
+ *
+ * A handle is a block number (EVENT_PAYLOAD_NONE for no payload) with a
+ * reference count. allocPayload() returns a block holding one reference
+ * for the caller; publishEvent() takes one more for every subscriber it
+ * queues the event for; whoever holds a reference gives it back with
+ * releasePayload(), and the block returns to the pool with the last one.
+ * So a publisher fills a block, publishes it and releases it, and a
+ * subscriber releases each payload it receives once it is done with it.
+ * Payload contents are written only before the first publish.
+ *
+ * The free list is a tagged lock-free stack and the counts are atomics,
+ * so every function may be called from any task or from an interrupt.
+ */
+
+#define EVENT_PAYLOAD_BLOCKS 16
+#define EVENT_PAYLOAD_SIZE 48          // Bytes per block
+#define EVENT_PAYLOAD_ALIGN 8
+
+typedef uint8_t EventPayload;
+#define EVENT_PAYLOAD_NONE 0
+
+struct PayloadPoolStats {
+  uint32_t allocs;
+  uint32_t exhausted;            // Allocations refused because every block was in use
+  uint32_t inUse;
+  uint32_t highWater;
+  uint32_t contention;           // Free-list updates retried after racing another core or an interrupt
+  uint32_t badReleases;          // Releases of a block that was already free
+};
+
+void initPayloadPool();
+// EVENT_PAYLOAD_NONE when the pool is exhausted
+EventPayload allocPayload();
+void retainPayload(EventPayload payload);
+void releasePayload(EventPayload payload);
+// NULL for EVENT_PAYLOAD_NONE
+void* payloadData(EventPayload payload);
+
+// Typed view of a payload block
+template <typename T>
+T* payloadAs(EventPayload payload) {
+  static_assert(sizeof(T) <= EVENT_PAYLOAD_SIZE, "payload type does not fit a pool block");
+  static_assert(alignof(T) <= EVENT_PAYLOAD_ALIGN, "payload type needs a stricter alignment");
+  static_assert(std::is_trivially_copyable<T>::value, "payloads must be plain data");
+  return static_cast<T*>(payloadData(payload));
+}
+
+void getPayloadPoolStats(PayloadPoolStats* stats);
+void printPayloadPoolStats();
@@ -1,5 +1,5 @@
 /**
- * EventQueue.h - Minimal event queue system for inter-task communication
+ * EventQueue.h - Publish/subscribe event bus for inter-task communication
  * 
  * Copyright (C) 2025 Michael Garcia, M&E Design
  * Based on original .ino by Geoff Mcintyre of Mr.Industries (https://mr.industries/)
@@ -22,6 +22,7 @@
 #include <Arduino.h>
 #include "freertos/FreeRTOS.h"
 #include "freertos/queue.h"
+#include "EventPayload.h"
 
 /**
  * Event types for inter-task communication
@@ -35,30 +36,96 @@ typedef enum {
     EVENT_LORA_SEND_REQUEST,    // Manual LoRa transmission requested
     EVENT_LORA_SEND_COMPLETE,   // LoRa transmission completed
     EVENT_CONFIG_CHANGED,       // System configuration modified
-    EVENT_SYSTEM_ERROR          // System error occurred
+    EVENT_SYSTEM_ERROR,         // System error occurred
+    EVENT_NOW_RX_READY,         // ESP-NOW frames waiting in the receive ring
+    EVENT_HISTORY_REQUEST,      // History upload requested
+    EVENT_TYPE_COUNT
 } EventType;
 
 /**
  * Event message structure for inter-task communication
  * 
  * Contains event type and optional data payloads for passing information
- * between FreeRTOS tasks through the global event queue.
+ * between FreeRTOS tasks through a subscriber's queue. Anything larger than
+ * 32 bits travels in a pool block (EventPayload.h); a received payload
+ * belongs to the receiver, which must release it.
  */
 typedef struct {
-    EventType type;    // Event identifier from EventType enum
-    uint32_t data;     // Optional 32-bit numeric data
-    void* ptr;         // Optional pointer to additional data
+    EventType type;        // Event identifier from EventType enum
+    uint32_t data;         // Optional 32-bit numeric data
+    EventPayload payload;  // Optional pool block, EVENT_PAYLOAD_NONE if none
 } EventMessage;
 
-// Event queue configuration constants
-#define EVENT_QUEUE_SIZE 10      // Maximum events in queue
-#define EVENT_TIMEOUT_MS 100     // Default timeout for queue operations
+/**
+ * Publish/subscribe event bus
+ * 
+ * Each task that consumes events subscribes to the topics (event types) it
+ * handles and gets its own queue. A publish looks up the subscribers of its
+ * topic and copies the event into each of their queues, so events nobody
+ * handles cost a table lookup and never occupy a queue. Publishing never
+ * blocks: an event that does not fit in a subscriber's queue is dropped and
+ * counted against that subscriber.
+ * 
+ * Topics in EVENT_COALESCED are state notifications ("new data is ready")
+ * rather than requests. A subscriber holds at most one undelivered copy of
+ * each; publishing again only updates the data and payload the queued copy
+ * will carry, releasing the payload it replaces, so a slow subscriber sees
+ * the latest value once instead of a backlog. If a notification is
+ * published while the subscriber is receiving the previous one, the
+ * receive can already pick up the newer payload and the next copy then
+ * arrives without one.
+ * 
+ * The publisher keeps its own reference to a payload; the bus takes one
+ * for each subscriber it queues the event for.
+ * 
+ * Subscribe from task context, typically at the start of the task; the
+ * subscriber table is fixed and never shrinks. Publish from tasks, or
+ * from interrupts with publishEventFromISR().
+ */
+
+#define EVENT_MAX_SUBSCRIBERS 4
+#define EVENT_SUBSCRIBER_DEPTH 8  // Default per-subscriber queue length
+
+typedef uint32_t EventMask;
+#define EVENT_BIT(type) ((EventMask)1 << (type))
+
+// Topics delivered at most once per subscriber until received
+#define EVENT_COALESCED (EVENT_BIT(EVENT_SENSOR_DATA_READY) | EVENT_BIT(EVENT_DISTANCE_UPDATED) | \
+                         EVENT_BIT(EVENT_LORA_SEND_COMPLETE) | EVENT_BIT(EVENT_NOW_RX_READY))
+
+struct EventSubscriber;
+
+typedef struct {
+    const char* name;
+    EventMask topics;
+    uint8_t depth;             // Queue length
+    uint32_t queued;           // Events placed in the queue
+    uint32_t coalesced;        // Publishes folded into a queued copy
+    uint32_t dropped;          // Publishes lost to a full queue
+    uint32_t highWater;        // Deepest the queue has been
+} EventSubscriberStats;
+
+typedef struct {
+    uint32_t published[EVENT_TYPE_COUNT];
+    uint32_t unheard;          // Publishes with no subscriber
+    uint32_t maxPublishUs;     // Slowest publishEvent() call
+    uint8_t subscribers;
+} EventBusStats;
 
-// Global event queue handle
-extern QueueHandle_t eventQueue;
+// Event bus management functions
+bool initEventBus();
+// NULL if the table is full or the queue cannot be created
+EventSubscriber* subscribeEvents(const char* name, EventMask topics, uint8_t depth = EVENT_SUBSCRIBER_DEPTH);
+// Change a subscriber's topics; 0 pauses it, queued events stay queued
+void setEventTopics(EventSubscriber* subscriber, EventMask topics);
+// Whether publishing type would reach anyone, to skip filling a payload
+bool eventHasSubscribers(EventType type);
+// false if any subscriber's queue was full
+bool publishEvent(EventType type, uint32_t data = 0, EventPayload payload = EVENT_PAYLOAD_NONE);
+bool publishEventFromISR(EventType type, uint32_t data = 0, EventPayload payload = EVENT_PAYLOAD_NONE);
+bool receiveEvent(EventSubscriber* subscriber, EventMessage* event, TickType_t timeout);
 
-// Event queue management functions
-bool initEventQueue();
-bool sendEvent(EventType type, uint32_t data = 0, void* ptr = nullptr);
-bool receiveEvent(EventMessage* event, TickType_t timeout = pdMS_TO_TICKS(EVENT_TIMEOUT_MS));
-bool sendEventFromISR(EventType type, uint32_t data = 0, void* ptr = nullptr);
\ No newline at end of file
+void getEventBusStats(EventBusStats* stats);
+bool getEventSubscriberStats(uint8_t index, EventSubscriberStats* stats);
+void printEventBusStats();
+const char* eventTypeName(EventType type);
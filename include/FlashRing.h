@@ -0,0 +1,121 @@
+/**
+ * FlashRing.h - Append-only page ring on a raw flash partition
+ * 
+ * Copyright (C) 2025 Michael Garcia, M&E Design
+ * Based on original .ino by Geoff Mcintyre of Mr.Industries (https://mr.industries/)
+ * 
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ * 
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU General Public License for more details.
+ * 
+ * You should have received a copy of the GNU General Public License
+ * along with this program. If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#pragma once
+#include <Arduino.h>
+#include <esp_partition.h>
+
+/**
+ * Append-only page ring on a raw flash partition
+ *
+ * Shared by the log storage sink and the telemetry backlog spill. The
+ * partition is written as a ring of 256-byte pages, one program operation
+ * per page:
+ *
+ *   offset size field
+ *   0      2    magic        chosen by the owner of the ring
+ *   2      1    version      FLASH_PAGE_VERSION
+ *   3      1    flags        owner-defined
+ *   4      4    sequence     uint32, increments with every page written
+ *   8      4    eraseCount   erases of the page's sector so far
+ *   12     2    used         payload bytes covered by the crc
+ *   14     2    crc          CRC-16/CCITT-FALSE over header and payload,
+ *                            with this field as zero
+ *   16     240  payload      owner data; bytes past "used" stay erased and
+ *                            may be programmed later (flashRingProgram)
+ *
+ * The write position only moves forward, wrapping at the end of the
+ * partition, and the 4 KB sector ahead of it is erased just before its
+ * first page is written. Every sector is therefore erased once per pass,
+ * which levels wear across the partition, and the oldest sector is the
+ * one reclaimed. Mounting scans every page and resumes after the highest
+ * valid sequence number; a page torn by a power cut fails its CRC and is
+ * stepped over.
+ *
+ * A FlashRing is not thread-safe; its owner serializes access.
+ */
+
+#define FLASH_RING_SECTOR_SIZE 4096
+#define FLASH_RING_PAGE_SIZE 256
+#define FLASH_RING_HEADER_SIZE 16
+#define FLASH_RING_PAYLOAD_SIZE (FLASH_RING_PAGE_SIZE - FLASH_RING_HEADER_SIZE)
+#define FLASH_RING_PAGES_PER_SECTOR (FLASH_RING_SECTOR_SIZE / FLASH_RING_PAGE_SIZE)
+#define FLASH_RING_MAX_SECTORS 64        // Larger partitions use the first 256 KB
+#define FLASH_RING_ENDURANCE 100000      // Rated erase cycles per sector
+#define FLASH_PAGE_VERSION 1
+
+typedef enum {
+  FLASH_PAGE_BLANK,
+  FLASH_PAGE_VALID,
+  FLASH_PAGE_CORRUPT
+} FlashPageState;
+
+struct FlashPageHeader {
+  uint8_t flags;
+  uint32_t sequence;
+  uint32_t eraseCount;
+  uint16_t used;
+};
+
+struct FlashRingStats {
+  uint32_t recoveredPages;    // Valid pages found by the mount scan
+  uint32_t corruptPages;      // Torn or damaged pages found by the mount scan
+  uint32_t recoveryMs;
+  uint32_t pagesWritten;
+  uint32_t sectorErases;
+  uint32_t skippedPages;      // Non-blank pages stepped over while writing
+  uint32_t writeErrors;
+};
+
+struct FlashRing {
+  const esp_partition_t* partition;
+  uint16_t magic;
+  uint32_t pageCount;
+  uint32_t headPage;          // Next page to program
+  uint32_t nextSequence;
+  uint32_t sectorEraseCount[FLASH_RING_MAX_SECTORS];
+  FlashRingStats stats;
+  // Called before a sector is erased to make room, with the pages it holds
+  void (*beforeErase)(FlashRing* ring, uint32_t firstPage, void* context);
+  void* context;
+};
+
+// Called by the mount scan for every valid page, in page order
+typedef void (*FlashPageVisitor)(uint32_t page, const FlashPageHeader* header,
+                                 const uint8_t* data, void* context);
+
+bool flashRingMount(FlashRing* ring, const char* label, uint8_t subtype, uint16_t magic,
+                    FlashPageVisitor visit, void* context);
+
+// True if the page has not been written since its sector was erased
+bool flashRingBlank(FlashRing* ring, uint32_t page);
+// Read and validate a page; buffer receives all FLASH_RING_PAGE_SIZE bytes
+FlashPageState flashRingRead(FlashRing* ring, uint32_t page, uint8_t* buffer, FlashPageHeader* header);
+
+// Program page (payload at FLASH_RING_HEADER_SIZE, the rest 0xFF) at the
+// head of the ring; fills in the header. Reports the page index used.
+bool flashRingAppend(FlashRing* ring, uint8_t flags, uint8_t* page, size_t used, uint32_t* pageOut = NULL);
+
+// Program bytes of an already written page; only clears bits
+bool flashRingProgram(FlashRing* ring, uint32_t page, size_t offset, const void* data, size_t length);
+
+uint32_t flashRingNext(const FlashRing* ring, uint32_t page);
+uint32_t flashRingPrevious(const FlashRing* ring, uint32_t page);
+void flashRingEraseCounts(const FlashRing* ring, uint32_t* minCount, uint32_t* maxCount);
@@ -20,16 +20,10 @@
 
 #pragma once
 #include <Arduino.h>
+#include "SensorSample.h"
 
-struct SensorData {
-  int temperature;
-  float humidity;
-  int lux;
-  float distance;
-  unsigned long lastEnvironmentalUpdate;
-  unsigned long lastDistanceUpdate;
-  unsigned long lastLoRaTransmit;
-};
+// Latest published readings, in the canonical fixed-point layout
+typedef SensorSample SensorData;
 
 struct GlobalContext {
   // Sensor data
@@ -37,13 +31,12 @@ struct GlobalContext {
   
   // LoRa state
   bool loraActive;
+  uint8_t loraFrameFormat;
+  uint8_t loraBatchSamples;       // 1 = a frame per sample
+  uint32_t loraBatchLatencyMs;
   
   // ESP-NOW state
-  bool nowSerialActive;
-  uint8_t peerMacAddress[6];
-  bool macAddressSet;
-  char receivedMessageBuffer[256];
-  int receivedMessageLen;
+  bool nowSerialActive;   // Peers live in the PeerTable module
   
   // Timing
   unsigned long currentTime;
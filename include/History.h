@@ -0,0 +1,169 @@
+/**
+ * History.h - In-RAM sensor time series with rolled-up tiers
+ * 
+ * Copyright (C) 2025 Michael Garcia, M&E Design
+ * Based on original .ino by Geoff Mcintyre of Mr.Industries (https://mr.industries/)
+ * 
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ * 
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU General Public License for more details.
+ * 
+ * You should have received a copy of the GNU General Public License
+ * along with this program. If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#pragma once
+#include <Arduino.h>
+#include "SensorSample.h"
+
+/**
+ * In-RAM sensor history
+ *
+ * Every published sample is kept per channel (temperature, humidity, lux,
+ * distance) in three tiers, each a fixed ring sized at compile time:
+ *
+ *   raw      every 1 Hz sample                 HISTORY_RAW_CAPACITY
+ *   1m       min/max/mean per minute           HISTORY_MINUTE_CAPACITY
+ *   15m      min/max/mean per quarter hour     HISTORY_QUARTER_CAPACITY
+ *
+ * The rolled-up tiers are not computed from the raw ring: each keeps an
+ * open accumulator (min, max, sum and count per channel) that every sample
+ * updates, and that is closed into the ring when a sample lands in the
+ * next bucket, so an append is O(1) whatever the capacities. Buckets are
+ * aligned to multiples of their interval in millis() and carry their start
+ * time, so gaps in sampling leave no empty slots. The open bucket is
+ * returned by queries as the newest, partial, bucket.
+ *
+ * A field whose flag is clear in the sample is not counted, so a point
+ * with count 0 has no reading and is skipped by queries. The shared store
+ * is fed only the channels each update actually read: a sensor pass
+ * appends the channels that were due, an ESP-NOW update the distance.
+ *
+ * The HistoryStore functions are plain code working on the store they are
+ * given (the benchmark uses its own); the capture and query functions
+ * below them work on the shared store under a mutex.
+ */
+
+#ifndef HISTORY_RAW_CAPACITY
+#define HISTORY_RAW_CAPACITY 300         // 5 minutes at 1 Hz
+#endif
+#ifndef HISTORY_MINUTE_CAPACITY
+#define HISTORY_MINUTE_CAPACITY 120      // 2 hours
+#endif
+#ifndef HISTORY_QUARTER_CAPACITY
+#define HISTORY_QUARTER_CAPACITY 96      // 24 hours
+#endif
+
+#define HISTORY_MINUTE_MS 60000UL
+#define HISTORY_QUARTER_MS 900000UL
+
+typedef enum {
+  HISTORY_RAW = 0,
+  HISTORY_MINUTE,
+  HISTORY_QUARTER,
+  HISTORY_TIER_COUNT
+} HistoryTier;
+
+typedef enum {
+  HISTORY_TEMPERATURE = 0,    // 0.01 °C
+  HISTORY_HUMIDITY,           // 0.01 %RH
+  HISTORY_LUX,                // lx
+  HISTORY_DISTANCE,           // 0.01 in
+  HISTORY_CHANNEL_COUNT
+} HistoryChannel;
+
+// One query result; raw points have min = max = mean and count 1
+struct HistoryPoint {
+  uint32_t timeMs;            // Sample time, or bucket start
+  int32_t min;
+  int32_t max;
+  int32_t mean;
+  uint16_t count;             // Samples with a reading in the bucket
+};
+
+// Closed bucket; values are the channel's SensorSample fields as stored
+// (temperature is an int16 bit pattern)
+struct HistoryStat {
+  uint16_t min;
+  uint16_t max;
+  uint16_t mean;
+  uint16_t count;
+};
+
+struct HistoryBucket {
+  uint32_t startMs;
+  HistoryStat stats[HISTORY_CHANNEL_COUNT];
+};
+
+struct HistoryAccumulator {
+  bool open;
+  uint32_t startMs;
+  int32_t min[HISTORY_CHANNEL_COUNT];
+  int32_t max[HISTORY_CHANNEL_COUNT];
+  int32_t sum[HISTORY_CHANNEL_COUNT];
+  uint16_t count[HISTORY_CHANNEL_COUNT];
+};
+
+struct HistoryTierRing {
+  HistoryBucket* buckets;
+  size_t capacity;
+  size_t head;                // Oldest bucket
+  size_t count;
+  uint32_t intervalMs;
+  HistoryAccumulator open;
+};
+
+struct HistoryStore {
+  // Raw ring, column-wise to avoid padding: 13 bytes per sample
+  uint32_t rawTime[HISTORY_RAW_CAPACITY];
+  uint16_t rawValue[HISTORY_RAW_CAPACITY][HISTORY_CHANNEL_COUNT];
+  uint8_t rawFlags[HISTORY_RAW_CAPACITY];
+  size_t rawHead;
+  size_t rawCount;
+  
+  HistoryBucket minuteBuckets[HISTORY_MINUTE_CAPACITY];
+  HistoryBucket quarterBuckets[HISTORY_QUARTER_CAPACITY];
+  HistoryTierRing tiers[HISTORY_TIER_COUNT];   // [HISTORY_RAW] is unused
+  uint32_t appended;
+};
+
+#define HISTORY_MEMORY_BYTES sizeof(HistoryStore)
+
+void historyInit(HistoryStore* store);
+void historyAppend(HistoryStore* store, const SensorSample& sample);
+// Points of one channel with fromMs <= time <= toMs, oldest first; returns
+// how many were written. Call again from the last time + 1 to page.
+size_t historyQuery(const HistoryStore* store, HistoryTier tier, HistoryChannel channel,
+                    uint32_t fromMs, uint32_t toMs, HistoryPoint* out, size_t maxPoints);
+// min/max/mean over the same range in one point; false if it has no reading
+bool historySummary(const HistoryStore* store, HistoryTier tier, HistoryChannel channel,
+                    uint32_t fromMs, uint32_t toMs, HistoryPoint* out);
+size_t historyDepth(const HistoryStore* store, HistoryTier tier);
+
+// Shared store, fed by SensorTask
+bool initHistory();
+// Append the channels (TELEMETRY_FLAG_* bits) just updated in the published
+// SensorData snapshot: SensorTask after each pass with the channels it
+// read, NowLink with TELEMETRY_FLAG_DISTANCE after a distance update
+void captureHistorySample(uint8_t channels);
+size_t queryHistory(HistoryTier tier, HistoryChannel channel, uint32_t fromMs, uint32_t toMs,
+                    HistoryPoint* out, size_t maxPoints);
+bool summarizeHistory(HistoryTier tier, HistoryChannel channel, uint32_t fromMs, uint32_t toMs,
+                      HistoryPoint* out);
+void printHistoryStats();
+
+// Names used by the history command, e.g. "1m" and "temp"
+const char* historyTierName(HistoryTier tier);
+const char* historyChannelName(HistoryChannel channel);
+bool parseHistoryTier(const char* name, HistoryTier* tier);
+bool parseHistoryChannel(const char* name, HistoryChannel* channel);
+uint32_t historyTierIntervalMs(HistoryTier tier);
+uint8_t historyChannelFlag(HistoryChannel channel);
+// Prints a channel value in its unit with the decimals it carries
+void printHistoryValue(HistoryChannel channel, int32_t value);
@@ -0,0 +1,54 @@
+/**
+ * Htu21dfDriver.h - HTU21D-F temperature/humidity driver
+ * 
+ * Copyright (C) 2025 Michael Garcia, M&E Design
+ * Based on original .ino by Geoff Mcintyre of Mr.Industries (https://mr.industries/)
+ * 
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ * 
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU General Public License for more details.
+ * 
+ * You should have received a copy of the GNU General Public License
+ * along with this program. If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#pragma once
+#include <Arduino.h>
+#include <Wire.h>
+#include <Adafruit_HTU21DF.h>
+#include "SensorDriver.h"
+
+/**
+ * HTU21D-F temperature/humidity driver (SensorDriver.h)
+ *
+ * Conversions use no-hold-master mode: the device NACKs its address until
+ * a result is ready, so the bus stays free. start() queues the trigger for
+ * the first requested conversion on the I2C bus manager; poll() waits out
+ * the nominal conversion time, queues the result read (again every
+ * HTU21DF_POLL_INTERVAL_MS while the device NACKs), checks its CRC and
+ * triggers the next one. Raw codes are scaled with integer math in read().
+ */
+
+// No-hold-master commands and worst-case conversion times (14/12 bit)
+#define HTU21DF_TRIGGER_TEMP_NOHOLD 0xF3
+#define HTU21DF_TRIGGER_HUM_NOHOLD  0xF5
+#define HTU21DF_TEMP_CONVERSION_MS  50
+#define HTU21DF_HUM_CONVERSION_MS   16
+#define HTU21DF_POLL_INTERVAL_MS    2
+#define HTU21DF_POLL_ATTEMPTS       10
+
+class Htu21dfDriver {
+ public:
+  static constexpr uint8_t CHANNELS = TELEMETRY_FLAG_TEMPERATURE | TELEMETRY_FLAG_HUMIDITY;
+
+  static bool probe();
+  static void start(uint8_t channels);
+  static uint32_t poll();
+  static void read(SensorSample* sample);
+};
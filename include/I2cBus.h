@@ -0,0 +1,107 @@
+/**
+ * I2cBus.h - I2C bus manager with an asynchronous transaction queue
+ * 
+ * Copyright (C) 2025 Michael Garcia, M&E Design
+ * Based on original .ino by Geoff Mcintyre of Mr.Industries (https://mr.industries/)
+ * 
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ * 
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU General Public License for more details.
+ * 
+ * You should have received a copy of the GNU General Public License
+ * along with this program. If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#pragma once
+#include <Arduino.h>
+#include <Wire.h>
+#include <atomic>
+#include "freertos/FreeRTOS.h"
+
+/**
+ * I2C bus manager
+ *
+ * I2cTask owns the bus. Drivers fill in an I2cTransaction (a register
+ * write, a read, or a write followed by a read) and submit it; the task
+ * runs queued transactions back to back and calls each one's callback in
+ * its own context when it completes. The submitting task does not block
+ * on the bus, so it can start another sensor's conversion, or sleep,
+ * while the bytes go out.
+ *
+ * Transactions are owned by the caller and must stay valid until their
+ * callback has run; there is no allocation. Callbacks must be short and
+ * must not block or lock the bus; typically they record the result and
+ * wake the waiting task. Code that can only talk to the bus through Wire
+ * directly (the Adafruit drivers' setup calls) brackets it with
+ * i2cBusLock() / i2cBusUnlock() so it never interleaves with the queue.
+ *
+ * The bus runs at I2C_BUS_CLOCK_HZ; the TSL2561 and HTU21D-F both
+ * support 400 kHz fast mode. At startup i2cBusScan() reports every
+ * address that ACKs.
+ */
+
+#define I2C_BUS_CLOCK_HZ 400000        // 100000 for standard mode
+#define I2C_QUEUE_LENGTH 8
+#define I2C_TASK_PRIORITY 3            // Above SensorTask, so queued transfers start at once
+#define I2C_TASK_STACK 2048
+#define I2C_LOCK_TIMEOUT_MS 100
+#define I2C_MAX_WRITE 4
+#define I2C_MAX_READ 4
+
+typedef enum {
+  I2C_IDLE = 0,                  // Never submitted
+  I2C_PENDING,                   // Queued or running
+  I2C_DONE,
+  I2C_NACK,                      // Address or data not acknowledged, or short read
+  I2C_FAILED                     // Not queued: bus manager not running or queue full
+} I2cStatus;
+
+struct I2cTransaction;
+typedef void (*I2cCallback)(I2cTransaction* transaction);
+
+struct I2cTransaction {
+  uint8_t address;
+  uint8_t writeLength;           // Bytes sent first, with a stop
+  uint8_t readLength;            // Bytes then read
+  uint8_t writeData[I2C_MAX_WRITE];
+  uint8_t readData[I2C_MAX_READ];
+  I2cCallback done;              // Called from I2cTask; may be NULL
+  void* context;
+  uint32_t submittedUs;
+  std::atomic<uint8_t> status;   // I2cStatus, set before done() runs
+};
+
+struct I2cBusStats {
+  uint32_t transactions;
+  uint32_t nacks;
+  uint32_t queueFull;
+  uint64_t busyUs;               // Time I2cTask spent on the bus
+  uint32_t maxLatencyUs;         // Submit to completion
+  uint32_t highWater;            // Deepest the queue has been
+  uint32_t lockWaits;            // i2cBusLock() calls that had to wait
+};
+
+bool initI2cBus();
+// Probe every 7-bit address and log the ones that ACK; returns how many
+uint8_t i2cBusScan();
+bool i2cDeviceFound(uint8_t address);
+
+// Queue a transaction; false (with status I2C_FAILED) if it could not be.
+bool i2cSubmit(I2cTransaction* transaction);
+inline I2cStatus i2cStatus(const I2cTransaction& transaction) {
+  return (I2cStatus)transaction.status.load(std::memory_order_acquire);
+}
+
+// Exclusive direct use of Wire
+bool i2cBusLock();
+void i2cBusUnlock();
+
+void getI2cBusStats(I2cBusStats* stats);
+void printI2cBusStats();
+void printI2cScan();
@@ -23,9 +23,149 @@
 #include <SPI.h>
 #include <LoRa.h>
 #include "pins.h"
+#include "PeerTable.h"
+#include "Backlog.h"
+#include "History.h"
 
 #define LORA_TRANSMIT_INTERVAL 1000
 
+// Numeric hub id carried in binary frames in place of the hub name
+#define LORA_HUB_ID 0x0001
+#define LORA_HUB_NAME_LENGTH 32               // Including the terminator
+
+// Payload of EVENT_LORA_SEND_REQUEST
+struct LoRaSendRequest {
+  char hubName[LORA_HUB_NAME_LENGTH];
+};
+
+/**
+ * Over-the-air packet formats
+ *
+ * LORA_FORMAT_BINARY sends the fixed-layout frame from TelemetryFrame.h.
+ * LORA_FORMAT_ASCII keeps the legacy "CH>"/"PD>" text packets for older
+ * receivers.
+ */
+typedef enum {
+  LORA_FORMAT_ASCII = 0,
+  LORA_FORMAT_BINARY = 1
+} LoRaFrameFormat;
+
+#define LORA_DEFAULT_FRAME_FORMAT LORA_FORMAT_BINARY
+
+/**
+ * Batching
+ *
+ * With batching on, binary mode holds samples back until
+ * loraBatchSamples are pending or the oldest has waited
+ * loraBatchLatencyMs, then sends them together in one delta-encoded batch
+ * frame (TelemetryFrame.h), so the preamble, header and CRC are paid once
+ * per batch instead of once per sample. ASCII mode always sends one packet
+ * per sample.
+ */
+#define LORA_DEFAULT_BATCH_SAMPLES 1          // Off
+#define LORA_DEFAULT_BATCH_LATENCY_MS 15000
+#define LORA_BATCH_MAX_LATENCY_MS 600000
+
+// Modem settings (LoRa library defaults), used for time-on-air estimates
+#ifndef LORA_SPREADING_FACTOR
+#define LORA_SPREADING_FACTOR 7
+#endif
+#define LORA_SIGNAL_BANDWIDTH 125E3
+#define LORA_CODING_RATE_DENOM 5
+#define LORA_PREAMBLE_LENGTH 8
+
+#define LORA_MAX_PACKET_SIZE 255
+
+// Asynchronous transmit queue. A frame whose TX-done interrupt has not
+// arrived within twice its time-on-air plus the margin is abandoned.
+#define LORA_TX_QUEUE_DEPTH 4
+#define LORA_TX_TIMEOUT_MARGIN_MS 100
+
+// Link supervision. There are no acknowledgements, so only failures the
+// radio itself reports (refused starts, missing TX-done) are detected; a
+// gateway that is simply out of range goes unnoticed.
+#define LORA_LINK_FAILURE_LIMIT 3     // Consecutive failed frames before the link is down
+#define LORA_RETRY_MIN_MS 2000        // First re-initialization attempt
+#define LORA_RETRY_MAX_MS 60000       // Backoff ceiling
+
+struct LoRaTxStats {
+  uint32_t queued;        // Frames accepted into the TX queue
+  uint32_t sent;          // Frames completed by the TX-done interrupt
+  uint32_t dropped;       // Frames rejected because the queue was full
+  uint32_t failed;        // Frames the radio refused to start
+  uint32_t timeouts;      // Frames abandoned without a TX-done interrupt
+  uint8_t depth;          // Frames currently queued, including the one on air
+  uint8_t maxDepth;
+  uint32_t maxEnqueueUs;  // Longest time a caller spent in queueLoRaPacket()
+  uint32_t outages;       // Times the link was declared down
+  uint32_t lastOutageMs;  // Duration of the most recent completed outage
+  uint32_t reconnectAttempts;
+  uint32_t lastSentMs;    // millis() of the most recent TX-done
+};
+
 bool initializeLoRa();
 void createHub(const char* hubName, const char* sensorNames, const char* types);
-void pushAllData(const char* hubName);
\ No newline at end of file
+void pushAllData(const char* hubName);
+
+// Transmit queue: queueLoRaPacket() copies the frame and returns without
+// waiting for time-on-air; serviceLoRaTx() runs in CommsTask to retire
+// completed frames and start the next one.
+bool queueLoRaPacket(const uint8_t* packet, size_t length);
+void serviceLoRaTx();
+void getLoRaTxStats(LoRaTxStats* stats);
+void printLoRaTxStats();
+
+// CommsTask: re-initialize a failed radio with exponential backoff, and send
+// the next frame from the backlog (Backlog.h) whenever the radio is idle.
+// With one sample pending this is the regular sensor frame; with batching,
+// or after an outage, it is a batch frame of up to BACKLOG_BATCH_MAX samples
+// (binary) or one PD> packet per sample (ASCII).
+void maintainLoRaLink();
+void drainBacklog(const char* hubName);
+
+// Milliseconds until CommsTask next has timed LoRa work: the in-flight
+// frame's TX timeout, the next reconnect attempt, or a batch reaching its
+// latency; UINT32_MAX if there is none. Everything else that creates work
+// publishes an event (TX-done, new samples, history requests, batching
+// changes). Work that could not be queued is retried after
+// LORA_SERVICE_RETRY_MS.
+#define LORA_SERVICE_RETRY_MS 1000
+uint32_t loraServiceDelayMs();
+
+// Upload one channel of the history (History.h) from fromMs up to the time
+// of the request in history frames. serviceHistoryUpload() runs in
+// CommsTask and sends a frame only when the radio has nothing else queued,
+// so live samples and the backlog go first. Returns false if an upload is
+// already running or LoRa is down.
+bool requestHistoryUpload(HistoryTier tier, HistoryChannel channel, uint32_t fromMs);
+void serviceHistoryUpload();
+
+void setLoRaFrameFormat(LoRaFrameFormat format);
+LoRaFrameFormat getLoRaFrameFormat();
+const char* loraFrameFormatName(LoRaFrameFormat format);
+
+// samples 1 turns batching off; returns false if out of range
+bool setLoRaBatching(uint8_t samples, uint32_t maxLatencyMs);
+void printLoRaBatching();
+
+// Build a sensor data packet in the given format; returns its length, 0 on overflow.
+// Binary frames carry a record for every peer with a reading newer than
+// PEER_STALE_MS; the ASCII format only has room for the single distance.
+size_t buildSensorPacket(LoRaFrameFormat format, const char* hubName, uint16_t sequence,
+                         const SensorSample& sample, const PeerState* peers, size_t peerCount,
+                         uint8_t* buffer, size_t bufferSize);
+
+// History frame for up to TELEMETRY_MAX_HISTORY_POINTS points; *encodedPoints
+// is how many fit
+size_t buildHistoryPacket(HistoryTier tier, HistoryChannel channel, const HistoryPoint* points,
+                          size_t count, uint8_t* buffer, size_t bufferSize, uint8_t* encodedPoints);
+
+// Batch frame for backlog samples plus the fresh peer readings, as drainBacklog() sends it
+size_t buildBatchPacket(const BacklogSample* samples, size_t count, const PeerState* peers,
+                        size_t peerCount, uint8_t* buffer, size_t bufferSize);
+
+// SX127x time-on-air for an explicit-header packet, in microseconds
+uint32_t loraTimeOnAirUs(size_t payloadLength, int spreadingFactor = LORA_SPREADING_FACTOR,
+                         long bandwidth = LORA_SIGNAL_BANDWIDTH,
+                         int codingRateDenom = LORA_CODING_RATE_DENOM,
+                         int preambleLength = LORA_PREAMBLE_LENGTH, bool crc = false);
\ No newline at end of file
@@ -0,0 +1,70 @@
+/**
+ * LogFrame.h - Binary log frame encoding
+ * 
+ * Copyright (C) 2025 Michael Garcia, M&E Design
+ * Based on original .ino by Geoff Mcintyre of Mr.Industries (https://mr.industries/)
+ * 
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ * 
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU General Public License for more details.
+ * 
+ * You should have received a copy of the GNU General Public License
+ * along with this program. If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#pragma once
+#include <stdint.h>
+#include <stddef.h>
+
+/**
+ * Binary log frame
+ *
+ * Compact encoding of one log record for the binary log mode. The format
+ * string is not sent; it is identified by logFormatId(), a pure function of
+ * its text, so the decoder (tools/logdecode.py) builds the id -> format
+ * dictionary from the sources at build time. Like TelemetryFrame, these
+ * helpers have no Arduino dependencies.
+ *
+ * Payload before COBS:
+ *
+ *   offset size field
+ *   0      1    magic        LOG_FRAME_MAGIC
+ *   1      4    formatId     uint32, FNV-1a of the format string
+ *   5      1    level        LogLevel; bit 7 set if arguments were truncated
+ *   6      var  timestamp    varint, millis()
+ *   ...    var  arguments    in format order:
+ *                              signed integers, %c   zigzag varint
+ *                              unsigned integers, %p varint
+ *                              floating point        float32
+ *                              strings               varint length + bytes
+ *   n      2    crc          CRC-16/CCITT-FALSE over bytes 0..n-1
+ *
+ * On the wire the payload is COBS-encoded and wrapped in 0x00 delimiters
+ * (0x00 <cobs> 0x00), so it can share the UART with plain text output:
+ * text never contains 0x00 and a frame never contains one inside.
+ */
+
+#define LOG_FRAME_MAGIC 0xB1
+#define LOG_FRAME_TRUNCATED 0x80
+#define LOG_FRAME_DELIMITER 0x00
+#define LOG_FRAME_MAX_PAYLOAD 160
+#define LOG_FRAME_MAX_ENCODED (2 + LOG_FRAME_MAX_PAYLOAD + LOG_FRAME_MAX_PAYLOAD / 254 + 1)
+
+// FNV-1a, written as a single-expression constexpr so literal formats can
+// be hashed at compile time even under C++11
+constexpr uint32_t logFormatId(const char* format, uint32_t hash = 2166136261u) {
+  return *format ? logFormatId(format + 1, (hash ^ (uint8_t)*format) * 16777619u) : hash;
+}
+
+// Varint helpers; return bytes written, or 0 if the buffer is too small
+size_t logPutVarint(uint8_t* buffer, size_t bufferSize, uint64_t value);
+size_t logPutZigzag(uint8_t* buffer, size_t bufferSize, int64_t value);
+
+// COBS-encode payload and wrap it in delimiters; returns the wire length or 0
+size_t logFrameWrap(const uint8_t* payload, size_t length, uint8_t* out, size_t outSize);
@@ -0,0 +1,86 @@
+/**
+ * LogStorage.h - Persistent flash log ring interface
+ * 
+ * Copyright (C) 2025 Michael Garcia, M&E Design
+ * Based on original .ino by Geoff Mcintyre of Mr.Industries (https://mr.industries/)
+ * 
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ * 
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU General Public License for more details.
+ * 
+ * You should have received a copy of the GNU General Public License
+ * along with this program. If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#pragma once
+#include <Arduino.h>
+#include "FlashRing.h"
+
+/**
+ * Persistent log storage (SINK_STORAGE)
+ *
+ * Log records are appended to a FlashRing (see FlashRing.h) in the
+ * dedicated "logs" partition (see partitions.csv). The logger task batches
+ * records into a RAM page and programs it in one write when it is full,
+ * or after LOG_STORAGE_FLUSH_MS so a quiet node still persists its logs.
+ * Records never span pages, and each page's payload is the records as
+ * sent to the serial sink: binary log frames (LogFrame.h) or text lines.
+ * A power cut loses at most the unwritten RAM page.
+ *
+ * "storage erase" does not erase flash: it writes an empty marker page,
+ * and pages older than the newest marker are no longer read back.
+ *
+ * All functions are thread-safe.
+ */
+
+#define LOG_STORAGE_PARTITION_LABEL "logs"
+#define LOG_STORAGE_PARTITION_SUBTYPE 0x40
+#define LOG_STORAGE_PAYLOAD_SIZE FLASH_RING_PAYLOAD_SIZE
+#define LOG_STORAGE_FLUSH_MS 5000        // Longest a record waits in RAM
+
+#define LOG_PAGE_MAGIC 0x474C            // "LG"
+#define LOG_PAGE_FLAG_ERASE 0x01         // Marker: discard older pages
+
+struct LogStorageStats {
+  bool ready;
+  uint32_t partitionBytes;
+  uint32_t pages;
+  uint32_t storedPages;       // Readable pages newer than the last erase marker
+  uint32_t oldestSequence;
+  uint32_t newestSequence;
+  uint32_t recoveredPages;    // Valid pages found by the boot scan
+  uint32_t corruptPages;      // Torn or damaged pages found by the boot scan
+  uint32_t recoveryMs;
+  uint32_t records;           // Records appended since boot
+  uint32_t recordBytes;
+  uint32_t droppedRecords;    // Larger than a page, or lost to a flash error
+  uint32_t pagesWritten;
+  uint32_t sectorErases;
+  uint32_t skippedPages;      // Non-blank pages stepped over while writing
+  uint32_t writeErrors;
+  uint32_t minEraseCount;
+  uint32_t maxEraseCount;
+};
+
+bool initLogStorage();
+bool logStorageReady();
+
+// Append one record; it is programmed when its page fills or is flushed
+bool logStorageAppend(const uint8_t* data, size_t length);
+// Write out the RAM page once it has waited LOG_STORAGE_FLUSH_MS. Returns
+// the ms until the page is due, or UINT32_MAX with nothing waiting.
+uint32_t pollLogStorage();
+bool flushLogStorage();
+bool eraseLogStorage();
+
+// Stream stored records, oldest first, to Serial for tools/logdecode.py
+void dumpLogStorage();
+// Reads every page header, taking the lock for one page at a time
+void getLogStorageStats(LogStorageStats* stats);
+void printLogStorageStats();
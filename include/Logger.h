@@ -1,6 +1,6 @@
 /**
  * Logger.h - Logging and telemetry abstraction layer
- * Version: 2.0.0
+ * Version: 2.2.0
  * 
  * Copyright (C) 2025 Michael Garcia, M&E Design
  * Based on original .ino by Geoff Mcintyre of Mr.Industries (https://mr.industries/)
@@ -21,6 +21,9 @@
 
 #pragma once
 #include <Arduino.h>
+#include "SensorSample.h"
+#include "LogFrame.h"
+#include <type_traits>
 
 /**
  * Log levels for message filtering and prioritization
@@ -45,28 +48,98 @@ typedef enum {
 typedef enum {
     SINK_SERIAL = 0x01,   // Serial console output
     SINK_NETWORK = 0x02,  // Network telemetry (future implementation)
-    SINK_STORAGE = 0x04   // Local storage (future implementation)
+    SINK_STORAGE = 0x04   // Flash log ring (see LogStorage.h)
 } LogSink;
 
+/**
+ * Serial sink encoding
+ *
+ * Text is the classic "[ms] LEVEL: message" line. Binary sends each record
+ * as a compact COBS frame (see LogFrame.h) that tools/logdecode.py turns
+ * back into the same text; other Serial output passes through unchanged.
+ */
+typedef enum {
+    LOG_OUTPUT_TEXT = 0,
+    LOG_OUTPUT_BINARY = 1
+} LogOutputFormat;
+
 // Logger configuration
 #define LOG_BUFFER_SIZE 256
 #define LOG_DEFAULT_LEVEL LOG_INFO
 #define LOG_DEFAULT_SINKS SINK_SERIAL
+#ifndef LOG_DEFAULT_OUTPUT
+#define LOG_DEFAULT_OUTPUT LOG_OUTPUT_TEXT
+#endif
+
+/**
+ * Deferred output
+ *
+ * Log calls do not format or touch the UART. The caller packs its
+ * arguments (strings are copied) into a fixed-size record and pushes it
+ * into a lock-free multi-producer ring; the logger task formats and writes
+ * records at low priority. When the ring is full the record is dropped and
+ * counted, so a slow UART never blocks the caller.
+ */
+#define LOG_QUEUE_DEPTH 32            // Records, power of two
+#define LOG_RECORD_ARG_BYTES 96       // Packed argument bytes per record
+#define LOGGER_TASK_PRIORITY 0        // Below every application task
+#define LOGGER_TASK_STACK 3072
+
+struct LoggerStats {
+    uint32_t queued;        // Records accepted into the ring
+    uint32_t written;       // Records formatted and output
+    uint32_t dropped;       // Records lost because the ring was full
+    uint32_t truncated;     // Records whose arguments did not fit
+    uint32_t highWater;     // Peak ring occupancy in records
+    uint32_t maxEnqueueUs;  // Slowest caller-side log call
+    uint32_t bytesOut;      // Serial bytes written by the logger
+};
 
 // Logger initialization and configuration
 void initLogger(LogLevel minLevel = LOG_DEFAULT_LEVEL, uint8_t sinks = LOG_DEFAULT_SINKS);
 void setLogLevel(LogLevel level);
 void setLogSinks(uint8_t sinks);
+void setLogOutputFormat(LogOutputFormat format);
+LogOutputFormat getLogOutputFormat();
+const char* logOutputFormatName(LogOutputFormat format);
+
+// Wait until the logger task has written everything queued so far
+void flushLogger(uint32_t timeoutMs = 500);
+void getLoggerStats(LoggerStats* stats);
+void printLoggerStats();
+
+/**
+ * Format ids
+ *
+ * The logging calls are macros so that logFormatId() (LogFrame.h) of the
+ * format is evaluated by the compiler at each call site and travels in the
+ * record; the logger task never hashes format text. The format must
+ * therefore be a string literal.
+ */
+#define LOG_FORMAT_ID(format) (std::integral_constant<uint32_t, logFormatId(format)>::value)
+
+// Encode an INFO record both ways without output (used by the log
+// benchmark); reports the serial bytes each encoding would take
+void measureLogEncodingWithId(size_t* textBytes, size_t* binaryBytes, uint32_t formatId, const char* format, ...);
+#define measureLogEncoding(textBytes, binaryBytes, format, ...) \
+    measureLogEncodingWithId(textBytes, binaryBytes, LOG_FORMAT_ID(format), format, ##__VA_ARGS__)
+// Encode a record as a binary log frame without queuing it; returns the
+// frame length, or 0 if it does not fit
+size_t encodeLogMessageWithId(uint8_t* frame, size_t frameSize, LogLevel level, uint32_t formatId,
+                              const char* format, ...);
+#define encodeLogMessage(frame, frameSize, level, format, ...) \
+    encodeLogMessageWithId(frame, frameSize, level, LOG_FORMAT_ID(format), format, ##__VA_ARGS__)
 
-// Core logging functions with level-specific variants
-void logMessage(LogLevel level, const char* format, ...);
-void logDebug(const char* format, ...);
-void logInfo(const char* format, ...);
-void logWarn(const char* format, ...);
-void logError(const char* format, ...);
-void logCritical(const char* format, ...);
+// Core logging function with level-specific variants
+void logMessageWithId(LogLevel level, uint32_t formatId, const char* format, ...);
+#define logMessage(level, format, ...) logMessageWithId(level, LOG_FORMAT_ID(format), format, ##__VA_ARGS__)
+#define logDebug(format, ...)    logMessage(LOG_DEBUG, format, ##__VA_ARGS__)
+#define logInfo(format, ...)     logMessage(LOG_INFO, format, ##__VA_ARGS__)
+#define logWarn(format, ...)     logMessage(LOG_WARN, format, ##__VA_ARGS__)
+#define logError(format, ...)    logMessage(LOG_ERROR, format, ##__VA_ARGS__)
+#define logCritical(format, ...) logMessage(LOG_CRITICAL, format, ##__VA_ARGS__)
 
 // Telemetry functions for structured data logging
-void logSensorData(int temp, float humidity, int lux, float distance);
+void logSensorData(const SensorSample& sample);
 void logSystemEvent(const char* event, const char* details = nullptr);
 void logNetworkEvent(const char* protocol, const char* event, const char* details = nullptr);
\ No newline at end of file
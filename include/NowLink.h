@@ -23,6 +23,7 @@
 #include <WiFi.h>
 #include <esp_now.h>
 #include <esp_wifi.h>
+#include <esp_idf_version.h>
 
 #define ESPNOW_WIFI_MODE_STATION 1
 #define ESPNOW_WIFI_CHANNEL 1
@@ -35,7 +36,41 @@
 #define ESPNOW_WIFI_IF   WIFI_IF_AP
 #endif
 
-bool initializeNowSerial(uint8_t* mac);
+// Receive path: the ESP-NOW callback copies frames into a lock-free ring
+// and publishes EVENT_NOW_RX_READY; handleNowMessages() drains the ring from
+// CommsTask
+#define NOW_RX_RING_SIZE 2048   // Bytes, power of two (~80 DIST frames)
+#define NOW_RX_BATCH_MAX 32     // Frames drained per handleNowMessages() call
+#define NOW_MAX_FRAME_SIZE 250  // ESP_NOW_MAX_DATA_LEN
+
+struct NowRxStats {
+  uint32_t frames;      // Frames accepted into the ring
+  uint32_t dropped;     // Frames lost because the ring was full
+  uint32_t oversize;    // Empty or oversized frames rejected
+  uint32_t lines;       // Readings stored in the peer table
+  uint32_t badLines;    // Lines that failed to parse
+  uint32_t unknownPeer; // Readings from MACs not in the peer table
+  uint32_t outliers;    // Distance readings replaced by the distance filter
+  uint32_t highWater;   // Peak ring usage in bytes
+  uint32_t maxBatch;    // Most frames drained in one call
+};
+
+// A "DIST:<value>[,<seq>]" or "SOIL:<value>[,<seq>]" line from a node
+struct NowReading {
+  uint8_t kind;         // PeerKind
+  float value;
+  bool hasSequence;
+  uint16_t sequence;
+};
+
+bool initializeNowSerial();
 void initializeNowFromEEPROM();
+bool addNowPeer(const uint8_t* mac);
+bool removeNowPeer(const uint8_t* mac);
+void clearNowPeers();
+bool parseNowReading(const char* message, NowReading* reading);
 bool parseDistance(const char* message, float* distance);
-void handleNowMessages();
\ No newline at end of file
+// Drains up to NOW_RX_BATCH_MAX frames; true if more are waiting
+bool handleNowMessages();
+void getNowRxStats(NowRxStats* stats);
+void printNowRxStats();
\ No newline at end of file
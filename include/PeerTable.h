@@ -0,0 +1,80 @@
+/**
+ * PeerTable.h - ESP-NOW multi-peer state table
+ * 
+ * Copyright (C) 2025 Michael Garcia, M&E Design
+ * Based on original .ino by Geoff Mcintyre of Mr.Industries (https://mr.industries/)
+ * 
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ * 
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU General Public License for more details.
+ * 
+ * You should have received a copy of the GNU General Public License
+ * along with this program. If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#pragma once
+#include <Arduino.h>
+
+/**
+ * ESP-NOW peer table
+ *
+ * Fixed-capacity table of the nodes reporting to this hub, keyed by MAC.
+ * An open-addressed hash index maps a MAC to its slot in O(1) on the
+ * receive path; removing a peer compacts the table and rebuilds the index.
+ * Each slot tracks the peer's latest reading, last-seen time, RSSI and
+ * sequence gaps. The MAC list (not the readings) is persisted in EEPROM.
+ *
+ * All functions are thread-safe; the table is guarded by its own mutex.
+ */
+
+#define PEER_TABLE_CAPACITY 20      // ESP_NOW_MAX_TOTAL_PEER_NUM
+#define PEER_INDEX_SIZE 32          // Hash index slots, power of two
+#define PEER_RSSI_UNKNOWN INT8_MIN
+#define PEER_STALE_MS 60000         // Readings older than this are not reported
+
+typedef enum {
+  PEER_KIND_UNKNOWN = 0,
+  PEER_KIND_DISTANCE = 1,   // "DIST:" lines, inches
+  PEER_KIND_SOIL = 2        // "SOIL:" lines, % volumetric moisture
+} PeerKind;
+
+struct PeerState {
+  uint8_t mac[6];
+  uint8_t kind;             // PeerKind of the latest reading
+  bool hasValue;
+  float value;
+  unsigned long lastSeen;   // millis() of the latest reading
+  int8_t rssi;              // dBm, PEER_RSSI_UNKNOWN if the stack does not report it
+  bool sequenceValid;
+  uint16_t lastSequence;
+  uint32_t readings;
+  uint32_t missed;          // Readings lost according to sequence gaps
+};
+
+bool initPeerTable();
+// addPeer returns the slot (existing or new), or -1 if the table is full
+int addPeer(const uint8_t* mac);
+bool removePeer(const uint8_t* mac);
+void clearPeers();
+int findPeer(const uint8_t* mac);
+size_t peerCount();
+
+// Receive path: update a known peer; returns false for unknown MACs
+bool recordPeerReading(const uint8_t* mac, uint8_t kind, float value, int8_t rssi,
+                       bool hasSequence, uint16_t sequence);
+
+// Copy all peers (including ones without readings) into out; returns the count
+size_t snapshotPeers(PeerState* out, size_t maxPeers);
+
+bool savePeerTable();
+bool loadPeerTable();
+void printPeerTable();
+
+// Two-byte id used for a peer in telemetry frames (last two MAC bytes)
+uint16_t peerTelemetryId(const uint8_t* mac);
@@ -0,0 +1,93 @@
+/**
+ * PowerManager.h - Frequency scaling, light sleep and power locks
+ * 
+ * Copyright (C) 2025 Michael Garcia, M&E Design
+ * Based on original .ino by Geoff Mcintyre of Mr.Industries (https://mr.industries/)
+ * 
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ * 
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU General Public License for more details.
+ * 
+ * You should have received a copy of the GNU General Public License
+ * along with this program. If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#pragma once
+#include <Arduino.h>
+
+/**
+ * Power management
+ *
+ * initPowerManager() hands the clocks to ESP-IDF power management: the CPU
+ * runs at POWER_MAX_FREQ_MHZ while a task needs it and drops to
+ * POWER_MIN_FREQ_MHZ otherwise, and with FreeRTOS tickless idle the idle
+ * task puts the chip into light sleep whenever every task is blocked for
+ * at least CONFIG_FREERTOS_IDLE_TIME_BEFORE_SLEEP ticks. It sleeps until
+ * the next task timeout or one of the wake sources:
+ *
+ *   timer        the earliest task timeout (tickless idle)
+ *   LoRa DIO0    TX-done; DIO0 becomes a high-level interrupt, which the
+ *                LoRa ISR clears by reading the radio's IRQ flags
+ *   UART0 RX     serial commands; the edges that wake the chip are lost,
+ *                so the first character typed after a quiet spell is
+ *                dropped (press Enter first)
+ *
+ * Tasks only ever block on queues, semaphores and timeouts, so nothing
+ * polls the chip awake. Code that needs the clocks while it waits (a bus
+ * transfer in progress) holds a power lock for just that long; a held lock
+ * keeps APB at its maximum and prevents light sleep. While WiFi is on for
+ * ESP-NOW the WiFi driver holds its own lock, so the chip sleeps only with
+ * no peers configured and the radio off.
+ *
+ * Frequency scaling needs CONFIG_PM_ENABLE and light sleep also
+ * CONFIG_FREERTOS_USE_TICKLESS_IDLE in the core's sdkconfig. On a core
+ * built without them initPowerManager() falls back to the best mode that
+ * works, and the locks do nothing.
+ */
+
+#define POWER_MAX_FREQ_MHZ 240
+#define POWER_MIN_FREQ_MHZ 80          // Lowest with APB at 80 MHz for the UART baud rate
+#define POWER_UART_WAKE_EDGES 3        // RX edges that wake the chip
+
+typedef enum {
+  POWER_MODE_OFF = 0,            // Fixed POWER_MAX_FREQ_MHZ, no sleep
+  POWER_MODE_DFS,                // Frequency scaling only
+  POWER_MODE_LIGHT_SLEEP         // Frequency scaling and automatic light sleep
+} PowerMode;
+
+// One lock per bus; each is only held while its bus is transferring
+typedef enum {
+  POWER_LOCK_I2C = 0,            // I2cTask running queued transactions
+  POWER_LOCK_LORA,               // SPI traffic to the SX127x
+  POWER_LOCK_COUNT
+} PowerLockId;
+
+struct PowerLockStats {
+  uint32_t acquires;
+  uint32_t heldUs;               // Total time held
+  uint32_t maxHeldUs;
+};
+
+bool initPowerManager();
+// false if the core does not support the mode; the previous mode stays
+bool setPowerMode(PowerMode mode);
+PowerMode getPowerMode();
+
+// Nest freely; the lock is released when every acquire has been matched
+void powerLockAcquire(PowerLockId lock);
+void powerLockRelease(PowerLockId lock);
+
+// Wake from light sleep when pin goes high. Call after attaching the pin's
+// interrupt, which this turns into a high-level interrupt.
+void powerWakeOnPin(uint8_t pin);
+
+void getPowerLockStats(PowerLockId lock, PowerLockStats* stats);
+void printPowerStats();
+const char* powerModeName(PowerMode mode);
+const char* powerLockName(PowerLockId lock);
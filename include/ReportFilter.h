@@ -0,0 +1,87 @@
+/**
+ * ReportFilter.h - Report-by-exception deadband filter
+ * 
+ * Copyright (C) 2025 Michael Garcia, M&E Design
+ * Based on original .ino by Geoff Mcintyre of Mr.Industries (https://mr.industries/)
+ * 
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ * 
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU General Public License for more details.
+ * 
+ * You should have received a copy of the GNU General Public License
+ * along with this program. If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#pragma once
+#include <stdint.h>
+#include <stddef.h>
+#include "SensorSample.h"
+
+/**
+ * Report-by-exception filter
+ *
+ * Decides whether a new sample is worth transmitting by comparing it with
+ * the last sample that was reported, not with the previous sample, so a
+ * slow drift is still reported once it has moved a full deadband. A sample
+ * goes out when any field moves past its deadband, when a field becomes
+ * valid or invalid, or when nothing has been reported for the heartbeat
+ * interval, which also tells the gateway the node is alive.
+ *
+ * The gateway holds the last value it received, so the error it sees is
+ * bounded by the deadbands. Values are in telemetry units (SensorSample.h).
+ * Like TelemetryFrame, this has no Arduino dependencies.
+ */
+
+#define REPORT_DEFAULT_TEMPERATURE_CENTI 50   // 0.5 °C
+#define REPORT_DEFAULT_HUMIDITY_CENTI 100     // 1 %RH
+#define REPORT_DEFAULT_LUX_PERCENT 10         // Relative: light spans decades
+#define REPORT_DEFAULT_LUX_MIN 5              // lx, keeps darkness from chattering
+#define REPORT_DEFAULT_DISTANCE_CENTI 50      // 0.5 in
+#define REPORT_DEFAULT_HEARTBEAT_MS 60000
+
+struct ReportDeadbands {
+  bool enabled;               // false: report every sample
+  uint16_t temperatureCenti;
+  uint16_t humidityCenti;
+  uint16_t luxPercent;
+  uint16_t luxMin;
+  uint16_t distanceCenti;
+  uint32_t heartbeatMs;
+};
+
+typedef enum {
+  REPORT_SUPPRESSED = 0,
+  REPORT_FIRST,
+  REPORT_DISABLED,
+  REPORT_HEARTBEAT,
+  REPORT_FLAGS,
+  REPORT_TEMPERATURE,
+  REPORT_HUMIDITY,
+  REPORT_LUX,
+  REPORT_DISTANCE,
+  REPORT_REASON_COUNT
+} ReportReason;
+
+struct ReportFilter {
+  ReportDeadbands deadbands;
+  bool hasReference;
+  SensorSample reference;     // Last reported sample
+  uint32_t checked;
+  uint32_t reasons[REPORT_REASON_COUNT];  // reasons[REPORT_SUPPRESSED] counts suppressed samples
+};
+
+void reportDefaultDeadbands(ReportDeadbands* deadbands);
+void reportFilterInit(ReportFilter* filter, const ReportDeadbands* deadbands);
+// Forget the reference so the next sample is reported (e.g. after a reboot)
+void reportFilterReset(ReportFilter* filter);
+
+// Returns REPORT_SUPPRESSED or why the sample must be sent; a sent sample
+// becomes the new reference
+ReportReason reportFilterCheck(ReportFilter* filter, const SensorSample* sample);
+const char* reportReasonName(ReportReason reason);
@@ -0,0 +1,95 @@
+/**
+ * SampleScheduler.h - Adaptive per-channel sensor sampling
+ * 
+ * Copyright (C) 2025 Michael Garcia, M&E Design
+ * Based on original .ino by Geoff Mcintyre of Mr.Industries (https://mr.industries/)
+ * 
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ * 
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU General Public License for more details.
+ * 
+ * You should have received a copy of the GNU General Public License
+ * along with this program. If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#pragma once
+#include <Arduino.h>
+#include "SensorSample.h"
+#include "TimerWheel.h"
+
+/**
+ * Adaptive per-channel sampling
+ *
+ * Temperature, humidity and lux each have their own sampling period, kept
+ * as a timer on a TimerWheel that SensorTask sleeps on. After every
+ * reading the channel's period adapts:
+ *
+ *   change beyond the band      back to the channel's minimum period
+ *   SAMPLE_STABLE_READINGS
+ *   readings within the band    period doubled, up to the maximum
+ *   no reading                  period kept, stable count restarted
+ *
+ * Changes are judged on the readings before filtering: a step that the
+ * Hampel stage is still holding back, or a glitch, speeds the channel up
+ * so it is confirmed or rejected within seconds. A reading only counts as
+ * stable once the filtered value has also caught up with it, so the EMA
+ * settles at the fast rate. The bands are below the report deadbands, so
+ * a channel speeds up before its value drifts far enough to be reported. Channels that come due
+ * together are read in one pass so the TSL2561 integration still overlaps
+ * the HTU21D-F conversions. "sampling fixed" pins every channel to its
+ * minimum period (the old 1 Hz lockstep).
+ *
+ * All functions are thread-safe. SensorTask calls sampleSchedulerDue(),
+ * sampleSchedulerUpdate() and sampleSchedulerWait(); the rest are for the
+ * command task.
+ */
+
+#define SAMPLE_TICK_MS 50              // Timer wheel resolution
+#define SAMPLE_STABLE_READINGS 4       // Stable readings before the period doubles
+
+typedef enum {
+  SAMPLE_TEMPERATURE = 0,
+  SAMPLE_HUMIDITY,
+  SAMPLE_LUX,
+  SAMPLE_CHANNEL_COUNT
+} SampleChannel;
+
+struct SampleRate {
+  uint32_t minPeriodMs;
+  uint32_t maxPeriodMs;
+  uint16_t band;                 // Change that resets the period, in channel units
+  uint8_t bandPercent;           // Lux: relative band, with band as the floor
+};
+
+struct SampleChannelStats {
+  uint32_t periodMs;             // Current period
+  uint32_t readings;
+  uint32_t speedUps;             // Changes that reset the period
+  uint32_t slowDowns;
+};
+
+bool initSampleScheduler();
+// Channels due now as TELEMETRY_FLAG_* bits (0 if none)
+uint8_t sampleSchedulerDue();
+// Feed back a pass over the due channels: the readings before and after
+// the channel filters, with flags for the ones that succeeded
+void sampleSchedulerUpdate(uint8_t channels, const SensorSample& raw, const SensorSample& filtered);
+// Sleep until the next channel is due or sampleSchedulerWake() is called
+void sampleSchedulerWait();
+void sampleSchedulerWake();
+// Make the channels due now and wake SensorTask, for a reading on demand;
+// their periods are kept
+void sampleSchedulerRequest(uint8_t channels);
+
+void setSampleAdaptive(bool adaptive);
+bool getSampleAdaptive();
+void getSampleChannelStats(SampleChannel channel, SampleChannelStats* stats);
+void printSampleScheduler();
+
+const char* sampleChannelName(SampleChannel channel);
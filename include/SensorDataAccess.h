@@ -24,15 +24,32 @@
 #include "freertos/FreeRTOS.h"
 #include "freertos/semphr.h"
 
-// Safe sensor data access functions
-bool getSensorTemperature(int* temp);
-bool getSensorHumidity(float* humidity);
-bool getSensorLux(int* lux);
-bool getSensorDistance(float* distance);
-bool getAllSensorData(int* temp, float* humidity, int* lux, float* distance);
+/**
+ * Sensor data access
+ *
+ * Readers copy a consistent snapshot of GlobalContext::sensors through a
+ * sequence lock and never block or time out. Writers must wrap updates in
+ * beginSensorDataUpdate()/endSensorDataUpdate(), which serializes them on
+ * sensorDataMutex; keep the section short since readers retry while it is
+ * open.
+ */
+bool beginSensorDataUpdate();
+void endSensorDataUpdate();
+void readSensorSnapshot(SensorData* dest);
+
+// Writer lock hold times, for checking that no slow work runs under it
+struct SensorLockStats {
+  uint32_t updates;
+  uint32_t lastHoldUs;
+  uint32_t maxHoldUs;
+  uint64_t totalHoldUs;
+};
+
+void getSensorLockStats(SensorLockStats* stats);
+void printSensorLockStats();
 
-bool setSensorDistance(float distance);
-bool updateSensorTimestamp(unsigned long* lastUpdate);
+// Newest ESP-NOW distance, 0.01 in; sets TELEMETRY_FLAG_DISTANCE
+bool setSensorDistance(uint16_t distanceCenti);
 
 // Bulk operations
 bool copySensorDataSafe(SensorData* dest);
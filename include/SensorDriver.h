@@ -0,0 +1,111 @@
+/**
+ * SensorDriver.h - Sensor driver interface and compile-time registry
+ * 
+ * Copyright (C) 2025 Michael Garcia, M&E Design
+ * Based on original .ino by Geoff Mcintyre of Mr.Industries (https://mr.industries/)
+ * 
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ * 
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU General Public License for more details.
+ * 
+ * You should have received a copy of the GNU General Public License
+ * along with this program. If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#pragma once
+#include <Arduino.h>
+#include "SensorSample.h"
+
+/**
+ * Sensor driver interface and compile-time registry
+ *
+ * A driver is a class with only static members, so calls through the
+ * registry are direct and inline; there are no driver objects, vtables or
+ * allocation on the sampling path. Each driver provides:
+ *
+ *   static constexpr uint8_t CHANNELS;   TELEMETRY_FLAG_* bits it produces
+ *   static bool probe();                 detect and configure at boot
+ *   static void start(uint8_t channels); begin conversions for the given
+ *                                        subset of CHANNELS
+ *   static uint32_t poll();              advance the conversions (reading
+ *                                        the device as results come in);
+ *                                        ms until the next poll is worth
+ *                                        doing, or SENSOR_POLL_DONE
+ *   static void read(SensorSample* s);   store the valid results of the
+ *                                        pass, setting their flags, and
+ *                                        forget them; no I/O
+ *
+ * Drivers talk to the bus through queued I2cBus transactions. While one is
+ * outstanding poll() returns SENSOR_POLL_BUS_MS; the callback of the last
+ * transaction in a batch calls sensorDriverNotify() so the pass polls
+ * again as soon as the batch completes rather than when the wait runs out.
+ *
+ * A driver that was not probed successfully returns SENSOR_POLL_DONE and
+ * reads nothing. Drivers belong to the task that samples them.
+ *
+ * SensorRegistry<A, B, ...> combines drivers into one driver with the same
+ * members. start() reaches drivers in list order, so a driver whose
+ * conversion runs unattended (the TSL2561 integration) should come first
+ * to overlap the others; poll() returns the shortest wait of the drivers
+ * still busy. A pass over a registry is:
+ *
+ *   Registry::start(channels);
+ *   while ((waitMs = Registry::poll()) != SENSOR_POLL_DONE) sleep until
+ *     sensorDriverNotify() or waitMs;
+ *   Registry::read(&sample);
+ */
+
+#define SENSOR_POLL_DONE 0
+#define SENSOR_POLL_BUS_MS 10          // Upper bound on a wait for a bus transaction
+
+// Wake the acquisition pass; safe to call from I2cTask callbacks
+void sensorDriverNotify();
+
+template <typename... Drivers>
+struct SensorRegistry;
+
+template <>
+struct SensorRegistry<> {
+  static constexpr uint8_t CHANNELS = 0;
+  static bool probe() { return true; }
+  static void start(uint8_t) {}
+  static uint32_t poll() { return SENSOR_POLL_DONE; }
+  static void read(SensorSample*) {}
+};
+
+template <typename First, typename... Rest>
+struct SensorRegistry<First, Rest...> {
+  typedef SensorRegistry<Rest...> Others;
+  static constexpr uint8_t CHANNELS = First::CHANNELS | Others::CHANNELS;
+  static_assert((First::CHANNELS & Others::CHANNELS) == 0, "two drivers produce the same channel");
+
+  // True if every driver was found
+  static bool probe() {
+    bool found = First::probe();
+    return Others::probe() && found;
+  }
+
+  static void start(uint8_t channels) {
+    if (channels & First::CHANNELS) First::start(channels & First::CHANNELS);
+    Others::start(channels);
+  }
+
+  static uint32_t poll() {
+    uint32_t first = First::poll();
+    uint32_t others = Others::poll();
+    if (first == SENSOR_POLL_DONE) return others;
+    if (others == SENSOR_POLL_DONE) return first;
+    return first < others ? first : others;
+  }
+
+  static void read(SensorSample* sample) {
+    First::read(sample);
+    Others::read(sample);
+  }
+};
@@ -0,0 +1,103 @@
+/**
+ * SensorSample.h - Fixed-point sensor sample layout
+ * 
+ * Copyright (C) 2025 Michael Garcia, M&E Design
+ * Based on original .ino by Geoff Mcintyre of Mr.Industries (https://mr.industries/)
+ * 
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ * 
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU General Public License for more details.
+ * 
+ * You should have received a copy of the GNU General Public License
+ * along with this program. If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#pragma once
+#include <stdint.h>
+#include "TelemetryFrame.h"
+
+/**
+ * Canonical sensor sample
+ *
+ * One fixed-point layout shared by SensorTask, the seqlocked snapshot in
+ * GlobalContext, the report filter, the backlog, the LoRa encoders and the
+ * logger, so a reading is scaled once when it is acquired and never goes
+ * back through float on its way out. Units match the binary telemetry
+ * frame (TelemetryFrame.h), which lets the encoders copy fields as they
+ * are. Like TelemetryFrame, this has no Arduino dependencies.
+ *
+ * A field only holds a reading when its TELEMETRY_FLAG_* bit is set; a
+ * field whose latest conversion failed keeps its last value with the bit
+ * cleared.
+ */
+
+struct SensorSample {
+  uint32_t timestamp;         // millis() of the acquisition pass
+  int16_t temperatureCenti;   // 0.01 °C
+  uint16_t humidityCenti;     // 0.01 %RH
+  uint16_t lux;               // lx, saturates at 65535
+  uint16_t distanceCenti;     // 0.01 in, newest ESP-NOW distance
+  uint8_t flags;              // TELEMETRY_FLAG_*
+};
+
+/**
+ * Channel descriptors
+ *
+ * One entry per SensorSample field, in frame order. Code that handles
+ * every channel alike (the serial printout, the hub definition and ASCII
+ * packets, the sample scheduler) walks this table instead of naming the
+ * fields, so a channel is described in one place. The table and accessors
+ * are constexpr/inline and resolve to plain field accesses.
+ */
+
+typedef enum {
+  SENSOR_CHANNEL_TEMPERATURE = 0,
+  SENSOR_CHANNEL_HUMIDITY,
+  SENSOR_CHANNEL_LUX,
+  SENSOR_CHANNEL_DISTANCE,
+  SENSOR_CHANNEL_COUNT
+} SensorChannelId;
+
+struct SensorChannelInfo {
+  uint8_t flag;               // TELEMETRY_FLAG_*
+  const char* name;           // Hub definition and serial printout
+  const char* unit;           // Appended to printed values
+  uint8_t decimals;           // Fixed-point decimals of the stored value
+  uint8_t asciiDecimals;      // Decimals in PD> packets; 0 truncates
+  uint8_t hubType;            // Gateway type code in the hub definition
+};
+
+static constexpr SensorChannelInfo sensorChannels[SENSOR_CHANNEL_COUNT] = {
+  {TELEMETRY_FLAG_TEMPERATURE, "Temperature", "°C", 2, 0, 1},
+  {TELEMETRY_FLAG_HUMIDITY,    "Humidity",    "%",  2, 1, 2},
+  {TELEMETRY_FLAG_LUX,         "Lux",         "",   0, 0, 1},
+  {TELEMETRY_FLAG_DISTANCE,    "Distance",    " in", 2, 2, 2},
+};
+
+inline int32_t sensorChannelValue(const SensorSample& sample, SensorChannelId channel) {
+  switch (channel) {
+    case SENSOR_CHANNEL_TEMPERATURE: return sample.temperatureCenti;
+    case SENSOR_CHANNEL_HUMIDITY:    return sample.humidityCenti;
+    case SENSOR_CHANNEL_LUX:         return sample.lux;
+    case SENSOR_CHANNEL_DISTANCE:    return sample.distanceCenti;
+    default:                         return 0;
+  }
+}
+
+// Stores the value and sets the channel's flag
+inline void setSensorChannelValue(SensorSample* sample, SensorChannelId channel, int32_t value) {
+  switch (channel) {
+    case SENSOR_CHANNEL_TEMPERATURE: sample->temperatureCenti = (int16_t)value; break;
+    case SENSOR_CHANNEL_HUMIDITY:    sample->humidityCenti = (uint16_t)value; break;
+    case SENSOR_CHANNEL_LUX:         sample->lux = (uint16_t)value; break;
+    case SENSOR_CHANNEL_DISTANCE:    sample->distanceCenti = (uint16_t)value; break;
+    default:                         return;
+  }
+  sample->flags |= sensorChannels[channel].flag;
+}
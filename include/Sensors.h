@@ -21,14 +21,36 @@
 #pragma once
 #include <Arduino.h>
 #include <Wire.h>
-#include <Adafruit_Sensor.h>
-#include <Adafruit_TSL2561_U.h>
-#include <Adafruit_HTU21DF.h>
 #include "pins.h"
+#include "SensorSample.h"
+#include "SensorDriver.h"
+#include "Tsl2561Driver.h"
+#include "Htu21dfDriver.h"
 
-#define ENVIRONMENTAL_SENSOR_INTERVAL 1000
+// Drivers sampled by SensorTask. The TSL2561 comes first so its
+// integration overlaps the HTU21D-F conversions; a new sensor is a driver
+// class added here plus its channel descriptor in SensorSample.h.
+typedef SensorRegistry<Tsl2561Driver, Htu21dfDriver> EnvironmentalSensors;
 
-void initializeSensors();
-void configureTSL2561();
-void readEnvironmentalSensors();
-void printCurrentSensorValues();
\ No newline at end of file
+// Channels read by SensorTask, as TELEMETRY_FLAG_* bits; each is scheduled
+// on its own period by SampleScheduler
+#define SENSOR_CHANNELS_ENVIRONMENTAL (EnvironmentalSensors::CHANNELS)
+
+// The duty-cycled mode skips the bus scan (DutyCycle.h)
+void initializeSensors(bool scanBus = true);
+// The drivers, their queued transactions and the filters belong to
+// SensorTask; only setup() calls this, before the task starts. Other tasks
+// ask for a pass with sampleSchedulerRequest().
+void readEnvironmentalSensors(uint8_t channels = SENSOR_CHANNELS_ENVIRONMENTAL);
+void printCurrentSensorValues();
+
+// Pipeline used by readEnvironmentalSensors(): acquisition runs the
+// registry's conversions for the requested channels and yields while they
+// complete, scaling the raw codes straight to fixed point without touching
+// shared state; the filter stage passes each valid field through its channel
+// filter (SignalFilter.h); publication copies the requested channels into
+// GlobalContext in one short write section.
+void acquireEnvironmentalSample(SensorSample* sample, uint8_t channels = SENSOR_CHANNELS_ENVIRONMENTAL);
+void filterEnvironmentalSample(SensorSample* sample);
+void publishEnvironmentalSample(const SensorSample& sample, uint8_t channels = SENSOR_CHANNELS_ENVIRONMENTAL);
+void printSensorFilterStats();
\ No newline at end of file
@@ -0,0 +1,76 @@
+/**
+ * SeqLock.h - Single-writer sequence lock for shared snapshots
+ * 
+ * Copyright (C) 2025 Michael Garcia, M&E Design
+ * Based on original .ino by Geoff Mcintyre of Mr.Industries (https://mr.industries/)
+ * 
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ * 
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU General Public License for more details.
+ * 
+ * You should have received a copy of the GNU General Public License
+ * along with this program. If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#pragma once
+#include <Arduino.h>
+#include <atomic>
+#include <string.h>
+
+/**
+ * Sequence lock for small shared structures
+ *
+ * Writers bump the sequence to an odd value, modify the data and bump it
+ * back to even. Readers copy the data without taking any lock and retry
+ * if the sequence was odd or changed during the copy, so they never block
+ * on a writer and a writer never waits for readers.
+ *
+ * The lock does not serialize writers; callers with more than one writer
+ * must hold a mutex across beginWrite()/endWrite(). The protected data
+ * must be trivially copyable and is kept outside the lock so existing
+ * structures (e.g. GlobalContext::sensors) can be covered in place.
+ */
+
+// Retries before a reader yields instead of spinning, so a reader that
+// preempted a lower-priority writer mid-update lets it finish
+#define SEQLOCK_SPIN_LIMIT 64
+
+class SeqLock {
+ public:
+  void beginWrite() {
+    sequence.store(sequence.load(std::memory_order_relaxed) + 1, std::memory_order_relaxed);
+    std::atomic_thread_fence(std::memory_order_release);
+  }
+
+  void endWrite() {
+    sequence.store(sequence.load(std::memory_order_relaxed) + 1, std::memory_order_release);
+  }
+
+  // Copies a consistent snapshot of src into dest; returns the number of retries
+  template <typename T>
+  uint32_t read(T* dest, const T& src) const {
+    uint32_t retries = 0;
+    while (true) {
+      uint32_t start = sequence.load(std::memory_order_acquire);
+      if ((start & 1) == 0) {
+        memcpy((void*)dest, (const void*)&src, sizeof(T));
+        std::atomic_thread_fence(std::memory_order_acquire);
+        if (sequence.load(std::memory_order_relaxed) == start) return retries;
+      }
+      if (++retries % SEQLOCK_SPIN_LIMIT == 0) {
+        vTaskDelay(1);
+      }
+    }
+  }
+
+  uint32_t version() const { return sequence.load(std::memory_order_acquire); }
+
+ private:
+  std::atomic<uint32_t> sequence{0};
+};
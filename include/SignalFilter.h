@@ -0,0 +1,232 @@
+/**
+ * SignalFilter.h - Streaming median, EMA and Hampel filters for sensor channels
+ * 
+ * Copyright (C) 2025 Michael Garcia, M&E Design
+ * Based on original .ino by Geoff Mcintyre of Mr.Industries (https://mr.industries/)
+ * 
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ * 
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU General Public License for more details.
+ * 
+ * You should have received a copy of the GNU General Public License
+ * along with this program. If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#pragma once
+#include <Arduino.h>
+#include <stdlib.h>
+
+/**
+ * Streaming filters for sensor channels
+ *
+ * Each filter takes one sample per update() and returns the filtered
+ * value. Window sizes and coefficients are template parameters, so a
+ * filter is a small fixed-size object with no allocation and its update
+ * inlines into the caller. Values are the fixed-point integers of
+ * SensorSample (e.g. 0.01 °C); intermediate math is done in 32 bits.
+ *
+ * Filters are not thread-safe; each instance belongs to the task that
+ * produces its channel.
+ */
+
+// Running median of the last N samples. The window is kept in arrival
+// order and as a sorted copy; each update moves the slot of the sample
+// leaving the window to where the new sample belongs, so it costs at most
+// N moves. Until the window fills, the median is taken over what it holds.
+template <typename T, size_t N>
+class MedianFilter {
+  static_assert(N >= 3 && N % 2 == 1, "median window must be odd and at least 3");
+
+ public:
+  MedianFilter() { reset(); }
+
+  void reset() {
+    count = 0;
+    oldest = 0;
+  }
+
+  T update(T value) {
+    size_t i;
+    if (count < N) {
+      i = count++;
+    } else {
+      T leaving = window[oldest];
+      i = 0;
+      while (sorted[i] != leaving) i++;
+    }
+    window[oldest] = value;
+    if (++oldest == N) oldest = 0;
+
+    // Slide the free slot at i to the new sample's place in the sorted copy
+    while (i > 0 && sorted[i - 1] > value) {
+      sorted[i] = sorted[i - 1];
+      i--;
+    }
+    while (i + 1 < count && sorted[i + 1] < value) {
+      sorted[i] = sorted[i + 1];
+      i++;
+    }
+    sorted[i] = value;
+    return median();
+  }
+
+  T median() const { return sorted[(count - 1) / 2]; }
+
+  // Median absolute deviation from the median: the deviations below and
+  // above the median are each already ordered in the sorted copy, so the
+  // middle one is found by merging the two runs outwards.
+  uint32_t deviation() const {
+    const size_t center = (count - 1) / 2;
+    const int32_t m = sorted[center];
+    size_t above = center;
+    size_t below = center;
+    uint32_t d = 0;
+    for (size_t k = 0; k <= center; k++) {
+      uint32_t up = above < count ? (uint32_t)((int32_t)sorted[above] - m) : UINT32_MAX;
+      uint32_t down = below > 0 ? (uint32_t)(m - (int32_t)sorted[below - 1]) : UINT32_MAX;
+      if (up <= down) {
+        d = up;
+        above++;
+      } else {
+        d = down;
+        below--;
+      }
+    }
+    return d;
+  }
+
+  size_t size() const { return count; }
+  uint32_t outliers() const { return 0; }
+
+ private:
+  T window[N];
+  T sorted[N];
+  size_t count;
+  size_t oldest;
+};
+
+// Exponential moving average with alpha = 1 / 2^Shift. The state keeps
+// Shift extra fraction bits so small steps are not lost to rounding; the
+// first sample seeds it.
+template <typename T, unsigned Shift>
+class EmaFilter {
+  static_assert(Shift >= 1 && Shift <= 15, "EMA shift must be 1..15");
+
+ public:
+  EmaFilter() { reset(); }
+
+  void reset() {
+    state = 0;
+    seeded = false;
+  }
+
+  T update(T value) {
+    if (!seeded) {
+      state = (int32_t)value * (1 << Shift);
+      seeded = true;
+    } else {
+      state += (int32_t)value - output();
+    }
+    return output();
+  }
+
+  uint32_t outliers() const { return 0; }
+
+ private:
+  T output() const { return (T)((state + (1 << (Shift - 1))) >> Shift); }
+
+  int32_t state;
+  bool seeded;
+};
+
+// Hampel identifier over the last N samples: a sample further than
+// SigmaTenths / 10 estimated standard deviations (1.4826 x the median
+// absolute deviation) from the window median is replaced by the median.
+// Floor is the smallest deviation, in channel units, ever treated as an
+// outlier, so a flat signal's zero spread does not reject quantization
+// steps. The replaced sample stays in the window, so a genuine step is
+// accepted once it fills half the window.
+template <typename T, size_t N, unsigned SigmaTenths, uint32_t Floor>
+class HampelFilter {
+ public:
+  HampelFilter() { reset(); }
+
+  void reset() {
+    window.reset();
+    rejected = 0;
+  }
+
+  T update(T value) {
+    T median = window.update(value);
+    if (window.size() < 3) return value;
+
+    uint32_t limit = (uint32_t)(((uint64_t)window.deviation() * SigmaTenths * 14826 + 50000) / 100000);
+    if (limit < Floor) limit = Floor;
+    int32_t delta = (int32_t)value - (int32_t)median;
+    if ((uint32_t)abs(delta) <= limit) return value;
+
+    rejected++;
+    return median;
+  }
+
+  uint32_t outliers() const { return rejected; }
+
+ private:
+  MedianFilter<T, N> window;
+  uint32_t rejected;
+};
+
+// Filters applied in order, e.g.
+// FilterChain<int16_t, HampelFilter<int16_t, 7, 30, 20>, EmaFilter<int16_t, 2>>
+template <typename T, typename... Stages>
+class FilterChain;
+
+template <typename T>
+class FilterChain<T> {
+ public:
+  void reset() {}
+  T update(T value) { return value; }
+  uint32_t outliers() const { return 0; }
+};
+
+template <typename T, typename First, typename... Rest>
+class FilterChain<T, First, Rest...> {
+ public:
+  void reset() {
+    first.reset();
+    rest.reset();
+  }
+
+  T update(T value) { return rest.update(first.update(value)); }
+
+  // Samples replaced by any stage
+  uint32_t outliers() const { return first.outliers() + rest.outliers(); }
+
+ private:
+  First first;
+  FilterChain<T, Rest...> rest;
+};
+
+// -----------------------------------------------------------------------------
+// Channel filters
+// -----------------------------------------------------------------------------
+
+// Temperature and humidity (0.01 units, 1 Hz): reject spikes beyond 3
+// sigma but at least 0.20 °C / 0.50 %RH, then smooth with alpha 1/4
+typedef FilterChain<int16_t, HampelFilter<int16_t, 7, 30, 20>, EmaFilter<int16_t, 2> > TemperatureFilter;
+typedef FilterChain<uint16_t, HampelFilter<uint16_t, 7, 30, 50>, EmaFilter<uint16_t, 2> > HumidityFilter;
+
+// Lux (1 Hz): cloud edges are real steps, so only a median of 3 to drop
+// single-sample glitches at one sample of delay
+typedef FilterChain<uint16_t, MedianFilter<uint16_t, 3> > LuxFilter;
+
+// Distance (0.01 in, per ESP-NOW reading): ultrasonic echo glitches come
+// in runs of up to three; a window of 7 rejects them and lets a refill
+// through after four readings
+typedef FilterChain<uint16_t, HampelFilter<uint16_t, 7, 30, 50> > DistanceFilter;
@@ -34,9 +34,23 @@
 #define COMMS_TASK_STACK 4096
 #define COMMAND_TASK_STACK 2048
 
+// CommsTask sleeps on its event subscription until an event arrives or
+// the next LoRa deadline; the cap bounds the sleep should a wake be missed.
+// Without a subscription it polls.
+#define COMMS_MAX_SLEEP_MS 60000
+#define COMMS_POLL_MS 10
+
+struct CommsTaskStats {
+  uint32_t wakeups;        // Passes through the CommsTask loop
+  uint32_t eventWakeups;   // Woken by an event rather than a deadline
+  uint32_t longestSleepMs;
+};
+
 void createTasks();
 void sensorTask(void* parameter);
 void commsTask(void* parameter);
 void commandTask(void* parameter);
+void getCommsTaskStats(CommsTaskStats* stats);
+void printCommsTaskStats();
 
 extern SemaphoreHandle_t sensorDataMutex;
\ No newline at end of file
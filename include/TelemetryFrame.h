@@ -0,0 +1,230 @@
+/**
+ * TelemetryFrame.h - Binary LoRa telemetry frame format
+ * 
+ * Copyright (C) 2025 Michael Garcia, M&E Design
+ * Based on original .ino by Geoff Mcintyre of Mr.Industries (https://mr.industries/)
+ * 
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ * 
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU General Public License for more details.
+ * 
+ * You should have received a copy of the GNU General Public License
+ * along with this program. If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#pragma once
+#include <stdint.h>
+#include <stddef.h>
+
+/**
+ * Binary LoRa telemetry frame
+ *
+ * Fixed-layout, little-endian frame that replaces the ASCII "PD>" packet.
+ * The encoder and decoder have no Arduino dependencies so the same files
+ * can be dropped into the gateway build.
+ *
+ * Sensor data frame (version 2, 18 + 6 x peerCount bytes):
+ *
+ *   offset size field
+ *   0      1    version      TELEMETRY_FRAME_VERSION
+ *   1      1    type         FRAME_TYPE_SENSOR_DATA
+ *   2      2    hubId        replaces the hub name string
+ *   4      2    sequence     increments per frame, wraps at 65535
+ *   6      1    flags        TELEMETRY_FLAG_* validity bits
+ *   7      2    temperature  int16,  0.01 °C
+ *   9      2    humidity     uint16, 0.01 %RH
+ *   11     2    lux          uint16, 1 lx (saturates at 65535)
+ *   13     2    distance     uint16, 0.01 in (saturates at 655.35)
+ *   15     1    peerCount    ESP-NOW peer records that follow
+ *   16     6n   peers        per peer: id u16 (last two MAC bytes), kind u8,
+ *                            value uint16 0.01 units, age u8 seconds (saturates)
+ *   16+6n  2    crc          CRC-16/CCITT-FALSE over all preceding bytes
+ *
+ * The distance field carries the newest distance reading from any peer.
+ *
+ * Every frame type shares TELEMETRY_FRAME_VERSION and the decoders reject
+ * any other version, so a gateway built with the version 1 decoder drops
+ * all version 2 frames: upgrade the gateway together with the nodes.
+ *
+ * Hub info frame (sent once by createHub() so the gateway can map hubId
+ * to the names the ASCII "CH>" packet used to carry):
+ *
+ *   0      1    version
+ *   1      1    type         FRAME_TYPE_HUB_INFO
+ *   2      2    hubId
+ *   4      n    "name\0sensorNames\0types\0"
+ *   4+n    2    crc
+ *
+ * Batch frame (several samples in one packet, from batching or from the
+ * store-and-forward backlog; 21 bytes plus about 6 per extra sample):
+ *
+ *   0      1    version
+ *   1      1    type         FRAME_TYPE_BATCH
+ *   2      2    hubId
+ *   4      1    count        samples, 1..TELEMETRY_MAX_BATCH_SAMPLES
+ *   5      2    sequence     first sample
+ *   7      2    age          first sample, seconds before transmission
+ *                            (TELEMETRY_AGE_UNKNOWN if sampled before the
+ *                            last reboot: all ages in the frame are unknown)
+ *   9      1    flags        first sample
+ *   10     8    values       first sample: temperature, humidity, lux and
+ *                            distance as above
+ *   18     var  deltas       per further sample, varints relative to the
+ *                            sample before it:
+ *                              zigzag(sequence delta) << 4 | flags
+ *                              zigzag(age delta), 0.1 s, older minus newer
+ *                              zigzag(temperature, humidity, lux, distance
+ *                              deltas), each in 16-bit wraparound arithmetic
+ *   ...    1    peerCount    then peer records as in the sensor frame
+ *   ...    2    crc
+ *
+ * A delta record is at most TELEMETRY_BATCH_DELTA_MAX bytes, so a full
+ * batch always fits; peer records that do not fit are left out.
+ *
+ * History frame (rolled-up points of one channel from the hub's history,
+ * sent on request; about 5 bytes per point):
+ *
+ *   0      1    version
+ *   1      1    type         FRAME_TYPE_HISTORY
+ *   2      2    hubId
+ *   4      1    channel      TELEMETRY_FLAG_* bit of the field
+ *   5      2    interval     seconds per point (1 for raw samples)
+ *   7      4    age          first point's start, seconds before transmission
+ *   11     1    count        points that follow
+ *   12     var  points       per point, varints:
+ *                              gap in intervals since the previous point
+ *                              (0 for the first)
+ *                              zigzag(mean - previous mean), the first
+ *                              relative to 0
+ *                              mean - min, max - mean
+ *                              samples in the point
+ *   ...    2    crc
+ *
+ * Values are in the field's units above. Points that do not fit are left
+ * for the next frame; the encoder reports how many it took.
+ */
+
+#define TELEMETRY_FRAME_VERSION 2
+
+#define FRAME_TYPE_SENSOR_DATA 0x01
+#define FRAME_TYPE_HUB_INFO    0x02
+#define FRAME_TYPE_BATCH       0x03
+#define FRAME_TYPE_HISTORY     0x04
+
+#define TELEMETRY_FLAG_TEMPERATURE 0x01
+#define TELEMETRY_FLAG_HUMIDITY    0x02
+#define TELEMETRY_FLAG_LUX         0x04
+#define TELEMETRY_FLAG_DISTANCE    0x08
+
+#define TELEMETRY_HEADER_SIZE      4
+#define TELEMETRY_CRC_SIZE         2
+#define TELEMETRY_SENSOR_FRAME_SIZE 18   // Without peer records
+#define TELEMETRY_PEER_RECORD_SIZE 6
+#define TELEMETRY_MAX_PEERS        20   // ESP-NOW peer limit
+#define TELEMETRY_MAX_FRAME_SIZE   255
+#define TELEMETRY_BATCH_HEADER_SIZE 18  // Up to and including the first sample
+#define TELEMETRY_BATCH_DELTA_MAX  18   // Worst-case delta record
+#define TELEMETRY_MAX_BATCH_SAMPLES 12  // 18 + 11 x 18 + 3 bytes worst case
+#define TELEMETRY_AGE_UNKNOWN      0xFFFF
+#define TELEMETRY_AGE_UNKNOWN_MS   0xFFFFFFFFUL
+#define TELEMETRY_HISTORY_HEADER_SIZE 12
+#define TELEMETRY_HISTORY_POINT_MAX 17  // Worst-case point record
+#define TELEMETRY_MAX_HISTORY_POINTS 60
+
+// Peer record kinds, matching PeerKind on the hub
+#define TELEMETRY_PEER_DISTANCE    1    // 0.01 in
+#define TELEMETRY_PEER_SOIL        2    // 0.01 % volumetric moisture
+
+struct TelemetryPeerReading {
+  uint16_t id;                // mac[4] << 8 | mac[5]
+  uint8_t kind;
+  uint16_t valueCenti;
+  uint8_t ageSeconds;         // Time since the hub heard the peer
+};
+
+struct TelemetryReading {
+  uint16_t hubId;
+  uint16_t sequence;
+  uint8_t flags;
+  int16_t temperatureCenti;   // 0.01 °C
+  uint16_t humidityCenti;     // 0.01 %RH
+  uint16_t lux;               // lx
+  uint16_t distanceCenti;     // 0.01 in
+  uint8_t peerCount;
+  TelemetryPeerReading peers[TELEMETRY_MAX_PEERS];
+};
+
+// One sample of a batch frame
+struct TelemetrySample {
+  uint16_t sequence;
+  uint32_t ageMs;             // TELEMETRY_AGE_UNKNOWN_MS if sampled before the last reboot
+  uint8_t flags;
+  int16_t temperatureCenti;
+  uint16_t humidityCenti;
+  uint16_t lux;
+  uint16_t distanceCenti;
+};
+
+struct TelemetryBatch {
+  uint16_t hubId;
+  uint8_t sampleCount;
+  TelemetrySample samples[TELEMETRY_MAX_BATCH_SAMPLES];
+  uint8_t peerCount;
+  TelemetryPeerReading peers[TELEMETRY_MAX_PEERS];
+};
+
+// One point of a history frame
+struct TelemetryHistoryPoint {
+  uint32_t ageMs;             // Start of the point, before transmission
+  int32_t min;
+  int32_t max;
+  int32_t mean;
+  uint16_t count;
+};
+
+struct TelemetryHistory {
+  uint16_t hubId;
+  uint8_t channel;            // TELEMETRY_FLAG_*
+  uint16_t intervalSeconds;
+  uint8_t pointCount;
+  TelemetryHistoryPoint points[TELEMETRY_MAX_HISTORY_POINTS];
+};
+
+struct HubInfo {
+  uint16_t hubId;
+  const char* name;          // Points into the decoded buffer
+  const char* sensorNames;
+  const char* types;
+};
+
+// Scaling helpers: round to the nearest step and saturate to the field range
+int16_t telemetryScaleTemperature(float celsius);
+uint16_t telemetryScaleHumidity(float percent);
+uint16_t telemetryScaleLux(int lux);
+uint16_t telemetryScaleDistance(float inches);
+
+// Frame encoding; return the number of bytes written, or 0 if the buffer is too small
+size_t encodeSensorFrame(const TelemetryReading* reading, uint8_t* buffer, size_t bufferSize);
+size_t encodeHubInfoFrame(uint16_t hubId, const char* name, const char* sensorNames,
+                          const char* types, uint8_t* buffer, size_t bufferSize);
+size_t encodeBatchFrame(const TelemetryBatch* batch, uint8_t* buffer, size_t bufferSize);
+// Encodes as many points as fit and stores that number in *encodedPoints
+size_t encodeHistoryFrame(const TelemetryHistory* history, uint8_t* buffer, size_t bufferSize,
+                          uint8_t* encodedPoints);
+
+// Frame decoding; return false on short frames, unknown version/type or CRC mismatch
+uint8_t telemetryFrameType(const uint8_t* buffer, size_t length);
+bool decodeSensorFrame(const uint8_t* buffer, size_t length, TelemetryReading* reading);
+bool decodeHubInfoFrame(const uint8_t* buffer, size_t length, HubInfo* info);
+// Ages come back at 0.1 s resolution relative to a whole-second first age
+bool decodeBatchFrame(const uint8_t* buffer, size_t length, TelemetryBatch* batch);
+// Ages come back at the point interval resolution relative to the first age
+bool decodeHistoryFrame(const uint8_t* buffer, size_t length, TelemetryHistory* history);
+
+uint16_t telemetryCrc16(const uint8_t* data, size_t length);
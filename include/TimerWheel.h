@@ -0,0 +1,64 @@
+/**
+ * TimerWheel.h - Hashed timer wheel for per-channel timers
+ * 
+ * Copyright (C) 2025 Michael Garcia, M&E Design
+ * Based on original .ino by Geoff Mcintyre of Mr.Industries (https://mr.industries/)
+ * 
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ * 
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU General Public License for more details.
+ * 
+ * You should have received a copy of the GNU General Public License
+ * along with this program. If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#pragma once
+#include <Arduino.h>
+
+/**
+ * Hashed timer wheel
+ *
+ * Timers hash into TIMER_WHEEL_SLOTS slots by their expiry tick and are
+ * kept in a singly-linked list per slot, so arming and cancelling are O(1)
+ * and advancing costs one slot visit per elapsed tick (at most one full
+ * turn) plus the timers in the visited slots. A timer due more than a turn
+ * ahead simply stays in its slot until the turn in which it expires.
+ *
+ * Ticks are whatever unit the owner chooses (SampleScheduler uses
+ * SAMPLE_TICK_MS); comparisons are wrap-safe over 2^31 ticks. Timers are
+ * owned by the caller and must stay valid while armed. The wheel is not
+ * thread-safe; no Arduino dependencies.
+ */
+
+#define TIMER_WHEEL_SLOTS 64    // Power of two
+
+struct WheelTimer {
+  WheelTimer* next;
+  uint32_t expiresTick;
+  bool armed;
+  uint8_t id;                   // Owner's tag, e.g. a channel number
+};
+
+struct TimerWheel {
+  WheelTimer* slots[TIMER_WHEEL_SLOTS];
+  uint32_t tick;                // Next tick to be processed
+  size_t armed;
+};
+
+void timerWheelInit(TimerWheel* wheel, uint32_t nowTick);
+// A timer armed for a tick already processed fires on the next advance
+void timerWheelArm(TimerWheel* wheel, WheelTimer* timer, uint32_t expiresTick);
+void timerWheelCancel(TimerWheel* wheel, WheelTimer* timer);
+// Process every tick up to and including nowTick; expired timers are
+// disarmed and returned in expiry order within a slot visit. Returns how
+// many were written; timers beyond maxExpired stay armed for the next call.
+size_t timerWheelAdvance(TimerWheel* wheel, uint32_t nowTick, WheelTimer** expired, size_t maxExpired);
+// Ticks from the next unprocessed tick until the earliest armed timer
+// (0 if one is already due), or UINT32_MAX if none is armed
+uint32_t timerWheelNextExpiry(const TimerWheel* wheel);
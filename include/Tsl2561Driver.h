@@ -0,0 +1,85 @@
+/**
+ * Tsl2561Driver.h - TSL2561 light sensor driver with auto-ranging
+ * 
+ * Copyright (C) 2025 Michael Garcia, M&E Design
+ * Based on original .ino by Geoff Mcintyre of Mr.Industries (https://mr.industries/)
+ * 
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ * 
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU General Public License for more details.
+ * 
+ * You should have received a copy of the GNU General Public License
+ * along with this program. If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#pragma once
+#include <Arduino.h>
+#include <Wire.h>
+#include <Adafruit_Sensor.h>
+#include <Adafruit_TSL2561_U.h>
+#include "SensorDriver.h"
+
+/**
+ * TSL2561 light sensor driver (SensorDriver.h)
+ *
+ * start() queues the power-up, which starts an integration in the current
+ * range; poll() queues the reads of both channels and the power-down
+ * back to back once it completes. Range changes go through the Adafruit
+ * driver under i2cBusLock().
+ *
+ * Gain and integration are auto-ranged: after each reading the next range
+ * is the fastest one whose predicted broadband count, scaled from this
+ * reading, is at least LIGHT_MIN_COUNTS (0.5 % resolution) and at most
+ * half the range's clip level, so light can double before the next reading
+ * saturates. Darker than every range allows uses the most sensitive one,
+ * brighter the least. A saturated reading is converted again at 13 ms / 1x
+ * in the same pass. "light fixed" pins the old 101 ms / 16x range.
+ */
+
+// ADC settling margin after the integration time
+#define TSL2561_SETTLE_MS           5
+#define LIGHT_MIN_COUNTS            200
+
+typedef enum {
+  LIGHT_RANGE_13MS_1X = 0,
+  LIGHT_RANGE_13MS_16X,
+  LIGHT_RANGE_101MS_1X,
+  LIGHT_RANGE_101MS_16X,
+  LIGHT_RANGE_402MS_1X,
+  LIGHT_RANGE_402MS_16X,
+  LIGHT_RANGE_COUNT
+} LightRange;
+
+struct LightStats {
+  uint32_t conversions;
+  uint32_t integrationMs;        // Sum over all conversions
+  uint32_t saturated;            // Conversions clipped at the range's limit
+  uint32_t retries;              // Saturated conversions repeated at 13 ms / 1x
+  uint32_t rangeChanges;
+  uint32_t rangeUses[LIGHT_RANGE_COUNT];
+  LightRange range;              // Range of the next conversion
+};
+
+class Tsl2561Driver {
+ public:
+  static constexpr uint8_t CHANNELS = TELEMETRY_FLAG_LUX;
+
+  static bool probe();
+  static void start(uint8_t channels);
+  static uint32_t poll();
+  static void read(SensorSample* sample);
+};
+
+// Program the current range into the Adafruit driver
+void configureTSL2561();
+void setLightAutoRange(bool enabled);
+bool getLightAutoRange();
+void getLightStats(LightStats* stats);
+void printLightStats();
+const char* lightRangeName(LightRange range);
@@ -0,0 +1,65 @@
+/**
+ * Adafruit_HTU21DF.cpp - Simulated HTU21D-F driver
+ * 
+ * Copyright (C) 2025 Michael Garcia, M&E Design
+ * Based on original .ino by Geoff Mcintyre of Mr.Industries (https://mr.industries/)
+ * 
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ * 
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU General Public License for more details.
+ * 
+ * You should have received a copy of the GNU General Public License
+ * along with this program. If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#include "Adafruit_HTU21DF.h"
+
+bool Adafruit_HTU21DF::begin(TwoWire* theWire) {
+  wire = theWire;
+  reset();
+
+  wire->beginTransmission(HTU21DF_I2CADDR);
+  wire->write(HTU21DF_READREG);
+  if (wire->endTransmission() != 0) return false;
+  if (wire->requestFrom(HTU21DF_I2CADDR, 1) != 1) return false;
+  return wire->read() == 0x02;
+}
+
+void Adafruit_HTU21DF::reset() {
+  wire->beginTransmission(HTU21DF_I2CADDR);
+  wire->write(HTU21DF_RESET);
+  wire->endTransmission();
+  delay(15);
+}
+
+bool Adafruit_HTU21DF::readRaw(uint8_t command, uint16_t* raw) {
+  wire->beginTransmission(HTU21DF_I2CADDR);
+  wire->write(command);
+  if (wire->endTransmission() != 0) return false;
+
+  // Hold-master read: the device stretches SCL until the conversion is done.
+  if (wire->requestFrom(HTU21DF_I2CADDR, 3) != 3) return false;
+  uint16_t value = (uint16_t)(wire->read() << 8);
+  value |= (uint16_t)wire->read();
+  wire->read();
+  *raw = value;
+  return true;
+}
+
+float Adafruit_HTU21DF::readTemperature() {
+  uint16_t raw;
+  if (!readRaw(HTU21DF_READTEMP, &raw)) return NAN;
+  return (float)(raw & 0xFFFC) * 175.72f / 65536.0f - 46.85f;
+}
+
+float Adafruit_HTU21DF::readHumidity() {
+  uint16_t raw;
+  if (!readRaw(HTU21DF_READHUM, &raw)) return NAN;
+  return (float)(raw & 0xFFFC) * 125.0f / 65536.0f - 6.0f;
+}
@@ -0,0 +1,45 @@
+/**
+ * Adafruit_HTU21DF.h - Simulated HTU21D-F driver interface
+ * 
+ * Copyright (C) 2025 Michael Garcia, M&E Design
+ * Based on original .ino by Geoff Mcintyre of Mr.Industries (https://mr.industries/)
+ * 
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ * 
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU General Public License for more details.
+ * 
+ * You should have received a copy of the GNU General Public License
+ * along with this program. If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#pragma once
+#include "Arduino.h"
+#include "Wire.h"
+
+#define HTU21DF_I2CADDR  0x40
+#define HTU21DF_READTEMP 0xE3
+#define HTU21DF_READHUM  0xE5
+#define HTU21DF_WRITEREG 0xE6
+#define HTU21DF_READREG  0xE7
+#define HTU21DF_RESET    0xFE
+
+// Host stand-in for the Adafruit HTU21DF driver, talking to the simulated
+// device over the simulated Wire bus with the same command sequence.
+class Adafruit_HTU21DF {
+ public:
+  Adafruit_HTU21DF() {}
+  bool begin(TwoWire* theWire = &Wire);
+  void reset();
+  float readTemperature();
+  float readHumidity();
+
+ private:
+  bool readRaw(uint8_t command, uint16_t* raw);
+  TwoWire* wire = &Wire;
+};
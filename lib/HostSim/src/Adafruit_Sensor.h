@@ -0,0 +1,62 @@
+/**
+ * Adafruit_Sensor.h - Unified sensor types for the host build
+ * 
+ * Copyright (C) 2025 Michael Garcia, M&E Design
+ * Based on original .ino by Geoff Mcintyre of Mr.Industries (https://mr.industries/)
+ * 
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ * 
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU General Public License for more details.
+ * 
+ * You should have received a copy of the GNU General Public License
+ * along with this program. If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#pragma once
+#include "Arduino.h"
+
+// Minimal Adafruit Unified Sensor types for the simulated drivers.
+
+typedef enum {
+  SENSOR_TYPE_LIGHT = 5,
+  SENSOR_TYPE_RELATIVE_HUMIDITY = 12,
+  SENSOR_TYPE_AMBIENT_TEMPERATURE = 13
+} sensors_type_t;
+
+typedef struct {
+  int32_t version;
+  int32_t sensor_id;
+  int32_t type;
+  int32_t reserved0;
+  int32_t timestamp;
+  union {
+    float data[4];
+    float temperature;
+    float relative_humidity;
+    float light;
+  };
+} sensors_event_t;
+
+typedef struct {
+  char name[12];
+  int32_t version;
+  int32_t sensor_id;
+  int32_t type;
+  float max_value;
+  float min_value;
+  float resolution;
+  int32_t min_delay;
+} sensor_t;
+
+class Adafruit_Sensor {
+ public:
+  virtual ~Adafruit_Sensor() {}
+  virtual bool getEvent(sensors_event_t*) = 0;
+  virtual void getSensor(sensor_t*) = 0;
+};
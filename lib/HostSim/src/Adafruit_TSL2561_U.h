@@ -0,0 +1,95 @@
+/**
+ * Adafruit_TSL2561_U.h - Simulated TSL2561 driver interface
+ * 
+ * Copyright (C) 2025 Michael Garcia, M&E Design
+ * Based on original .ino by Geoff Mcintyre of Mr.Industries (https://mr.industries/)
+ * 
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ * 
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU General Public License for more details.
+ * 
+ * You should have received a copy of the GNU General Public License
+ * along with this program. If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#pragma once
+#include "Arduino.h"
+#include "Wire.h"
+#include "Adafruit_Sensor.h"
+
+#define TSL2561_ADDR_LOW   0x29
+#define TSL2561_ADDR_FLOAT 0x39
+#define TSL2561_ADDR_HIGH  0x49
+
+#define TSL2561_COMMAND_BIT      0x80
+#define TSL2561_CLEAR_BIT        0x40
+#define TSL2561_WORD_BIT         0x20
+#define TSL2561_BLOCK_BIT        0x10
+#define TSL2561_CONTROL_POWERON  0x03
+#define TSL2561_CONTROL_POWEROFF 0x00
+
+#define TSL2561_REGISTER_CONTROL    0x00
+#define TSL2561_REGISTER_TIMING     0x01
+#define TSL2561_REGISTER_ID         0x0A
+#define TSL2561_REGISTER_CHAN0_LOW  0x0C
+#define TSL2561_REGISTER_CHAN1_LOW  0x0E
+
+#define TSL2561_DELAY_INTTIME_13MS  15
+#define TSL2561_DELAY_INTTIME_101MS 120
+#define TSL2561_DELAY_INTTIME_402MS 450
+
+#define TSL2561_CLIPPING_13MS  4900
+#define TSL2561_CLIPPING_101MS 37000
+#define TSL2561_CLIPPING_402MS 65000
+
+typedef enum {
+  TSL2561_INTEGRATIONTIME_13MS = 0x00,
+  TSL2561_INTEGRATIONTIME_101MS = 0x01,
+  TSL2561_INTEGRATIONTIME_402MS = 0x02
+} tsl2561IntegrationTime_t;
+
+typedef enum {
+  TSL2561_GAIN_1X = 0x00,
+  TSL2561_GAIN_16X = 0x10
+} tsl2561Gain_t;
+
+// Host stand-in for the Adafruit TSL2561 Unified driver. Register access
+// and lux math follow the real driver so conversion timing is realistic.
+class Adafruit_TSL2561_Unified : public Adafruit_Sensor {
+ public:
+  Adafruit_TSL2561_Unified(uint8_t addr, int32_t sensorID = -1);
+  bool begin();
+  bool begin(TwoWire* theWire);
+  bool init();
+
+  void enableAutoRange(bool enable);
+  void setIntegrationTime(tsl2561IntegrationTime_t time);
+  void setGain(tsl2561Gain_t gain);
+  void getLuminosity(uint16_t* broadband, uint16_t* ir);
+  uint32_t calculateLux(uint16_t broadband, uint16_t ir);
+
+  bool getEvent(sensors_event_t* event) override;
+  void getSensor(sensor_t* sensor) override;
+
+ private:
+  void enable();
+  void disable();
+  void write8(uint8_t reg, uint8_t value);
+  uint8_t read8(uint8_t reg);
+  uint16_t read16(uint8_t reg);
+  void getData(uint16_t* broadband, uint16_t* ir);
+
+  TwoWire* wire = &Wire;
+  uint8_t address;
+  int32_t sensorId;
+  bool initialized = false;
+  bool autoGain = false;
+  tsl2561IntegrationTime_t integration = TSL2561_INTEGRATIONTIME_13MS;
+  tsl2561Gain_t gain = TSL2561_GAIN_1X;
+};
@@ -0,0 +1,291 @@
+/**
+ * Arduino.cpp - Host Arduino core implementation
+ * 
+ * Copyright (C) 2025 Michael Garcia, M&E Design
+ * Based on original .ino by Geoff Mcintyre of Mr.Industries (https://mr.industries/)
+ * 
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ * 
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU General Public License for more details.
+ * 
+ * You should have received a copy of the GNU General Public License
+ * along with this program. If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#include "Arduino.h"
+#include "HostSim.h"
+#include "HostSimInternal.h"
+#include <chrono>
+#include <deque>
+#include <mutex>
+#include <random>
+
+// -----------------------------------------------------------------------------
+// Timing and GPIO
+// -----------------------------------------------------------------------------
+
+unsigned long millis() {
+  return (unsigned long)((hostsim::simMicros() - hostsim::bootMicros()) / 1000ULL);
+}
+
+// Both restart from zero on every boot, including wakes from deep sleep
+unsigned long micros() {
+  return (unsigned long)(hostsim::simMicros() - hostsim::bootMicros());
+}
+
+void delay(uint32_t ms) {
+  vTaskDelay(pdMS_TO_TICKS(ms));
+}
+
+void delayMicroseconds(uint32_t us) {
+  hostsim::sleepSimMicros(us);
+}
+
+void yield() {
+  taskYIELD();
+}
+
+namespace {
+  uint8_t pinLevels[64];
+  std::mt19937 rng(12345);
+}
+
+void pinMode(uint8_t pin, uint8_t mode) {
+  (void)pin;
+  (void)mode;
+}
+
+void digitalWrite(uint8_t pin, uint8_t val) {
+  if (pin < sizeof(pinLevels)) pinLevels[pin] = val;
+}
+
+int digitalRead(uint8_t pin) {
+  return pin < sizeof(pinLevels) ? pinLevels[pin] : LOW;
+}
+
+int digitalPinToInterrupt(uint8_t pin) {
+  return pin;
+}
+
+void attachInterrupt(uint8_t pin, void (*isr)(void), int mode) {
+  (void)pin;
+  (void)isr;
+  (void)mode;
+}
+
+void detachInterrupt(uint8_t pin) {
+  (void)pin;
+}
+
+long random(long howbig) {
+  if (howbig <= 0) return 0;
+  return (long)(rng() % (unsigned long)howbig);
+}
+
+long random(long howsmall, long howbig) {
+  if (howsmall >= howbig) return howsmall;
+  return howsmall + random(howbig - howsmall);
+}
+
+void randomSeed(unsigned long seed) {
+  rng.seed((uint32_t)seed);
+}
+
+// -----------------------------------------------------------------------------
+// Print
+// -----------------------------------------------------------------------------
+
+size_t Print::write(const uint8_t* buffer, size_t size) {
+  size_t n = 0;
+  while (size--) {
+    n += write(*buffer++);
+  }
+  return n;
+}
+
+size_t Print::print(const String& s) { return write(s.c_str()); }
+size_t Print::print(const char* s) { return write(s); }
+size_t Print::print(char c) { return write((uint8_t)c); }
+size_t Print::print(unsigned char n, int base) { return print((unsigned long)n, base); }
+size_t Print::print(unsigned int n, int base) { return print((unsigned long)n, base); }
+size_t Print::print(unsigned long n, int base) { return printNumber(n, base); }
+size_t Print::print(unsigned long long n, int base) { return printNumber(n, base); }
+size_t Print::print(int n, int base) { return print((long long)n, base); }
+size_t Print::print(long n, int base) { return print((long long)n, base); }
+
+size_t Print::print(long long n, int base) {
+  if (base == DEC && n < 0) {
+    return print('-') + printNumber((unsigned long long)(-n), DEC);
+  }
+  return printNumber((unsigned long long)n, base);
+}
+
+size_t Print::print(double n, int digits) {
+  char buf[48];
+  int len = snprintf(buf, sizeof(buf), "%.*f", digits, n);
+  return write((const uint8_t*)buf, len > 0 ? (size_t)len : 0);
+}
+
+size_t Print::println() {
+  return write("\r\n");
+}
+
+size_t Print::printf(const char* format, ...) {
+  char buf[256];
+  va_list args;
+  va_start(args, format);
+  int len = vsnprintf(buf, sizeof(buf), format, args);
+  va_end(args);
+  if (len < 0) return 0;
+  return write((const uint8_t*)buf, std::min((size_t)len, sizeof(buf) - 1));
+}
+
+size_t Print::printNumber(unsigned long long n, int base) {
+  char buf[8 * sizeof(n) + 1];
+  char* p = &buf[sizeof(buf) - 1];
+  *p = '\0';
+  if (base < 2) base = 10;
+  do {
+    int digit = (int)(n % base);
+    *--p = (char)(digit < 10 ? '0' + digit : 'A' + digit - 10);
+    n /= base;
+  } while (n);
+  return write(p);
+}
+
+// -----------------------------------------------------------------------------
+// Stream
+// -----------------------------------------------------------------------------
+
+int Stream::timedRead() {
+  unsigned long start = millis();
+  do {
+    int c = read();
+    if (c >= 0) return c;
+    delay(1);
+  } while (millis() - start < timeout);
+  return -1;
+}
+
+size_t Stream::readBytes(char* buffer, size_t length) {
+  size_t count = 0;
+  while (count < length) {
+    int c = timedRead();
+    if (c < 0) break;
+    buffer[count++] = (char)c;
+  }
+  return count;
+}
+
+size_t Stream::readBytesUntil(char terminator, char* buffer, size_t length) {
+  size_t count = 0;
+  while (count < length) {
+    int c = timedRead();
+    if (c < 0 || c == terminator) break;
+    buffer[count++] = (char)c;
+  }
+  return count;
+}
+
+// -----------------------------------------------------------------------------
+// Serial
+// -----------------------------------------------------------------------------
+
+HardwareSerial Serial;
+
+namespace {
+  std::mutex serialRxMutex;
+  std::deque<uint8_t> serialRx;
+  OnReceiveCb serialRxCallback;
+  std::mutex serialTxMutex;
+}
+
+namespace hostsim {
+
+void serialInjectInput(const char* data, size_t len) {
+  OnReceiveCb callback;
+  {
+    std::lock_guard<std::mutex> lock(serialRxMutex);
+    serialRx.insert(serialRx.end(), data, data + len);
+    callback = serialRxCallback;
+  }
+  if (callback) callback();
+}
+
+}  // namespace hostsim
+
+void HardwareSerial::begin(unsigned long baud) {
+  (void)baud;
+}
+
+void HardwareSerial::onReceive(OnReceiveCb function, bool onlyOnTimeout) {
+  (void)onlyOnTimeout;
+  std::lock_guard<std::mutex> lock(serialRxMutex);
+  serialRxCallback = function;
+}
+
+int HardwareSerial::available() {
+  std::lock_guard<std::mutex> lock(serialRxMutex);
+  return (int)serialRx.size();
+}
+
+int HardwareSerial::read() {
+  std::lock_guard<std::mutex> lock(serialRxMutex);
+  if (serialRx.empty()) return -1;
+  uint8_t c = serialRx.front();
+  serialRx.pop_front();
+  return c;
+}
+
+int HardwareSerial::peek() {
+  std::lock_guard<std::mutex> lock(serialRxMutex);
+  return serialRx.empty() ? -1 : serialRx.front();
+}
+
+size_t HardwareSerial::write(uint8_t c) {
+  return write(&c, 1);
+}
+
+size_t HardwareSerial::write(const uint8_t* buffer, size_t size) {
+  std::lock_guard<std::mutex> lock(serialTxMutex);
+  for (size_t i = 0; i < size; i++) {
+    // Drop the CR of CRLF line endings so host logs stay Unix-style; a lone
+    // CR may be part of binary output and is kept.
+    if (buffer[i] == '\r' && i + 1 < size && buffer[i + 1] == '\n') continue;
+    fputc(buffer[i], stdout);
+  }
+  return size;
+}
+
+void HardwareSerial::flush() {
+  fflush(stdout);
+}
+
+// -----------------------------------------------------------------------------
+// Chip control
+// -----------------------------------------------------------------------------
+
+EspClass ESP;
+
+void EspClass::restart() {
+  fprintf(stderr, "[sim] ESP.restart() requested\n");
+  hostsim::shutdown(0);
+}
+
+uint32_t EspClass::getFreeHeap() {
+  return 200 * 1024;
+}
+
+// Code runs at host speed regardless of the time scale, so the cycle counter
+// follows the real clock; benchmarks would otherwise be inflated by --scale.
+uint32_t EspClass::getCycleCount() {
+  auto realNs = std::chrono::duration_cast<std::chrono::nanoseconds>(
+      std::chrono::steady_clock::now().time_since_epoch());
+  return (uint32_t)((uint64_t)realNs.count() * getCpuFreqMHz() / 1000ULL);
+}
@@ -0,0 +1,212 @@
+/**
+ * Arduino.h - Host Arduino core API
+ * 
+ * Copyright (C) 2025 Michael Garcia, M&E Design
+ * Based on original .ino by Geoff Mcintyre of Mr.Industries (https://mr.industries/)
+ * 
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ * 
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU General Public License for more details.
+ * 
+ * You should have received a copy of the GNU General Public License
+ * along with this program. If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#pragma once
+#include <stdint.h>
+#include <stddef.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdio.h>
+#include <stdarg.h>
+#include <ctype.h>
+#include <math.h>
+#include <algorithm>
+#include <functional>
+#include <string>
+#include "freertos/FreeRTOS.h"
+#include "freertos/task.h"
+#include "freertos/semphr.h"
+
+/**
+ * Host implementation of the Arduino-ESP32 core API surface used by the
+ * firmware: timing, GPIO stubs, Print/Stream, String and the Serial port.
+ *
+ * Serial output goes to stdout; Serial input comes from stdin (or a
+ * --script file), minus lines starting with '!' which are simulator
+ * commands (see HostSim.h).
+ */
+
+#define HOST_NATIVE_SIM 1
+
+#define HIGH 0x1
+#define LOW  0x0
+
+#define INPUT          0x01
+#define OUTPUT         0x03
+#define INPUT_PULLUP   0x05
+#define INPUT_PULLDOWN 0x09
+
+#define RISING   0x01
+#define FALLING  0x02
+#define CHANGE   0x03
+
+#define DEC 10
+#define HEX 16
+#define OCT 8
+#define BIN 2
+
+// Feather ESP32 VSPI defaults
+#define SS    5
+#define SCK   18
+#define MISO  19
+#define MOSI  23
+
+#define IRAM_ATTR
+#define DRAM_ATTR
+// Kept together so a simulated deep sleep can carry them over (esp_sleep.h)
+#define RTC_DATA_ATTR __attribute__((section("hostsim_rtc")))
+
+using std::min;
+using std::max;
+
+typedef bool boolean;
+typedef uint8_t byte;
+
+// -----------------------------------------------------------------------------
+// Timing and GPIO
+// -----------------------------------------------------------------------------
+
+unsigned long millis();
+unsigned long micros();
+void delay(uint32_t ms);
+void delayMicroseconds(uint32_t us);
+void yield();
+
+void pinMode(uint8_t pin, uint8_t mode);
+void digitalWrite(uint8_t pin, uint8_t val);
+int digitalRead(uint8_t pin);
+int digitalPinToInterrupt(uint8_t pin);
+void attachInterrupt(uint8_t pin, void (*isr)(void), int mode);
+void detachInterrupt(uint8_t pin);
+
+long random(long howbig);
+long random(long howsmall, long howbig);
+void randomSeed(unsigned long seed);
+
+// -----------------------------------------------------------------------------
+// String
+// -----------------------------------------------------------------------------
+
+class String {
+ public:
+  String(const char* s = "") : value(s ? s : "") {}
+  String(const std::string& s) : value(s) {}
+  String(int v) : value(std::to_string(v)) {}
+  String(unsigned long v) : value(std::to_string(v)) {}
+
+  const char* c_str() const { return value.c_str(); }
+  unsigned int length() const { return (unsigned int)value.size(); }
+  bool equals(const String& other) const { return value == other.value; }
+  bool operator==(const String& other) const { return value == other.value; }
+  bool operator!=(const String& other) const { return value != other.value; }
+  String& operator+=(const String& other) { value += other.value; return *this; }
+  String operator+(const String& other) const { return String(value + other.value); }
+
+ private:
+  std::string value;
+};
+
+// -----------------------------------------------------------------------------
+// Print / Stream
+// -----------------------------------------------------------------------------
+
+class Print {
+ public:
+  virtual ~Print() {}
+
+  virtual size_t write(uint8_t c) = 0;
+  virtual size_t write(const uint8_t* buffer, size_t size);
+  size_t write(const char* str) { return str ? write((const uint8_t*)str, strlen(str)) : 0; }
+  size_t write(const char* buffer, size_t size) { return write((const uint8_t*)buffer, size); }
+  virtual void flush() {}
+
+  size_t print(const String& s);
+  size_t print(const char* s);
+  size_t print(char c);
+  size_t print(unsigned char n, int base = DEC);
+  size_t print(int n, int base = DEC);
+  size_t print(unsigned int n, int base = DEC);
+  size_t print(long n, int base = DEC);
+  size_t print(unsigned long n, int base = DEC);
+  size_t print(long long n, int base = DEC);
+  size_t print(unsigned long long n, int base = DEC);
+  size_t print(double n, int digits = 2);
+
+  size_t println();
+  template <typename T>
+  size_t println(const T& value) { size_t n = print(value); return n + println(); }
+  template <typename T>
+  size_t println(const T& value, int format) { size_t n = print(value, format); return n + println(); }
+
+  size_t printf(const char* format, ...) __attribute__((format(printf, 2, 3)));
+
+ private:
+  size_t printNumber(unsigned long long n, int base);
+};
+
+class Stream : public Print {
+ public:
+  virtual int available() = 0;
+  virtual int read() = 0;
+  virtual int peek() = 0;
+
+  void setTimeout(unsigned long timeoutMs) { timeout = timeoutMs; }
+  size_t readBytes(char* buffer, size_t length);
+  size_t readBytesUntil(char terminator, char* buffer, size_t length);
+
+ protected:
+  int timedRead();
+  unsigned long timeout = 1000;
+};
+
+typedef std::function<void(void)> OnReceiveCb;
+
+class HardwareSerial : public Stream {
+ public:
+  void begin(unsigned long baud);
+  // Called from the input thread after each injected line, like the UART
+  // event task on the target
+  void onReceive(OnReceiveCb function, bool onlyOnTimeout = false);
+  void end() {}
+  int available() override;
+  int read() override;
+  int peek() override;
+  size_t write(uint8_t c) override;
+  size_t write(const uint8_t* buffer, size_t size) override;
+  using Print::write;
+  void flush() override;
+  operator bool() const { return true; }
+};
+
+extern HardwareSerial Serial;
+
+// -----------------------------------------------------------------------------
+// Chip control
+// -----------------------------------------------------------------------------
+
+class EspClass {
+ public:
+  void restart();
+  uint32_t getFreeHeap();
+  uint32_t getCycleCount();
+  uint32_t getCpuFreqMHz() { return 240; }
+};
+
+extern EspClass ESP;
@@ -0,0 +1,260 @@
+/**
+ * DeepSleep.cpp - Simulated deep sleep with RTC memory retention
+ * 
+ * Copyright (C) 2025 Michael Garcia, M&E Design
+ * Based on original .ino by Geoff Mcintyre of Mr.Industries (https://mr.industries/)
+ * 
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ * 
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU General Public License for more details.
+ * 
+ * You should have received a copy of the GNU General Public License
+ * along with this program. If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#include "esp_sleep.h"
+#include "HostSim.h"
+#include "HostSimInternal.h"
+#include <fcntl.h>
+#include <unistd.h>
+#include <atomic>
+#include <condition_variable>
+#include <mutex>
+#include <string>
+#include <vector>
+#include <cstring>
+
+// Start and end of the RTC_DATA_ATTR variables; weak so a firmware
+// without any still links
+extern "C" {
+extern char __start_hostsim_rtc[] __attribute__((weak));
+extern char __stop_hostsim_rtc[] __attribute__((weak));
+}
+
+namespace {
+  constexpr uint32_t RESUME_MAGIC = 0x52545331;   // "RTS1"
+
+  // The ROM and second-stage bootloader run before the app after every
+  // wake; about 40 ms with image verification skipped on deep sleep wake
+  // (CONFIG_BOOTLOADER_SKIP_VALIDATE_IN_DEEP_SLEEP)
+  constexpr uint64_t WAKE_BOOT_US = 40000;
+
+  struct ResumeState {
+    uint32_t magic;
+    uint32_t rtcSize;
+    uint64_t sleepStartUs;
+    uint64_t timerUs;           // 0: no timer armed
+    int32_t ext0Pin;            // -1: not armed
+    int32_t ext0Level;
+    uint32_t wakes;             // Deep sleep wakes whose app has run
+    uint64_t awakeUs;           // App time over those wakes
+    uint8_t loraAsleep;
+    hostsim::EnergyTotals energy;
+  };
+
+  std::vector<std::string> programArgs;
+  std::string rtcPath = "hostsim_rtc.bin";
+
+  std::mutex sleepMutex;
+  std::condition_variable sleepCv;
+  uint64_t timerUs = 0;
+  int ext0Pin = -1;
+  int ext0Level = 0;
+  bool buttonPressed = false;
+
+  bool resumed = false;
+  ResumeState resumeState = {};
+  esp_sleep_wakeup_cause_t wakeCause = ESP_SLEEP_WAKEUP_UNDEFINED;
+  std::atomic<uint64_t> bootUs{0};
+
+  size_t rtcSize() {
+    if (!__start_hostsim_rtc || !__stop_hostsim_rtc) return 0;
+    return (size_t)(__stop_hostsim_rtc - __start_hostsim_rtc);
+  }
+
+  // Nothing but the standard streams survives into the next boot
+  void closeOnExec() {
+    long maxFd = sysconf(_SC_OPEN_MAX);
+    if (maxFd < 0 || maxFd > 4096) maxFd = 4096;
+    for (int fd = 3; fd < maxFd; fd++) {
+      int flags = fcntl(fd, F_GETFD);
+      if (flags >= 0) fcntl(fd, F_SETFD, flags | FD_CLOEXEC);
+    }
+  }
+}
+
+namespace hostsim {
+
+void setProgramArgs(int argc, char** argv) {
+  programArgs.clear();
+  for (int i = 0; i < argc; i++) {
+    // A resumed boot's own resume argument is not passed on
+    if (!strcmp(argv[i], "--resume") && i + 1 < argc) {
+      i++;
+      continue;
+    }
+    programArgs.push_back(argv[i]);
+  }
+}
+
+void setRtcPath(const char* path) {
+  rtcPath = path;
+}
+
+bool resumeFromDeepSleep(const char* path) {
+  FILE* f = fopen(path, "rb");
+  if (!f) {
+    fprintf(stderr, "[sim] cannot open deep sleep state %s, cold boot\n", path);
+    return false;
+  }
+  ResumeState state;
+  bool ok = fread(&state, sizeof(state), 1, f) == 1 && state.magic == RESUME_MAGIC &&
+            state.rtcSize == rtcSize() &&
+            (state.rtcSize == 0 || fread(__start_hostsim_rtc, 1, state.rtcSize, f) == state.rtcSize);
+  fclose(f);
+  if (!ok) {
+    fprintf(stderr, "[sim] deep sleep state %s does not match this build, cold boot\n", path);
+    return false;
+  }
+
+  resumeState = state;
+  resumed = true;
+  timerUs = state.timerUs;
+  ext0Pin = state.ext0Pin;
+  ext0Level = state.ext0Level;
+  startClockAt(state.sleepStartUs);
+  energyResume(state.energy, state.sleepStartUs);
+  if (state.loraAsleep) loraResumeAsleep(state.sleepStartUs);
+  return true;
+}
+
+void waitForDeepSleepWake() {
+  if (!resumed) return;
+  uint64_t start = resumeState.sleepStartUs;
+  {
+    std::unique_lock<std::mutex> lock(sleepMutex);
+    bool woke = false;
+    if (timerUs) {
+      uint64_t now = simMicros();
+      uint64_t end = start + timerUs;
+      woke = sleepCv.wait_until(lock, realDeadline(end > now ? end - now : 0), [] { return buttonPressed; });
+      wakeCause = woke ? ESP_SLEEP_WAKEUP_EXT0 : ESP_SLEEP_WAKEUP_TIMER;
+    } else {
+      // Nothing but the button can wake the node; the duration still ends
+      // the simulation
+      sleepCv.wait(lock, [] { return buttonPressed; });
+      wakeCause = ESP_SLEEP_WAKEUP_EXT0;
+    }
+    timerUs = 0;
+    ext0Pin = -1;
+    buttonPressed = false;
+  }
+
+  uint64_t wakeUs = simMicros();
+  sleepSimMicros(WAKE_BOOT_US);
+  uint64_t appUs = simMicros();
+  bootUs.store(appUs);
+  energyWake(wakeUs, appUs);
+  fprintf(stderr, "[sim] wake %u at t=%.3fs by %s after %.3fs in deep sleep\n", resumeState.wakes + 1,
+          wakeUs / 1e6, wakeCause == ESP_SLEEP_WAKEUP_TIMER ? "timer" : "button", (wakeUs - start) / 1e6);
+}
+
+bool resumedBoot() {
+  return resumed;
+}
+
+uint64_t bootMicros() {
+  return bootUs.load(std::memory_order_relaxed);
+}
+
+void pressBootButton() {
+  std::lock_guard<std::mutex> lock(sleepMutex);
+  if (ext0Pin != 0 || ext0Level != 0) {
+    fprintf(stderr, "[sim] BOOT button pressed, no deep sleep wake armed on it\n");
+    return;
+  }
+  buttonPressed = true;
+  sleepCv.notify_all();
+}
+
+void printDeepSleepStats(FILE* out) {
+  if (!resumed) return;
+  uint32_t wakes = resumeState.wakes;
+  uint64_t awakeUs = resumeState.awakeUs;
+  if (bootMicros()) {
+    wakes++;
+    awakeUs += simMicros() - bootMicros();
+  }
+  fprintf(out, "[sim] deep sleep: %u wakes, app awake %.1f ms per wake on average\n", wakes,
+          wakes ? awakeUs / 1e3 / wakes : 0.0);
+}
+
+}  // namespace hostsim
+
+// -----------------------------------------------------------------------------
+// esp_sleep
+// -----------------------------------------------------------------------------
+
+esp_err_t esp_sleep_enable_timer_wakeup(uint64_t time_in_us) {
+  std::lock_guard<std::mutex> lock(sleepMutex);
+  timerUs = time_in_us;
+  return ESP_OK;
+}
+
+esp_err_t esp_sleep_enable_ext0_wakeup(gpio_num_t gpio_num, int level) {
+  if (gpio_num < 0 || gpio_num > 39) return ESP_ERR_INVALID_ARG;
+  std::lock_guard<std::mutex> lock(sleepMutex);
+  ext0Pin = gpio_num;
+  ext0Level = level;
+  return ESP_OK;
+}
+
+esp_sleep_wakeup_cause_t esp_sleep_get_wakeup_cause(void) {
+  return wakeCause;
+}
+
+void esp_deep_sleep_start(void) {
+  ResumeState state = {};
+  state.magic = RESUME_MAGIC;
+  state.rtcSize = (uint32_t)rtcSize();
+  {
+    std::lock_guard<std::mutex> lock(sleepMutex);
+    state.timerUs = timerUs;
+    state.ext0Pin = ext0Pin;
+    state.ext0Level = ext0Level;
+  }
+  state.sleepStartUs = hostsim::simMicros();
+  state.wakes = resumed ? resumeState.wakes + 1 : 0;
+  state.awakeUs = resumed ? resumeState.awakeUs + (state.sleepStartUs - hostsim::bootMicros()) : 0;
+  state.loraAsleep = hostsim::loraAsleep();
+  hostsim::energyTotals(&state.energy);
+
+  FILE* f = fopen(rtcPath.c_str(), "wb");
+  bool ok = f && fwrite(&state, sizeof(state), 1, f) == 1 &&
+            (state.rtcSize == 0 || fwrite(__start_hostsim_rtc, 1, state.rtcSize, f) == state.rtcSize);
+  if (f) ok = fclose(f) == 0 && ok;
+  if (!ok) {
+    fprintf(stderr, "[sim] cannot write deep sleep state %s\n", rtcPath.c_str());
+    hostsim::shutdown(1);
+  }
+
+  fflush(stdout);
+  fflush(stderr);
+  closeOnExec();
+  std::vector<char*> argv;
+  for (std::string& arg : programArgs) argv.push_back(&arg[0]);
+  std::string resumeFlag = "--resume";
+  argv.push_back(&resumeFlag[0]);
+  argv.push_back(&rtcPath[0]);
+  argv.push_back(nullptr);
+  execv("/proc/self/exe", argv.data());
+
+  perror("[sim] execv");
+  std::_Exit(1);
+}
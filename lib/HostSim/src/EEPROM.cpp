@@ -0,0 +1,78 @@
+/**
+ * EEPROM.cpp - File-backed EEPROM emulation
+ * 
+ * Copyright (C) 2025 Michael Garcia, M&E Design
+ * Based on original .ino by Geoff Mcintyre of Mr.Industries (https://mr.industries/)
+ * 
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ * 
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU General Public License for more details.
+ * 
+ * You should have received a copy of the GNU General Public License
+ * along with this program. If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#include "EEPROM.h"
+#include "HostSimInternal.h"
+#include <string>
+
+EEPROMClass EEPROM;
+
+namespace {
+  std::string eepromPath = "hostsim_eeprom.bin";
+}
+
+namespace hostsim {
+
+void setEepromPath(const char* path) {
+  eepromPath = path;
+}
+
+}  // namespace hostsim
+
+bool EEPROMClass::begin(size_t newSize) {
+  if (newSize == 0) return false;
+  end();
+  data = new uint8_t[newSize];
+  size = newSize;
+  memset(data, 0xFF, size);
+
+  FILE* f = fopen(eepromPath.c_str(), "rb");
+  if (f) {
+    size_t n = fread(data, 1, size, f);
+    (void)n;
+    fclose(f);
+  }
+  return true;
+}
+
+void EEPROMClass::end() {
+  delete[] data;
+  data = nullptr;
+  size = 0;
+}
+
+uint8_t EEPROMClass::read(int address) {
+  if (!data || address < 0 || (size_t)address >= size) return 0;
+  return data[address];
+}
+
+void EEPROMClass::write(int address, uint8_t value) {
+  if (!data || address < 0 || (size_t)address >= size) return;
+  data[address] = value;
+}
+
+bool EEPROMClass::commit() {
+  if (!data) return false;
+  FILE* f = fopen(eepromPath.c_str(), "wb");
+  if (!f) return false;
+  bool ok = fwrite(data, 1, size, f) == size;
+  fclose(f);
+  return ok;
+}
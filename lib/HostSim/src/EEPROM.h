@@ -0,0 +1,56 @@
+/**
+ * EEPROM.h - File-backed EEPROM emulation interface
+ * 
+ * Copyright (C) 2025 Michael Garcia, M&E Design
+ * Based on original .ino by Geoff Mcintyre of Mr.Industries (https://mr.industries/)
+ * 
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ * 
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU General Public License for more details.
+ * 
+ * You should have received a copy of the GNU General Public License
+ * along with this program. If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#pragma once
+#include "Arduino.h"
+
+/**
+ * Host EEPROM emulation. Like the ESP32 core, reads and writes go to a RAM
+ * copy and commit() persists it - here to a file (default
+ * hostsim_eeprom.bin, override with --eeprom).
+ */
+class EEPROMClass {
+ public:
+  bool begin(size_t size);
+  void end();
+  uint8_t read(int address);
+  void write(int address, uint8_t value);
+  bool commit();
+  size_t length() { return size; }
+  uint8_t* getDataPtr() { return data; }
+
+  template <typename T>
+  T& get(int address, T& value) {
+    if (address >= 0 && address + sizeof(T) <= size) memcpy(&value, data + address, sizeof(T));
+    return value;
+  }
+
+  template <typename T>
+  const T& put(int address, const T& value) {
+    if (address >= 0 && address + sizeof(T) <= size) memcpy(data + address, &value, sizeof(T));
+    return value;
+  }
+
+ private:
+  uint8_t* data = nullptr;
+  size_t size = 0;
+};
+
+extern EEPROMClass EEPROM;
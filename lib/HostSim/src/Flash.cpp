@@ -0,0 +1,212 @@
+/**
+ * Flash.cpp - Simulated SPI NOR flash partitions
+ * 
+ * Copyright (C) 2025 Michael Garcia, M&E Design
+ * Based on original .ino by Geoff Mcintyre of Mr.Industries (https://mr.industries/)
+ * 
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ * 
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU General Public License for more details.
+ * 
+ * You should have received a copy of the GNU General Public License
+ * along with this program. If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#include "esp_partition.h"
+#include "HostSim.h"
+#include "HostSimInternal.h"
+#include <atomic>
+#include <mutex>
+#include <string>
+#include <vector>
+#include <cstring>
+
+namespace {
+  // Typical SPI NOR timings (page program ~0.6 ms, 4 KB sector erase ~45 ms)
+  const uint32_t FLASH_PAGE_SIZE = 256;
+  const uint64_t PAGE_PROGRAM_US = 600;
+  const uint64_t SECTOR_ERASE_US = 45000;
+
+  // Mirrors the raw data partitions in partitions.csv used by the firmware.
+  // The image file holds the flash from the first of them to the end.
+  esp_partition_t partitions[] = {
+    {nullptr, ESP_PARTITION_TYPE_DATA, (esp_partition_subtype_t)0x41,
+     0x3D0000, 0x10000, SPI_FLASH_SEC_SIZE, "backlog", false, false},
+    {nullptr, ESP_PARTITION_TYPE_DATA, (esp_partition_subtype_t)0x40,
+     0x3E0000, 0x10000, SPI_FLASH_SEC_SIZE, "logs", false, false},
+  };
+  const uint32_t IMAGE_BASE = 0x3D0000;
+  const uint32_t IMAGE_SIZE = 0x20000;
+
+  std::mutex flashMutex;
+  std::string flashPath = "hostsim_flash.bin";
+  std::vector<uint8_t> image;
+  std::vector<uint32_t> sectorErases;
+  FILE* flashFile = nullptr;
+  std::atomic<bool> cutPending{false};
+
+  struct FlashStats {
+    std::atomic<uint64_t> bytesRead{0};
+    std::atomic<uint64_t> bytesWritten{0};
+    std::atomic<uint32_t> writes{0};
+    std::atomic<uint32_t> erases{0};
+    std::atomic<uint32_t> bitViolations{0};
+  } stats;
+
+  // Called with flashMutex held
+  void loadImage() {
+    if (!image.empty()) return;
+    image.assign(IMAGE_SIZE, 0xFF);
+    sectorErases.assign(IMAGE_SIZE / SPI_FLASH_SEC_SIZE, 0);
+    flashFile = fopen(flashPath.c_str(), "r+b");
+    if (flashFile) {
+      size_t n = fread(image.data(), 1, image.size(), flashFile);
+      (void)n;
+    } else {
+      flashFile = fopen(flashPath.c_str(), "w+b");
+    }
+    if (flashFile) {
+      fseek(flashFile, 0, SEEK_SET);
+      fwrite(image.data(), 1, image.size(), flashFile);
+      fflush(flashFile);
+    }
+  }
+
+  // Write-through so the image survives an abrupt exit
+  void persist(size_t offset, size_t size) {
+    if (!flashFile) return;
+    fseek(flashFile, (long)offset, SEEK_SET);
+    fwrite(&image[offset], 1, size, flashFile);
+    fflush(flashFile);
+  }
+
+  bool known(const esp_partition_t* partition) {
+    for (const esp_partition_t& p : partitions) {
+      if (partition == &p) return true;
+    }
+    return false;
+  }
+
+  bool inRange(const esp_partition_t* partition, size_t offset, size_t size) {
+    return known(partition) && offset <= partition->size && size <= partition->size - offset;
+  }
+
+  // Image offset of a partition-relative offset
+  size_t imageOffset(const esp_partition_t* partition, size_t offset) {
+    return partition->address - IMAGE_BASE + offset;
+  }
+
+  // An armed power cut lets half of the operation reach the chip, then stops
+  // the simulation the way a brown-out would
+  size_t applyCut(size_t size) {
+    if (!cutPending.exchange(false)) return size;
+    return size / 2;
+  }
+
+  void powerLoss() {
+    fprintf(stderr, "[sim] flash power cut\n");
+    hostsim::shutdown(0);
+  }
+}
+
+namespace hostsim {
+
+void setFlashPath(const char* path) {
+  flashPath = path;
+}
+
+void armFlashPowerCut() {
+  cutPending.store(true);
+  fprintf(stderr, "[sim] flash power cut armed for the next write or erase\n");
+}
+
+void printFlashStats(FILE* out) {
+  std::lock_guard<std::mutex> lock(flashMutex);
+  uint32_t minErases = 0, maxErases = 0;
+  for (size_t i = 0; i < sectorErases.size(); i++) {
+    if (i == 0 || sectorErases[i] < minErases) minErases = sectorErases[i];
+    if (sectorErases[i] > maxErases) maxErases = sectorErases[i];
+  }
+  fprintf(out, "[sim] flash writes=%u bytes=%llu read=%llu erases=%u (per sector %u..%u) bit-violations=%u\n",
+          stats.writes.load(), (unsigned long long)stats.bytesWritten.load(),
+          (unsigned long long)stats.bytesRead.load(), stats.erases.load(), minErases, maxErases,
+          stats.bitViolations.load());
+}
+
+}  // namespace hostsim
+
+const esp_partition_t* esp_partition_find_first(esp_partition_type_t type, esp_partition_subtype_t subtype,
+                                                 const char* label) {
+  for (const esp_partition_t& p : partitions) {
+    if (type != ESP_PARTITION_TYPE_ANY && type != p.type) continue;
+    if (subtype != ESP_PARTITION_SUBTYPE_ANY && subtype != p.subtype) continue;
+    if (label && strcmp(label, p.label) != 0) continue;
+    std::lock_guard<std::mutex> lock(flashMutex);
+    loadImage();
+    return &p;
+  }
+  return nullptr;
+}
+
+esp_err_t esp_partition_read(const esp_partition_t* partition, size_t src_offset, void* dst, size_t size) {
+  if (!dst || !inRange(partition, src_offset, size)) return ESP_ERR_INVALID_ARG;
+  std::lock_guard<std::mutex> lock(flashMutex);
+  loadImage();
+  memcpy(dst, &image[imageOffset(partition, src_offset)], size);
+  stats.bytesRead.fetch_add(size);
+  return ESP_OK;
+}
+
+esp_err_t esp_partition_write(const esp_partition_t* partition, size_t dst_offset, const void* src, size_t size) {
+  if (!src || !inRange(partition, dst_offset, size)) return ESP_ERR_INVALID_ARG;
+  const uint8_t* data = (const uint8_t*)src;
+  size_t programmed = applyCut(size);
+  {
+    std::lock_guard<std::mutex> lock(flashMutex);
+    loadImage();
+    size_t base = imageOffset(partition, dst_offset);
+    for (size_t i = 0; i < programmed; i++) {
+      uint8_t& cell = image[base + i];
+      // NOR programming only clears bits
+      if (data[i] & ~cell) stats.bitViolations.fetch_add(1);
+      cell &= data[i];
+    }
+    persist(base, programmed);
+  }
+  if (programmed < size) powerLoss();
+
+  stats.writes.fetch_add(1);
+  stats.bytesWritten.fetch_add(size);
+  size_t pages = (dst_offset % FLASH_PAGE_SIZE + size + FLASH_PAGE_SIZE - 1) / FLASH_PAGE_SIZE;
+  hostsim::sleepSimMicros(pages * PAGE_PROGRAM_US);
+  return ESP_OK;
+}
+
+esp_err_t esp_partition_erase_range(const esp_partition_t* partition, size_t offset, size_t size) {
+  if (!inRange(partition, offset, size) ||
+      offset % SPI_FLASH_SEC_SIZE != 0 || size % SPI_FLASH_SEC_SIZE != 0) {
+    return ESP_ERR_INVALID_ARG;
+  }
+  size_t erased = applyCut(size);
+  {
+    std::lock_guard<std::mutex> lock(flashMutex);
+    loadImage();
+    size_t base = imageOffset(partition, offset);
+    memset(&image[base], 0xFF, erased);
+    persist(base, erased);
+    for (size_t s = base / SPI_FLASH_SEC_SIZE; s < (base + size) / SPI_FLASH_SEC_SIZE; s++) {
+      sectorErases[s]++;
+    }
+  }
+  if (erased < size) powerLoss();
+
+  stats.erases.fetch_add(size / SPI_FLASH_SEC_SIZE);
+  hostsim::sleepSimMicros(size / SPI_FLASH_SEC_SIZE * SECTOR_ERASE_US);
+  return ESP_OK;
+}
@@ -0,0 +1,411 @@
+/**
+ * FreeRTOSSim.cpp - FreeRTOS tasks, queues and semaphores on POSIX threads
+ * 
+ * Copyright (C) 2025 Michael Garcia, M&E Design
+ * Based on original .ino by Geoff Mcintyre of Mr.Industries (https://mr.industries/)
+ * 
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ * 
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU General Public License for more details.
+ * 
+ * You should have received a copy of the GNU General Public License
+ * along with this program. If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#include "freertos/FreeRTOS.h"
+#include "freertos/task.h"
+#include "freertos/queue.h"
+#include "freertos/semphr.h"
+#include "HostSim.h"
+#include "HostSimInternal.h"
+#include <pthread.h>
+#include <time.h>
+#include <atomic>
+#include <condition_variable>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+#include <cstring>
+
+// -----------------------------------------------------------------------------
+// Tasks
+// -----------------------------------------------------------------------------
+
+struct SimTask {
+  std::string name;
+  UBaseType_t priority;
+  TaskFunction_t code;
+  void* parameters;
+  pthread_t thread;
+  std::atomic<uint32_t> wakeups{0};
+};
+
+namespace {
+  struct TaskExit {};
+
+  std::mutex taskListMutex;
+  std::vector<SimTask*> taskList;
+  thread_local SimTask* currentTask = nullptr;
+
+  void* taskTrampoline(void* arg) {
+    SimTask* task = static_cast<SimTask*>(arg);
+    currentTask = task;
+    try {
+      task->code(task->parameters);
+    } catch (const TaskExit&) {
+    }
+    return nullptr;
+  }
+
+  // Tickless idle estimate: a gap between two wakeups of any task that is
+  // at least IDLE_SLEEP_MIN_US (CONFIG_FREERTOS_IDLE_TIME_BEFORE_SLEEP, 3
+  // ticks) is time the target could have spent in light sleep
+  using hostsim::IDLE_SLEEP_MIN_US;
+  std::atomic<uint64_t> lastWakeupUs{0};
+  std::atomic<uint64_t> idleUs{0};
+  std::atomic<uint32_t> idleGaps{0};
+
+  void countIdleGap(uint64_t from, uint64_t to) {
+    if (to > from && to - from >= IDLE_SLEEP_MIN_US) {
+      idleUs.fetch_add(to - from, std::memory_order_relaxed);
+      idleGaps.fetch_add(1, std::memory_order_relaxed);
+    }
+  }
+
+  void countWakeup() {
+    if (!currentTask) return;
+    currentTask->wakeups.fetch_add(1, std::memory_order_relaxed);
+    uint64_t now = hostsim::simMicros();
+    // A boot from deep sleep starts with no gap open
+    uint64_t last = lastWakeupUs.exchange(now);
+    countIdleGap(last > hostsim::bootMicros() ? last : hostsim::bootMicros(), now);
+    hostsim::energyTaskWakeup(now);
+  }
+
+  double threadCpuMs(pthread_t thread) {
+    clockid_t cid;
+    timespec ts;
+    if (pthread_getcpuclockid(thread, &cid) != 0 || clock_gettime(cid, &ts) != 0) return 0.0;
+    return ts.tv_sec * 1e3 + ts.tv_nsec / 1e6;
+  }
+}
+
+BaseType_t xTaskCreate(TaskFunction_t taskCode, const char* name, uint32_t stackDepth,
+                       void* parameters, UBaseType_t priority, TaskHandle_t* createdTask) {
+  (void)stackDepth;
+  SimTask* task = new SimTask();
+  task->name = name ? name : "";
+  task->priority = priority;
+  task->code = taskCode;
+  task->parameters = parameters;
+
+  if (pthread_create(&task->thread, nullptr, taskTrampoline, task) != 0) {
+    delete task;
+    return pdFAIL;
+  }
+  pthread_detach(task->thread);
+
+  {
+    std::lock_guard<std::mutex> lock(taskListMutex);
+    taskList.push_back(task);
+  }
+  if (createdTask) *createdTask = task;
+  return pdPASS;
+}
+
+BaseType_t xTaskCreatePinnedToCore(TaskFunction_t taskCode, const char* name, uint32_t stackDepth,
+                                   void* parameters, UBaseType_t priority, TaskHandle_t* createdTask,
+                                   BaseType_t coreId) {
+  (void)coreId;
+  return xTaskCreate(taskCode, name, stackDepth, parameters, priority, createdTask);
+}
+
+void vTaskDelete(TaskHandle_t task) {
+  // Only self-deletion is supported; the thread unwinds back to its trampoline.
+  // The main thread (loopTask on the target) has no trampoline and parks.
+  if (task == nullptr && currentTask == nullptr) {
+    for (;;) std::this_thread::sleep_for(std::chrono::hours(1));
+  }
+  if (task == nullptr || task == currentTask) {
+    throw TaskExit();
+  }
+}
+
+void vTaskDelay(TickType_t ticks) {
+  hostsim::sleepSimMicros((uint64_t)ticks * 1000ULL);
+  countWakeup();
+}
+
+void vTaskDelayUntil(TickType_t* previousWakeTime, TickType_t timeIncrement) {
+  TickType_t target = *previousWakeTime + timeIncrement;
+  TickType_t now = xTaskGetTickCount();
+  if ((int32_t)(target - now) > 0) {
+    hostsim::sleepSimMicros((uint64_t)(target - now) * 1000ULL);
+  }
+  *previousWakeTime = target;
+  countWakeup();
+}
+
+TickType_t xTaskGetTickCount() {
+  return (TickType_t)((hostsim::simMicros() - hostsim::bootMicros()) / 1000ULL);
+}
+
+TickType_t xTaskGetTickCountFromISR() {
+  return xTaskGetTickCount();
+}
+
+TaskHandle_t xTaskGetCurrentTaskHandle() {
+  return currentTask;
+}
+
+const char* pcTaskGetName(TaskHandle_t task) {
+  if (!task) task = currentTask;
+  return task ? task->name.c_str() : "main";
+}
+
+UBaseType_t uxTaskGetStackHighWaterMark(TaskHandle_t task) {
+  (void)task;
+  return 0;
+}
+
+void taskYIELD() {
+  std::this_thread::yield();
+}
+
+namespace hostsim {
+
+void printTaskStats(FILE* out) {
+  std::lock_guard<std::mutex> lock(taskListMutex);
+  // Rates cover this boot only
+  uint64_t boot = bootMicros();
+  uint64_t now = simMicros();
+  uint64_t up = now - boot;
+  double seconds = (double)up / 1e6;
+  uint32_t total = 0;
+  for (SimTask* task : taskList) {
+    uint32_t wakeups = task->wakeups.load();
+    total += wakeups;
+    fprintf(out, "[sim] task %-12s prio=%u wakeups=%u (%.1f/s sim) cpu=%.1fms\n",
+            task->name.c_str(), task->priority, wakeups,
+            seconds > 0 ? wakeups / seconds : 0.0, threadCpuMs(task->thread));
+  }
+
+  // Include the gap still open since the last wakeup
+  uint64_t last = lastWakeupUs.load() > boot ? lastWakeupUs.load() : boot;
+  uint64_t idle = idleUs.load();
+  uint32_t gaps = idleGaps.load();
+  if (now > last && now - last >= IDLE_SLEEP_MIN_US) {
+    idle += now - last;
+    gaps++;
+  }
+  fprintf(out, "[sim] tasks: %u wakeups (%.1f/s sim), idle %.1f%% in %u gaps >= %.0f ms (mean %.1f ms)\n",
+          total, seconds > 0 ? total / seconds : 0.0, up ? 100.0 * idle / up : 0.0, gaps,
+          IDLE_SLEEP_MIN_US / 1e3, gaps ? idle / 1e3 / gaps : 0.0);
+}
+
+}  // namespace hostsim
+
+// -----------------------------------------------------------------------------
+// Queues and semaphores
+// -----------------------------------------------------------------------------
+
+struct SimQueue {
+  std::mutex mutex;
+  std::condition_variable notEmpty;
+  std::condition_variable notFull;
+  std::vector<uint8_t> storage;
+  UBaseType_t length;
+  UBaseType_t itemSize;
+  UBaseType_t count;
+  UBaseType_t head;
+};
+
+namespace {
+  // Waits on cv until pred() holds or the tick timeout expires.
+  template <typename Pred>
+  bool waitFor(std::condition_variable& cv, std::unique_lock<std::mutex>& lock,
+               TickType_t ticks, Pred pred) {
+    if (pred()) return true;
+    if (ticks == 0) return false;
+    if (ticks == portMAX_DELAY) {
+      cv.wait(lock, pred);
+    } else if (!cv.wait_until(lock, hostsim::realDeadline((uint64_t)ticks * 1000ULL), pred)) {
+      countWakeup();
+      return false;
+    }
+    countWakeup();
+    return true;
+  }
+
+  void pushItem(SimQueue* q, const void* item, bool front) {
+    UBaseType_t slot;
+    if (front) {
+      q->head = (q->head + q->length - 1) % q->length;
+      slot = q->head;
+    } else {
+      slot = (q->head + q->count) % q->length;
+    }
+    if (q->itemSize && item) {
+      memcpy(&q->storage[slot * q->itemSize], item, q->itemSize);
+    }
+    q->count++;
+  }
+
+  void copyFront(SimQueue* q, void* buffer) {
+    if (q->itemSize && buffer) {
+      memcpy(buffer, &q->storage[q->head * q->itemSize], q->itemSize);
+    }
+  }
+
+  void popItem(SimQueue* q, void* buffer) {
+    copyFront(q, buffer);
+    q->head = (q->head + 1) % q->length;
+    q->count--;
+  }
+
+  BaseType_t sendGeneric(QueueHandle_t q, const void* item, TickType_t ticks, bool front) {
+    if (!q) return pdFAIL;
+    std::unique_lock<std::mutex> lock(q->mutex);
+    if (!waitFor(q->notFull, lock, ticks, [q] { return q->count < q->length; })) {
+      return pdFAIL;
+    }
+    pushItem(q, item, front);
+    q->notEmpty.notify_one();
+    return pdPASS;
+  }
+}
+
+QueueHandle_t xQueueCreate(UBaseType_t length, UBaseType_t itemSize) {
+  if (length == 0) return nullptr;
+  SimQueue* q = new SimQueue();
+  q->storage.resize((size_t)length * itemSize);
+  q->length = length;
+  q->itemSize = itemSize;
+  q->count = 0;
+  q->head = 0;
+  return q;
+}
+
+void vQueueDelete(QueueHandle_t queue) {
+  delete queue;
+}
+
+BaseType_t xQueueSend(QueueHandle_t queue, const void* item, TickType_t ticksToWait) {
+  return sendGeneric(queue, item, ticksToWait, false);
+}
+
+BaseType_t xQueueSendToBack(QueueHandle_t queue, const void* item, TickType_t ticksToWait) {
+  return sendGeneric(queue, item, ticksToWait, false);
+}
+
+BaseType_t xQueueSendToFront(QueueHandle_t queue, const void* item, TickType_t ticksToWait) {
+  return sendGeneric(queue, item, ticksToWait, true);
+}
+
+BaseType_t xQueueOverwrite(QueueHandle_t queue, const void* item) {
+  if (!queue) return pdFAIL;
+  std::lock_guard<std::mutex> lock(queue->mutex);
+  if (queue->count == queue->length) popItem(queue, nullptr);
+  pushItem(queue, item, false);
+  queue->notEmpty.notify_one();
+  return pdPASS;
+}
+
+BaseType_t xQueueReceive(QueueHandle_t queue, void* buffer, TickType_t ticksToWait) {
+  if (!queue) return pdFAIL;
+  std::unique_lock<std::mutex> lock(queue->mutex);
+  if (!waitFor(queue->notEmpty, lock, ticksToWait, [queue] { return queue->count > 0; })) {
+    return pdFAIL;
+  }
+  popItem(queue, buffer);
+  queue->notFull.notify_one();
+  return pdPASS;
+}
+
+BaseType_t xQueuePeek(QueueHandle_t queue, void* buffer, TickType_t ticksToWait) {
+  if (!queue) return pdFAIL;
+  std::unique_lock<std::mutex> lock(queue->mutex);
+  if (!waitFor(queue->notEmpty, lock, ticksToWait, [queue] { return queue->count > 0; })) {
+    return pdFAIL;
+  }
+  copyFront(queue, buffer);
+  return pdPASS;
+}
+
+BaseType_t xQueueSendFromISR(QueueHandle_t queue, const void* item, BaseType_t* higherPriorityTaskWoken) {
+  if (higherPriorityTaskWoken) *higherPriorityTaskWoken = pdFALSE;
+  return sendGeneric(queue, item, 0, false);
+}
+
+BaseType_t xQueueReceiveFromISR(QueueHandle_t queue, void* buffer, BaseType_t* higherPriorityTaskWoken) {
+  if (higherPriorityTaskWoken) *higherPriorityTaskWoken = pdFALSE;
+  return xQueueReceive(queue, buffer, 0);
+}
+
+UBaseType_t uxQueueMessagesWaiting(QueueHandle_t queue) {
+  if (!queue) return 0;
+  std::lock_guard<std::mutex> lock(queue->mutex);
+  return queue->count;
+}
+
+UBaseType_t uxQueueSpacesAvailable(QueueHandle_t queue) {
+  if (!queue) return 0;
+  std::lock_guard<std::mutex> lock(queue->mutex);
+  return queue->length - queue->count;
+}
+
+BaseType_t xQueueReset(QueueHandle_t queue) {
+  if (!queue) return pdFAIL;
+  std::lock_guard<std::mutex> lock(queue->mutex);
+  queue->count = 0;
+  queue->head = 0;
+  queue->notFull.notify_all();
+  return pdPASS;
+}
+
+SemaphoreHandle_t xSemaphoreCreateMutex() {
+  // A mutex is a binary semaphore that starts available. Priority
+  // inheritance is not modelled.
+  return xSemaphoreCreateCounting(1, 1);
+}
+
+SemaphoreHandle_t xSemaphoreCreateBinary() {
+  return xSemaphoreCreateCounting(1, 0);
+}
+
+SemaphoreHandle_t xSemaphoreCreateCounting(UBaseType_t maxCount, UBaseType_t initialCount) {
+  SemaphoreHandle_t s = xQueueCreate(maxCount, 0);
+  if (s) s->count = initialCount;
+  return s;
+}
+
+void vSemaphoreDelete(SemaphoreHandle_t semaphore) {
+  vQueueDelete(semaphore);
+}
+
+BaseType_t xSemaphoreTake(SemaphoreHandle_t semaphore, TickType_t ticksToWait) {
+  return xQueueReceive(semaphore, nullptr, ticksToWait);
+}
+
+BaseType_t xSemaphoreGive(SemaphoreHandle_t semaphore) {
+  return sendGeneric(semaphore, nullptr, 0, false);
+}
+
+BaseType_t xSemaphoreTakeFromISR(SemaphoreHandle_t semaphore, BaseType_t* higherPriorityTaskWoken) {
+  return xQueueReceiveFromISR(semaphore, nullptr, higherPriorityTaskWoken);
+}
+
+BaseType_t xSemaphoreGiveFromISR(SemaphoreHandle_t semaphore, BaseType_t* higherPriorityTaskWoken) {
+  return xQueueSendFromISR(semaphore, nullptr, higherPriorityTaskWoken);
+}
+
+UBaseType_t uxSemaphoreGetCount(SemaphoreHandle_t semaphore) {
+  return uxQueueMessagesWaiting(semaphore);
+}
@@ -0,0 +1,38 @@
+/**
+ * HostMain.cpp - Host entry point
+ * 
+ * Copyright (C) 2025 Michael Garcia, M&E Design
+ * Based on original .ino by Geoff Mcintyre of Mr.Industries (https://mr.industries/)
+ * 
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ * 
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU General Public License for more details.
+ * 
+ * You should have received a copy of the GNU General Public License
+ * along with this program. If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#include "Arduino.h"
+#include "HostSim.h"
+
+void setup();
+void loop();
+
+/**
+ * Host entry point: the Arduino core's app_main equivalent. setup() and
+ * loop() run on the main thread, which plays the role of the ESP32
+ * loopTask.
+ */
+int main(int argc, char** argv) {
+  hostsim::init(argc, argv);
+  setup();
+  while (true) {
+    loop();
+  }
+}
@@ -0,0 +1,335 @@
+/**
+ * HostSim.cpp - Host simulation clock, console and harness
+ * 
+ * Copyright (C) 2025 Michael Garcia, M&E Design
+ * Based on original .ino by Geoff Mcintyre of Mr.Industries (https://mr.industries/)
+ * 
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ * 
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU General Public License for more details.
+ * 
+ * You should have received a copy of the GNU General Public License
+ * along with this program. If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#include "HostSim.h"
+#include "HostSimInternal.h"
+#include <atomic>
+#include <chrono>
+#include <mutex>
+#include <thread>
+#include <string>
+#include <cstring>
+#include <cstdlib>
+
+namespace hostsim {
+
+// -----------------------------------------------------------------------------
+// Simulated clock
+// -----------------------------------------------------------------------------
+
+namespace {
+  using SteadyClock = std::chrono::steady_clock;
+
+  // Each scale change starts a new epoch so simulated time stays continuous.
+  // Epochs are immutable once published and are never freed (scale changes
+  // are rare), which keeps simMicros() lock-free.
+  struct ClockEpoch {
+    SteadyClock::time_point realBase;
+    uint64_t simBaseUs;
+    double scale;
+  };
+
+  std::atomic<const ClockEpoch*> currentEpoch{nullptr};
+  std::mutex epochMutex;
+
+  const ClockEpoch* epoch() {
+    const ClockEpoch* e = currentEpoch.load(std::memory_order_acquire);
+    if (!e) {
+      std::lock_guard<std::mutex> lock(epochMutex);
+      e = currentEpoch.load(std::memory_order_acquire);
+      if (!e) {
+        e = new ClockEpoch{SteadyClock::now(), 0, 1.0};
+        currentEpoch.store(e, std::memory_order_release);
+      }
+    }
+    return e;
+  }
+
+  std::mutex statsMutex;
+  std::string scriptPath;
+  double durationSeconds = 0.0;
+}
+
+uint64_t simMicros() {
+  const ClockEpoch* e = epoch();
+  auto realElapsed = std::chrono::duration_cast<std::chrono::nanoseconds>(SteadyClock::now() - e->realBase);
+  return e->simBaseUs + (uint64_t)((double)realElapsed.count() * e->scale / 1000.0);
+}
+
+void sleepSimMicros(uint64_t us) {
+  if (us == 0) {
+    std::this_thread::yield();
+    return;
+  }
+  std::this_thread::sleep_until(realDeadline(us));
+}
+
+SteadyClock::time_point realDeadline(uint64_t simUsFromNow) {
+  double scale = epoch()->scale;
+  auto realNs = std::chrono::nanoseconds((int64_t)((double)simUsFromNow * 1000.0 / scale));
+  return SteadyClock::now() + realNs;
+}
+
+double timeScale() {
+  return epoch()->scale;
+}
+
+void setTimeScale(double scale) {
+  if (scale <= 0.0) return;
+  epoch();
+  std::lock_guard<std::mutex> lock(epochMutex);
+  uint64_t now = simMicros();
+  currentEpoch.store(new ClockEpoch{SteadyClock::now(), now, scale}, std::memory_order_release);
+}
+
+void startClockAt(uint64_t simUs) {
+  double scale = epoch()->scale;
+  std::lock_guard<std::mutex> lock(epochMutex);
+  currentEpoch.store(new ClockEpoch{SteadyClock::now(), simUs, scale}, std::memory_order_release);
+}
+
+// -----------------------------------------------------------------------------
+// Command console
+// -----------------------------------------------------------------------------
+
+bool parseMac(const char* text, uint8_t mac[6]) {
+  unsigned int b[6];
+  if (!text || sscanf(text, "%x:%x:%x:%x:%x:%x", &b[0], &b[1], &b[2], &b[3], &b[4], &b[5]) != 6) {
+    return false;
+  }
+  for (int i = 0; i < 6; i++) {
+    if (b[i] > 0xFF) return false;
+    mac[i] = (uint8_t)b[i];
+  }
+  return true;
+}
+
+static bool parseOnOff(const char* word, bool* value) {
+  if (!word) return false;
+  if (!strcmp(word, "on") || !strcmp(word, "up") || !strcmp(word, "1")) { *value = true; return true; }
+  if (!strcmp(word, "off") || !strcmp(word, "down") || !strcmp(word, "0")) { *value = false; return true; }
+  return false;
+}
+
+bool runCommand(const char* line) {
+  if (!line) return false;
+  while (*line == '!' || *line == ' ') line++;
+
+  char buffer[128];
+  strncpy(buffer, line, sizeof(buffer) - 1);
+  buffer[sizeof(buffer) - 1] = '\0';
+  buffer[strcspn(buffer, "\r\n")] = '\0';
+
+  char* save = nullptr;
+  char* cmd = strtok_r(buffer, " ", &save);
+  char* a1 = strtok_r(nullptr, " ", &save);
+  char* a2 = strtok_r(nullptr, " ", &save);
+  if (!cmd) return false;
+
+  bool flag = false;
+  if (!strcmp(cmd, "scale") && a1) {
+    setTimeScale(atof(a1));
+    fprintf(stderr, "[sim] time scale %.1fx\n", timeScale());
+    return true;
+  }
+  if (!strcmp(cmd, "env") && a1 && a2) {
+    Environment env = getEnvironment();
+    if (!strcmp(a1, "temp")) env.temperatureC = (float)atof(a2);
+    else if (!strcmp(a1, "hum")) env.humidity = (float)atof(a2);
+    else if (!strcmp(a1, "lux")) env.lux = (float)atof(a2);
+    else if (!strcmp(a1, "luxday")) env.luxDaySeconds = (float)atof(a2);
+    else return false;
+    setEnvironment(env);
+    return true;
+  }
+  if (!strcmp(cmd, "i2c") && a1 && parseOnOff(a2, &flag)) {
+    setI2cDevicePresent((uint8_t)strtol(a1, nullptr, 16), flag);
+    return true;
+  }
+  if (!strcmp(cmd, "lora") && a1 && a2 && !strcmp(a1, "outage")) {
+    setLoRaOutage(atof(a2));
+    return true;
+  }
+  if (!strcmp(cmd, "lora") && a1 && parseOnOff(a2, &flag)) {
+    if (!strcmp(a1, "fault")) { setLoRaFault(flag); return true; }
+    if (!strcmp(a1, "link")) { setLoRaLinkUp(flag); return true; }
+    return false;
+  }
+  if (!strcmp(cmd, "peer") && a1 && a2) {
+    uint8_t mac[6];
+    if (!parseMac(a1, mac)) return false;
+    if (!strcmp(a2, "off")) return removeNowPeer(mac);
+    return addNowPeer(mac, (float)atof(a2));
+  }
+  if (!strcmp(cmd, "button")) {
+    pressBootButton();
+    return true;
+  }
+  if (!strcmp(cmd, "flash") && a1 && !strcmp(a1, "cut")) {
+    armFlashPowerCut();
+    return true;
+  }
+  if (!strcmp(cmd, "stats")) {
+    printStats(stderr);
+    return true;
+  }
+  if (!strcmp(cmd, "quit")) {
+    shutdown(0);
+    return true;
+  }
+
+  fprintf(stderr, "[sim] unknown command: %s\n", cmd);
+  return false;
+}
+
+// -----------------------------------------------------------------------------
+// Harness
+// -----------------------------------------------------------------------------
+
+namespace {
+  void usage(const char* argv0) {
+    fprintf(stderr,
+            "usage: %s [--scale N] [--duration SIM_SECONDS] [--script FILE]\n"
+            "          [--eeprom FILE] [--flash FILE] [--lora-log FILE] [--peer MAC@HZ]...\n"
+            "          [--lux-day SIM_SECONDS] [--rtc FILE]\n",
+            argv0);
+  }
+
+  // Script lines are fed exactly like stdin; a line "@<seconds>" waits until
+  // that absolute simulated time before continuing. After a deep sleep the
+  // script starts over and skips what an earlier boot has already run.
+  void scriptThread(std::string path) {
+    FILE* f = fopen(path.c_str(), "r");
+    if (!f) {
+      fprintf(stderr, "[sim] cannot open script %s\n", path.c_str());
+      return;
+    }
+    char line[256];
+    bool skipping = resumedBoot();
+    while (fgets(line, sizeof(line), f)) {
+      if (line[0] == '#' || line[0] == '\n') continue;
+      if (line[0] == '@') {
+        uint64_t target = (uint64_t)(atof(line + 1) * 1e6);
+        uint64_t now = simMicros();
+        if (target > now) {
+          skipping = false;
+          sleepSimMicros(target - now);
+        }
+        continue;
+      }
+      if (!skipping) feedInputLine(line);
+    }
+    fclose(f);
+  }
+
+  void stdinThread() {
+    char line[256];
+    while (fgets(line, sizeof(line), stdin)) {
+      feedInputLine(line);
+    }
+  }
+
+  void durationThread(double seconds) {
+    uint64_t end = (uint64_t)(seconds * 1e6);
+    uint64_t now = simMicros();
+    if (end > now) sleepSimMicros(end - now);
+    shutdown(0);
+  }
+}
+
+void feedInputLine(const char* line) {
+  if (line[0] == '!') {
+    runCommand(line);
+    return;
+  }
+  serialInjectInput(line, strlen(line));
+}
+
+void init(int argc, char** argv) {
+  setvbuf(stdout, nullptr, _IOLBF, 0);
+  setProgramArgs(argc, argv);
+
+  const char* envScale = getenv("HOSTSIM_TIME_SCALE");
+  if (envScale) setTimeScale(atof(envScale));
+
+  const char* resumePath = nullptr;
+  for (int i = 1; i < argc; i++) {
+    const char* arg = argv[i];
+    const char* val = (i + 1 < argc) ? argv[i + 1] : nullptr;
+    if (!strcmp(arg, "--scale") && val) { setTimeScale(atof(val)); i++; }
+    else if (!strcmp(arg, "--duration") && val) { durationSeconds = atof(val); i++; }
+    else if (!strcmp(arg, "--script") && val) { scriptPath = val; i++; }
+    else if (!strcmp(arg, "--eeprom") && val) { setEepromPath(val); i++; }
+    else if (!strcmp(arg, "--flash") && val) { setFlashPath(val); i++; }
+    else if (!strcmp(arg, "--lora-log") && val) { setLoRaLogPath(val); i++; }
+    else if (!strcmp(arg, "--rtc") && val) { setRtcPath(val); i++; }
+    else if (!strcmp(arg, "--resume") && val) { resumePath = val; i++; }
+    else if (!strcmp(arg, "--lux-day") && val) {
+      Environment env = getEnvironment();
+      env.luxDaySeconds = (float)atof(val);
+      env.lux = 40000.0f;   // Greenhouse midday under glass
+      setEnvironment(env);
+      i++;
+    }
+    else if (!strcmp(arg, "--peer") && val) {
+      uint8_t mac[6];
+      const char* rate = strrchr(val, '@');
+      if (!rate || !parseMac(val, mac)) { usage(argv[0]); exit(2); }
+      pendingPeer(mac, (float)atof(rate + 1));
+      i++;
+    }
+    else { usage(argv[0]); exit(2); }
+  }
+
+  // esp_deep_sleep_start() re-runs the program with --resume; the clock
+  // carries on from the moment the node went to sleep
+  if (resumePath && resumeFromDeepSleep(resumePath)) {
+    fprintf(stderr, "[sim] resumed from deep sleep at t=%.3fs, time scale %.1fx\n", simMicros() / 1e6, timeScale());
+  } else {
+    fprintf(stderr, "[sim] host simulation started, time scale %.1fx\n", timeScale());
+  }
+
+  std::thread(stdinThread).detach();
+  if (!scriptPath.empty()) std::thread(scriptThread, scriptPath).detach();
+  if (durationSeconds > 0.0) std::thread(durationThread, durationSeconds).detach();
+  waitForDeepSleepWake();
+}
+
+void printStats(FILE* out) {
+  std::lock_guard<std::mutex> lock(statsMutex);
+  fprintf(out, "[sim] ---- simulator stats at t=%.3fs ----\n", (double)simMicros() / 1e6);
+  printTaskStats(out);
+  printI2cStats(out);
+  printLoRaStats(out);
+  printNowStats(out);
+  printFlashStats(out);
+  printEnergyStats(out);
+  printDeepSleepStats(out);
+  fflush(out);
+}
+
+void shutdown(int code) {
+  fflush(stdout);
+  printStats(stderr);
+  // Firmware tasks never return, so skip static destructors entirely.
+  std::_Exit(code);
+}
+
+}  // namespace hostsim
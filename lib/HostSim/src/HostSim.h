@@ -0,0 +1,118 @@
+/**
+ * HostSim.h - Host simulation control interface
+ * 
+ * Copyright (C) 2025 Michael Garcia, M&E Design
+ * Based on original .ino by Geoff Mcintyre of Mr.Industries (https://mr.industries/)
+ * 
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ * 
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU General Public License for more details.
+ * 
+ * You should have received a copy of the GNU General Public License
+ * along with this program. If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#pragma once
+#include <stdint.h>
+#include <stddef.h>
+#include <stdio.h>
+
+/**
+ * Host simulation control interface
+ *
+ * The HostSim library backs the Arduino, FreeRTOS, Wire, LoRa, ESP-NOW,
+ * EEPROM and flash partition APIs used by the firmware with POSIX threads
+ * and simulated peripherals, so the unmodified sources in src/ build and
+ * run on Linux under [env:native].
+ *
+ * All firmware-visible time (millis(), tick count, delays, queue timeouts,
+ * I2C conversions, LoRa airtime) runs on a simulated clock that advances
+ * at timeScale() times real time, which is what makes accelerated soak
+ * runs possible.
+ *
+ * Simulation controls can be given on the command line, from a script
+ * file, or interactively on stdin as lines starting with '!':
+ *
+ *   !scale <factor>            - change the simulated clock rate
+ *   !env temp|hum|lux <value>  - set the simulated environment
+ *   !i2c <addr> on|off         - attach/detach a simulated I2C device
+ *   !lora fault on|off         - make the radio fail begin()/endPacket()
+ *   !lora outage <seconds>     - radio fault for a while, then recovery
+ *   !lora link up|down         - drop transmitted frames before the gateway
+ *                                (undetectable by the node: no ACKs)
+ *   !peer <mac> <hz>|off       - simulated ESP-NOW peer sending DIST: frames
+ *   !flash cut                 - lose power halfway through the next flash
+ *                                write or erase
+ *   !button                    - press BOOT (GPIO 0), waking the node from
+ *                                deep sleep if it armed that wake source
+ *   !stats                     - print simulator counters to stderr
+ *   !quit                      - print counters and exit
+ */
+
+namespace hostsim {
+
+// -----------------------------------------------------------------------------
+// Simulated clock
+// -----------------------------------------------------------------------------
+
+uint64_t simMicros();
+void sleepSimMicros(uint64_t us);
+double timeScale();
+void setTimeScale(double scale);
+
+// -----------------------------------------------------------------------------
+// Simulated environment seen by the I2C sensor models
+// -----------------------------------------------------------------------------
+
+struct Environment {
+  float temperatureC;
+  float humidity;
+  float lux;                // Fixed level, or the midday peak of the day profile
+  float luxDaySeconds;      // > 0: lux follows a day profile of this length
+};
+
+// Light level the TSL2561 model sees now
+float currentLux();
+
+Environment getEnvironment();
+void setEnvironment(const Environment& env);
+void setI2cDevicePresent(uint8_t address, bool present);
+
+// -----------------------------------------------------------------------------
+// Radio and peer simulation
+// -----------------------------------------------------------------------------
+
+void setLoRaFault(bool fault);
+void setLoRaOutage(double seconds);
+void setLoRaLinkUp(bool up);
+bool addNowPeer(const uint8_t mac[6], float rateHz);
+bool removeNowPeer(const uint8_t mac[6]);
+
+// -----------------------------------------------------------------------------
+// Flash
+// -----------------------------------------------------------------------------
+
+void armFlashPowerCut();
+
+// -----------------------------------------------------------------------------
+// Harness
+// -----------------------------------------------------------------------------
+
+void init(int argc, char** argv);
+bool runCommand(const char* line);
+void printStats(FILE* out);
+void shutdown(int code);
+
+// Per-subsystem counters printed by printStats()
+void printLoRaStats(FILE* out);
+void printI2cStats(FILE* out);
+void printNowStats(FILE* out);
+void printFlashStats(FILE* out);
+
+}  // namespace hostsim
@@ -0,0 +1,89 @@
+/**
+ * HostSimInternal.h - Internal host simulation plumbing
+ * 
+ * Copyright (C) 2025 Michael Garcia, M&E Design
+ * Based on original .ino by Geoff Mcintyre of Mr.Industries (https://mr.industries/)
+ * 
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ * 
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU General Public License for more details.
+ * 
+ * You should have received a copy of the GNU General Public License
+ * along with this program. If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#pragma once
+#include <stdint.h>
+#include <stddef.h>
+#include <stdio.h>
+#include <chrono>
+
+/**
+ * Shared plumbing between the HostSim translation units. Not for use by
+ * firmware code; the public control surface is HostSim.h.
+ */
+
+namespace hostsim {
+
+std::chrono::steady_clock::time_point realDeadline(uint64_t simUsFromNow);
+bool parseMac(const char* text, uint8_t mac[6]);
+
+void feedInputLine(const char* line);
+void serialInjectInput(const char* data, size_t len);
+
+void setEepromPath(const char* path);
+void setFlashPath(const char* path);
+void setLoRaLogPath(const char* path);
+void pendingPeer(const uint8_t mac[6], float rateHz);
+
+// Idle gaps at least this long could be spent in light sleep
+// (CONFIG_FREERTOS_IDLE_TIME_BEFORE_SLEEP, 3 ticks)
+constexpr uint64_t IDLE_SLEEP_MIN_US = 3000;
+
+void printTaskStats(FILE* out);
+
+// Energy since power-on, carried across simulated deep sleeps
+struct EnergyTotals {
+  uint64_t activeUs;
+  uint64_t idleMaxUs;
+  uint64_t idleMinUs;
+  uint64_t sleepUs;           // Light sleep
+  uint64_t deepSleepUs;
+  uint64_t bootUs;            // Bootloader after each deep sleep wake
+  uint64_t wifiUs;
+  uint64_t loraAirUs;
+  uint64_t loraSleepUs;
+  uint32_t wakeups;
+  uint32_t sleeps;
+  uint32_t deepSleeps;
+};
+
+void energyTaskWakeup(uint64_t nowUs);
+void setWifiPowered(bool on);
+void loraPowerTimes(uint64_t* airtimeUs, uint64_t* sleepUs);
+bool loraAsleep();
+void loraResumeAsleep(uint64_t sinceUs);
+void energyTotals(EnergyTotals* totals);
+// A resumed boot: totals up to the deep sleep that started at sleepStartUs
+void energyResume(const EnergyTotals& totals, uint64_t sleepStartUs);
+void energyWake(uint64_t wakeUs, uint64_t appStartUs);
+void printEnergyStats(FILE* out);
+
+// Deep sleep (DeepSleep.cpp)
+void startClockAt(uint64_t simUs);
+void setProgramArgs(int argc, char** argv);
+void setRtcPath(const char* path);
+bool resumeFromDeepSleep(const char* path);
+void waitForDeepSleepWake();
+bool resumedBoot();
+uint64_t bootMicros();          // Sim time this boot's app started; millis() counts from here
+void pressBootButton();
+void printDeepSleepStats(FILE* out);
+
+}  // namespace hostsim
@@ -0,0 +1,371 @@
+/**
+ * LoRa.cpp - Simulated SX127x LoRa radio
+ * 
+ * Copyright (C) 2025 Michael Garcia, M&E Design
+ * Based on original .ino by Geoff Mcintyre of Mr.Industries (https://mr.industries/)
+ * 
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ * 
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU General Public License for more details.
+ * 
+ * You should have received a copy of the GNU General Public License
+ * along with this program. If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#include "LoRa.h"
+#include "HostSim.h"
+#include "HostSimInternal.h"
+#include <atomic>
+#include <condition_variable>
+#include <mutex>
+#include <string>
+#include <thread>
+
+LoRaClass LoRa;
+SPIClass SPI;
+
+namespace {
+  struct ModemConfig {
+    int spreadingFactor = 7;
+    long bandwidth = 125000;
+    int codingRate = 5;  // 4/x denominator
+    long preamble = 8;
+    bool crc = false;
+    bool implicitHeader = false;
+  };
+
+  std::mutex radioMutex;
+  std::condition_variable radioCv;
+  ModemConfig modem;
+  bool initialized = false;
+  bool inPacket = false;
+  bool transmitting = false;
+  bool asyncTx = false;           // The transmission is dio0Thread's to finish
+  uint64_t txDoneAt = 0;
+  uint8_t packet[255];
+  size_t packetLength = 0;
+  uint8_t pendingPacket[255];
+  size_t pendingLength = 0;
+  void (*txDoneCallback)() = nullptr;
+  bool asleep = false;
+  uint64_t asleepSinceUs = 0;
+  uint64_t asleepUs = 0;
+  std::atomic<bool> radioFault{false};
+  std::atomic<bool> linkUp{true};
+  std::string logPath;
+  FILE* logFile = nullptr;
+
+  struct RadioStats {
+    std::atomic<uint32_t> packets{0};
+    std::atomic<uint32_t> delivered{0};
+    std::atomic<uint32_t> lost{0};
+    std::atomic<uint32_t> faults{0};
+    std::atomic<uint64_t> bytes{0};
+    std::atomic<uint64_t> airtimeUs{0};
+  } stats;
+
+  // Leaves sleep mode for standby. Caller holds radioMutex.
+  void wake() {
+    if (!asleep) return;
+    asleep = false;
+    asleepUs += hostsim::simMicros() - asleepSinceUs;
+  }
+
+  // SX127x time-on-air (Semtech AN1200.13)
+  uint64_t airtimeUs(const ModemConfig& cfg, size_t payloadLength) {
+    double tSym = (double)(1L << cfg.spreadingFactor) / (double)cfg.bandwidth * 1e6;
+    int lowDataRate = tSym > 16000.0 ? 1 : 0;
+    double tPreamble = ((double)cfg.preamble + 4.25) * tSym;
+    double num = 8.0 * payloadLength - 4.0 * cfg.spreadingFactor + 28 + 16 * (cfg.crc ? 1 : 0)
+                 - 20 * (cfg.implicitHeader ? 1 : 0);
+    double den = 4.0 * (cfg.spreadingFactor - 2 * lowDataRate);
+    double symbols = ceil(num / den) * cfg.codingRate;
+    if (symbols < 0) symbols = 0;
+    double tPayload = (8.0 + symbols) * tSym;
+    return (uint64_t)(tPreamble + tPayload);
+  }
+
+  // Hands a finished frame to the simulated gateway.
+  void deliver(const uint8_t* data, size_t length, uint64_t airtime) {
+    stats.packets.fetch_add(1);
+    stats.bytes.fetch_add(length);
+    stats.airtimeUs.fetch_add(airtime);
+    if (!linkUp.load()) {
+      stats.lost.fetch_add(1);
+      return;
+    }
+    stats.delivered.fetch_add(1);
+    // Frames from earlier boots stay in the log after a deep sleep
+    if (!logPath.empty() && !logFile) logFile = fopen(logPath.c_str(), hostsim::resumedBoot() ? "a" : "w");
+    if (logFile) {
+      fprintf(logFile, "%llu %u ", (unsigned long long)(hostsim::simMicros() / 1000), (unsigned)length);
+      for (size_t i = 0; i < length; i++) fprintf(logFile, "%02X", data[i]);
+      fprintf(logFile, "\n");
+      fflush(logFile);
+    }
+  }
+
+  // Completes async transmissions and plays the DIO0 TxDone interrupt.
+  void dio0Thread() {
+    std::unique_lock<std::mutex> lock(radioMutex);
+    while (true) {
+      radioCv.wait(lock, [] { return transmitting && asyncTx; });
+      uint64_t now = hostsim::simMicros();
+      if (now < txDoneAt) {
+        radioCv.wait_until(lock, hostsim::realDeadline(txDoneAt - now));
+        continue;
+      }
+      transmitting = false;
+      asyncTx = false;
+      uint8_t frame[255];
+      size_t length = pendingLength;
+      memcpy(frame, pendingPacket, length);
+      uint64_t airtime = airtimeUs(modem, length);
+      void (*callback)() = txDoneCallback;
+      lock.unlock();
+      deliver(frame, length, airtime);
+      if (callback) callback();
+      lock.lock();
+    }
+  }
+
+  void startDio0Thread() {
+    static std::once_flag once;
+    std::call_once(once, [] { std::thread(dio0Thread).detach(); });
+  }
+}
+
+namespace hostsim {
+
+void setLoRaFault(bool fault) {
+  radioFault.store(fault);
+  fprintf(stderr, "[sim] LoRa radio fault %s\n", fault ? "on" : "off");
+}
+
+void setLoRaOutage(double seconds) {
+  setLoRaFault(true);
+  std::thread([seconds]() {
+    sleepSimMicros((uint64_t)(seconds * 1e6));
+    setLoRaFault(false);
+  }).detach();
+}
+
+void setLoRaLinkUp(bool up) {
+  linkUp.store(up);
+  fprintf(stderr, "[sim] LoRa link %s\n", up ? "up" : "down");
+}
+
+void setLoRaLogPath(const char* path) {
+  logPath = path;
+}
+
+void printLoRaStats(FILE* out) {
+  double seconds = (double)simMicros() / 1e6;
+  uint64_t air = stats.airtimeUs.load();
+  fprintf(out, "[sim] lora packets=%u delivered=%u lost=%u faults=%u bytes=%llu airtime=%.1fms (%.3f%% duty)\n",
+          stats.packets.load(), stats.delivered.load(), stats.lost.load(), stats.faults.load(),
+          (unsigned long long)stats.bytes.load(), air / 1000.0,
+          seconds > 0 ? air / 1e4 / seconds : 0.0);
+}
+
+void loraPowerTimes(uint64_t* airtimeUs, uint64_t* sleepUs) {
+  std::lock_guard<std::mutex> lock(radioMutex);
+  *airtimeUs = stats.airtimeUs.load();
+  *sleepUs = asleepUs + (asleep ? simMicros() - asleepSinceUs : 0);
+}
+
+bool loraAsleep() {
+  std::lock_guard<std::mutex> lock(radioMutex);
+  return asleep;
+}
+
+// The SX127x keeps its registers through the ESP32's deep sleep
+void loraResumeAsleep(uint64_t sinceUs) {
+  std::lock_guard<std::mutex> lock(radioMutex);
+  asleep = true;
+  asleepSinceUs = sinceUs;
+}
+
+}  // namespace hostsim
+
+int LoRaClass::begin(long frequency) {
+  (void)frequency;
+  std::lock_guard<std::mutex> lock(radioMutex);
+  if (radioFault.load()) {
+    stats.faults.fetch_add(1);
+    return 0;
+  }
+  wake();
+  initialized = true;
+  inPacket = false;
+  modem = ModemConfig();
+  startDio0Thread();
+  return 1;
+}
+
+void LoRaClass::end() {
+  std::lock_guard<std::mutex> lock(radioMutex);
+  initialized = false;
+}
+
+bool LoRaClass::isTransmitting() {
+  std::lock_guard<std::mutex> lock(radioMutex);
+  return transmitting;
+}
+
+int LoRaClass::beginPacket(int implicitHeader) {
+  std::lock_guard<std::mutex> lock(radioMutex);
+  if (!initialized || transmitting) return 0;
+  if (radioFault.load()) {
+    stats.faults.fetch_add(1);
+    return 0;
+  }
+  wake();
+  modem.implicitHeader = implicitHeader != 0;
+  inPacket = true;
+  packetLength = 0;
+  return 1;
+}
+
+int LoRaClass::endPacket(bool async) {
+  std::unique_lock<std::mutex> lock(radioMutex);
+  if (!inPacket) return 0;
+  inPacket = false;
+  if (radioFault.load()) {
+    stats.faults.fetch_add(1);
+    return 0;
+  }
+
+  uint64_t airtime = airtimeUs(modem, packetLength);
+  if (async) {
+    memcpy(pendingPacket, packet, packetLength);
+    pendingLength = packetLength;
+    txDoneAt = hostsim::simMicros() + airtime;
+    transmitting = true;
+    asyncTx = true;
+    radioCv.notify_all();
+    return 1;
+  }
+
+  uint8_t frame[255];
+  size_t length = packetLength;
+  memcpy(frame, packet, length);
+  transmitting = true;
+  lock.unlock();
+  hostsim::sleepSimMicros(airtime);
+  deliver(frame, length, airtime);
+  lock.lock();
+  transmitting = false;
+  return 1;
+}
+
+int LoRaClass::parsePacket(int size) {
+  (void)size;
+  return 0;
+}
+
+int LoRaClass::packetRssi() {
+  return -80;
+}
+
+float LoRaClass::packetSnr() {
+  return 9.5f;
+}
+
+size_t LoRaClass::write(uint8_t byte) {
+  return write(&byte, 1);
+}
+
+size_t LoRaClass::write(const uint8_t* buffer, size_t size) {
+  std::lock_guard<std::mutex> lock(radioMutex);
+  if (!inPacket) return 0;
+  if (packetLength + size > sizeof(packet)) size = sizeof(packet) - packetLength;
+  memcpy(packet + packetLength, buffer, size);
+  packetLength += size;
+  return size;
+}
+
+int LoRaClass::available() { return 0; }
+int LoRaClass::read() { return -1; }
+int LoRaClass::peek() { return -1; }
+
+void LoRaClass::onReceive(void (*callback)(int)) { (void)callback; }
+
+void LoRaClass::onTxDone(void (*callback)()) {
+  std::lock_guard<std::mutex> lock(radioMutex);
+  txDoneCallback = callback;
+}
+
+void LoRaClass::receive(int size) { (void)size; }
+// Standby aborts a transmission in progress, as on the SX127x
+void LoRaClass::idle() {
+  std::lock_guard<std::mutex> lock(radioMutex);
+  wake();
+  transmitting = false;
+}
+// Sleep mode also aborts a transmission, and keeps the FIFO powered down
+// until the next beginPacket()
+void LoRaClass::sleep() {
+  std::lock_guard<std::mutex> lock(radioMutex);
+  transmitting = false;
+  inPacket = false;
+  if (!asleep) {
+    asleep = true;
+    asleepSinceUs = hostsim::simMicros();
+  }
+}
+
+void LoRaClass::setTxPower(int level, int outputPin) {
+  (void)level;
+  (void)outputPin;
+}
+
+void LoRaClass::setFrequency(long frequency) { (void)frequency; }
+
+void LoRaClass::setSpreadingFactor(int sf) {
+  std::lock_guard<std::mutex> lock(radioMutex);
+  if (sf < 6) sf = 6;
+  if (sf > 12) sf = 12;
+  modem.spreadingFactor = sf;
+}
+
+void LoRaClass::setSignalBandwidth(long sbw) {
+  std::lock_guard<std::mutex> lock(radioMutex);
+  modem.bandwidth = sbw;
+}
+
+void LoRaClass::setCodingRate4(int denominator) {
+  std::lock_guard<std::mutex> lock(radioMutex);
+  if (denominator < 5) denominator = 5;
+  if (denominator > 8) denominator = 8;
+  modem.codingRate = denominator;
+}
+
+void LoRaClass::setPreambleLength(long length) {
+  std::lock_guard<std::mutex> lock(radioMutex);
+  modem.preamble = length;
+}
+
+void LoRaClass::setSyncWord(int sw) { (void)sw; }
+
+void LoRaClass::enableCrc() {
+  std::lock_guard<std::mutex> lock(radioMutex);
+  modem.crc = true;
+}
+
+void LoRaClass::disableCrc() {
+  std::lock_guard<std::mutex> lock(radioMutex);
+  modem.crc = false;
+}
+
+void LoRaClass::setPins(int ss, int reset, int dio0) {
+  (void)ss;
+  (void)reset;
+  (void)dio0;
+}
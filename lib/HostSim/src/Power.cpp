@@ -0,0 +1,320 @@
+/**
+ * Power.cpp - Simulated power management and energy model
+ * 
+ * Copyright (C) 2025 Michael Garcia, M&E Design
+ * Based on original .ino by Geoff Mcintyre of Mr.Industries (https://mr.industries/)
+ * 
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ * 
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU General Public License for more details.
+ * 
+ * You should have received a copy of the GNU General Public License
+ * along with this program. If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#include "esp_pm.h"
+#include "esp_sleep.h"
+#include "driver/gpio.h"
+#include "driver/uart.h"
+#include "HostSim.h"
+#include "HostSimInternal.h"
+#include <mutex>
+#include <string>
+
+struct esp_pm_lock {
+  esp_pm_lock_type_t type;
+  std::string name;
+  int count;
+};
+
+namespace {
+  /**
+   * Energy model
+   *
+   * The CPU is charged WAKE_ACTIVE_US at full speed for every task wakeup;
+   * the rest of the time it idles. An idle gap of at least
+   * IDLE_SLEEP_MIN_US is spent in light sleep if power management allows
+   * it for the whole gap (light sleep configured, no lock held, WiFi off),
+   * as tickless idle would; shorter gaps idle at the minimum frequency, or
+   * at the maximum without power management. Deep sleep, and the
+   * bootloader after each wake from it, are charged from DeepSleep.cpp.
+   * The radios add their own current on top. Currents are datasheet
+   * typicals (ESP32 at 240/80 MHz, SX1276 at +17 dBm), so the result is an
+   * estimate for comparing firmware changes, not a measurement.
+   */
+  constexpr double CPU_ACTIVE_MA = 50.0;       // 240 MHz, running
+  constexpr double CPU_IDLE_MAX_MA = 30.0;     // 240 MHz, idle task waiting
+  constexpr double CPU_IDLE_MIN_MA = 20.0;     // POWER_MIN_FREQ_MHZ, idle
+  constexpr double LIGHT_SLEEP_MA = 0.8;
+  constexpr double WIFI_LISTEN_MA = 65.0;      // Radio receiving, above the CPU
+  constexpr double LORA_TX_MA = 87.0;
+  constexpr double LORA_STANDBY_MA = 1.6;
+  constexpr double LORA_SLEEP_MA = 0.0002;
+  constexpr uint64_t WAKE_ACTIVE_US = 1000;
+
+  constexpr double DEEP_SLEEP_MA = 0.01;        // RTC timer and RTC memory on
+
+  std::mutex energyMutex;
+  bool pmConfigured = false;
+  esp_pm_config_t pmConfig = {240, 240, false};
+  int heldLocks = 0;
+  bool wifiOn = false;
+  uint64_t wifiSinceUs = 0;
+  bool wakeGpio = false;
+  bool wakeUart = false;
+
+  hostsim::EnergyTotals carried = {};   // Earlier boots
+  hostsim::EnergyTotals boot = {};      // This boot; lora fields unused
+  bool deepSleeping = false;            // Resumed boot still in deep sleep
+  uint64_t deepSleepSinceUs = 0;
+
+  uint64_t accountedUs = 0;       // CPU time is accounted up to here
+  uint64_t activeLeftUs = 0;      // Still owed to the latest wakeups
+  uint64_t pendingIdleUs = 0;     // Idle in the current gap that may be slept
+
+  bool sleepAllowed() {
+    return pmConfigured && pmConfig.light_sleep_enable && heldLocks == 0 && !wifiOn;
+  }
+
+  bool idleAtMax() {
+    return !pmConfigured || pmConfig.min_freq_mhz >= pmConfig.max_freq_mhz;
+  }
+
+  // Ends the current idle gap: tickless idle only sleeps through gaps of
+  // at least IDLE_SLEEP_MIN_US
+  void settleGap() {
+    if (pendingIdleUs >= hostsim::IDLE_SLEEP_MIN_US) {
+      boot.sleepUs += pendingIdleUs;
+      boot.sleeps++;
+    } else {
+      boot.idleMinUs += pendingIdleUs;
+    }
+    pendingIdleUs = 0;
+  }
+
+  // Charges the time since the last call to the current state. Caller
+  // holds energyMutex.
+  void accrue(uint64_t now) {
+    if (now <= accountedUs || deepSleeping) return;
+    uint64_t span = now - accountedUs;
+    accountedUs = now;
+
+    uint64_t active = span < activeLeftUs ? span : activeLeftUs;
+    activeLeftUs -= active;
+    boot.activeUs += active;
+    span -= active;
+    if (span == 0) return;
+
+    if (sleepAllowed()) {
+      pendingIdleUs += span;
+    } else {
+      settleGap();
+      (idleAtMax() ? boot.idleMaxUs : boot.idleMinUs) += span;
+    }
+  }
+
+  // Caller holds energyMutex
+  void sumTotals(uint64_t now, hostsim::EnergyTotals* t) {
+    accrue(now);
+    settleGap();
+    uint64_t loraAirUs = 0, loraSleepUs = 0;
+    hostsim::loraPowerTimes(&loraAirUs, &loraSleepUs);
+
+    *t = carried;
+    t->activeUs += boot.activeUs;
+    t->idleMaxUs += boot.idleMaxUs;
+    t->idleMinUs += boot.idleMinUs;
+    t->sleepUs += boot.sleepUs;
+    t->bootUs += boot.bootUs;
+    t->deepSleepUs += boot.deepSleepUs + (deepSleeping ? now - deepSleepSinceUs : 0);
+    t->wifiUs += boot.wifiUs + (wifiOn ? now - wifiSinceUs : 0);
+    t->loraAirUs += loraAirUs;
+    t->loraSleepUs += loraSleepUs;
+    t->wakeups += boot.wakeups;
+    t->sleeps += boot.sleeps;
+    t->deepSleeps += boot.deepSleeps;
+  }
+
+  double percent(uint64_t part, uint64_t total) {
+    return total ? 100.0 * part / total : 0.0;
+  }
+}
+
+namespace hostsim {
+
+void energyTaskWakeup(uint64_t nowUs) {
+  std::lock_guard<std::mutex> lock(energyMutex);
+  accrue(nowUs);
+  settleGap();
+  activeLeftUs += WAKE_ACTIVE_US;
+  boot.wakeups++;
+}
+
+void setWifiPowered(bool on) {
+  std::lock_guard<std::mutex> lock(energyMutex);
+  uint64_t now = simMicros();
+  accrue(now);
+  if (on == wifiOn) return;
+  if (wifiOn) boot.wifiUs += now - wifiSinceUs;
+  wifiOn = on;
+  wifiSinceUs = now;
+}
+
+void energyTotals(EnergyTotals* totals) {
+  std::lock_guard<std::mutex> lock(energyMutex);
+  sumTotals(simMicros(), totals);
+}
+
+void energyResume(const EnergyTotals& totals, uint64_t sleepStartUs) {
+  std::lock_guard<std::mutex> lock(energyMutex);
+  carried = totals;
+  deepSleeping = true;
+  deepSleepSinceUs = sleepStartUs;
+  accountedUs = sleepStartUs;
+}
+
+// The bootloader runs at full speed between the wake and the app
+void energyWake(uint64_t wakeUs, uint64_t appStartUs) {
+  std::lock_guard<std::mutex> lock(energyMutex);
+  boot.deepSleepUs += wakeUs - deepSleepSinceUs;
+  boot.deepSleeps++;
+  boot.bootUs += appStartUs - wakeUs;
+  deepSleeping = false;
+  accountedUs = appStartUs;
+}
+
+void printEnergyStats(FILE* out) {
+  std::lock_guard<std::mutex> lock(energyMutex);
+  uint64_t now = simMicros();
+  if (now == 0) return;
+  EnergyTotals t;
+  sumTotals(now, &t);
+  uint64_t loraStandbyUs = now > t.loraAirUs + t.loraSleepUs ? now - t.loraAirUs - t.loraSleepUs : 0;
+
+  double cpuMa = ((t.activeUs + t.bootUs) * CPU_ACTIVE_MA + t.idleMaxUs * CPU_IDLE_MAX_MA +
+                  t.idleMinUs * CPU_IDLE_MIN_MA + t.sleepUs * LIGHT_SLEEP_MA + t.deepSleepUs * DEEP_SLEEP_MA) / now;
+  double wifiMa = t.wifiUs * WIFI_LISTEN_MA / now;
+  double loraMa = (t.loraAirUs * LORA_TX_MA + loraStandbyUs * LORA_STANDBY_MA + t.loraSleepUs * LORA_SLEEP_MA) / now;
+  double totalMa = cpuMa + wifiMa + loraMa;
+
+  fprintf(out, "[sim] pm: %s, %d-%d MHz, wake on timer%s%s\n",
+          !pmConfigured ? "not configured" : pmConfig.light_sleep_enable ? "light sleep" : "no sleep",
+          pmConfigured ? pmConfig.min_freq_mhz : 240, pmConfigured ? pmConfig.max_freq_mhz : 240,
+          wakeGpio ? ", gpio" : "", wakeUart ? ", uart" : "");
+  fprintf(out, "[sim] energy: %.2f mA average, %.1f mAh/day\n", totalMa, totalMa * 24.0);
+  fprintf(out, "[sim]   cpu  %6.2f mA: active %.2f%% (%u wakeups x %.1f ms), idle %.2f%% at max / %.2f%% at min freq, "
+               "light sleep %.2f%% (%u entries)\n",
+          cpuMa, percent(t.activeUs, now), t.wakeups, WAKE_ACTIVE_US / 1e3, percent(t.idleMaxUs, now),
+          percent(t.idleMinUs, now), percent(t.sleepUs, now), t.sleeps);
+  if (t.deepSleeps || deepSleeping) {
+    fprintf(out, "[sim]                deep sleep %.2f%% (%u wakes), boot %.2f%%\n", percent(t.deepSleepUs, now),
+            t.deepSleeps, percent(t.bootUs, now));
+  }
+  fprintf(out, "[sim]   wifi %6.2f mA: listening %.1f%%\n", wifiMa, percent(t.wifiUs, now));
+  fprintf(out, "[sim]   lora %6.2f mA: tx %.3f%%, standby %.1f%%, sleep %.1f%%\n", loraMa,
+          percent(t.loraAirUs, now), percent(loraStandbyUs, now), percent(t.loraSleepUs, now));
+}
+
+}  // namespace hostsim
+
+// -----------------------------------------------------------------------------
+// esp_pm
+// -----------------------------------------------------------------------------
+
+esp_err_t esp_pm_configure(const void* config) {
+  const esp_pm_config_t* cfg = static_cast<const esp_pm_config_t*>(config);
+  if (!cfg || cfg->min_freq_mhz > cfg->max_freq_mhz) return ESP_ERR_INVALID_ARG;
+  std::lock_guard<std::mutex> lock(energyMutex);
+  accrue(hostsim::simMicros());
+  pmConfig = *cfg;
+  pmConfigured = true;
+  return ESP_OK;
+}
+
+esp_err_t esp_pm_get_configuration(void* config) {
+  if (!config) return ESP_ERR_INVALID_ARG;
+  std::lock_guard<std::mutex> lock(energyMutex);
+  *static_cast<esp_pm_config_t*>(config) = pmConfig;
+  return ESP_OK;
+}
+
+esp_err_t esp_pm_lock_create(esp_pm_lock_type_t lock_type, int arg, const char* name,
+                             esp_pm_lock_handle_t* out_handle) {
+  (void)arg;
+  if (!out_handle) return ESP_ERR_INVALID_ARG;
+  *out_handle = new esp_pm_lock{lock_type, name ? name : "", 0};
+  return ESP_OK;
+}
+
+esp_err_t esp_pm_lock_delete(esp_pm_lock_handle_t handle) {
+  if (!handle) return ESP_ERR_INVALID_ARG;
+  if (handle->count) return ESP_ERR_INVALID_STATE;
+  delete handle;
+  return ESP_OK;
+}
+
+// Every lock type keeps the chip out of light sleep
+esp_err_t esp_pm_lock_acquire(esp_pm_lock_handle_t handle) {
+  if (!handle) return ESP_ERR_INVALID_ARG;
+  std::lock_guard<std::mutex> lock(energyMutex);
+  accrue(hostsim::simMicros());
+  handle->count++;
+  heldLocks++;
+  return ESP_OK;
+}
+
+esp_err_t esp_pm_lock_release(esp_pm_lock_handle_t handle) {
+  if (!handle) return ESP_ERR_INVALID_ARG;
+  std::lock_guard<std::mutex> lock(energyMutex);
+  if (handle->count == 0) return ESP_ERR_INVALID_STATE;
+  accrue(hostsim::simMicros());
+  handle->count--;
+  heldLocks--;
+  return ESP_OK;
+}
+
+esp_err_t esp_pm_dump_locks(FILE* stream) {
+  hostsim::printEnergyStats(stream);
+  return ESP_OK;
+}
+
+// -----------------------------------------------------------------------------
+// Wake-up sources
+// -----------------------------------------------------------------------------
+
+esp_err_t esp_sleep_enable_gpio_wakeup(void) {
+  std::lock_guard<std::mutex> lock(energyMutex);
+  wakeGpio = true;
+  return ESP_OK;
+}
+
+esp_err_t esp_sleep_enable_uart_wakeup(int uart_num) {
+  if (uart_num < UART_NUM_0 || uart_num > UART_NUM_1) return ESP_ERR_INVALID_ARG;
+  std::lock_guard<std::mutex> lock(energyMutex);
+  wakeUart = true;
+  return ESP_OK;
+}
+
+esp_err_t gpio_wakeup_enable(gpio_num_t gpio_num, gpio_int_type_t intr_type) {
+  if (gpio_num < 0 || (intr_type != GPIO_INTR_LOW_LEVEL && intr_type != GPIO_INTR_HIGH_LEVEL)) {
+    return ESP_ERR_INVALID_ARG;
+  }
+  return ESP_OK;
+}
+
+esp_err_t gpio_wakeup_disable(gpio_num_t gpio_num) {
+  return gpio_num < 0 ? ESP_ERR_INVALID_ARG : ESP_OK;
+}
+
+esp_err_t uart_set_wakeup_threshold(uart_port_t uart_num, int wakeup_threshold) {
+  if (uart_num < UART_NUM_0 || uart_num > UART_NUM_2 || wakeup_threshold < 3 || wakeup_threshold > 0x3ff) {
+    return ESP_ERR_INVALID_ARG;
+  }
+  return ESP_OK;
+}
@@ -0,0 +1,57 @@
+/**
+ * WiFi.h - Simulated WiFi station interface
+ * 
+ * Copyright (C) 2025 Michael Garcia, M&E Design
+ * Based on original .ino by Geoff Mcintyre of Mr.Industries (https://mr.industries/)
+ * 
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ * 
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU General Public License for more details.
+ * 
+ * You should have received a copy of the GNU General Public License
+ * along with this program. If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#pragma once
+#include "Arduino.h"
+#include "esp_wifi.h"
+
+#define WIFI_OFF   WIFI_MODE_NULL
+#define WIFI_STA   WIFI_MODE_STA
+#define WIFI_AP    WIFI_MODE_AP
+#define WIFI_AP_STA WIFI_MODE_APSTA
+
+typedef enum {
+  WL_IDLE_STATUS = 0,
+  WL_NO_SSID_AVAIL = 1,
+  WL_SCAN_COMPLETED = 2,
+  WL_CONNECTED = 3,
+  WL_CONNECT_FAILED = 4,
+  WL_CONNECTION_LOST = 5,
+  WL_DISCONNECTED = 6
+} wl_status_t;
+
+/**
+ * Host WiFi station. There is no IP stack; the station "associates" a
+ * short simulated time after mode() so boot code waiting on status()
+ * behaves as it does next to a real access point.
+ */
+class WiFiClass {
+ public:
+  bool mode(wifi_mode_t mode);
+  wifi_mode_t getMode();
+  wl_status_t status();
+  bool disconnect(bool wifiOff = false);
+  String macAddress();
+  uint8_t* macAddress(uint8_t* mac);
+  String softAPmacAddress();
+  int32_t channel();
+};
+
+extern WiFiClass WiFi;
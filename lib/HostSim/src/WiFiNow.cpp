@@ -0,0 +1,330 @@
+/**
+ * WiFiNow.cpp - Simulated WiFi station and ESP-NOW driver
+ * 
+ * Copyright (C) 2025 Michael Garcia, M&E Design
+ * Based on original .ino by Geoff Mcintyre of Mr.Industries (https://mr.industries/)
+ * 
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ * 
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU General Public License for more details.
+ * 
+ * You should have received a copy of the GNU General Public License
+ * along with this program. If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#include "WiFi.h"
+#include "esp_now.h"
+#include "HostSim.h"
+#include "HostSimInternal.h"
+#include <atomic>
+#include <mutex>
+#include <thread>
+#include <vector>
+#include <random>
+
+WiFiClass WiFi;
+
+namespace {
+  const uint8_t stationMac[6] = {0x24, 0x0A, 0xC4, 0x00, 0x00, 0x01};
+  const uint8_t softApMac[6] = {0x24, 0x0A, 0xC4, 0x00, 0x00, 0x02};
+  const uint64_t ASSOCIATION_US = 250000;
+
+  std::atomic<int> wifiMode{WIFI_MODE_NULL};
+  std::atomic<uint64_t> modeSetAt{0};
+  uint8_t wifiChannel = 1;
+
+  String formatMac(const uint8_t* mac) {
+    char buf[18];
+    snprintf(buf, sizeof(buf), "%02X:%02X:%02X:%02X:%02X:%02X",
+             mac[0], mac[1], mac[2], mac[3], mac[4], mac[5]);
+    return String(buf);
+  }
+}
+
+const char* esp_err_to_name(esp_err_t code) {
+  switch (code) {
+    case ESP_OK: return "ESP_OK";
+    case ESP_FAIL: return "ESP_FAIL";
+    case ESP_ERR_NO_MEM: return "ESP_ERR_NO_MEM";
+    case ESP_ERR_INVALID_ARG: return "ESP_ERR_INVALID_ARG";
+    case ESP_ERR_INVALID_STATE: return "ESP_ERR_INVALID_STATE";
+    case ESP_ERR_NOT_FOUND: return "ESP_ERR_NOT_FOUND";
+    case ESP_ERR_ESPNOW_NOT_INIT: return "ESP_ERR_ESPNOW_NOT_INIT";
+    case ESP_ERR_ESPNOW_ARG: return "ESP_ERR_ESPNOW_ARG";
+    case ESP_ERR_ESPNOW_FULL: return "ESP_ERR_ESPNOW_FULL";
+    case ESP_ERR_ESPNOW_NOT_FOUND: return "ESP_ERR_ESPNOW_NOT_FOUND";
+    case ESP_ERR_ESPNOW_EXIST: return "ESP_ERR_ESPNOW_EXIST";
+    default: return "UNKNOWN_ERROR";
+  }
+}
+
+// -----------------------------------------------------------------------------
+// WiFi
+// -----------------------------------------------------------------------------
+
+bool WiFiClass::mode(wifi_mode_t mode) {
+  wifiMode.store(mode);
+  modeSetAt.store(hostsim::simMicros());
+  hostsim::setWifiPowered(mode != WIFI_MODE_NULL);
+  return true;
+}
+
+wifi_mode_t WiFiClass::getMode() {
+  return (wifi_mode_t)wifiMode.load();
+}
+
+wl_status_t WiFiClass::status() {
+  if (wifiMode.load() != WIFI_MODE_STA) return WL_DISCONNECTED;
+  return hostsim::simMicros() - modeSetAt.load() >= ASSOCIATION_US ? WL_CONNECTED : WL_DISCONNECTED;
+}
+
+bool WiFiClass::disconnect(bool wifiOff) {
+  if (wifiOff) {
+    wifiMode.store(WIFI_MODE_NULL);
+    hostsim::setWifiPowered(false);
+  }
+  return true;
+}
+
+String WiFiClass::macAddress() {
+  return formatMac(stationMac);
+}
+
+uint8_t* WiFiClass::macAddress(uint8_t* mac) {
+  memcpy(mac, stationMac, 6);
+  return mac;
+}
+
+String WiFiClass::softAPmacAddress() {
+  return formatMac(softApMac);
+}
+
+int32_t WiFiClass::channel() {
+  return wifiChannel;
+}
+
+esp_err_t esp_wifi_set_channel(uint8_t primary, wifi_second_chan_t second) {
+  (void)second;
+  if (primary < 1 || primary > 14) return ESP_ERR_INVALID_ARG;
+  wifiChannel = primary;
+  return ESP_OK;
+}
+
+esp_err_t esp_wifi_get_mac(wifi_interface_t ifx, uint8_t mac[6]) {
+  memcpy(mac, ifx == WIFI_IF_STA ? stationMac : softApMac, 6);
+  return ESP_OK;
+}
+
+// -----------------------------------------------------------------------------
+// ESP-NOW
+// -----------------------------------------------------------------------------
+
+namespace {
+  std::mutex nowMutex;
+  bool nowInitialized = false;
+  esp_now_recv_cb_t recvCallback = nullptr;
+  esp_now_send_cb_t sendCallback = nullptr;
+  std::vector<esp_now_peer_info_t> registeredPeers;
+
+  struct NowStats {
+    std::atomic<uint32_t> framesSent{0};
+    std::atomic<uint32_t> framesDelivered{0};
+    std::atomic<uint32_t> framesDropped{0};
+    std::atomic<uint32_t> framesTransmitted{0};
+  } nowStats;
+
+  // A simulated remote node streaming "DIST:<inches>,<seq>" lines.
+  struct SimPeer {
+    uint8_t mac[6];
+    std::atomic<float> rateHz;
+    std::atomic<bool> running;
+  };
+
+  std::mutex simPeersMutex;
+  std::vector<SimPeer*> simPeers;
+
+  bool macEqual(const uint8_t* a, const uint8_t* b) {
+    return memcmp(a, b, 6) == 0;
+  }
+
+  void deliverFrame(const uint8_t* mac, int8_t rssi, const uint8_t* data, int len) {
+    nowStats.framesSent.fetch_add(1);
+    esp_now_recv_cb_t callback;
+    {
+      std::lock_guard<std::mutex> lock(nowMutex);
+      callback = nowInitialized ? recvCallback : nullptr;
+    }
+    if (!callback) {
+      nowStats.framesDropped.fetch_add(1);
+      return;
+    }
+    nowStats.framesDelivered.fetch_add(1);
+    // On hardware every receive callback runs in the single WiFi task, so
+    // serialize deliveries from the peer threads the same way
+    static std::mutex wifiTaskMutex;
+    std::lock_guard<std::mutex> lock(wifiTaskMutex);
+    uint8_t src[6];
+    uint8_t dest[6];
+    memcpy(src, mac, 6);
+    esp_wifi_get_mac(WIFI_IF_STA, dest);
+    wifi_pkt_rx_ctrl_t rxCtrl = {};
+    rxCtrl.rssi = rssi;
+    rxCtrl.channel = wifiChannel;
+    esp_now_recv_info_t info = {src, dest, &rxCtrl};
+    callback(&info, data, len);
+  }
+
+  void simPeerThread(SimPeer* peer) {
+    std::mt19937 rng(peer->mac[5]);
+    std::normal_distribution<float> step(0.0f, 0.2f);
+    std::uniform_int_distribution<int> fade(-3, 3);
+    float distance = 40.0f + peer->mac[5] % 20;
+    int baseRssi = -55 - peer->mac[5] % 30;
+    uint16_t sequence = 0;
+    while (peer->running.load()) {
+      float rate = peer->rateHz.load();
+      hostsim::sleepSimMicros((uint64_t)(1e6f / (rate > 0.01f ? rate : 0.01f)));
+      if (!peer->running.load()) break;
+      distance += step(rng);
+      if (distance < 1.0f) distance = 1.0f;
+      char frame[32];
+      int len = snprintf(frame, sizeof(frame), "DIST:%.2f,%u\n", distance, (unsigned)sequence++);
+      deliverFrame(peer->mac, (int8_t)(baseRssi + fade(rng)), (const uint8_t*)frame, len);
+    }
+  }
+}
+
+namespace hostsim {
+
+bool addNowPeer(const uint8_t mac[6], float rateHz) {
+  std::lock_guard<std::mutex> lock(simPeersMutex);
+  for (SimPeer* peer : simPeers) {
+    if (macEqual(peer->mac, mac) && peer->running.load()) {
+      peer->rateHz.store(rateHz);
+      return true;
+    }
+  }
+  SimPeer* peer = new SimPeer();
+  memcpy(peer->mac, mac, 6);
+  peer->rateHz.store(rateHz);
+  peer->running.store(true);
+  simPeers.push_back(peer);
+  std::thread(simPeerThread, peer).detach();
+  fprintf(stderr, "[sim] ESP-NOW peer %s streaming at %.1f Hz\n", formatMac(mac).c_str(), rateHz);
+  return true;
+}
+
+bool removeNowPeer(const uint8_t mac[6]) {
+  std::lock_guard<std::mutex> lock(simPeersMutex);
+  for (SimPeer* peer : simPeers) {
+    if (macEqual(peer->mac, mac)) peer->running.store(false);
+  }
+  return true;
+}
+
+void pendingPeer(const uint8_t mac[6], float rateHz) {
+  // Peers given on the command line start streaming immediately; frames
+  // that arrive before esp_now_init() are dropped, as on hardware.
+  addNowPeer(mac, rateHz);
+}
+
+void printNowStats(FILE* out) {
+  fprintf(out, "[sim] espnow rx_frames=%u delivered=%u dropped=%u tx_frames=%u\n",
+          nowStats.framesSent.load(), nowStats.framesDelivered.load(),
+          nowStats.framesDropped.load(), nowStats.framesTransmitted.load());
+}
+
+}  // namespace hostsim
+
+esp_err_t esp_now_init(void) {
+  std::lock_guard<std::mutex> lock(nowMutex);
+  if (WiFi.getMode() == WIFI_MODE_NULL) return ESP_ERR_INVALID_STATE;
+  nowInitialized = true;
+  return ESP_OK;
+}
+
+esp_err_t esp_now_deinit(void) {
+  std::lock_guard<std::mutex> lock(nowMutex);
+  nowInitialized = false;
+  recvCallback = nullptr;
+  sendCallback = nullptr;
+  registeredPeers.clear();
+  return ESP_OK;
+}
+
+esp_err_t esp_now_register_recv_cb(esp_now_recv_cb_t cb) {
+  std::lock_guard<std::mutex> lock(nowMutex);
+  if (!nowInitialized) return ESP_ERR_ESPNOW_NOT_INIT;
+  recvCallback = cb;
+  return ESP_OK;
+}
+
+esp_err_t esp_now_unregister_recv_cb(void) {
+  std::lock_guard<std::mutex> lock(nowMutex);
+  recvCallback = nullptr;
+  return ESP_OK;
+}
+
+esp_err_t esp_now_register_send_cb(esp_now_send_cb_t cb) {
+  std::lock_guard<std::mutex> lock(nowMutex);
+  if (!nowInitialized) return ESP_ERR_ESPNOW_NOT_INIT;
+  sendCallback = cb;
+  return ESP_OK;
+}
+
+esp_err_t esp_now_unregister_send_cb(void) {
+  std::lock_guard<std::mutex> lock(nowMutex);
+  sendCallback = nullptr;
+  return ESP_OK;
+}
+
+esp_err_t esp_now_send(const uint8_t* peer_addr, const uint8_t* data, size_t len) {
+  esp_now_send_cb_t callback;
+  {
+    std::lock_guard<std::mutex> lock(nowMutex);
+    if (!nowInitialized) return ESP_ERR_ESPNOW_NOT_INIT;
+    if (!data || len == 0 || len > ESP_NOW_MAX_DATA_LEN) return ESP_ERR_ESPNOW_ARG;
+    callback = sendCallback;
+  }
+  nowStats.framesTransmitted.fetch_add(1);
+  if (callback) callback(peer_addr, ESP_NOW_SEND_SUCCESS);
+  return ESP_OK;
+}
+
+esp_err_t esp_now_add_peer(const esp_now_peer_info_t* peer) {
+  std::lock_guard<std::mutex> lock(nowMutex);
+  if (!nowInitialized) return ESP_ERR_ESPNOW_NOT_INIT;
+  if (!peer) return ESP_ERR_ESPNOW_ARG;
+  for (const esp_now_peer_info_t& p : registeredPeers) {
+    if (macEqual(p.peer_addr, peer->peer_addr)) return ESP_ERR_ESPNOW_EXIST;
+  }
+  if (registeredPeers.size() >= ESP_NOW_MAX_TOTAL_PEER_NUM) return ESP_ERR_ESPNOW_FULL;
+  registeredPeers.push_back(*peer);
+  return ESP_OK;
+}
+
+esp_err_t esp_now_del_peer(const uint8_t* peer_addr) {
+  std::lock_guard<std::mutex> lock(nowMutex);
+  if (!nowInitialized) return ESP_ERR_ESPNOW_NOT_INIT;
+  for (size_t i = 0; i < registeredPeers.size(); i++) {
+    if (macEqual(registeredPeers[i].peer_addr, peer_addr)) {
+      registeredPeers.erase(registeredPeers.begin() + i);
+      return ESP_OK;
+    }
+  }
+  return ESP_ERR_ESPNOW_NOT_FOUND;
+}
+
+bool esp_now_is_peer_exist(const uint8_t* peer_addr) {
+  std::lock_guard<std::mutex> lock(nowMutex);
+  for (const esp_now_peer_info_t& p : registeredPeers) {
+    if (macEqual(p.peer_addr, peer_addr)) return true;
+  }
+  return false;
+}
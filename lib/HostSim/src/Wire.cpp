@@ -0,0 +1,413 @@
+/**
+ * Wire.cpp - Simulated I2C bus and sensor device models
+ * 
+ * Copyright (C) 2025 Michael Garcia, M&E Design
+ * Based on original .ino by Geoff Mcintyre of Mr.Industries (https://mr.industries/)
+ * 
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ * 
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU General Public License for more details.
+ * 
+ * You should have received a copy of the GNU General Public License
+ * along with this program. If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#include "Wire.h"
+#include "HostSim.h"
+#include "HostSimInternal.h"
+#include <atomic>
+#include <thread>
+#include <mutex>
+#include <cmath>
+
+TwoWire Wire;
+
+// -----------------------------------------------------------------------------
+// Simulated environment
+// -----------------------------------------------------------------------------
+
+namespace {
+  std::mutex envMutex;
+  hostsim::Environment environment = {22.5f, 45.0f, 800.0f, 0.0f};
+
+  struct BusStats {
+    std::atomic<uint32_t> transactions{0};
+    std::atomic<uint32_t> nacks{0};
+    std::atomic<uint64_t> bytes{0};
+    std::atomic<uint64_t> busTimeUs{0};
+  } busStats;
+}
+
+namespace hostsim {
+
+Environment getEnvironment() {
+  std::lock_guard<std::mutex> lock(envMutex);
+  return environment;
+}
+
+void setEnvironment(const Environment& env) {
+  std::lock_guard<std::mutex> lock(envMutex);
+  environment = env;
+}
+
+// Day profile compressed into luxDaySeconds: 1 lx of night, a sine from
+// sunrise at 06:00 to sunset at 20:00 peaking at env.lux, and a cloud
+// every 1/96 of the day dimming it to between 30 % and 100 %.
+float currentLux() {
+  Environment env = getEnvironment();
+  if (env.luxDaySeconds <= 0.0f) return env.lux;
+
+  double day = (double)simMicros() / 1e6 / env.luxDaySeconds;
+  double hour = (day - floor(day)) * 24.0;
+  if (hour < 6.0 || hour > 20.0) return 1.0f;
+
+  uint32_t slot = (uint32_t)(day * 96.0);
+  slot ^= slot >> 16;
+  slot *= 0x45D9F3BU;
+  slot ^= slot >> 16;
+  double cloud = 0.3 + 0.7 * (slot % 1000) / 999.0;
+  double lux = env.lux * sin((hour - 6.0) * M_PI / 14.0) * cloud;
+  return (float)(lux > 1.0 ? lux : 1.0);
+}
+
+}  // namespace hostsim
+
+// -----------------------------------------------------------------------------
+// Device models
+// -----------------------------------------------------------------------------
+
+namespace {
+
+class I2cDevice {
+ public:
+  explicit I2cDevice(uint8_t addr) : address(addr) {}
+  virtual ~I2cDevice() {}
+  virtual bool onWrite(const uint8_t* data, size_t len) = 0;
+  virtual size_t onRead(uint8_t* out, size_t len) = 0;
+
+  uint8_t address;
+  std::atomic<bool> present{true};
+};
+
+uint8_t htuCrc8(const uint8_t* data, size_t len) {
+  uint8_t crc = 0;
+  for (size_t i = 0; i < len; i++) {
+    crc ^= data[i];
+    for (int bit = 0; bit < 8; bit++) {
+      crc = (crc & 0x80) ? (uint8_t)((crc << 1) ^ 0x31) : (uint8_t)(crc << 1);
+    }
+  }
+  return crc;
+}
+
+/**
+ * HTU21D-F: hold-master (0xE3/0xE5) reads stretch the clock until the
+ * conversion finishes; no-hold-master (0xF3/0xF5) reads NACK until then.
+ */
+class Htu21dfModel : public I2cDevice {
+ public:
+  Htu21dfModel() : I2cDevice(0x40) {}
+
+  bool onWrite(const uint8_t* data, size_t len) override {
+    if (len == 0) return true;
+    command = data[0];
+    switch (command) {
+      case 0xE3: case 0xF3:
+        startConversion(TEMP_CONVERSION_US);
+        break;
+      case 0xE5: case 0xF5:
+        startConversion(HUMIDITY_CONVERSION_US);
+        break;
+      case 0xFE: case 0xE6: case 0xE7:
+        break;
+      default:
+        return false;
+    }
+    return true;
+  }
+
+  size_t onRead(uint8_t* out, size_t len) override {
+    if (command == 0xE7) {
+      if (len > 0) out[0] = 0x02;
+      return len > 0 ? 1 : 0;
+    }
+
+    bool hold = (command == 0xE3 || command == 0xE5);
+    bool isTemp = (command == 0xE3 || command == 0xF3);
+    if (!hold && !isTemp && command != 0xF5) return 0;
+
+    uint64_t now = hostsim::simMicros();
+    if (now < readyAt) {
+      if (!hold) return 0;
+      hostsim::sleepSimMicros(readyAt - now);
+    }
+
+    hostsim::Environment env = hostsim::getEnvironment();
+    uint16_t raw;
+    if (isTemp) {
+      raw = (uint16_t)((env.temperatureC + 46.85f) / 175.72f * 65536.0f) & 0xFFFC;
+    } else {
+      raw = (uint16_t)((env.humidity + 6.0f) / 125.0f * 65536.0f) & 0xFFFC;
+      raw |= 0x0002;
+    }
+
+    uint8_t frame[3] = {(uint8_t)(raw >> 8), (uint8_t)(raw & 0xFF), 0};
+    frame[2] = htuCrc8(frame, 2);
+    size_t n = len < 3 ? len : 3;
+    memcpy(out, frame, n);
+    command = 0;
+    return n;
+  }
+
+ private:
+  static constexpr uint64_t TEMP_CONVERSION_US = 50000;
+  static constexpr uint64_t HUMIDITY_CONVERSION_US = 16000;
+
+  void startConversion(uint64_t durationUs) {
+    readyAt = hostsim::simMicros() + durationUs;
+  }
+
+  uint8_t command = 0;
+  uint64_t readyAt = 0;
+};
+
+/**
+ * TSL2561: channel counts follow the simulated lux level with a fixed
+ * IR/visible ratio, scaled by gain and integration time and clipped at
+ * the ADC full scale. Data is only valid one integration period after
+ * power-up. Conversions read, clipped readings and powered time are
+ * counted for the stats.
+ */
+class Tsl2561Model : public I2cDevice {
+ public:
+  Tsl2561Model() : I2cDevice(0x39) {}
+
+  std::atomic<uint32_t> conversions{0};
+  std::atomic<uint32_t> saturated{0};
+  std::atomic<uint64_t> poweredUs{0};
+
+  bool onWrite(const uint8_t* data, size_t len) override {
+    if (len == 0) return true;
+    if (!(data[0] & 0x80)) return false;
+    pointer = data[0] & 0x0F;
+    if (len >= 2) {
+      if (pointer == 0x00) {
+        bool on = (data[1] & 0x03) == 0x03;
+        if (on && !powered) powerOnAt = hostsim::simMicros();
+        if (!on && powered) poweredUs.fetch_add(hostsim::simMicros() - powerOnAt);
+        powered = on;
+      } else if (pointer == 0x01) {
+        timing = data[1];
+      }
+    }
+    return true;
+  }
+
+  size_t onRead(uint8_t* out, size_t len) override {
+    for (size_t i = 0; i < len; i++) {
+      out[i] = readRegister((uint8_t)(pointer + i));
+    }
+    return len;
+  }
+
+ private:
+  uint8_t readRegister(uint8_t reg) {
+    switch (reg) {
+      case 0x00: return powered ? 0x03 : 0x00;
+      case 0x01: return timing;
+      case 0x0A: return 0x50;
+      case 0x0C: {
+        // A conversion is read low byte first
+        uint16_t counts = channel(0);
+        uint8_t integ = timing & 0x03;
+        if (powered && integ <= 2) {
+          conversions.fetch_add(1);
+          if (counts >= fullScale[integ]) saturated.fetch_add(1);
+        }
+        return (uint8_t)(counts & 0xFF);
+      }
+      case 0x0D: return (uint8_t)(channel(0) >> 8);
+      case 0x0E: return (uint8_t)(channel(1) & 0xFF);
+      case 0x0F: return (uint8_t)(channel(1) >> 8);
+      default:   return 0;
+    }
+  }
+
+  static constexpr uint32_t fullScale[] = {5047, 37177, 65535};
+
+  uint16_t channel(int index) {
+    static const uint32_t integrationUs[] = {13700, 101000, 402000};
+    static const float integrationScale[] = {1024.0f / 0x7517, 1024.0f / 0x0FE7, 1.0f};
+
+    uint8_t integ = timing & 0x03;
+    if (integ > 2 || !powered) return 0;
+    if (hostsim::simMicros() - powerOnAt < integrationUs[integ]) return 0;
+
+    // Inverse of the datasheet lux equation for an IR ratio of 0.30
+    // (coefficients B3T/M3T) at 402 ms, 16x gain.
+    const float irRatio = 0.30f;
+    float lux = hostsim::currentLux();
+    float counts = lux * 16384.0f / (0x023F - irRatio * 0x037B);
+    counts *= integrationScale[integ];
+    if (!(timing & 0x10)) counts /= 16.0f;
+    if (index == 1) counts *= irRatio;
+
+    if (counts < 0) counts = 0;
+    if (counts > fullScale[integ]) counts = (float)fullScale[integ];
+    return (uint16_t)counts;
+  }
+
+  uint8_t pointer = 0;
+  uint8_t timing = 0x02;
+  bool powered = false;
+  uint64_t powerOnAt = 0;
+};
+
+constexpr uint32_t Tsl2561Model::fullScale[];
+
+Htu21dfModel htuModel;
+Tsl2561Model tslModel;
+I2cDevice* const devices[] = {&htuModel, &tslModel};
+std::recursive_mutex busMutex;
+
+I2cDevice* findDevice(uint16_t address) {
+  for (I2cDevice* dev : devices) {
+    if (dev->address == address && dev->present.load()) return dev;
+  }
+  return nullptr;
+}
+
+}  // namespace
+
+namespace hostsim {
+
+void setI2cDevicePresent(uint8_t address, bool present) {
+  for (I2cDevice* dev : devices) {
+    if (dev->address == address) dev->present.store(present);
+  }
+}
+
+void printI2cStats(FILE* out) {
+  uint32_t transactions = busStats.transactions.load();
+  uint64_t busUs = busStats.busTimeUs.load();
+  double seconds = (double)simMicros() / 1e6;
+  fprintf(out, "[sim] i2c transactions=%u bytes=%llu nacks=%u bus_time=%.1fms (%.2f%% utilisation)\n",
+          transactions, (unsigned long long)busStats.bytes.load(), busStats.nacks.load(),
+          busUs / 1000.0, seconds > 0 ? busUs / 1e4 / seconds : 0.0);
+  uint32_t conversions = tslModel.conversions.load();
+  uint32_t saturated = tslModel.saturated.load();
+  double poweredMs = tslModel.poweredUs.load() / 1000.0;
+  fprintf(out, "[sim] tsl2561 conversions=%u saturated=%u (%.1f%%) powered=%.1fms (%.1f ms/conversion)\n",
+          conversions, saturated, conversions ? 100.0 * saturated / conversions : 0.0, poweredMs,
+          conversions ? poweredMs / conversions : 0.0);
+}
+
+}  // namespace hostsim
+
+// -----------------------------------------------------------------------------
+// TwoWire
+// -----------------------------------------------------------------------------
+
+namespace {
+  // Start + address byte + payload bytes (9 clocks each) + stop.
+  void chargeBusTime(uint32_t clockHz, size_t payloadBytes) {
+    uint64_t bits = 2 + 9 * (1 + payloadBytes);
+    uint64_t us = bits * 1000000ULL / (clockHz ? clockHz : 100000);
+    busStats.transactions.fetch_add(1, std::memory_order_relaxed);
+    busStats.bytes.fetch_add(payloadBytes, std::memory_order_relaxed);
+    busStats.busTimeUs.fetch_add(us, std::memory_order_relaxed);
+
+    // Spin rather than sleep: a sleep's wakeup latency is longer than a
+    // whole fast-mode transfer and would swamp bus timing measurements
+    auto deadline = hostsim::realDeadline(us);
+    while (std::chrono::steady_clock::now() < deadline) {
+      std::this_thread::yield();
+    }
+  }
+}
+
+bool TwoWire::begin(int sda, int scl, uint32_t frequency) {
+  (void)sda;
+  (void)scl;
+  if (frequency) clockHz = frequency;
+  return true;
+}
+
+bool TwoWire::end() {
+  return true;
+}
+
+bool TwoWire::setClock(uint32_t frequency) {
+  clockHz = frequency;
+  return true;
+}
+
+uint32_t TwoWire::getClock() {
+  return clockHz;
+}
+
+void TwoWire::beginTransmission(uint16_t address) {
+  busMutex.lock();
+  txAddress = address;
+  txLength = 0;
+}
+
+uint8_t TwoWire::endTransmission(bool sendStop) {
+  (void)sendStop;
+  I2cDevice* dev = findDevice(txAddress);
+  chargeBusTime(clockHz, txLength);
+  uint8_t result = 0;
+  if (!dev) {
+    result = 2;
+  } else if (!dev->onWrite(txBuffer, txLength)) {
+    result = 3;
+  }
+  if (result) busStats.nacks.fetch_add(1, std::memory_order_relaxed);
+  txLength = 0;
+  busMutex.unlock();
+  return result;
+}
+
+size_t TwoWire::requestFrom(uint16_t address, size_t size, bool sendStop) {
+  (void)sendStop;
+  std::lock_guard<std::recursive_mutex> lock(busMutex);
+  if (size > sizeof(rxBuffer)) size = sizeof(rxBuffer);
+  rxIndex = 0;
+  rxLength = 0;
+
+  I2cDevice* dev = findDevice(address);
+  if (dev) rxLength = dev->onRead(rxBuffer, size);
+  chargeBusTime(clockHz, rxLength);
+  if (rxLength == 0) busStats.nacks.fetch_add(1, std::memory_order_relaxed);
+  return rxLength;
+}
+
+size_t TwoWire::write(uint8_t data) {
+  if (txLength >= sizeof(txBuffer)) return 0;
+  txBuffer[txLength++] = data;
+  return 1;
+}
+
+size_t TwoWire::write(const uint8_t* data, size_t quantity) {
+  size_t n = 0;
+  while (n < quantity && write(data[n])) n++;
+  return n;
+}
+
+int TwoWire::available() {
+  return (int)(rxLength - rxIndex);
+}
+
+int TwoWire::read() {
+  return rxIndex < rxLength ? rxBuffer[rxIndex++] : -1;
+}
+
+int TwoWire::peek() {
+  return rxIndex < rxLength ? rxBuffer[rxIndex] : -1;
+}
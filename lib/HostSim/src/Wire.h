@@ -0,0 +1,64 @@
+/**
+ * Wire.h - Simulated I2C bus interface
+ * 
+ * Copyright (C) 2025 Michael Garcia, M&E Design
+ * Based on original .ino by Geoff Mcintyre of Mr.Industries (https://mr.industries/)
+ * 
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ * 
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU General Public License for more details.
+ * 
+ * You should have received a copy of the GNU General Public License
+ * along with this program. If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#pragma once
+#include "Arduino.h"
+
+#define I2C_BUFFER_LENGTH 128
+
+/**
+ * Host I2C bus. Transactions are routed to simulated device models
+ * (HTU21D-F at 0x40, TSL2561 at 0x39) and cost simulated bus time
+ * according to the configured SCL clock.
+ */
+class TwoWire : public Stream {
+ public:
+  bool begin(int sda = -1, int scl = -1, uint32_t frequency = 0);
+  bool end();
+  bool setClock(uint32_t frequency);
+  uint32_t getClock();
+
+  void beginTransmission(uint16_t address);
+  void beginTransmission(int address) { beginTransmission((uint16_t)address); }
+  uint8_t endTransmission(bool sendStop = true);
+
+  size_t requestFrom(uint16_t address, size_t size, bool sendStop = true);
+  uint8_t requestFrom(uint8_t address, uint8_t size) { return (uint8_t)requestFrom((uint16_t)address, (size_t)size, true); }
+  uint8_t requestFrom(int address, int size) { return (uint8_t)requestFrom((uint16_t)address, (size_t)size, true); }
+
+  size_t write(uint8_t data) override;
+  size_t write(const uint8_t* data, size_t quantity) override;
+  using Print::write;
+  int available() override;
+  int read() override;
+  int peek() override;
+  void flush() override {}
+
+ private:
+  uint32_t clockHz = 100000;
+  uint16_t txAddress = 0;
+  uint8_t txBuffer[I2C_BUFFER_LENGTH];
+  size_t txLength = 0;
+  uint8_t rxBuffer[I2C_BUFFER_LENGTH];
+  size_t rxLength = 0;
+  size_t rxIndex = 0;
+};
+
+extern TwoWire Wire;
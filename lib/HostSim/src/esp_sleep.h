@@ -0,0 +1,53 @@
+/**
+ * esp_sleep.h - Simulated sleep wake-up sources
+ * 
+ * Copyright (C) 2025 Michael Garcia, M&E Design
+ * Based on original .ino by Geoff Mcintyre of Mr.Industries (https://mr.industries/)
+ * 
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ * 
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU General Public License for more details.
+ * 
+ * You should have received a copy of the GNU General Public License
+ * along with this program. If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#pragma once
+#include <stdint.h>
+#include "esp_err.h"
+#include "driver/gpio.h"
+
+/**
+ * Host sleep. Light sleep happens in the energy model (esp_pm.h); the
+ * light-sleep wake-up sources only record that they are armed.
+ *
+ * esp_deep_sleep_start() resets the node as on hardware: RTC_DATA_ATTR
+ * memory and the armed wake-up sources are saved and the program is
+ * executed again, which sleeps out the timer (or until "!button" presses
+ * the ext0 pin) before setup() runs with everything else reset.
+ */
+
+typedef enum {
+  ESP_SLEEP_WAKEUP_UNDEFINED = 0,     // Not a wake from deep sleep
+  ESP_SLEEP_WAKEUP_ALL,
+  ESP_SLEEP_WAKEUP_EXT0,
+  ESP_SLEEP_WAKEUP_EXT1,
+  ESP_SLEEP_WAKEUP_TIMER,
+  ESP_SLEEP_WAKEUP_TOUCHPAD,
+  ESP_SLEEP_WAKEUP_ULP,
+  ESP_SLEEP_WAKEUP_GPIO,
+  ESP_SLEEP_WAKEUP_UART
+} esp_sleep_wakeup_cause_t;
+
+esp_err_t esp_sleep_enable_timer_wakeup(uint64_t time_in_us);
+esp_err_t esp_sleep_enable_gpio_wakeup(void);
+esp_err_t esp_sleep_enable_uart_wakeup(int uart_num);
+esp_err_t esp_sleep_enable_ext0_wakeup(gpio_num_t gpio_num, int level);
+esp_sleep_wakeup_cause_t esp_sleep_get_wakeup_cause(void);
+[[noreturn]] void esp_deep_sleep_start(void);
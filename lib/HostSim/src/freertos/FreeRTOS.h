@@ -0,0 +1,76 @@
+/**
+ * FreeRTOS.h - Host FreeRTOS configuration and port layer
+ * 
+ * Copyright (C) 2025 Michael Garcia, M&E Design
+ * Based on original .ino by Geoff Mcintyre of Mr.Industries (https://mr.industries/)
+ * 
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ * 
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU General Public License for more details.
+ * 
+ * You should have received a copy of the GNU General Public License
+ * along with this program. If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#pragma once
+#include <stdint.h>
+#include <stddef.h>
+#include <assert.h>
+#include <mutex>
+
+/**
+ * Host FreeRTOS kernel configuration and port layer.
+ *
+ * Only the subset of the ESP-IDF FreeRTOS API used by the firmware is
+ * provided. Tasks are POSIX threads, queues and semaphores are condition
+ * variable queues, and ticks are milliseconds of simulated time.
+ */
+
+typedef int BaseType_t;
+typedef unsigned int UBaseType_t;
+typedef uint32_t TickType_t;
+typedef uint8_t StackType_t;
+
+#define pdFALSE   ((BaseType_t)0)
+#define pdTRUE    ((BaseType_t)1)
+#define pdFAIL    pdFALSE
+#define pdPASS    pdTRUE
+
+#define portMAX_DELAY        ((TickType_t)0xffffffffUL)
+#define configTICK_RATE_HZ   1000
+#define portTICK_PERIOD_MS   ((TickType_t)1000 / configTICK_RATE_HZ)
+#define pdMS_TO_TICKS(xTimeInMs) \
+  ((TickType_t)(((uint64_t)(xTimeInMs) * (uint64_t)configTICK_RATE_HZ) / (uint64_t)1000U))
+#define pdTICKS_TO_MS(xTicks) \
+  ((uint32_t)(((uint64_t)(xTicks) * (uint64_t)1000U) / (uint64_t)configTICK_RATE_HZ))
+
+#define configMAX_PRIORITIES  25
+#define configASSERT(x)       assert(x)
+#define tskNO_AFFINITY        0x7FFFFFFF
+
+// Interrupt context is simulated by ordinary threads, so there is never a
+// deferred context switch to request.
+#define portYIELD_FROM_ISR(...) do {} while (0)
+
+/**
+ * Critical sections. On the ESP32 these are spinlocks that also mask
+ * interrupts on the calling core; on the host every portMUX is a recursive
+ * mutex shared between "task" and "ISR" threads.
+ */
+typedef struct {
+  std::recursive_mutex lock;
+} portMUX_TYPE;
+
+#define portMUX_INITIALIZER_UNLOCKED {}
+#define portENTER_CRITICAL(mux)      (mux)->lock.lock()
+#define portEXIT_CRITICAL(mux)       (mux)->lock.unlock()
+#define portENTER_CRITICAL_ISR(mux)  (mux)->lock.lock()
+#define portEXIT_CRITICAL_ISR(mux)   (mux)->lock.unlock()
+#define taskENTER_CRITICAL(mux)      portENTER_CRITICAL(mux)
+#define taskEXIT_CRITICAL(mux)       portEXIT_CRITICAL(mux)
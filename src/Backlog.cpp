@@ -0,0 +1,499 @@
+/**
+ * Backlog.cpp - Store-and-forward telemetry backlog implementation
+ * 
+ * Copyright (C) 2025 Michael Garcia, M&E Design
+ * Based on original .ino by Geoff Mcintyre of Mr.Industries (https://mr.industries/)
+ * 
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ * 
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU General Public License for more details.
+ * 
+ * You should have received a copy of the GNU General Public License
+ * along with this program. If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#include "Backlog.h"
+#include "SensorDataAccess.h"
+#include "TelemetryFrame.h"
+#include "freertos/FreeRTOS.h"
+#include "freertos/semphr.h"
+#include <cstring>
+
+#define BACKLOG_MUTEX_TIMEOUT_MS 200
+#define BACKLOG_BITMAP_OFFSET (FLASH_RING_HEADER_SIZE + BACKLOG_SAMPLES_PER_PAGE * BACKLOG_SAMPLE_SIZE)
+#define BACKLOG_ALL_PENDING ((uint16_t)((1u << BACKLOG_SAMPLES_PER_PAGE) - 1))
+#define BACKLOG_DRAIN_MIN_SAMPLES 4      // Smaller catch-ups are not reported
+
+static_assert(BACKLOG_BITMAP_OFFSET + 2 <= FLASH_RING_PAGE_SIZE, "Sent bitmap must fit in the page");
+static_assert(BACKLOG_SAMPLES_PER_PAGE <= 16, "Sent bitmap is 16 bits");
+static_assert(BACKLOG_BATCH_MAX <= TELEMETRY_MAX_BATCH_SAMPLES, "Batch must fit in a batch frame");
+
+typedef enum {
+  BATCH_NONE,
+  BATCH_RAM_OLDEST,
+  BATCH_RAM_NEWEST,
+  BATCH_FLASH
+} BatchSource;
+
+// RAM ring of the newest samples, [ramTail, ramTail + ramCount). Everything
+// here is newer than what is in flash. Guarded by backlogMutex.
+static BacklogSample ram[BACKLOG_RAM_CAPACITY];
+static size_t ramTail = 0;
+static size_t ramCount = 0;
+
+static FlashRing ring;
+static bool flashReady = false;
+static uint32_t flashPending = 0;
+static uint32_t bootSequence = 1;         // First page written this boot
+
+// The batch out on the radio
+static BatchSource batchSource = BATCH_NONE;
+static BacklogSample batch[BACKLOG_BATCH_MAX];
+static size_t batchCount = 0;
+static unsigned long batchPeekMs = 0;
+static uint32_t batchPage = 0;
+static uint32_t batchPageSequence = 0;
+static uint16_t batchBitmap = 0;          // Page bitmap after the batch is sent
+static bool batchReclaimed = false;       // Its page was erased while on air
+
+static uint8_t pageBuffer[FLASH_RING_PAGE_SIZE];
+static uint8_t eraseBuffer[FLASH_RING_PAGE_SIZE];  // pageBuffer may hold the page being appended
+static SemaphoreHandle_t backlogMutex = NULL;
+static BacklogOrder order = BACKLOG_DEFAULT_ORDER;
+static ReportFilter reportFilter;
+static uint16_t telemetrySequence = 0;
+static BacklogStats stats;
+static unsigned long drainStartMs = 0;
+static uint32_t drainSent = 0;
+
+static bool lockBacklog() {
+  return backlogMutex && xSemaphoreTake(backlogMutex, pdMS_TO_TICKS(BACKLOG_MUTEX_TIMEOUT_MS));
+}
+
+static void unlockBacklog() {
+  xSemaphoreGive(backlogMutex);
+}
+
+static void putU16(uint8_t* p, uint16_t v) {
+  p[0] = (uint8_t)v;
+  p[1] = (uint8_t)(v >> 8);
+}
+
+static uint16_t getU16(const uint8_t* p) {
+  return (uint16_t)(p[0] | (p[1] << 8));
+}
+
+static int popcount16(uint16_t v) {
+  int n = 0;
+  for (; v; v &= (uint16_t)(v - 1)) n++;
+  return n;
+}
+
+// -----------------------------------------------------------------------------
+// Flash pages
+// -----------------------------------------------------------------------------
+
+static void packSample(const BacklogSample& entry, uint8_t* out) {
+  const SensorSample& sample = entry.sample;
+  putU16(&out[0], (uint16_t)sample.timestamp);
+  putU16(&out[2], (uint16_t)(sample.timestamp >> 16));
+  putU16(&out[4], entry.sequence);
+  out[6] = sample.flags;
+  out[7] = 0;
+  putU16(&out[8], (uint16_t)sample.temperatureCenti);
+  putU16(&out[10], sample.humidityCenti);
+  putU16(&out[12], sample.lux);
+  putU16(&out[14], sample.distanceCenti);
+}
+
+static void unpackSample(const uint8_t* in, bool earlierBoot, BacklogSample* entry) {
+  SensorSample& sample = entry->sample;
+  sample.timestamp = getU16(&in[0]) | ((uint32_t)getU16(&in[2]) << 16);
+  entry->sequence = getU16(&in[4]);
+  sample.flags = in[6];
+  entry->earlierBoot = earlierBoot;
+  sample.temperatureCenti = (int16_t)getU16(&in[8]);
+  sample.humidityCenti = getU16(&in[10]);
+  sample.lux = getU16(&in[12]);
+  sample.distanceCenti = getU16(&in[14]);
+}
+
+static uint16_t pendingBits(const FlashPageHeader* header, const uint8_t* page) {
+  size_t count = header->used / BACKLOG_SAMPLE_SIZE;
+  uint16_t valid = (uint16_t)((1u << count) - 1);
+  return getU16(&page[BACKLOG_BITMAP_OFFSET]) & valid;
+}
+
+// Reclaiming a sector loses whatever it still holds unsent. A batch on
+// air from the sector leaves flash too; backlogAbort() counts it as lost
+// if the frame fails.
+static void beforeErase(FlashRing* r, uint32_t firstPage, void* context) {
+  for (uint32_t i = 0; i < FLASH_RING_PAGES_PER_SECTOR; i++) {
+    FlashPageHeader header;
+    if (flashRingRead(r, firstPage + i, eraseBuffer, &header) != FLASH_PAGE_VALID) continue;
+    uint32_t pending = popcount16(pendingBits(&header, eraseBuffer));
+    flashPending -= pending;
+    if (batchSource == BATCH_FLASH && !batchReclaimed && batchPage == firstPage + i) {
+      pending -= batchCount;   // Already out on the radio
+      batchReclaimed = true;   // Nothing left to mark
+    }
+    stats.lost += pending;
+  }
+}
+
+static void visitPage(uint32_t page, const FlashPageHeader* header, const uint8_t* data, void* context) {
+  flashPending += popcount16(pendingBits(header, data));
+}
+
+// Write the oldest count RAM samples as one flash page. Called with the lock held.
+static bool spillOldest(size_t count) {
+  if (!flashReady || count == 0) return false;
+  
+  memset(pageBuffer, 0xFF, sizeof(pageBuffer));
+  for (size_t i = 0; i < count; i++) {
+    const BacklogSample& sample = ram[(ramTail + i) % BACKLOG_RAM_CAPACITY];
+    packSample(sample, &pageBuffer[FLASH_RING_HEADER_SIZE + i * BACKLOG_SAMPLE_SIZE]);
+  }
+  if (!flashRingAppend(&ring, 0, pageBuffer, count * BACKLOG_SAMPLE_SIZE)) {
+    return false;
+  }
+  
+  ramTail = (ramTail + count) % BACKLOG_RAM_CAPACITY;
+  ramCount -= count;
+  flashPending += count;
+  stats.spilled += count;
+  return true;
+}
+
+// Make room for one more RAM sample. Called with the lock held.
+static void makeRoom() {
+  if (ramCount < BACKLOG_RAM_CAPACITY) return;
+  if (spillOldest(BACKLOG_SAMPLES_PER_PAGE)) return;
+  
+  // No flash: the oldest sample is lost
+  ramTail = (ramTail + 1) % BACKLOG_RAM_CAPACITY;
+  ramCount--;
+  stats.lost++;
+}
+
+// Find the oldest or newest page with unsent samples
+static bool findPendingPage(bool newest, uint32_t* pageOut, FlashPageHeader* header, uint16_t* bits) {
+  if (!flashReady || flashPending == 0) return false;
+  
+  uint32_t page = newest ? flashRingPrevious(&ring, ring.headPage) : ring.headPage;
+  for (uint32_t i = 0; i < ring.pageCount; i++) {
+    if (!flashRingBlank(&ring, page) &&
+        flashRingRead(&ring, page, pageBuffer, header) == FLASH_PAGE_VALID) {
+      *bits = pendingBits(header, pageBuffer);
+      if (*bits) {
+        *pageOut = page;
+        return true;
+      }
+    }
+    page = newest ? flashRingPrevious(&ring, page) : flashRingNext(&ring, page);
+  }
+  return false;
+}
+
+// -----------------------------------------------------------------------------
+// Public API
+// -----------------------------------------------------------------------------
+
+bool initBacklog() {
+  if (!backlogMutex) {
+    backlogMutex = xSemaphoreCreateMutex();
+    if (!backlogMutex) return false;
+  }
+  
+  reportFilterInit(&reportFilter, NULL);
+  ring.beforeErase = beforeErase;
+  flashPending = 0;
+  flashReady = flashRingMount(&ring, BACKLOG_PARTITION_LABEL, BACKLOG_PARTITION_SUBTYPE,
+                              BACKLOG_PAGE_MAGIC, visitPage, NULL);
+  bootSequence = flashReady ? ring.nextSequence : 1;
+  return flashReady;
+}
+
+bool captureBacklogSample() {
+  BacklogSample entry;
+  readSensorSnapshot(&entry.sample);
+  entry.earlierBoot = false;
+  
+  if (!lockBacklog()) return false;
+  if (reportFilterCheck(&reportFilter, &entry.sample) == REPORT_SUPPRESSED) {
+    unlockBacklog();
+    return true;
+  }
+  // Sequence numbers count reported samples, so gaps still mean loss
+  entry.sequence = telemetrySequence++;
+  makeRoom();
+  ram[(ramTail + ramCount) % BACKLOG_RAM_CAPACITY] = entry;
+  ramCount++;
+  stats.captured++;
+  uint32_t depth = ramCount + flashPending;
+  if (depth > stats.maxDepth) stats.maxDepth = depth;
+  unlockBacklog();
+  return true;
+}
+
+bool adoptBacklogSample(const SensorSample* sample) {
+  if (!sample) return false;
+  BacklogSample entry;
+  entry.sample = *sample;
+  entry.sample.timestamp = 0;   // Oldest this boot, should it spill to flash
+  entry.earlierBoot = true;
+  
+  if (!lockBacklog()) return false;
+  entry.sequence = telemetrySequence++;
+  makeRoom();
+  ram[(ramTail + ramCount) % BACKLOG_RAM_CAPACITY] = entry;
+  ramCount++;
+  stats.captured++;
+  uint32_t depth = ramCount + flashPending;
+  if (depth > stats.maxDepth) stats.maxDepth = depth;
+  unlockBacklog();
+  return true;
+}
+
+uint16_t nextTelemetrySequence() {
+  if (!lockBacklog()) return telemetrySequence;
+  uint16_t sequence = telemetrySequence++;
+  unlockBacklog();
+  return sequence;
+}
+
+size_t backlogDepth() {
+  return ramCount + flashPending;
+}
+
+uint32_t backlogOldestAgeMs() {
+  if (!lockBacklog()) return 0;
+  uint32_t age = 0;
+  if (flashPending > 0 || (ramCount > 0 && ram[ramTail].earlierBoot)) {
+    age = UINT32_MAX;   // Left over from an outage or an earlier boot
+  } else if (ramCount > 0) {
+    age = millis() - ram[ramTail].sample.timestamp;
+  }
+  unlockBacklog();
+  return age;
+}
+
+size_t backlogPeek(BacklogSample* out, size_t maxSamples) {
+  if (!out || maxSamples == 0 || !lockBacklog()) return 0;
+  if (batchSource != BATCH_NONE) {
+    unlockBacklog();
+    return 0;
+  }
+  if (maxSamples > BACKLOG_BATCH_MAX) maxSamples = BACKLOG_BATCH_MAX;
+  
+  bool newest = order == BACKLOG_NEWEST_FIRST;
+  FlashPageHeader header;
+  uint16_t bits = 0;
+  
+  // RAM holds the newest samples, flash the oldest
+  if ((newest && ramCount > 0) || (!newest && ramCount > 0 && flashPending == 0)) {
+    size_t n = ramCount < maxSamples ? ramCount : maxSamples;
+    for (size_t i = 0; i < n; i++) {
+      size_t index = newest ? ramTail + ramCount - 1 - i : ramTail + i;
+      batch[i] = ram[index % BACKLOG_RAM_CAPACITY];
+    }
+    if (!newest) ramTail = (ramTail + n) % BACKLOG_RAM_CAPACITY;
+    ramCount -= n;
+    batchCount = n;
+    batchSource = newest ? BATCH_RAM_NEWEST : BATCH_RAM_OLDEST;
+  } else if (findPendingPage(newest, &batchPage, &header, &bits)) {
+    bool earlierBoot = header.sequence < bootSequence;
+    size_t n = 0;
+    for (int i = newest ? BACKLOG_SAMPLES_PER_PAGE - 1 : 0;
+         i >= 0 && i < BACKLOG_SAMPLES_PER_PAGE && n < maxSamples; i += newest ? -1 : 1) {
+      if (!(bits & (1u << i))) continue;
+      unpackSample(&pageBuffer[FLASH_RING_HEADER_SIZE + i * BACKLOG_SAMPLE_SIZE], earlierBoot, &batch[n++]);
+      bits &= (uint16_t)~(1u << i);
+    }
+    batchCount = n;
+    batchBitmap = bits;
+    batchPageSequence = header.sequence;
+    batchReclaimed = false;
+    batchSource = BATCH_FLASH;
+  } else {
+    batchCount = 0;
+  }
+  
+  batchPeekMs = millis();
+  memcpy(out, batch, batchCount * sizeof(BacklogSample));
+  size_t n = batchCount;
+  unlockBacklog();
+  return n;
+}
+
+void backlogCommit() {
+  if (!lockBacklog()) return;
+  if (batchSource == BATCH_FLASH) {
+    // The page may have been reclaimed while the frame was on air
+    FlashPageHeader header;
+    if (!batchReclaimed &&
+        flashRingRead(&ring, batchPage, pageBuffer, &header) == FLASH_PAGE_VALID &&
+        header.sequence == batchPageSequence) {
+      uint8_t bitmap[2];
+      putU16(bitmap, batchBitmap);
+      flashRingProgram(&ring, batchPage, BACKLOG_BITMAP_OFFSET, bitmap, sizeof(bitmap));
+      flashPending -= batchCount;
+    }
+  }
+  if (batchSource != BATCH_NONE) {
+    stats.sent += batchCount;
+    
+    // Catch-up after an outage: from the first batch that leaves more
+    // behind than the live sample until that is all that is left
+    uint32_t depth = ramCount + flashPending;
+    if (drainSent == 0 && depth > 1) {
+      drainStartMs = batchPeekMs;
+    }
+    if (drainSent > 0 || depth > 1) {
+      drainSent += batchCount;
+    }
+    if (drainSent > 0 && depth <= 1) {
+      if (drainSent >= BACKLOG_DRAIN_MIN_SAMPLES) {
+        stats.lastDrainSamples = drainSent;
+        stats.lastDrainMs = millis() - drainStartMs;
+      }
+      drainSent = 0;
+    }
+  }
+  batchSource = BATCH_NONE;
+  batchCount = 0;
+  unlockBacklog();
+}
+
+void backlogAbort() {
+  if (!lockBacklog()) return;
+  if (batchSource == BATCH_RAM_OLDEST || batchSource == BATCH_RAM_NEWEST) {
+    // Put the samples back where they came from; anything that no longer
+    // fits goes to flash first
+    for (size_t i = 0; i < batchCount; i++) {
+      if (batchSource == BATCH_RAM_OLDEST) {
+        const BacklogSample& sample = batch[batchCount - 1 - i];
+        if (ramCount == BACKLOG_RAM_CAPACITY && !spillOldest(BACKLOG_SAMPLES_PER_PAGE)) {
+          stats.lost++;
+          continue;
+        }
+        ramTail = (ramTail + BACKLOG_RAM_CAPACITY - 1) % BACKLOG_RAM_CAPACITY;
+        ram[ramTail] = sample;
+      } else {
+        makeRoom();
+        ram[(ramTail + ramCount) % BACKLOG_RAM_CAPACITY] = batch[batchCount - 1 - i];
+      }
+      ramCount++;
+    }
+  }
+  // Flash samples stay marked unsent, unless their page is gone
+  if (batchSource == BATCH_FLASH && batchReclaimed) {
+    stats.lost += batchCount;
+  }
+  if (batchSource != BATCH_NONE) {
+    stats.aborted++;
+  }
+  batchSource = BATCH_NONE;
+  batchCount = 0;
+  unlockBacklog();
+}
+
+bool flushBacklog() {
+  if (!flashReady || !lockBacklog()) return false;
+  bool ok = true;
+  while (ok && ramCount > 0) {
+    ok = spillOldest(ramCount < BACKLOG_SAMPLES_PER_PAGE ? ramCount : BACKLOG_SAMPLES_PER_PAGE);
+  }
+  unlockBacklog();
+  return ok;
+}
+
+void setBacklogOrder(BacklogOrder newOrder) {
+  order = newOrder;
+}
+
+BacklogOrder getBacklogOrder() {
+  return order;
+}
+
+const char* backlogOrderName(BacklogOrder value) {
+  return value == BACKLOG_NEWEST_FIRST ? "newest-first" : "oldest-first";
+}
+
+void getBacklogStats(BacklogStats* out) {
+  if (!out) return;
+  if (!lockBacklog()) {
+    memset(out, 0, sizeof(*out));
+    return;
+  }
+  *out = stats;
+  out->flashReady = flashReady;
+  out->ramDepth = ramCount;
+  out->flashDepth = flashPending;
+  out->flashCapacity = flashReady ? ring.pageCount * BACKLOG_SAMPLES_PER_PAGE : 0;
+  unlockBacklog();
+}
+
+void printBacklogStats() {
+  BacklogStats s;
+  getBacklogStats(&s);
+  Serial.printf("Backlog: depth %lu (RAM %lu/%u, flash %lu/%lu%s), max %lu, %s\n",
+                (unsigned long)(s.ramDepth + s.flashDepth), (unsigned long)s.ramDepth, BACKLOG_RAM_CAPACITY,
+                (unsigned long)s.flashDepth, (unsigned long)s.flashCapacity,
+                s.flashReady ? "" : " unavailable", (unsigned long)s.maxDepth, backlogOrderName(order));
+  Serial.printf("Backlog samples: captured %lu, sent %lu, spilled %lu, lost %lu, failed batches %lu\n",
+                (unsigned long)s.captured, (unsigned long)s.sent, (unsigned long)s.spilled,
+                (unsigned long)s.lost, (unsigned long)s.aborted);
+  if (s.lastDrainSamples > 0) {
+    Serial.printf("Backlog last drain: %lu samples in %.1f s (%.1f samples/s)\n",
+                  (unsigned long)s.lastDrainSamples, s.lastDrainMs / 1000.0f,
+                  s.lastDrainMs ? s.lastDrainSamples * 1000.0f / s.lastDrainMs : 0.0f);
+  }
+}
+
+void setReportDeadbands(const ReportDeadbands* deadbands) {
+  if (!deadbands || !lockBacklog()) return;
+  reportFilter.deadbands = *deadbands;
+  reportFilterReset(&reportFilter);   // Report the current state under the new bands
+  unlockBacklog();
+}
+
+void getReportFilter(ReportFilter* filter) {
+  if (!filter) return;
+  if (!lockBacklog()) {
+    memset(filter, 0, sizeof(*filter));
+    return;
+  }
+  *filter = reportFilter;
+  unlockBacklog();
+}
+
+void printReportFilter() {
+  ReportFilter filter;
+  getReportFilter(&filter);
+  const ReportDeadbands& bands = filter.deadbands;
+  if (bands.enabled) {
+    Serial.printf("Report filter: temp %.2f C, hum %.2f %%, lux %u%% (min %u), dist %.2f in, heartbeat %lu s\n",
+                  bands.temperatureCenti / 100.0f, bands.humidityCenti / 100.0f, bands.luxPercent,
+                  bands.luxMin, bands.distanceCenti / 100.0f, (unsigned long)(bands.heartbeatMs / 1000));
+  } else {
+    Serial.println("Report filter: off (every sample is sent)");
+  }
+  
+  uint32_t suppressed = filter.reasons[REPORT_SUPPRESSED];
+  Serial.printf("Report filter: %lu of %lu samples reported (%.1f%% suppressed);",
+                (unsigned long)(filter.checked - suppressed), (unsigned long)filter.checked,
+                filter.checked ? 100.0f * suppressed / filter.checked : 0.0f);
+  for (int i = REPORT_SUPPRESSED + 1; i < REPORT_REASON_COUNT; i++) {
+    if (filter.reasons[i]) {
+      Serial.printf(" %s %lu", reportReasonName((ReportReason)i), (unsigned long)filter.reasons[i]);
+    }
+  }
+  Serial.println();
+}
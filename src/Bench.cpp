@@ -0,0 +1,1164 @@
+/**
+ * Bench.cpp - On-target micro-benchmarks
+ * 
+ * Copyright (C) 2025 Michael Garcia, M&E Design
+ * Based on original .ino by Geoff Mcintyre of Mr.Industries (https://mr.industries/)
+ * 
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ * 
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU General Public License for more details.
+ * 
+ * You should have received a copy of the GNU General Public License
+ * along with this program. If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#include "Bench.h"
+#include "LoRaLink.h"
+#include "TelemetryFrame.h"
+#include "GlobalContext.h"
+#include "SeqLock.h"
+#include "Tasks.h"
+#include "Logger.h"
+#include "LogFrame.h"
+#include "LogStorage.h"
+#include "ReportFilter.h"
+#include "History.h"
+#include "SignalFilter.h"
+#include "I2cBus.h"
+#include "EventQueue.h"
+#include "freertos/semphr.h"
+#include <cmath>
+#include <cstring>
+
+struct BenchEntry {
+  const char *name;
+  const char *description;
+  void (*run)();
+};
+
+static void benchFrame();
+static void benchAirtime();
+static void benchSnapshot();
+static void benchLog();
+static void benchStorage();
+static void benchReportFilter();
+static void benchHistory();
+static void benchFilter();
+static void benchI2c();
+static void benchEvents();
+static void benchPayload();
+
+static BenchEntry benchTable[] = {
+  {"frame", "LoRa sensor packet: ASCII vs binary size, encode time, airtime", benchFrame},
+  {"airtime", "LoRa airtime per sample, single vs batched frames, per SF/BW", benchAirtime},
+  {"snapshot", "SensorData reader latency: mutex vs seqlock under a writer", benchSnapshot},
+  {"log", "Caller cost of a log call: deferred ring vs direct print", benchLog},
+  {"storage", "Flash log ring: append throughput, write amplification, endurance", benchStorage},
+  {"report", "Report-by-exception over a 24 h trace: frames sent vs reconstruction error", benchReportFilter},
+  {"history", "History tiers: insert cost and range queries over a 24 h trace", benchHistory},
+  {"filter", "Channel filters: cost per sample, glitch rejection and error on a 24 h trace", benchFilter},
+  {"i2c", "I2C pass: blocking Wire calls vs queued transactions, 100 vs 400 kHz", benchI2c},
+  {"events", "Event delivery at 1 kHz: single blocking queue vs pub/sub bus", benchEvents},
+  {"payload", "Event payload pool: alloc/free cost vs heap, fan-out, exhaustion, contention", benchPayload},
+};
+
+// Keeps results observable so the compiler cannot drop benchmarked work
+static volatile uint32_t benchSink;
+
+uint32_t benchCycles() {
+  return ESP.getCycleCount();
+}
+
+void benchReport(const char* label, uint32_t elapsedCycles, uint32_t iterations) {
+  if (iterations == 0) return;
+  float cyclesPerOp = (float)elapsedCycles / iterations;
+  Serial.printf("  %-24s %10.1f cycles/op %8.2f us/op\n",
+                label, cyclesPerOp, cyclesPerOp / ESP.getCpuFreqMHz());
+}
+
+void listBenchmarks() {
+  Serial.println("Available benchmarks:");
+  for (const BenchEntry& entry : benchTable) {
+    Serial.printf("  %-10s - %s\n", entry.name, entry.description);
+  }
+}
+
+void runBenchmark(const char* name) {
+  bool runAll = !name || !name[0] || strcmp(name, "all") == 0;
+  bool found = false;
+  
+  for (const BenchEntry& entry : benchTable) {
+    if (runAll || strcmp(name, entry.name) == 0) {
+      Serial.printf("\n=== BENCH %s ===\n", entry.name);
+      entry.run();
+      found = true;
+    }
+  }
+  
+  if (!found) {
+    Serial.println("Unknown benchmark.");
+    listBenchmarks();
+  }
+}
+
+// -----------------------------------------------------------------------------
+// LoRa packet format
+// -----------------------------------------------------------------------------
+
+static void benchFrame() {
+  static const LoRaFrameFormat formats[] = {LORA_FORMAT_ASCII, LORA_FORMAT_BINARY};
+  uint8_t packet[LORA_MAX_PACKET_SIZE];
+  SensorSample sample = {0, 2300, 4510, 812, 1234, TELEMETRY_FLAG_TEMPERATURE |
+                         TELEMETRY_FLAG_HUMIDITY | TELEMETRY_FLAG_LUX | TELEMETRY_FLAG_DISTANCE};
+  
+  for (LoRaFrameFormat format : formats) {
+    size_t length = 0;
+    uint32_t start = benchCycles();
+    for (uint32_t i = 0; i < BENCH_DEFAULT_ITERATIONS; i++) {
+      // Vary the values so every iteration formats different digits
+      sample.temperatureCenti = (int16_t)(2300 + 100 * (i & 7));
+      sample.humidityCenti = (uint16_t)(4510 + 100 * (i & 3));
+      sample.lux = (uint16_t)(812 + i);
+      sample.distanceCenti = (uint16_t)(1234 + 100 * (i & 15));
+      length = buildSensorPacket(format, "Greenhouse", (uint16_t)i, sample,
+                                 NULL, 0, packet, sizeof(packet));
+      benchSink = benchSink + packet[length ? length - 1 : 0];
+    }
+    uint32_t elapsed = benchCycles() - start;
+    
+    Serial.printf("%s: %u bytes, airtime SF7 %.1f ms, SF10 %.1f ms, SF12 %.1f ms\n",
+                  loraFrameFormatName(format), (unsigned)length,
+                  loraTimeOnAirUs(length, 7) / 1000.0f,
+                  loraTimeOnAirUs(length, 10) / 1000.0f,
+                  loraTimeOnAirUs(length, 12) / 1000.0f);
+    benchReport("encode", elapsed, BENCH_DEFAULT_ITERATIONS);
+  }
+  
+  TelemetryReading reading;
+  size_t length = buildSensorPacket(LORA_FORMAT_BINARY, "Greenhouse", 0, sample,
+                                    NULL, 0, packet, sizeof(packet));
+  uint32_t start = benchCycles();
+  for (uint32_t i = 0; i < BENCH_DEFAULT_ITERATIONS; i++) {
+    benchSink = benchSink + (decodeSensorFrame(packet, length, &reading) ? reading.lux : 0);
+  }
+  benchReport("binary decode", benchCycles() - start, BENCH_DEFAULT_ITERATIONS);
+}
+
+// -----------------------------------------------------------------------------
+// Batched frame airtime
+// -----------------------------------------------------------------------------
+
+// Batch sizes compared against one frame per sample
+static const size_t benchBatchSizes[] = {4, BACKLOG_BATCH_MAX};
+
+// A 1 Hz run of samples with the small sample-to-sample changes a
+// greenhouse shows, at the 0.01 resolution SensorSample carries
+static void benchFillSamples(BacklogSample* samples, size_t count) {
+  unsigned long now = millis();
+  for (size_t i = 0; i < count; i++) {
+    BacklogSample& entry = samples[i];
+    SensorSample& sample = entry.sample;
+    sample.timestamp = now - (count - 1 - i) * 1000UL;
+    entry.sequence = (uint16_t)(100 + i);
+    sample.flags = TELEMETRY_FLAG_TEMPERATURE | TELEMETRY_FLAG_HUMIDITY | TELEMETRY_FLAG_LUX;
+    entry.earlierBoot = false;
+    sample.temperatureCenti = (int16_t)(2312 + (i * 7) % 5 - 2);
+    sample.humidityCenti = (uint16_t)(4510 + (i & 3) * 3);
+    sample.lux = (uint16_t)(812 + (i * 3) % 7);
+    sample.distanceCenti = 0;
+  }
+}
+
+static void benchAirtime() {
+  static const int spreadingFactors[] = {7, 8, 9, 10, 11, 12};
+  static const long bandwidths[] = {125000, 250000, 500000};
+  const size_t sizeCount = sizeof(benchBatchSizes) / sizeof(benchBatchSizes[0]);
+  BacklogSample samples[BACKLOG_BATCH_MAX];
+  uint8_t packet[LORA_MAX_PACKET_SIZE];
+  benchFillSamples(samples, BACKLOG_BATCH_MAX);
+  
+  size_t single = buildSensorPacket(LORA_FORMAT_BINARY, "Greenhouse", 0, samples[0].sample,
+                                    NULL, 0, packet, sizeof(packet));
+  size_t batchBytes[sizeCount];
+  for (size_t i = 0; i < sizeCount; i++) {
+    batchBytes[i] = buildBatchPacket(samples, benchBatchSizes[i], NULL, 0, packet, sizeof(packet));
+  }
+  
+  uint32_t start = benchCycles();
+  for (uint32_t i = 0; i < BENCH_DEFAULT_ITERATIONS; i++) {
+    samples[i % BACKLOG_BATCH_MAX].sample.lux = (uint16_t)(812 + (i & 7));
+    size_t length = buildBatchPacket(samples, BACKLOG_BATCH_MAX, NULL, 0, packet, sizeof(packet));
+    benchSink = benchSink + packet[length ? length - 1 : 0];
+  }
+  uint32_t elapsed = benchCycles() - start;
+  
+  Serial.printf("Frame bytes: single %u", (unsigned)single);
+  for (size_t i = 0; i < sizeCount; i++) {
+    Serial.printf(", batch of %u %u (%.1f/sample)", (unsigned)benchBatchSizes[i],
+                  (unsigned)batchBytes[i], (float)batchBytes[i] / benchBatchSizes[i]);
+  }
+  Serial.println();
+  Serial.println("Airtime per sample, ms:");
+  Serial.printf("  SF  BW kHz   single");
+  for (size_t i = 0; i < sizeCount; i++) {
+    Serial.printf("  batch %-3u saving", (unsigned)benchBatchSizes[i]);
+  }
+  Serial.println();
+  
+  for (int sf : spreadingFactors) {
+    for (long bw : bandwidths) {
+      float singleMs = loraTimeOnAirUs(single, sf, bw) / 1000.0f;
+      Serial.printf("  %2d  %6ld %8.1f", sf, bw / 1000, singleMs);
+      for (size_t i = 0; i < sizeCount; i++) {
+        float perSample = loraTimeOnAirUs(batchBytes[i], sf, bw) / 1000.0f / benchBatchSizes[i];
+        Serial.printf("  %9.1f %5.0f%%", perSample, 100.0f * (1.0f - perSample / singleMs));
+      }
+      Serial.println();
+    }
+  }
+  benchReport("batch encode", elapsed, BENCH_DEFAULT_ITERATIONS);
+}
+
+// -----------------------------------------------------------------------------
+// SensorData reader contention
+// -----------------------------------------------------------------------------
+
+// Writer shaped like SensorTask: a sample every 250 ms whose I2C
+// conversions take ~170 ms (HTU21D-F temperature + humidity, TSL2561 101 ms)
+#define BENCH_CONVERSION_MS 170
+#define BENCH_SAMPLE_PERIOD_MS 250
+#define BENCH_CONTENTION_MS 2000
+#define BENCH_READ_INTERVAL_MS 5
+#define BENCH_MUTEX_TIMEOUT_MS 100
+
+typedef enum {
+  CONTENTION_MUTEX,        // Lock held across the conversion, as SensorTask used to
+  CONTENTION_SEQLOCK,      // Convert outside, publish in a short write section
+  CONTENTION_SEQLOCK_HOT   // Publish every tick to force reader retries
+} ContentionMode;
+
+static SemaphoreHandle_t benchMutex = NULL;
+static SeqLock benchSeq;
+static SensorData benchData;
+static volatile bool benchWriterRunning = false;
+static volatile bool benchWriterDone = false;
+static ContentionMode benchMode;
+
+static volatile uint32_t benchWrites = 0;
+
+static void benchPublish() {
+  benchWrites = benchWrites + 1;
+  benchData.temperatureCenti++;
+  benchData.humidityCenti += 10;
+  benchData.lux++;
+  benchData.timestamp = millis();
+}
+
+static void benchWriterTask(void* parameter) {
+  while (benchWriterRunning) {
+    switch (benchMode) {
+      case CONTENTION_MUTEX:
+        xSemaphoreTake(benchMutex, portMAX_DELAY);
+        vTaskDelay(pdMS_TO_TICKS(BENCH_CONVERSION_MS));
+        benchPublish();
+        xSemaphoreGive(benchMutex);
+        vTaskDelay(pdMS_TO_TICKS(BENCH_SAMPLE_PERIOD_MS - BENCH_CONVERSION_MS));
+        break;
+      case CONTENTION_SEQLOCK:
+        vTaskDelay(pdMS_TO_TICKS(BENCH_CONVERSION_MS));
+        xSemaphoreTake(benchMutex, portMAX_DELAY);
+        benchSeq.beginWrite();
+        benchPublish();
+        benchSeq.endWrite();
+        xSemaphoreGive(benchMutex);
+        vTaskDelay(pdMS_TO_TICKS(BENCH_SAMPLE_PERIOD_MS - BENCH_CONVERSION_MS));
+        break;
+      case CONTENTION_SEQLOCK_HOT:
+        xSemaphoreTake(benchMutex, portMAX_DELAY);
+        benchSeq.beginWrite();
+        benchPublish();
+        benchSeq.endWrite();
+        xSemaphoreGive(benchMutex);
+        taskYIELD();
+        break;
+    }
+  }
+  benchWriterDone = true;
+  vTaskDelete(NULL);
+}
+
+static void runContention(const char* label, ContentionMode mode) {
+  benchMode = mode;
+  benchWrites = 0;
+  benchWriterRunning = true;
+  benchWriterDone = false;
+  // The hot writer never blocks, so it runs at the reader's priority and the
+  // two time-slice instead of the writer starving the reader
+  UBaseType_t priority = (mode == CONTENTION_SEQLOCK_HOT) ? COMMAND_TASK_PRIORITY : SENSOR_TASK_PRIORITY;
+  if (xTaskCreate(benchWriterTask, "BenchWriter", SENSOR_TASK_STACK, NULL, priority, NULL) != pdPASS) {
+    Serial.println("ERROR: Failed to create benchmark writer task");
+    return;
+  }
+  
+  uint32_t reads = 0, timeouts = 0, retries = 0;
+  uint32_t maxUs = 0;
+  uint64_t totalUs = 0;
+  SensorData snapshot = {};
+  unsigned long startMs = millis();
+  
+  while (millis() - startMs < BENCH_CONTENTION_MS) {
+    uint32_t start = micros();
+    if (mode == CONTENTION_MUTEX) {
+      if (xSemaphoreTake(benchMutex, pdMS_TO_TICKS(BENCH_MUTEX_TIMEOUT_MS))) {
+        snapshot = benchData;
+        xSemaphoreGive(benchMutex);
+      } else {
+        timeouts++;
+      }
+    } else {
+      retries += benchSeq.read(&snapshot, benchData);
+    }
+    uint32_t elapsed = micros() - start;
+    
+    benchSink = benchSink + (uint32_t)snapshot.temperatureCenti;
+    reads++;
+    totalUs += elapsed;
+    if (elapsed > maxUs) maxUs = elapsed;
+    
+    if (mode != CONTENTION_SEQLOCK_HOT) {
+      vTaskDelay(pdMS_TO_TICKS(BENCH_READ_INTERVAL_MS));
+    } else {
+      taskYIELD();
+    }
+  }
+  
+  benchWriterRunning = false;
+  while (!benchWriterDone) {
+    vTaskDelay(pdMS_TO_TICKS(10));
+  }
+  
+  Serial.printf("  %-14s writes %7lu reads %8lu  avg %9.2f us  max %8lu us  timeouts %lu  retries %lu\n",
+                label, (unsigned long)benchWrites, (unsigned long)reads,
+                reads ? (double)totalUs / reads : 0.0, (unsigned long)maxUs,
+                (unsigned long)timeouts, (unsigned long)retries);
+}
+
+static void benchSnapshot() {
+  if (!benchMutex) {
+    benchMutex = xSemaphoreCreateMutex();
+    if (!benchMutex) {
+      Serial.println("ERROR: Failed to create benchmark mutex");
+      return;
+    }
+  }
+  
+  Serial.printf("Writer: %d ms conversion every %d ms; reader every %d ms for %d ms\n",
+                BENCH_CONVERSION_MS, BENCH_SAMPLE_PERIOD_MS, BENCH_READ_INTERVAL_MS,
+                BENCH_CONTENTION_MS);
+  runContention("mutex", CONTENTION_MUTEX);
+  runContention("seqlock", CONTENTION_SEQLOCK);
+  runContention("seqlock (hot)", CONTENTION_SEQLOCK_HOT);
+}
+
+// -----------------------------------------------------------------------------
+// Logger caller cost
+// -----------------------------------------------------------------------------
+
+static void benchLog() {
+  const uint32_t burst = LOG_QUEUE_DEPTH / 2;
+  const uint32_t overflowBurst = LOG_QUEUE_DEPTH * 2;
+  char line[LOG_BUFFER_SIZE];
+  
+  flushLogger();
+  uint32_t start = benchCycles();
+  for (uint32_t i = 0; i < burst; i++) {
+    logInfo("BENCH_LOG i=%lu temp=%d humidity=%.1f peer=%s", (unsigned long)i, 23, 45.1f, "24:6F:28:11:22:33");
+  }
+  uint32_t deferred = benchCycles() - start;
+  flushLogger();
+  
+  // What every log call used to cost: format and print in the caller
+  start = benchCycles();
+  for (uint32_t i = 0; i < burst; i++) {
+    snprintf(line, sizeof(line), "[%lu] INFO: BENCH_LOG i=%lu temp=%d humidity=%.1f peer=%s",
+             millis(), (unsigned long)i, 23, 45.1f, "24:6F:28:11:22:33");
+    Serial.println(line);
+  }
+  uint32_t direct = benchCycles() - start;
+  
+  // Burst past the ring capacity without yielding; excess calls are dropped
+  LoggerStats before;
+  LoggerStats after;
+  getLoggerStats(&before);
+  start = benchCycles();
+  for (uint32_t i = 0; i < overflowBurst; i++) {
+    logInfo("BENCH_LOG overflow %lu", (unsigned long)i);
+  }
+  uint32_t overflow = benchCycles() - start;
+  flushLogger();
+  getLoggerStats(&after);
+  
+  Serial.printf("Ring: %u records; overflow burst of %lu calls dropped %lu\n", LOG_QUEUE_DEPTH,
+                (unsigned long)overflowBurst, (unsigned long)(after.dropped - before.dropped));
+  
+  // Serial bytes per record for the binary log mode
+  size_t sensorText, sensorBinary, eventText, eventBinary;
+  measureLogEncoding(&sensorText, &sensorBinary, "SENSOR_DATA temp=%d humidity=%.1f lux=%d distance=%.2f",
+                     23, 45.1f, 812, 12.34f);
+  measureLogEncoding(&eventText, &eventBinary, "NETWORK_EVENT %s %s: %s", "LoRa", "TX_DONE", "24 bytes sent");
+  Serial.printf("Encoding: SENSOR_DATA text %u / binary %u bytes, NETWORK_EVENT text %u / binary %u bytes\n",
+                (unsigned)sensorText, (unsigned)sensorBinary, (unsigned)eventText, (unsigned)eventBinary);
+  benchReport("deferred log call", deferred, burst);
+  benchReport("direct format + print", direct, burst);
+  benchReport("log call, ring full", overflow, overflowBurst);
+}
+
+// -----------------------------------------------------------------------------
+// Flash log ring
+// -----------------------------------------------------------------------------
+
+static void benchStorage() {
+  if (!logStorageReady()) {
+    Serial.println("Log storage not available");
+    return;
+  }
+  
+  // Appends real SENSOR_DATA frames to the live ring (the oldest stored
+  // logs are overwritten), timing the flash writes along with them
+  uint8_t frame[LOG_FRAME_MAX_ENCODED];
+  LogStorageStats before;
+  LogStorageStats after;
+  flushLogStorage();
+  getLogStorageStats(&before);
+  
+  uint32_t bytes = 0;
+  unsigned long startMs = millis();
+  uint32_t start = benchCycles();
+  for (uint32_t i = 0; i < BENCH_DEFAULT_ITERATIONS; i++) {
+    size_t length = encodeLogMessage(frame, sizeof(frame), LOG_INFO,
+                                     "SENSOR_DATA temp=%d humidity=%.1f lux=%d distance=%.2f",
+                                     23, 45.1f, 812 + (int)i, 12.34f);
+    if (length && logStorageAppend(frame, length)) {
+      bytes += length;
+    }
+  }
+  flushLogStorage();
+  uint32_t elapsed = benchCycles() - start;
+  unsigned long elapsedMs = millis() - startMs;
+  getLogStorageStats(&after);
+  
+  uint32_t pages = after.pagesWritten - before.pagesWritten;
+  uint32_t flashBytes = pages * FLASH_RING_PAGE_SIZE;
+  float recordBytes = (float)bytes / BENCH_DEFAULT_ITERATIONS;
+  float amplification = bytes ? (float)flashBytes / bytes : 0.0f;
+  Serial.printf("Appended %u records (%lu bytes) in %lu ms: %.1f KB/s, %lu pages, %lu sector erases\n",
+                BENCH_DEFAULT_ITERATIONS, (unsigned long)bytes, elapsedMs,
+                elapsedMs ? bytes / 1.024f / elapsedMs : 0.0f, (unsigned long)pages,
+                (unsigned long)(after.sectorErases - before.sectorErases));
+  Serial.printf("Flash bytes per record byte: %.2f; sector erases now %lu..%lu\n",
+                amplification, (unsigned long)after.minEraseCount, (unsigned long)after.maxEraseCount);
+  
+  // The ring wears out after every sector reaches its rated erase count
+  static const float rates[] = {1.0f, 10.0f};
+  for (float rate : rates) {
+    float flashPerDay = rate * recordBytes * amplification * 86400.0f;
+    float retentionHours = after.pages * (float)LOG_STORAGE_PAYLOAD_SIZE / recordBytes / rate / 3600.0f;
+    float lifetimeYears = flashPerDay > 0 ? (float)FLASH_RING_ENDURANCE * after.partitionBytes / flashPerDay / 365.0f : 0.0f;
+    Serial.printf("At %4.0f records/s: %.1f h retained, %.0f years to rated endurance\n",
+                  rate, retentionHours, lifetimeYears);
+  }
+  Serial.printf("Boot recovery scan: %lu pages in %lu ms\n",
+                (unsigned long)after.pages, (unsigned long)after.recoveryMs);
+  benchReport("append (incl. flash)", elapsed, BENCH_DEFAULT_ITERATIONS);
+}
+
+// -----------------------------------------------------------------------------
+// Report-by-exception replay
+// -----------------------------------------------------------------------------
+
+#define BENCH_TRACE_SECONDS 86400UL
+#define BENCH_TRACE_SEED 0x2545F491UL
+
+// Deterministic 24 h greenhouse trace at 1 Hz, as SensorTask would publish
+// it: temperature with a diurnal swing, humidity following it
+// with sensor noise, daylight with passing clouds, and a slowly draining
+// tank that is refilled twice a day. Regenerated per run instead of stored.
+struct BenchTrace {
+  uint32_t rng;
+  float tankInches;
+  float cloud;
+};
+
+static float benchNoise(BenchTrace* trace) {
+  trace->rng ^= trace->rng << 13;
+  trace->rng ^= trace->rng >> 17;
+  trace->rng ^= trace->rng << 5;
+  return (trace->rng & 0xFFFF) / 32768.0f - 1.0f;   // [-1, 1)
+}
+
+static void benchTraceSample(BenchTrace* trace, uint32_t second, SensorSample* sample) {
+  float hour = second / 3600.0f;
+  float day = sinf((hour - 9.0f) * (float)M_PI / 12.0f);   // Peaks mid-afternoon
+  float celsius = 21.0f + 6.0f * day + 0.05f * benchNoise(trace);
+  float humidity = 70.0f - 2.0f * (celsius - 21.0f) + 0.1f * benchNoise(trace);
+  
+  if (benchNoise(trace) > 0.993f) {   // A new cloud every ~5 minutes
+    trace->cloud = 0.35f + 0.65f * (benchNoise(trace) + 1.0f) / 2.0f;
+  }
+  float sun = (hour > 6.0f && hour < 20.0f) ? sinf((hour - 6.0f) * (float)M_PI / 14.0f) : 0.0f;
+  float lux = 30000.0f * sun * trace->cloud * (1.0f + 0.01f * benchNoise(trace));
+  
+  trace->tankInches -= 0.0004f;
+  if (second % 43200 == 21600) trace->tankInches = 30.0f;
+  float distance = 40.0f - trace->tankInches + 0.05f * benchNoise(trace);
+  
+  sample->timestamp = second * 1000UL;
+  sample->flags = TELEMETRY_FLAG_TEMPERATURE | TELEMETRY_FLAG_HUMIDITY | TELEMETRY_FLAG_LUX |
+                  TELEMETRY_FLAG_DISTANCE;
+  sample->temperatureCenti = telemetryScaleTemperature(celsius);
+  sample->humidityCenti = telemetryScaleHumidity(humidity);
+  sample->lux = telemetryScaleLux((int)lux);
+  sample->distanceCenti = telemetryScaleDistance(distance);
+}
+
+struct BenchReportCase {
+  const char* name;
+  int scale;                  // Deadband multiple of the defaults; 0 = filter off
+};
+
+static void benchReportFilter() {
+  static const BenchReportCase cases[] = {
+    {"off", 0}, {"default", 1}, {"default x2", 2}, {"default x4", 4},
+  };
+  
+  Serial.printf("24 h at 1 Hz (%lu samples); error is what the gateway holds vs the sample\n",
+                (unsigned long)BENCH_TRACE_SECONDS);
+  Serial.println("  deadbands       sent  reduction  airtime/day   max err: temp   hum     lux    dist");
+  
+  uint32_t checkCycles = 0;
+  for (const BenchReportCase& test : cases) {
+    ReportDeadbands bands;
+    reportDefaultDeadbands(&bands);
+    bands.enabled = test.scale > 0;
+    bands.temperatureCenti *= test.scale;
+    bands.humidityCenti *= test.scale;
+    bands.luxPercent *= test.scale;
+    bands.distanceCenti *= test.scale;
+    ReportFilter filter;
+    reportFilterInit(&filter, &bands);
+    
+    BenchTrace trace = {BENCH_TRACE_SEED, 30.0f, 1.0f};
+    SensorSample sample;
+    SensorSample held = {};
+    uint32_t maxError[4] = {};
+    uint32_t start = benchCycles();
+    for (uint32_t second = 0; second < BENCH_TRACE_SECONDS; second++) {
+      benchTraceSample(&trace, second, &sample);
+      if (reportFilterCheck(&filter, &sample) != REPORT_SUPPRESSED) {
+        held = sample;
+      }
+      uint32_t error[4] = {
+        (uint32_t)abs(sample.temperatureCenti - held.temperatureCenti),
+        (uint32_t)abs((int)sample.humidityCenti - (int)held.humidityCenti),
+        (uint32_t)abs((int)sample.lux - (int)held.lux),
+        (uint32_t)abs((int)sample.distanceCenti - (int)held.distanceCenti),
+      };
+      for (int i = 0; i < 4; i++) {
+        if (error[i] > maxError[i]) maxError[i] = error[i];
+      }
+    }
+    if (test.scale == 1) checkCycles = benchCycles() - start;
+    
+    uint32_t sent = filter.checked - filter.reasons[REPORT_SUPPRESSED];
+    float airtimeS = sent * (loraTimeOnAirUs(TELEMETRY_SENSOR_FRAME_SIZE) / 1e6f);
+    Serial.printf("  %-12s %7lu %9.1fx %10.0f s  %12.2f C %5.2f %% %5lu lx %5.2f in\n",
+                  test.name, (unsigned long)sent, sent ? (float)filter.checked / sent : 0.0f, airtimeS,
+                  maxError[0] / 100.0f, maxError[1] / 100.0f, (unsigned long)maxError[2],
+                  maxError[3] / 100.0f);
+    if (test.scale == 1) {
+      Serial.printf("  default by cause:");
+      for (int i = REPORT_SUPPRESSED + 1; i < REPORT_REASON_COUNT; i++) {
+        if (filter.reasons[i]) {
+          Serial.printf(" %s %lu", reportReasonName((ReportReason)i), (unsigned long)filter.reasons[i]);
+        }
+      }
+      Serial.println();
+    }
+  }
+  benchReport("trace + check (default)", checkCycles, BENCH_TRACE_SECONDS);
+}
+
+// -----------------------------------------------------------------------------
+// History tiers
+// -----------------------------------------------------------------------------
+
+#define BENCH_HISTORY_QUERIES 200
+
+static void benchHistory() {
+  // A private store, so the benchmark leaves the live history alone; the
+  // query buffer is on the heap too, as it would not fit CommandTask's stack
+  const size_t maxPoints = HISTORY_QUARTER_CAPACITY + 1;
+  HistoryStore* store = (HistoryStore*)malloc(sizeof(HistoryStore));
+  HistoryPoint* points = (HistoryPoint*)malloc(maxPoints * sizeof(HistoryPoint));
+  if (!store || !points) {
+    Serial.println("ERROR: Not enough memory for the history benchmark");
+    free(store);
+    free(points);
+    return;
+  }
+  historyInit(store);
+  Serial.printf("Store: %u bytes (raw %u x 13, 1m %u + 15m %u buckets x %u)\n",
+                (unsigned)sizeof(HistoryStore), HISTORY_RAW_CAPACITY, HISTORY_MINUTE_CAPACITY,
+                HISTORY_QUARTER_CAPACITY, (unsigned)sizeof(HistoryBucket));
+  
+  // Generating the trace is timed separately and taken out of the insert cost
+  BenchTrace trace = {BENCH_TRACE_SEED, 30.0f, 1.0f};
+  SensorSample sample;
+  uint32_t start = benchCycles();
+  for (uint32_t second = 0; second < BENCH_TRACE_SECONDS; second++) {
+    benchTraceSample(&trace, second, &sample);
+    benchSink = benchSink + sample.lux;
+  }
+  uint32_t traceCycles = benchCycles() - start;
+  
+  trace = {BENCH_TRACE_SEED, 30.0f, 1.0f};
+  start = benchCycles();
+  for (uint32_t second = 0; second < BENCH_TRACE_SECONDS; second++) {
+    benchTraceSample(&trace, second, &sample);
+    historyAppend(store, sample);
+  }
+  uint32_t insertCycles = benchCycles() - start;
+  benchReport("insert", insertCycles > traceCycles ? insertCycles - traceCycles : 0, BENCH_TRACE_SECONDS);
+  
+  struct HistoryCase {
+    const char* label;
+    HistoryTier tier;
+    uint32_t spanMs;
+    bool summary;
+  };
+  static const HistoryCase cases[] = {
+    {"query raw 1 min", HISTORY_RAW, 60000UL, false},
+    {"query 1m 1 h", HISTORY_MINUTE, 3600000UL, false},
+    {"query 15m 24 h", HISTORY_QUARTER, 86400000UL, false},
+    {"summary 1m 2 h", HISTORY_MINUTE, 7200000UL, true},
+    {"summary 15m 24 h", HISTORY_QUARTER, 86400000UL, true},
+  };
+  
+  uint32_t endMs = (BENCH_TRACE_SECONDS - 1) * 1000UL;
+  for (const HistoryCase& test : cases) {
+    size_t count = 0;
+    uint32_t fromMs = endMs - test.spanMs;
+    start = benchCycles();
+    for (uint32_t i = 0; i < BENCH_HISTORY_QUERIES; i++) {
+      HistoryChannel channel = (HistoryChannel)(i % HISTORY_CHANNEL_COUNT);
+      if (test.summary) {
+        HistoryPoint summary;
+        count = historySummary(store, test.tier, channel, fromMs, endMs, &summary) ? summary.count : 0;
+        benchSink = benchSink + (uint32_t)summary.mean;
+      } else {
+        count = historyQuery(store, test.tier, channel, fromMs, endMs, points, maxPoints);
+        benchSink = benchSink + (uint32_t)points[0].mean;
+      }
+    }
+    char label[40];
+    snprintf(label, sizeof(label), "%s (%u)", test.label, (unsigned)count);
+    benchReport(label, benchCycles() - start, BENCH_HISTORY_QUERIES);
+  }
+  
+  free(points);
+  free(store);
+}
+
+// -----------------------------------------------------------------------------
+// Signal filters
+// -----------------------------------------------------------------------------
+
+#define BENCH_FILTER_SAMPLES 1024
+#define BENCH_GLITCH_SEED 0x9E3779B9UL
+
+// Sensor glitches injected into the 24 h trace: a spike every ~200
+// samples per channel, in runs of up to three for the ultrasonic echo
+struct BenchGlitch {
+  BenchTrace rng;
+  uint8_t remaining;
+  int32_t offset;
+};
+
+static bool benchGlitch(BenchGlitch* glitch, uint8_t maxRun, int32_t minOffset, int32_t maxOffset) {
+  if (glitch->remaining == 0 && benchNoise(&glitch->rng) > 0.99f) {
+    glitch->remaining = 1 + (uint8_t)((benchNoise(&glitch->rng) + 1.0f) / 2.0f * maxRun) % maxRun;
+    int32_t span = maxOffset - minOffset;
+    glitch->offset = minOffset + (int32_t)((benchNoise(&glitch->rng) + 1.0f) / 2.0f * span);
+    if (benchNoise(&glitch->rng) < 0.0f) glitch->offset = -glitch->offset;
+  }
+  if (glitch->remaining == 0) return false;
+  glitch->remaining--;
+  return true;
+}
+
+template <typename T>
+static T benchClamp(int32_t value) {
+  const int32_t low = (T)-1 < 0 ? -32768 : 0;
+  const int32_t high = (T)-1 < 0 ? 32767 : 65535;
+  return (T)(value < low ? low : (value > high ? high : value));
+}
+
+// Filter output against the trace before glitches were injected
+struct BenchFilterScore {
+  uint32_t glitches;
+  uint32_t passedRaw;
+  uint32_t passed;              // Glitch samples still off by more than the limit
+  double squared;               // Outside glitches: smoothing and step lag
+  uint32_t maxError;
+};
+
+static void benchScore(BenchFilterScore* score, bool glitch, int32_t clean, int32_t raw, int32_t out,
+                       int32_t limit) {
+  int32_t rawError = abs(raw - clean);
+  int32_t error = abs(out - clean);
+  if (glitch) {
+    score->glitches++;
+    if (rawError > limit) score->passedRaw++;
+    if (error > limit) score->passed++;
+  } else {
+    score->squared += (double)error * error;
+    if ((uint32_t)error > score->maxError) score->maxError = error;
+  }
+}
+
+template <typename Filter, typename T>
+static uint32_t benchFilterCost(const T* values) {
+  Filter filter;
+  uint32_t sum = 0;
+  uint32_t start = benchCycles();
+  for (uint32_t round = 0; round < 10; round++) {
+    for (uint32_t i = 0; i < BENCH_FILTER_SAMPLES; i++) {
+      sum += filter.update(values[i]);
+    }
+  }
+  uint32_t elapsed = benchCycles() - start;
+  benchSink = benchSink + sum;
+  return elapsed;
+}
+
+static void benchFilter() {
+  // Distance-like input for the cost runs: slow drift, noise and glitches
+  static uint16_t values[BENCH_FILTER_SAMPLES];
+  BenchGlitch glitch = {{BENCH_GLITCH_SEED, 0.0f, 0.0f}, 0, 0};
+  for (uint32_t i = 0; i < BENCH_FILTER_SAMPLES; i++) {
+    int32_t value = 1500 + (int32_t)(i / 8) + (int32_t)(5 * benchNoise(&glitch.rng));
+    if (benchGlitch(&glitch, 3, 500, 10000)) value += glitch.offset;
+    values[i] = benchClamp<uint16_t>(value);
+  }
+  
+  const uint32_t updates = 10 * BENCH_FILTER_SAMPLES;
+  Serial.println("Cost per sample:");
+  benchReport("median of 3", benchFilterCost<MedianFilter<uint16_t, 3> >(values), updates);
+  benchReport("median of 7", benchFilterCost<MedianFilter<uint16_t, 7> >(values), updates);
+  benchReport("EMA 1/4", benchFilterCost<EmaFilter<uint16_t, 2> >(values), updates);
+  benchReport("Hampel 7", benchFilterCost<HampelFilter<uint16_t, 7, 30, 50> >(values), updates);
+  benchReport("humidity chain", benchFilterCost<HumidityFilter>(values), updates);
+  benchReport("lux chain", benchFilterCost<LuxFilter>(values), updates);
+  benchReport("distance chain", benchFilterCost<DistanceFilter>(values), updates);
+  
+  // Quality over the 24 h trace with glitches injected into every channel
+  BenchTrace trace = {BENCH_TRACE_SEED, 30.0f, 1.0f};
+  BenchGlitch glitches[4] = {
+    {{BENCH_GLITCH_SEED, 0.0f, 0.0f}, 0, 0}, {{BENCH_GLITCH_SEED + 1, 0.0f, 0.0f}, 0, 0},
+    {{BENCH_GLITCH_SEED + 2, 0.0f, 0.0f}, 0, 0}, {{BENCH_GLITCH_SEED + 3, 0.0f, 0.0f}, 0, 0},
+  };
+  TemperatureFilter temperatureFilter;
+  HumidityFilter humidityFilter;
+  LuxFilter luxFilter;
+  DistanceFilter distanceFilter;
+  BenchFilterScore scores[4] = {};
+  SensorSample clean;
+  
+  for (uint32_t second = 0; second < BENCH_TRACE_SECONDS; second++) {
+    benchTraceSample(&trace, second, &clean);
+    bool hit[4] = {
+      benchGlitch(&glitches[0], 1, 200, 1500),      // 2-15 °C
+      benchGlitch(&glitches[1], 1, 500, 3000),      // 5-30 %RH
+      benchGlitch(&glitches[2], 1, 2000, 40000),    // Read while a channel settles
+      benchGlitch(&glitches[3], 3, 500, 10000),     // Echo off another surface
+    };
+    int16_t temperature = benchClamp<int16_t>(clean.temperatureCenti + (hit[0] ? glitches[0].offset : 0));
+    uint16_t humidity = benchClamp<uint16_t>(clean.humidityCenti + (hit[1] ? glitches[1].offset : 0));
+    uint16_t lux = benchClamp<uint16_t>(clean.lux + (hit[2] ? glitches[2].offset : 0));
+    uint16_t distance = benchClamp<uint16_t>(clean.distanceCenti + (hit[3] ? glitches[3].offset : 0));
+    
+    benchScore(&scores[0], hit[0], clean.temperatureCenti, temperature,
+               temperatureFilter.update(temperature), 100);
+    benchScore(&scores[1], hit[1], clean.humidityCenti, humidity, humidityFilter.update(humidity), 200);
+    benchScore(&scores[2], hit[2], clean.lux, lux, luxFilter.update(lux), 1000);
+    benchScore(&scores[3], hit[3], clean.distanceCenti, distance, distanceFilter.update(distance), 200);
+  }
+  
+  static const char* const names[4] = {"temp C", "hum %", "lux", "dist in"};
+  static const float units[4] = {100.0f, 100.0f, 1.0f, 100.0f};
+  const uint32_t outliers[4] = {temperatureFilter.outliers(), humidityFilter.outliers(), 0,
+                                distanceFilter.outliers()};
+  Serial.println("24 h trace; a glitch passes if its sample is off by > 1 C, 2 %, 1000 lx, 2 in.");
+  Serial.println("Errors are on the other samples: smoothing, and lag on steps (clouds, tank refill).");
+  Serial.println("  channel   glitches  passed raw/filtered   rms err   max err  outliers");
+  for (int i = 0; i < 4; i++) {
+    const BenchFilterScore& score = scores[i];
+    uint32_t steady = BENCH_TRACE_SECONDS - score.glitches;
+    Serial.printf("  %-8s %9lu %10lu %8lu %11.3f %9.2f %9lu\n", names[i],
+                  (unsigned long)score.glitches, (unsigned long)score.passedRaw,
+                  (unsigned long)score.passed, sqrt(score.squared / steady) / units[i],
+                  score.maxError / units[i],
+                  (unsigned long)outliers[i]);
+  }
+}
+
+// -----------------------------------------------------------------------------
+// I2C bus manager
+// -----------------------------------------------------------------------------
+
+#define BENCH_I2C_ROUNDS 50
+#define BENCH_I2C_TIMEOUT_MS 100
+
+// Register reads shaped like an acquisition pass (TSL2561 timing, ID and
+// both channel pointers, HTU21D-F user register) that leave both sensors
+// as they were
+static const uint8_t benchI2cTsl[] = {0x81, 0x8A, 0x81, 0x8A};
+#define BENCH_I2C_BATCH (sizeof(benchI2cTsl) + 1)
+
+static I2cTransaction benchTransactions[BENCH_I2C_BATCH];
+static SemaphoreHandle_t benchI2cDone = NULL;
+
+static void benchI2cComplete(I2cTransaction* transaction) {
+  xSemaphoreGive(benchI2cDone);
+}
+
+static void benchI2cSetup() {
+  for (size_t i = 0; i < BENCH_I2C_BATCH; i++) {
+    I2cTransaction& transaction = benchTransactions[i];
+    bool htu = (i == BENCH_I2C_BATCH - 1);
+    transaction.address = htu ? 0x40 : 0x39;
+    transaction.writeData[0] = htu ? 0xE7 : benchI2cTsl[i];
+    transaction.writeLength = 1;
+    transaction.readLength = 1;
+    transaction.done = htu ? benchI2cComplete : NULL;
+  }
+}
+
+// Caller-blocked and completion time per pass, in microseconds
+static void benchI2cRun(const char* label, uint32_t clockHz, bool queued) {
+  uint64_t blockedUs = 0;
+  uint64_t completeUs = 0;
+  uint32_t failed = 0;
+  
+  if (!i2cBusLock()) {
+    Serial.println("  bus busy, skipped");
+    return;
+  }
+  Wire.setClock(clockHz);
+  if (queued) i2cBusUnlock();
+  
+  for (uint32_t round = 0; round < BENCH_I2C_ROUNDS; round++) {
+    uint32_t start = micros();
+    uint32_t returned;
+    if (queued) {
+      for (size_t i = 0; i < BENCH_I2C_BATCH; i++) {
+        if (!i2cSubmit(&benchTransactions[i])) failed++;
+      }
+      returned = micros();
+      if (xSemaphoreTake(benchI2cDone, pdMS_TO_TICKS(BENCH_I2C_TIMEOUT_MS)) != pdTRUE) failed++;
+    } else {
+      for (size_t i = 0; i < BENCH_I2C_BATCH; i++) {
+        I2cTransaction& transaction = benchTransactions[i];
+        Wire.beginTransmission(transaction.address);
+        Wire.write(transaction.writeData, transaction.writeLength);
+        if (Wire.endTransmission() != 0 ||
+            Wire.requestFrom(transaction.address, transaction.readLength) != transaction.readLength) {
+          failed++;
+        }
+        while (Wire.available()) benchSink = benchSink + (uint32_t)Wire.read();
+      }
+      returned = micros();
+    }
+    uint32_t end = micros();
+    blockedUs += returned - start;
+    completeUs += end - start;
+  }
+  
+  if (queued) {
+    for (size_t i = 0; i < BENCH_I2C_BATCH; i++) {
+      benchSink = benchSink + benchTransactions[i].readData[0];
+    }
+    if (!i2cBusLock()) return;
+  }
+  Wire.setClock(I2C_BUS_CLOCK_HZ);
+  i2cBusUnlock();
+  
+  Serial.printf("  %-18s caller blocked %8.1f us  complete %8.1f us  failed %lu\n", label,
+                (double)blockedUs / BENCH_I2C_ROUNDS, (double)completeUs / BENCH_I2C_ROUNDS,
+                (unsigned long)failed);
+}
+
+static void benchI2c() {
+  if (!i2cDeviceFound(0x39) || !i2cDeviceFound(0x40)) {
+    Serial.println("Needs the TSL2561 (0x39) and HTU21D-F (0x40) on the bus");
+    return;
+  }
+  if (!benchI2cDone) {
+    benchI2cDone = xSemaphoreCreateBinary();
+    if (!benchI2cDone) {
+      Serial.println("ERROR: Failed to create benchmark semaphore");
+      return;
+    }
+  }
+  benchI2cSetup();
+  
+  Serial.printf("%u register reads per pass, %d passes\n", (unsigned)BENCH_I2C_BATCH, BENCH_I2C_ROUNDS);
+  benchI2cRun("blocking 100 kHz", 100000, false);
+  benchI2cRun("blocking 400 kHz", 400000, false);
+  benchI2cRun("queued 100 kHz", 100000, true);
+  benchI2cRun("queued 400 kHz", 400000, true);
+}
+
+// -----------------------------------------------------------------------------
+// Event bus
+// -----------------------------------------------------------------------------
+
+// 1 kHz of synthetic events for two seconds against a consumer that, like
+// CommsTask used to, drains its queue every 10 ms: a data-ready notification every
+// millisecond, a distance update every 4 ms and a config change every 50 ms
+#define BENCH_EVENT_MS 2000
+#define BENCH_EVENT_DRAIN_MS 10
+#define BENCH_LEGACY_QUEUE_SIZE 10       // The old global event queue
+#define BENCH_LEGACY_TIMEOUT_MS 100
+
+typedef enum {
+  EVENTS_SINGLE_QUEUE,     // Every event into one queue, blocking when full
+  EVENTS_BUS               // Per-subscriber queue, coalescing, non-blocking
+} EventBenchMode;
+
+static QueueHandle_t benchLegacyQueue = NULL;
+static EventSubscriber* benchSubscriber = NULL;
+static EventBenchMode benchEventMode;
+static volatile bool benchConsumerRunning = false;
+static volatile bool benchConsumerDone = false;
+static volatile uint32_t benchConsumed = 0;
+
+static void benchConsumerTask(void* parameter) {
+  EventMessage event;
+  while (benchConsumerRunning) {
+    vTaskDelay(pdMS_TO_TICKS(BENCH_EVENT_DRAIN_MS));
+    bool received;
+    do {
+      received = (benchEventMode == EVENTS_SINGLE_QUEUE) ? xQueueReceive(benchLegacyQueue, &event, 0) == pdTRUE
+                                                          : receiveEvent(benchSubscriber, &event, 0);
+      if (received) {
+        if (benchEventMode == EVENTS_BUS) releasePayload(event.payload);
+        benchConsumed = benchConsumed + 1;
+      }
+    } while (received);
+  }
+  benchConsumerDone = true;
+  vTaskDelete(NULL);
+}
+
+static EventType benchEventAt(uint32_t ms) {
+  if (ms % 50 == 0) return EVENT_CONFIG_CHANGED;
+  if (ms % 4 == 0) return EVENT_DISTANCE_UPDATED;
+  return EVENT_SENSOR_DATA_READY;
+}
+
+static void runEventLoad(const char* label, EventBenchMode mode) {
+  benchEventMode = mode;
+  benchConsumed = 0;
+  benchConsumerRunning = true;
+  benchConsumerDone = false;
+  xQueueReset(benchLegacyQueue);
+  EventSubscriberStats before = {};
+  uint8_t benchIndex = 0;
+  if (mode == EVENTS_BUS) {
+    EventSubscriberStats stats;
+    while (getEventSubscriberStats(benchIndex, &stats) && strcmp(stats.name, "bench") != 0) benchIndex++;
+    getEventSubscriberStats(benchIndex, &before);
+    setEventTopics(benchSubscriber, EVENT_BIT(EVENT_SENSOR_DATA_READY) | EVENT_BIT(EVENT_DISTANCE_UPDATED) |
+                                    EVENT_BIT(EVENT_CONFIG_CHANGED));
+  }
+  if (xTaskCreate(benchConsumerTask, "BenchConsumer", COMMS_TASK_STACK, NULL, COMMS_TASK_PRIORITY, NULL) != pdPASS) {
+    Serial.println("ERROR: Failed to create benchmark consumer task");
+    return;
+  }
+  
+  uint32_t published = 0, failed = 0, maxUs = 0;
+  uint32_t maxDepth = 0;
+  uint64_t totalUs = 0;
+  unsigned long startMs = millis();
+  TickType_t wake = xTaskGetTickCount();
+  for (uint32_t ms = 0; ms < BENCH_EVENT_MS; ms++) {
+    vTaskDelayUntil(&wake, pdMS_TO_TICKS(1));
+    EventType type = benchEventAt(ms);
+    uint32_t start = micros();
+    bool sent;
+    if (mode == EVENTS_SINGLE_QUEUE) {
+      EventMessage event = {type, ms, EVENT_PAYLOAD_NONE};
+      sent = xQueueSend(benchLegacyQueue, &event, pdMS_TO_TICKS(BENCH_LEGACY_TIMEOUT_MS)) == pdTRUE;
+      uint32_t depth = uxQueueMessagesWaiting(benchLegacyQueue);
+      if (depth > maxDepth) maxDepth = depth;
+    } else {
+      sent = publishEvent(type, ms);
+    }
+    uint32_t elapsed = micros() - start;
+    
+    published++;
+    if (!sent) failed++;
+    totalUs += elapsed;
+    if (elapsed > maxUs) maxUs = elapsed;
+  }
+  unsigned long elapsedMs = millis() - startMs;
+  
+  benchConsumerRunning = false;
+  while (!benchConsumerDone) {
+    vTaskDelay(pdMS_TO_TICKS(BENCH_EVENT_DRAIN_MS));
+  }
+  
+  uint32_t coalesced = 0;
+  if (mode == EVENTS_BUS) {
+    setEventTopics(benchSubscriber, 0);
+    EventMessage event;
+    while (receiveEvent(benchSubscriber, &event, 0)) {
+      releasePayload(event.payload);
+    }
+    EventSubscriberStats after;
+    getEventSubscriberStats(benchIndex, &after);
+    failed = after.dropped - before.dropped;
+    coalesced = after.coalesced - before.coalesced;
+    maxDepth = after.highWater;
+  }
+  
+  Serial.printf("  %-13s %lu events in %lu ms  publish avg %8.2f us  max %6lu us  depth %lu  "
+                "received %lu  coalesced %lu  lost %lu\n",
+                label, (unsigned long)published, elapsedMs, published ? (double)totalUs / published : 0.0,
+                (unsigned long)maxUs, (unsigned long)maxDepth, (unsigned long)benchConsumed,
+                (unsigned long)coalesced, (unsigned long)failed);
+}
+
+static void benchEvents() {
+  if (!benchLegacyQueue) {
+    benchLegacyQueue = xQueueCreate(BENCH_LEGACY_QUEUE_SIZE, sizeof(EventMessage));
+    benchSubscriber = subscribeEvents("bench", 0);
+    if (!benchLegacyQueue || !benchSubscriber) {
+      Serial.println("ERROR: Failed to create benchmark queues");
+      return;
+    }
+  }
+  
+  Serial.printf("Publisher at 1 kHz for %d ms; consumer drains every %d ms\n", BENCH_EVENT_MS,
+                BENCH_EVENT_DRAIN_MS);
+  runEventLoad("single queue", EVENTS_SINGLE_QUEUE);
+  runEventLoad("pub/sub bus", EVENTS_BUS);
+}
+
+// -----------------------------------------------------------------------------
+// Event payload pool
+// -----------------------------------------------------------------------------
+
+#define BENCH_PAYLOAD_FANOUT 3           // Subscribers holding a reference
+#define BENCH_PAYLOAD_CONTENTION_MS 500
+
+static volatile bool benchPayloadRunning = false;
+static volatile bool benchPayloadDone = false;
+static volatile uint32_t benchPayloadPairs = 0;
+
+static void benchPayloadTask(void* parameter) {
+  while (benchPayloadRunning) {
+    EventPayload payload = allocPayload();
+    if (payload != EVENT_PAYLOAD_NONE) {
+      *(volatile uint8_t*)payloadData(payload) = 1;
+      releasePayload(payload);
+      benchPayloadPairs = benchPayloadPairs + 1;
+    }
+  }
+  benchPayloadDone = true;
+  vTaskDelete(NULL);
+}
+
+static void benchPayload() {
+  PayloadPoolStats before;
+  PayloadPoolStats after;
+  getPayloadPoolStats(&before);
+  
+  uint32_t start = benchCycles();
+  for (uint32_t i = 0; i < BENCH_DEFAULT_ITERATIONS; i++) {
+    EventPayload payload = allocPayload();
+    benchSink = benchSink + payload;
+    releasePayload(payload);
+  }
+  benchReport("pool alloc+release", benchCycles() - start, BENCH_DEFAULT_ITERATIONS);
+  
+  start = benchCycles();
+  for (uint32_t i = 0; i < BENCH_DEFAULT_ITERATIONS; i++) {
+    volatile uint8_t* block = (volatile uint8_t*)malloc(EVENT_PAYLOAD_SIZE);
+    if (block) block[0] = (uint8_t)i;
+    benchSink = benchSink + (uint32_t)(uintptr_t)block;
+    free((void*)block);
+  }
+  benchReport("heap malloc+free", benchCycles() - start, BENCH_DEFAULT_ITERATIONS);
+  
+  // One publish reaching BENCH_PAYLOAD_FANOUT subscribers
+  start = benchCycles();
+  for (uint32_t i = 0; i < BENCH_DEFAULT_ITERATIONS; i++) {
+    EventPayload payload = allocPayload();
+    for (int s = 0; s < BENCH_PAYLOAD_FANOUT; s++) retainPayload(payload);
+    for (int s = 0; s <= BENCH_PAYLOAD_FANOUT; s++) releasePayload(payload);
+  }
+  benchReport("alloc+3 retain+4 release", benchCycles() - start, BENCH_DEFAULT_ITERATIONS);
+  
+  // Drain the pool: the refused allocation must be as cheap as a good one
+  EventPayload held[EVENT_PAYLOAD_BLOCKS];
+  size_t count = 0;
+  while (count < EVENT_PAYLOAD_BLOCKS && (held[count] = allocPayload()) != EVENT_PAYLOAD_NONE) count++;
+  start = benchCycles();
+  for (uint32_t i = 0; i < BENCH_DEFAULT_ITERATIONS; i++) {
+    benchSink = benchSink + allocPayload();
+  }
+  uint32_t refused = benchCycles() - start;
+  for (size_t i = 0; i < count; i++) releasePayload(held[i]);
+  Serial.printf("Pool of %d x %d bytes: %u blocks were free\n", EVENT_PAYLOAD_BLOCKS, EVENT_PAYLOAD_SIZE,
+                (unsigned)count);
+  benchReport("alloc when exhausted", refused, BENCH_DEFAULT_ITERATIONS);
+  
+  // Two tasks allocating and releasing as fast as they can
+  benchPayloadPairs = 0;
+  benchPayloadRunning = true;
+  benchPayloadDone = false;
+  getPayloadPoolStats(&before);
+  if (xTaskCreate(benchPayloadTask, "BenchPayload", COMMAND_TASK_STACK, NULL, COMMAND_TASK_PRIORITY, NULL) != pdPASS) {
+    Serial.println("ERROR: Failed to create benchmark payload task");
+    return;
+  }
+  uint32_t ownPairs = 0;
+  unsigned long startMs = millis();
+  while (millis() - startMs < BENCH_PAYLOAD_CONTENTION_MS) {
+    EventPayload payload = allocPayload();
+    if (payload != EVENT_PAYLOAD_NONE) {
+      *(volatile uint8_t*)payloadData(payload) = 2;
+      releasePayload(payload);
+      ownPairs++;
+    }
+    if ((ownPairs & 0x3FF) == 0) taskYIELD();
+  }
+  benchPayloadRunning = false;
+  while (!benchPayloadDone) {
+    vTaskDelay(pdMS_TO_TICKS(10));
+  }
+  getPayloadPoolStats(&after);
+  Serial.printf("Two tasks for %d ms: %lu + %lu alloc/release pairs, %lu contended updates, %lu bad releases\n",
+                BENCH_PAYLOAD_CONTENTION_MS, (unsigned long)ownPairs, (unsigned long)benchPayloadPairs,
+                (unsigned long)(after.contention - before.contention),
+                (unsigned long)(after.badReleases - before.badReleases));
+  printPayloadPoolStats();
+}
@@ -22,10 +22,21 @@
 #include "GlobalContext.h"
 #include "Config.h"
 #include "Sensors.h"
+#include "SensorDataAccess.h"
 #include "LoRaLink.h"
 #include "NowLink.h"
+#include "PeerTable.h"
 #include "EventQueue.h"
 #include "Logger.h"
+#include "LogStorage.h"
+#include "Backlog.h"
+#include "History.h"
+#include "SampleScheduler.h"
+#include "I2cBus.h"
+#include "PowerManager.h"
+#include "DutyCycle.h"
+#include "Bench.h"
+#include "Tasks.h"
 #include "WiFi.h"
 #include <cstring>
 
@@ -41,6 +52,20 @@ static CommandEntry commandTable[] = {
   {"status",  cmdStatus},
   {"lora",    cmdLora},
   {"reset",   cmdReset},
+  {"frame",   cmdFrame},
+  {"bench",   cmdBench},
+  {"peers",   cmdPeers},
+  {"log",     cmdLog},
+  {"storage", cmdStorage},
+  {"backlog", cmdBacklog},
+  {"batch",   cmdBatch},
+  {"deadband", cmdDeadband},
+  {"history", cmdHistory},
+  {"sampling", cmdSampling},
+  {"light",   cmdLight},
+  {"i2c",     cmdI2c},
+  {"power",   cmdPower},
+  {"duty",    cmdDuty},
 };
 
 bool readSerialLine(char *buffer, size_t bufferSize) {
@@ -102,15 +127,17 @@ void handleSerialCommands() {
 
 void printStartupInfo() {
   Serial.println("\nCommands:");
-  Serial.println("- Type 'config' to configure peer MAC address");
+  Serial.println("- Type 'config' to add a peer MAC address");
+  Serial.println("- Type 'peers' to list, add or remove ESP-NOW peers");
   Serial.println("- Type 'status' to show current configuration");
   Serial.println("- Type 'sensors' to read sensors now");
   Serial.println("- Type 'send' to send LoRa packet now");
   Serial.println("- Type 'lora' to retry LoRa initialization");
   Serial.println("- Type 'reset' to restart the device");
+  Serial.println("- Type 'frame' to show or select the LoRa packet format");
 
   GlobalContext& ctx = getGlobalContext();
-  if (!ctx.macAddressSet) {
+  if (peerCount() == 0) {
     Serial.println("\n⚠️  No peer MAC configured! Type 'config' to set up ESP-NOW");
   } else if (ctx.nowSerialActive) {
     Serial.println("\n✓ ESP-NOW ready - waiting for distance data...");
@@ -127,9 +154,20 @@ void cmdConfig(const char *args) {
   configureMacAddress();
 }
 
+#define SENSORS_COMMAND_TIMEOUT_MS 1000
+
 void cmdSensors(const char *args) {
   Serial.println("\nReading sensors now...");
-  readEnvironmentalSensors();
+  // SensorTask owns the drivers: have it read every channel now and wait
+  // for the snapshot it publishes
+  SensorData before, after;
+  readSensorSnapshot(&before);
+  sampleSchedulerRequest(SENSOR_CHANNELS_ENVIRONMENTAL);
+  unsigned long start = millis();
+  do {
+    delay(10);
+    readSensorSnapshot(&after);
+  } while (after.timestamp == before.timestamp && millis() - start < SENSORS_COMMAND_TIMEOUT_MS);
   printCurrentSensorValues();
 }
 
@@ -142,8 +180,19 @@ void cmdSend(const char *args) {
   const char *hubName = (args && args[0]) ? args : "Greenhouse";
   logInfo("Manual LoRa transmission requested for hub: %s", hubName);
   
-  // Send asynchronous LoRa transmission request to communications task
-  sendEvent(EVENT_LORA_SEND_REQUEST);
+  // Send asynchronous LoRa transmission request to communications task;
+  // without a payload block it goes to the default hub
+  EventPayload payload = allocPayload();
+  LoRaSendRequest* request = payloadAs<LoRaSendRequest>(payload);
+  if (request) {
+    snprintf(request->hubName, sizeof(request->hubName), "%s", hubName);
+  } else {
+    logWarn("No event payload free - sending to the default hub");
+  }
+  if (!publishEvent(EVENT_LORA_SEND_REQUEST, 0, payload)) {
+    logWarn("LoRa transmission request dropped - communications task busy");
+  }
+  releasePayload(payload);
 }
 
 void cmdStatus(const char *args) {
@@ -163,28 +212,413 @@ void cmdStatus(const char *args) {
 
   Serial.print("LoRa Status: ");
   Serial.println(ctx.loraActive ? "Active ✓" : "Inactive ✗");
+  if (ctx.nowSerialActive) {
+    printNowRxStats();
+    printPeerTable();
+  }
+  printLoRaTxStats();
+  printLoRaBatching();
+  printBacklogStats();
+  printReportFilter();
+  printHistoryStats();
 
   printCurrentSensorValues();
+  printSensorFilterStats();
+  printSampleScheduler();
+  printLightStats();
+  printI2cBusStats();
+  printSensorLockStats();
+  printEventBusStats();
+  printCommsTaskStats();
+  printPowerStats();
+  printDutyCycleStats();
+  printPayloadPoolStats();
+  printLoggerStats();
+  printLogStorageStats();
   Serial.println("====================\n");
 }
 
 void cmdLora(const char *args) {
   logInfo("Manual LoRa initialization retry requested");
   initializeLoRa();
+  publishEvent(EVENT_CONFIG_CHANGED);   // CommsTask re-times its LoRa work
 }
 
 void cmdReset(const char *args) {
   logSystemEvent("SYSTEM_RESTART", "Manual restart requested via command");
-  delay(100); // Allow log message to be sent
+  flushLogger(); // Let the logger task write everything queued
+  flushLogStorage();
+  flushBacklog();   // Unsent samples are replayed after the restart
   ESP.restart();
 }
 
+void cmdFrame(const char *args) {
+  if (args && args[0]) {
+    if (strcmp(args, "ascii") == 0) {
+      setLoRaFrameFormat(LORA_FORMAT_ASCII);
+    } else if (strcmp(args, "binary") == 0) {
+      setLoRaFrameFormat(LORA_FORMAT_BINARY);
+    } else {
+      Serial.println("Usage: frame [ascii|binary]");
+      return;
+    }
+    logInfo("LoRa frame format set to %s", loraFrameFormatName(getLoRaFrameFormat()));
+    return;
+  }
+  
+  Serial.print("LoRa frame format: ");
+  Serial.println(loraFrameFormatName(getLoRaFrameFormat()));
+}
+
+void cmdBench(const char *args) {
+  runBenchmark(args);
+}
+
+void cmdPeers(const char *args) {
+  if (!args || !args[0]) {
+    printPeerTable();
+    return;
+  }
+  
+  if (strcmp(args, "clear") == 0) {
+    clearNowPeers();
+    logInfo("All ESP-NOW peers removed");
+    return;
+  }
+  
+  uint8_t mac[6];
+  bool add = strncmp(args, "add ", 4) == 0;
+  bool del = strncmp(args, "del ", 4) == 0;
+  if ((!add && !del) || !parseMacAddress(args + 4, mac)) {
+    Serial.println("Usage: peers [add MAC|del MAC|clear]");
+    return;
+  }
+  
+  if (add ? addNowPeer(mac) : removeNowPeer(mac)) {
+    logInfo("Peer %s %s", args + 4, add ? "added" : "removed");
+  } else {
+    logWarn("Failed to %s peer %s", add ? "add" : "remove", args + 4);
+  }
+}
+
+void cmdLog(const char *args) {
+  if (args && args[0]) {
+    if (strcmp(args, "text") == 0) {
+      setLogOutputFormat(LOG_OUTPUT_TEXT);
+    } else if (strcmp(args, "binary") == 0) {
+      // Announce in text so a plain terminal shows why output stops
+      Serial.println("Log output switching to binary; decode with tools/logdecode.py");
+      setLogOutputFormat(LOG_OUTPUT_BINARY);
+    } else {
+      Serial.println("Usage: log [text|binary]");
+      return;
+    }
+    logInfo("Log output set to %s", logOutputFormatName(getLogOutputFormat()));
+    return;
+  }
+  
+  Serial.print("Log output: ");
+  Serial.println(logOutputFormatName(getLogOutputFormat()));
+}
+
+void cmdStorage(const char *args) {
+  if (!args || !args[0]) {
+    printLogStorageStats();
+  } else if (strcmp(args, "dump") == 0) {
+    flushLogger();
+    dumpLogStorage();
+  } else if (strcmp(args, "flush") == 0) {
+    flushLogger();
+    if (!flushLogStorage()) logWarn("Log storage flush failed");
+  } else if (strcmp(args, "erase") == 0) {
+    if (eraseLogStorage()) {
+      logInfo("Stored logs erased");
+    } else {
+      logWarn("Log storage erase failed");
+    }
+  } else {
+    Serial.println("Usage: storage [dump|flush|erase]");
+  }
+}
+
+void cmdBacklog(const char *args) {
+  if (args && args[0]) {
+    if (strcmp(args, "oldest") == 0) {
+      setBacklogOrder(BACKLOG_OLDEST_FIRST);
+    } else if (strcmp(args, "newest") == 0) {
+      setBacklogOrder(BACKLOG_NEWEST_FIRST);
+    } else {
+      Serial.println("Usage: backlog [oldest|newest]");
+      return;
+    }
+    logInfo("Backlog drain order set to %s", backlogOrderName(getBacklogOrder()));
+    return;
+  }
+  
+  printBacklogStats();
+}
+
+void cmdBatch(const char *args) {
+  if (args && args[0]) {
+    GlobalContext& ctx = getGlobalContext();
+    unsigned samples = 1;
+    unsigned seconds = ctx.loraBatchLatencyMs / 1000;
+    bool ok;
+    if (strcmp(args, "off") == 0) {
+      ok = setLoRaBatching(1, ctx.loraBatchLatencyMs);
+    } else {
+      ok = sscanf(args, "%u %u", &samples, &seconds) >= 1 && samples <= 255 &&
+           setLoRaBatching((uint8_t)samples, seconds * 1000UL);
+    }
+    if (!ok) {
+      Serial.printf("Usage: batch [off|samples [seconds]] (up to %u samples, %u s)\n",
+                    BACKLOG_BATCH_MAX, LORA_BATCH_MAX_LATENCY_MS / 1000);
+      return;
+    }
+    logInfo("LoRa batching set to %u samples, %u s", (unsigned)ctx.loraBatchSamples,
+            (unsigned)(ctx.loraBatchLatencyMs / 1000));
+  }
+  
+  printLoRaBatching();
+}
+
+void cmdDeadband(const char *args) {
+  if (!args || !args[0]) {
+    printReportFilter();
+    return;
+  }
+  
+  ReportFilter filter;
+  getReportFilter(&filter);
+  ReportDeadbands bands = filter.deadbands;
+  char field[12];
+  float value = 0;
+  bool ok = true;
+  
+  if (strcmp(args, "off") == 0) {
+    bands.enabled = false;
+  } else if (strcmp(args, "on") == 0) {
+    reportDefaultDeadbands(&bands);
+  } else if (sscanf(args, "%11s %f", field, &value) == 2 && value >= 0 && value < 65535) {
+    bands.enabled = true;
+    if (strcmp(field, "temp") == 0) {
+      bands.temperatureCenti = (uint16_t)(value * 100 + 0.5f);
+    } else if (strcmp(field, "hum") == 0) {
+      bands.humidityCenti = (uint16_t)(value * 100 + 0.5f);
+    } else if (strcmp(field, "lux") == 0) {
+      bands.luxPercent = (uint16_t)value;
+    } else if (strcmp(field, "dist") == 0) {
+      bands.distanceCenti = (uint16_t)(value * 100 + 0.5f);
+    } else if (strcmp(field, "heartbeat") == 0 && value >= 1) {
+      bands.heartbeatMs = (uint32_t)value * 1000;
+    } else {
+      ok = false;
+    }
+  } else {
+    ok = false;
+  }
+  
+  if (!ok) {
+    Serial.println("Usage: deadband [on|off|temp C|hum %|lux %|dist in|heartbeat s]");
+    return;
+  }
+  setReportDeadbands(&bands);
+  logInfo("Report deadbands updated");
+  printReportFilter();
+}
+
+void cmdSampling(const char *args) {
+  if (args && args[0]) {
+    if (strcmp(args, "adaptive") == 0) {
+      setSampleAdaptive(true);
+    } else if (strcmp(args, "fixed") == 0) {
+      setSampleAdaptive(false);
+    } else {
+      Serial.println("Usage: sampling [adaptive|fixed]");
+      return;
+    }
+    logInfo("Sampling mode set to %s", args);
+  }
+  printSampleScheduler();
+}
+
+void cmdLight(const char *args) {
+  if (args && args[0]) {
+    if (strcmp(args, "auto") == 0) {
+      setLightAutoRange(true);
+    } else if (strcmp(args, "fixed") == 0) {
+      setLightAutoRange(false);
+    } else {
+      Serial.println("Usage: light [auto|fixed]");
+      return;
+    }
+    logInfo("Light sensor range set to %s", args);
+  }
+  printLightStats();
+}
+
+void cmdI2c(const char *args) {
+  if (args && args[0]) {
+    if (strcmp(args, "scan") != 0) {
+      Serial.println("Usage: i2c [scan]");
+      return;
+    }
+    i2cBusScan();
+  }
+  printI2cScan();
+  printI2cBusStats();
+}
+
+void cmdPower(const char *args) {
+  if (args && args[0]) {
+    PowerMode mode;
+    if (strcmp(args, "off") == 0) {
+      mode = POWER_MODE_OFF;
+    } else if (strcmp(args, "dfs") == 0) {
+      mode = POWER_MODE_DFS;
+    } else if (strcmp(args, "sleep") == 0) {
+      mode = POWER_MODE_LIGHT_SLEEP;
+    } else {
+      Serial.println("Usage: power [off|dfs|sleep]");
+      return;
+    }
+    if (!setPowerMode(mode)) {
+      logWarn("Power mode %s not supported by this core", args);
+    } else {
+      logInfo("Power mode set to %s", args);
+    }
+  }
+  printPowerStats();
+}
+
+void cmdDuty(const char *args) {
+  if (args && args[0]) {
+    DutyCycleConfig config;
+    getDutyCycleConfig(&config);
+    unsigned seconds = config.periodSeconds;
+    unsigned samples = config.batchSamples;
+    bool ok;
+    if (strcmp(args, "off") == 0) {
+      config.enabled = false;
+      ok = setDutyCycleConfig(&config);
+    } else {
+      ok = (strcmp(args, "on") == 0 || sscanf(args, "on %u %u", &seconds, &samples) >= 1) &&
+           seconds <= DUTY_MAX_PERIOD_S && samples <= 255;
+      config.enabled = true;
+      config.periodSeconds = (uint16_t)seconds;
+      config.batchSamples = (uint8_t)samples;
+      ok = ok && setDutyCycleConfig(&config);
+    }
+    if (!ok) {
+      Serial.printf("Usage: duty [off|on [seconds [samples]]] (%u-%u s, up to %u samples)\n",
+                    DUTY_MIN_PERIOD_S, DUTY_MAX_PERIOD_S, BACKLOG_BATCH_MAX);
+      return;
+    }
+    if (config.enabled) {
+      logInfo("Duty cycling every %u s, %u samples per frame - press BOOT to wake",
+              (unsigned)config.periodSeconds, (unsigned)config.batchSamples);
+      startDutyCycle();
+    } else {
+      logInfo("Duty cycling off");
+    }
+  }
+  printDutyCycleStats();
+}
+
+#define HISTORY_PRINT_PAGE 16
+
+static void printHistoryRange(HistoryTier tier, HistoryChannel channel, uint32_t fromMs, uint32_t toMs) {
+  HistoryPoint points[HISTORY_PRINT_PAGE];
+  unsigned long now = millis();
+  uint32_t cursorMs = fromMs;
+  size_t count;
+  Serial.printf("History %s %s (age s: mean [min..max] samples)\n", historyTierName(tier),
+                historyChannelName(channel));
+  while ((count = queryHistory(tier, channel, cursorMs, toMs, points, HISTORY_PRINT_PAGE)) > 0) {
+    for (size_t i = 0; i < count; i++) {
+      const HistoryPoint& point = points[i];
+      Serial.printf("  %6lu: ", (unsigned long)((now - point.timeMs) / 1000));
+      printHistoryValue(channel, point.mean);
+      if (tier != HISTORY_RAW) {
+        Serial.print(" [");
+        printHistoryValue(channel, point.min);
+        Serial.print("..");
+        printHistoryValue(channel, point.max);
+        Serial.printf("] %u", point.count);
+      }
+      Serial.println();
+    }
+    cursorMs = points[count - 1].timeMs + 1;
+  }
+  
+  HistoryPoint summary;
+  if (!summarizeHistory(tier, channel, fromMs, toMs, &summary)) {
+    Serial.println("  no readings in range");
+    return;
+  }
+  Serial.printf("  %u points, mean ", summary.count);
+  printHistoryValue(channel, summary.mean);
+  Serial.print(" [");
+  printHistoryValue(channel, summary.min);
+  Serial.print("..");
+  printHistoryValue(channel, summary.max);
+  Serial.println("]");
+}
+
+void cmdHistory(const char *args) {
+  if (!args || !args[0]) {
+    printHistoryStats();
+    return;
+  }
+  
+  bool send = strncmp(args, "send ", 5) == 0;
+  char tierName[6], channelName[6];
+  unsigned minutes = 0;
+  HistoryTier tier;
+  HistoryChannel channel;
+  int fields = sscanf(send ? args + 5 : args, "%5s %5s %u", tierName, channelName, &minutes);
+  if (fields < 2 || !parseHistoryTier(tierName, &tier) || !parseHistoryChannel(channelName, &channel)) {
+    Serial.println("Usage: history [send] [raw|1m|15m temp|hum|lux|dist [minutes]]");
+    return;
+  }
+  if (fields < 3) minutes = tier == HISTORY_RAW ? 1 : 60;
+  
+  uint32_t now = millis();
+  uint32_t span = minutes * 60000UL;
+  uint32_t fromMs = span < now ? now - span : 0;
+  
+  if (send) {
+    if (requestHistoryUpload(tier, channel, fromMs)) {
+      logInfo("History upload queued: %s %s, last %u min", historyTierName(tier),
+              historyChannelName(channel), minutes);
+    } else {
+      logWarn("History upload not started - LoRa down or an upload is running");
+    }
+    return;
+  }
+  printHistoryRange(tier, channel, fromMs, now);
+}
+
 void cmdHelp(const char *args) {
   Serial.println("Available commands:");
-  Serial.println("  config              - configure peer MAC address");
+  Serial.println("  config              - add a peer MAC address interactively");
   Serial.println("  status              - show current configuration & sensor state");
   Serial.println("  sensors             - read sensors now");
   Serial.println("  send [hubName]      - send LoRa packet now (default: Greenhouse)");
   Serial.println("  lora                - retry LoRa initialization");
   Serial.println("  reset               - restart the device");
+  Serial.println("  frame [fmt]         - show or select LoRa packet format (ascii|binary)");
+  Serial.println("  bench [name|all]    - run micro-benchmarks");
+  Serial.println("  peers [add|del MAC] - list, add or remove ESP-NOW peers (peers clear)");
+  Serial.println("  log [text|binary]   - show or select the serial log encoding");
+  Serial.println("  storage [dump]      - stored log stats, dump for logdecode.py (flush|erase)");
+  Serial.println("  backlog [order]     - unsent sample stats, drain order (oldest|newest)");
+  Serial.println("  batch [n [secs]]    - send n samples per LoRa frame, at most secs late (batch off)");
+  Serial.println("  deadband [field v]  - report-by-exception thresholds (temp|hum|lux|dist|heartbeat, on|off)");
+  Serial.println("  history [tier ch m] - last m minutes of raw|1m|15m temp|hum|lux|dist (history send ... over LoRa)");
+  Serial.println("  sampling [mode]     - per-sensor sampling periods (adaptive|fixed)");
+  Serial.println("  light [mode]        - TSL2561 gain/integration ranging (auto|fixed)");
+  Serial.println("  i2c [scan]          - I2C devices found and bus stats, scan again");
+  Serial.println("  power [mode]        - clock scaling and light sleep (off|dfs|sleep), lock stats");
+  Serial.println("  duty [on [s [n]]]   - deep sleep between samples every s seconds, send n per frame (duty off)");
 }
\ No newline at end of file
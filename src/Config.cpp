@@ -21,6 +21,7 @@
 #include "Config.h"
 #include "GlobalContext.h"
 #include "NowLink.h"
+#include "PeerTable.h"
 #include <cstring>
 
 void initializeConfig() {
@@ -36,25 +37,6 @@ void printMacAddress(uint8_t* mac) {
   Serial.println();
 }
 
-void saveMacToEEPROM(uint8_t* mac) {
-  if (!mac) {
-    Serial.println("ERROR: Invalid MAC address pointer");
-    return;
-  }
-  
-  for (int i = 0; i < MAC_ADDRESS_SIZE; i++) {
-    EEPROM.write(EEPROM_MAC_ADDR + i, mac[i]);
-  }
-  
-  EEPROM.write(EEPROM_INIT_FLAG, 0xAA);
-  if (!EEPROM.commit()) {
-    Serial.println("ERROR: Failed to commit MAC to EEPROM");
-    return;
-  }
-  
-  Serial.println("MAC address saved to EEPROM!");
-}
-
 bool loadMacFromEEPROM(uint8_t* mac) {
   if (!mac) return false;
   
@@ -68,6 +50,14 @@ bool loadMacFromEEPROM(uint8_t* mac) {
   return true;
 }
 
+// The legacy single-peer slot is only read for migration into the peer table
+void clearLegacyMacInEEPROM() {
+  EEPROM.write(EEPROM_INIT_FLAG, 0x00);
+  if (!EEPROM.commit()) {
+    Serial.println("ERROR: Failed to clear legacy MAC in EEPROM");
+  }
+}
+
 bool parseMacAddress(const char* macStr, uint8_t* mac) {
   if (!macStr || !mac) return false;
   
@@ -99,8 +89,8 @@ bool parseMacAddress(const char* macStr, uint8_t* mac) {
 
 void configureMacAddress() {
   Serial.println("\n=== MAC ADDRESS CONFIGURATION ===");
-  Serial.println("Enter peer MAC address (format: AA:BB:CC:DD:EE:FF):");
-  Serial.println("Or type 'show' to display current MAC, 'clear' to reset");
+  Serial.println("Enter peer MAC address to add (format: AA:BB:CC:DD:EE:FF):");
+  Serial.println("Or type 'show' to list peers, 'clear' to remove all peers");
 
   char inputBuffer[50];
   unsigned long timeout = millis() + 30000;
@@ -120,37 +110,25 @@ void configureMacAddress() {
       }
 
       if (strcasecmp(inputBuffer, "show") == 0) {
-        GlobalContext& ctx = getGlobalContext();
-        if (ctx.macAddressSet) {
-          Serial.print("Current peer MAC: ");
-          printMacAddress(ctx.peerMacAddress);
-        } else {
-          Serial.println("No MAC address set");
-        }
+        printPeerTable();
         continue;
       }
 
       if (strcasecmp(inputBuffer, "clear") == 0) {
-        EEPROM.write(EEPROM_INIT_FLAG, 0x00);
-        if (!EEPROM.commit()) {
-          Serial.println("Failed to clear EEPROM");
-          continue;
-        }
-        Serial.println("MAC address cleared from EEPROM");
-        getGlobalContext().macAddressSet = false;
+        clearNowPeers();
+        Serial.println("All peers cleared from EEPROM");
         continue;
       }
 
       uint8_t newMac[6];
       if (parseMacAddress(inputBuffer, newMac)) {
-        if (initializeNowSerial(newMac)) {
-          saveMacToEEPROM(newMac);
-          Serial.print("Peer MAC address set to: ");
+        if (addNowPeer(newMac)) {
+          Serial.print("Peer MAC address added: ");
           printMacAddress(newMac);
           Serial.println("Configuration saved!\n");
           break;
         } else {
-          Serial.println("Failed to initialize ESP-NOW with new MAC");
+          Serial.println("Failed to add peer");
         }
       } else {
         Serial.println("Invalid MAC address format. Use AA:BB:CC:DD:EE:FF");
@@ -163,12 +141,3 @@ void configureMacAddress() {
     Serial.println("Configuration timeout - returning to main loop");
   }
 }
-
-void setMacAddress(uint8_t* mac) {
-  if (mac) {
-    GlobalContext& ctx = getGlobalContext();
-    memcpy(ctx.peerMacAddress, mac, 6);
-    ctx.macAddressSet = true;
-  }
-}
-
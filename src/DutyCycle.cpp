@@ -0,0 +1,266 @@
+/**
+ * DutyCycle.cpp - Duty-cycled deep sleep mode
+ * 
+ * Copyright (C) 2025 Michael Garcia, M&E Design
+ * Based on original .ino by Geoff Mcintyre of Mr.Industries (https://mr.industries/)
+ * 
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ * 
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU General Public License for more details.
+ * 
+ * You should have received a copy of the GNU General Public License
+ * along with this program. If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#include "DutyCycle.h"
+#include "Config.h"
+#include "Sensors.h"
+#include "LoRaLink.h"
+#include "Backlog.h"
+#include "ReportFilter.h"
+#include "Logger.h"
+#include "LogStorage.h"
+#include "TelemetryFrame.h"
+#include "esp_sleep.h"
+#include <cstring>
+
+static_assert(DUTY_DEFAULT_BATCH <= BACKLOG_BATCH_MAX, "Default batch must fit in a batch frame");
+
+/**
+ * EEPROM layout at EEPROM_DUTY_CONFIG_ADDR:
+ * 'D' 'C' version enabled period(u16) batch, then CRC-16 over everything
+ * before it
+ */
+#define DUTY_CONFIG_MAGIC0 'D'
+#define DUTY_CONFIG_MAGIC1 'C'
+#define DUTY_CONFIG_VERSION 1
+#define DUTY_CONFIG_SIZE 7
+
+static_assert(EEPROM_DUTY_CONFIG_ADDR + DUTY_CONFIG_SIZE + 2 <= EEPROM_SIZE, "Duty cycle config does not fit in EEPROM");
+
+static DutyCycleConfig config = {false, DUTY_DEFAULT_PERIOD_S, DUTY_DEFAULT_BATCH};
+
+// Survives deep sleep; zeroed by any other reset. The ring holds
+// [rtcHead, rtcHead + rtcCount) with timestamps on the duty clock.
+RTC_DATA_ATTR static BacklogSample rtcSamples[DUTY_BACKLOG_CAPACITY];
+RTC_DATA_ATTR static uint8_t rtcHead;
+RTC_DATA_ATTR static uint8_t rtcCount;
+RTC_DATA_ATTR static uint16_t rtcSequence;
+RTC_DATA_ATTR static uint32_t dutyClockMs;      // Start of the current wake
+RTC_DATA_ATTR static bool rtcFilterReady;
+RTC_DATA_ATTR static ReportFilter rtcFilter;
+RTC_DATA_ATTR static DutyCycleStats stats;
+
+static bool loadDutyCycleConfig() {
+  uint8_t image[DUTY_CONFIG_SIZE + 2];
+  for (size_t i = 0; i < sizeof(image); i++) {
+    image[i] = EEPROM.read(EEPROM_DUTY_CONFIG_ADDR + i);
+  }
+  uint16_t stored = (uint16_t)(image[DUTY_CONFIG_SIZE] | (image[DUTY_CONFIG_SIZE + 1] << 8));
+  if (image[0] != DUTY_CONFIG_MAGIC0 || image[1] != DUTY_CONFIG_MAGIC1 ||
+      image[2] != DUTY_CONFIG_VERSION || telemetryCrc16(image, DUTY_CONFIG_SIZE) != stored) {
+    return false;
+  }
+
+  DutyCycleConfig loaded;
+  loaded.enabled = image[3] != 0;
+  loaded.periodSeconds = (uint16_t)(image[4] | (image[5] << 8));
+  loaded.batchSamples = image[6];
+  if (loaded.periodSeconds < DUTY_MIN_PERIOD_S || loaded.periodSeconds > DUTY_MAX_PERIOD_S ||
+      loaded.batchSamples == 0 || loaded.batchSamples > BACKLOG_BATCH_MAX) {
+    return false;
+  }
+  config = loaded;
+  return true;
+}
+
+static bool saveDutyCycleConfig() {
+  uint8_t image[DUTY_CONFIG_SIZE + 2];
+  image[0] = DUTY_CONFIG_MAGIC0;
+  image[1] = DUTY_CONFIG_MAGIC1;
+  image[2] = DUTY_CONFIG_VERSION;
+  image[3] = config.enabled ? 1 : 0;
+  image[4] = (uint8_t)(config.periodSeconds & 0xFF);
+  image[5] = (uint8_t)(config.periodSeconds >> 8);
+  image[6] = config.batchSamples;
+  uint16_t crc = telemetryCrc16(image, DUTY_CONFIG_SIZE);
+  image[DUTY_CONFIG_SIZE] = (uint8_t)(crc & 0xFF);
+  image[DUTY_CONFIG_SIZE + 1] = (uint8_t)(crc >> 8);
+
+  for (size_t i = 0; i < sizeof(image); i++) {
+    EEPROM.write(EEPROM_DUTY_CONFIG_ADDR + i, image[i]);
+  }
+  if (!EEPROM.commit()) {
+    Serial.println("ERROR: Failed to commit duty cycle config to EEPROM");
+    return false;
+  }
+  return true;
+}
+
+static void appendRtcSample(const SensorSample& sample) {
+  if (rtcCount == DUTY_BACKLOG_CAPACITY) {
+    rtcHead = (rtcHead + 1) % DUTY_BACKLOG_CAPACITY;
+    rtcCount--;
+    stats.dropped++;
+  }
+  BacklogSample& entry = rtcSamples[(rtcHead + rtcCount) % DUTY_BACKLOG_CAPACITY];
+  entry.sample = sample;
+  entry.sequence = rtcSequence++;
+  entry.earlierBoot = false;
+  rtcCount++;
+}
+
+static void dropRtcSamples(size_t count) {
+  rtcHead = (rtcHead + count) % DUTY_BACKLOG_CAPACITY;
+  rtcCount -= (uint8_t)count;
+}
+
+// Sends the whole RTC backlog, oldest first, and leaves the radio asleep
+static bool sendRtcBacklog(uint32_t clockMs) {
+  LoRa.setPins(PIN_LORA_CS, PIN_LORA_RST, PIN_LORA_DIO0);
+  if (!LoRa.begin(915E6)) {
+    logError("LoRa initialization failed at 915MHz");
+    return false;
+  }
+  LoRa.setSpreadingFactor(LORA_SPREADING_FACTOR);
+
+  bool ok = true;
+  while (ok && rtcCount > 0) {
+    // buildBatchPacket() takes ages from millis(), so move the duty clock
+    // timestamps onto it
+    BacklogSample batch[BACKLOG_BATCH_MAX];
+    size_t count = rtcCount < BACKLOG_BATCH_MAX ? rtcCount : BACKLOG_BATCH_MAX;
+    unsigned long now = millis();
+    for (size_t i = 0; i < count; i++) {
+      batch[i] = rtcSamples[(rtcHead + i) % DUTY_BACKLOG_CAPACITY];
+      batch[i].sample.timestamp = now - (clockMs + now - batch[i].sample.timestamp);
+    }
+
+    uint8_t packet[LORA_MAX_PACKET_SIZE];
+    size_t length = buildBatchPacket(batch, count, NULL, 0, packet, sizeof(packet));
+    ok = length > 0 && LoRa.beginPacket() && LoRa.write(packet, length) == length && LoRa.endPacket();
+    if (ok) {
+      dropRtcSamples(count);
+      stats.frames++;
+    }
+  }
+  LoRa.sleep();
+  return ok;
+}
+
+[[noreturn]] static void deepSleep(uint32_t sleepMs) {
+  esp_sleep_enable_timer_wakeup((uint64_t)sleepMs * 1000ULL);
+  esp_sleep_enable_ext0_wakeup((gpio_num_t)DUTY_WAKE_PIN, 0);
+  esp_deep_sleep_start();
+}
+
+bool dutyCycleBoot() {
+  loadDutyCycleConfig();
+  return config.enabled && esp_sleep_get_wakeup_cause() != ESP_SLEEP_WAKEUP_EXT0;
+}
+
+void runDutyCycle() {
+  // Only problems are worth the time on the console
+  initLogger(LOG_WARN, SINK_SERIAL);
+  initializeSensors(false);
+
+  if (!rtcFilterReady) {
+    ReportDeadbands bands;
+    reportDefaultDeadbands(&bands);
+    bands.heartbeatMs = UINT32_MAX;   // The batch is the heartbeat
+    reportFilterInit(&rtcFilter, &bands);
+    rtcFilterReady = true;
+  }
+
+  SensorSample sample;
+  acquireEnvironmentalSample(&sample);
+  sample.timestamp += dutyClockMs;
+  appendRtcSample(sample);
+  stats.cycles++;
+
+  bool exception = reportFilterCheck(&rtcFilter, &sample) != REPORT_SUPPRESSED;
+  if ((rtcCount >= config.batchSamples || exception) && !sendRtcBacklog(dutyClockMs)) {
+    stats.sendFailures++;
+  }
+  stats.pending = rtcCount;
+  flushLogger();
+
+  uint32_t awakeMs = millis();
+  uint32_t periodMs = config.periodSeconds * 1000UL;
+  uint32_t sleepMs = awakeMs + DUTY_MIN_SLEEP_MS < periodMs ? periodMs - awakeMs : DUTY_MIN_SLEEP_MS;
+  stats.lastAwakeMs = awakeMs;
+  if (awakeMs > stats.maxAwakeMs) stats.maxAwakeMs = awakeMs;
+  stats.totalAwakeMs += awakeMs;
+  dutyClockMs += awakeMs + sleepMs;
+  deepSleep(sleepMs);
+}
+
+size_t adoptDutyCycleSamples() {
+  size_t adopted = 0;
+  while (rtcCount > 0 && adoptBacklogSample(&rtcSamples[rtcHead].sample)) {
+    dropRtcSamples(1);
+    adopted++;
+  }
+  stats.pending = rtcCount;
+  return adopted;
+}
+
+void getDutyCycleConfig(DutyCycleConfig* out) {
+  if (out) *out = config;
+}
+
+bool setDutyCycleConfig(const DutyCycleConfig* newConfig) {
+  if (!newConfig || newConfig->periodSeconds < DUTY_MIN_PERIOD_S || newConfig->periodSeconds > DUTY_MAX_PERIOD_S ||
+      newConfig->batchSamples == 0 || newConfig->batchSamples > BACKLOG_BATCH_MAX) {
+    return false;
+  }
+  config = *newConfig;
+  return saveDutyCycleConfig();
+}
+
+void startDutyCycle() {
+  logSystemEvent("DUTY_CYCLE", "Entering deep sleep");
+
+  // Let the frame on air finish before the radio goes to sleep
+  unsigned long start = millis();
+  LoRaTxStats tx;
+  getLoRaTxStats(&tx);
+  while (tx.depth > 0 && millis() - start < DUTY_TX_DRAIN_TIMEOUT_MS) {
+    delay(10);
+    getLoRaTxStats(&tx);
+  }
+
+  flushLogger();
+  flushLogStorage();
+  flushBacklog();   // Sent by the normal firmware after the next BOOT wake
+  LoRa.sleep();
+
+  // A fresh run: the deadbands report the first sample, and the first
+  // wake comes one period from now
+  memset(&stats, 0, sizeof(stats));
+  stats.pending = rtcCount;
+  rtcFilterReady = false;
+  deepSleep(config.periodSeconds * 1000UL);
+}
+
+void getDutyCycleStats(DutyCycleStats* out) {
+  if (out) *out = stats;
+}
+
+void printDutyCycleStats() {
+  Serial.printf("Duty cycle: %s, every %u s, %u samples per frame\n", config.enabled ? "on" : "off",
+                (unsigned)config.periodSeconds, (unsigned)config.batchSamples);
+  if (stats.cycles == 0 && stats.pending == 0) return;
+  Serial.printf("  %lu wakes, awake %lu ms last, %lu ms max, %lu ms average\n", (unsigned long)stats.cycles,
+                (unsigned long)stats.lastAwakeMs, (unsigned long)stats.maxAwakeMs,
+                (unsigned long)(stats.cycles ? stats.totalAwakeMs / stats.cycles : 0));
+  Serial.printf("  %lu frames sent, %lu failed sends, %lu samples dropped, %u pending in RTC memory\n",
+                (unsigned long)stats.frames, (unsigned long)stats.sendFailures, (unsigned long)stats.dropped,
+                (unsigned)stats.pending);
+}
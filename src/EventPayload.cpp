@@ -0,0 +1,131 @@
+/**
+ * EventPayload.cpp - Reference-counted fixed-block payloads for events
+ * 
+ * Copyright (C) 2025 Michael Garcia, M&E Design
+ * Based on original .ino by Geoff Mcintyre of Mr.Industries (https://mr.industries/)
+ * 
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ * 
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU General Public License for more details.
+ * 
+ * You should have received a copy of the GNU General Public License
+ * along with this program. If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#include "EventPayload.h"
+#include <atomic>
+
+static_assert(EVENT_PAYLOAD_BLOCKS < 256, "payload handles are 8-bit");
+
+struct PayloadBlock {
+  alignas(EVENT_PAYLOAD_ALIGN) uint8_t data[EVENT_PAYLOAD_SIZE];
+};
+
+static PayloadBlock blocks[EVENT_PAYLOAD_BLOCKS];
+static std::atomic<uint16_t> refs[EVENT_PAYLOAD_BLOCKS];
+// Handle of the next free block; only meaningful while the block is free
+static std::atomic<uint8_t> nextFree[EVENT_PAYLOAD_BLOCKS];
+// Top of the free stack: a tag bumped on every update, then the handle in
+// the low byte, so a pop that raced a pop and push of the same block fails
+static std::atomic<uint32_t> freeHead(0);
+
+static std::atomic<uint32_t> allocCount(0);
+static std::atomic<uint32_t> exhaustedCount(0);
+static std::atomic<uint32_t> inUseCount(0);
+static std::atomic<uint32_t> highWater(0);
+static std::atomic<uint32_t> contentionCount(0);
+static std::atomic<uint32_t> badReleaseCount(0);
+
+static bool validPayload(EventPayload payload) {
+  return payload != EVENT_PAYLOAD_NONE && payload <= EVENT_PAYLOAD_BLOCKS;
+}
+
+static void pushFree(EventPayload payload) {
+  uint32_t head = freeHead.load(std::memory_order_relaxed);
+  while (true) {
+    nextFree[payload - 1].store((uint8_t)(head & 0xFF), std::memory_order_relaxed);
+    uint32_t top = (((head >> 8) + 1) << 8) | payload;
+    if (freeHead.compare_exchange_weak(head, top, std::memory_order_release, std::memory_order_relaxed)) return;
+    contentionCount.fetch_add(1, std::memory_order_relaxed);
+  }
+}
+
+void initPayloadPool() {
+  // Only at startup, before any task can hold a payload
+  freeHead.store(0, std::memory_order_relaxed);
+  for (int i = EVENT_PAYLOAD_BLOCKS; i > 0; i--) {
+    refs[i - 1].store(0, std::memory_order_relaxed);
+    pushFree((EventPayload)i);
+  }
+  inUseCount.store(0, std::memory_order_relaxed);
+}
+
+EventPayload allocPayload() {
+  uint32_t head = freeHead.load(std::memory_order_acquire);
+  EventPayload payload;
+  while (true) {
+    payload = (EventPayload)(head & 0xFF);
+    if (payload == EVENT_PAYLOAD_NONE) {
+      exhaustedCount.fetch_add(1, std::memory_order_relaxed);
+      return EVENT_PAYLOAD_NONE;
+    }
+    uint32_t top = (((head >> 8) + 1) << 8) | nextFree[payload - 1].load(std::memory_order_relaxed);
+    if (freeHead.compare_exchange_weak(head, top, std::memory_order_acquire, std::memory_order_acquire)) break;
+    contentionCount.fetch_add(1, std::memory_order_relaxed);
+  }
+  
+  refs[payload - 1].store(1, std::memory_order_relaxed);
+  allocCount.fetch_add(1, std::memory_order_relaxed);
+  uint32_t inUse = inUseCount.fetch_add(1, std::memory_order_relaxed) + 1;
+  uint32_t peak = highWater.load(std::memory_order_relaxed);
+  while (inUse > peak && !highWater.compare_exchange_weak(peak, inUse, std::memory_order_relaxed)) {}
+  return payload;
+}
+
+void retainPayload(EventPayload payload) {
+  if (validPayload(payload)) refs[payload - 1].fetch_add(1, std::memory_order_relaxed);
+}
+
+void releasePayload(EventPayload payload) {
+  if (!validPayload(payload)) return;
+  uint16_t previous = refs[payload - 1].fetch_sub(1, std::memory_order_acq_rel);
+  if (previous == 0) {
+    refs[payload - 1].store(0, std::memory_order_relaxed);
+    badReleaseCount.fetch_add(1, std::memory_order_relaxed);
+    return;
+  }
+  if (previous != 1) return;
+  
+  inUseCount.fetch_sub(1, std::memory_order_relaxed);
+  pushFree(payload);
+}
+
+void* payloadData(EventPayload payload) {
+  return validPayload(payload) ? blocks[payload - 1].data : NULL;
+}
+
+void getPayloadPoolStats(PayloadPoolStats* stats) {
+  if (!stats) return;
+  stats->allocs = allocCount.load(std::memory_order_relaxed);
+  stats->exhausted = exhaustedCount.load(std::memory_order_relaxed);
+  stats->inUse = inUseCount.load(std::memory_order_relaxed);
+  stats->highWater = highWater.load(std::memory_order_relaxed);
+  stats->contention = contentionCount.load(std::memory_order_relaxed);
+  stats->badReleases = badReleaseCount.load(std::memory_order_relaxed);
+}
+
+void printPayloadPoolStats() {
+  PayloadPoolStats stats;
+  getPayloadPoolStats(&stats);
+  Serial.printf("Event payloads: %lu/%d blocks in use (peak %lu), %lu allocated, %lu refused, "
+                "%lu contended, %lu bad releases\n",
+                (unsigned long)stats.inUse, EVENT_PAYLOAD_BLOCKS, (unsigned long)stats.highWater,
+                (unsigned long)stats.allocs, (unsigned long)stats.exhausted, (unsigned long)stats.contention,
+                (unsigned long)stats.badReleases);
+}
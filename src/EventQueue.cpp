@@ -19,89 +19,293 @@
  */
 
 #include "EventQueue.h"
+#include "freertos/semphr.h"
+#include <atomic>
 
-// Global FreeRTOS queue handle for inter-task communication
-QueueHandle_t eventQueue = NULL;
+static_assert(EVENT_MAX_SUBSCRIBERS <= 8, "topic subscriber sets are 8-bit masks");
+static_assert(EVENT_TYPE_COUNT <= 32, "event types must fit an EventMask");
+
+struct EventSubscriber {
+  const char* name;
+  QueueHandle_t queue;
+  uint8_t depth;
+  EventMask topics;
+  std::atomic<EventMask> pending;                  // Coalesced topics with a copy queued
+  std::atomic<uint32_t> latest[EVENT_TYPE_COUNT];  // Data the queued copy will carry
+  std::atomic<EventPayload> latestPayload[EVENT_TYPE_COUNT];
+  uint32_t queued;
+  uint32_t coalesced;
+  uint32_t dropped;
+  uint32_t highWater;
+};
+
+static EventSubscriber subscribers[EVENT_MAX_SUBSCRIBERS];
+static std::atomic<uint8_t> subscriberCount(0);
+// One bit per subscriber index for each topic; read by every publish
+static std::atomic<uint8_t> topicSubscribers[EVENT_TYPE_COUNT];
+static SemaphoreHandle_t subscribeMutex = NULL;
+static EventBusStats busStats = {};
 
 /**
- * Initialize the global event queue for inter-task communication
+ * Initialize the event bus
  * 
- * Creates a FreeRTOS queue with EVENT_QUEUE_SIZE capacity for EventMessage structures.
- * Must be called during system initialization before any tasks are created.
+ * Creates the mutex that serializes subscriptions and fills the payload
+ * pool. Must be called during system initialization before any tasks are
+ * created.
  * 
- * @return true if queue created successfully, false on failure
+ * @return true if the bus is ready, false on failure
  */
-bool initEventQueue() {
-  eventQueue = xQueueCreate(EVENT_QUEUE_SIZE, sizeof(EventMessage));
-  return (eventQueue != NULL);
+bool initEventBus() {
+  if (!subscribeMutex) {
+    initPayloadPool();
+    subscribeMutex = xSemaphoreCreateMutex();
+  }
+  return subscribeMutex != NULL;
+}
+
+// Caller holds subscribeMutex
+static void applyTopics(uint8_t index, EventMask topics) {
+  subscribers[index].topics = topics;
+  for (int type = 0; type < EVENT_TYPE_COUNT; type++) {
+    uint8_t bit = (uint8_t)(1 << index);
+    if (topics & EVENT_BIT(type)) {
+      topicSubscribers[type].fetch_or(bit, std::memory_order_acq_rel);
+    } else {
+      topicSubscribers[type].fetch_and((uint8_t)~bit, std::memory_order_acq_rel);
+    }
+  }
 }
 
 /**
- * Send an event message to the global event queue
+ * Subscribe the calling task to a set of topics
  * 
- * Constructs an EventMessage and sends it to the queue with timeout protection.
- * Non-blocking operation that returns immediately if queue is full.
+ * Creates the subscriber's queue and adds it to the publish lists of its
+ * topics. Subscribers are never removed; setEventTopics() can pause one.
  * 
- * @param type Event type identifier from EventType enum
- * @param data Optional 32-bit data payload (default: 0)
- * @param ptr Optional pointer payload (default: nullptr)
- * @return true if event sent successfully, false if queue full or invalid
+ * @param name Name shown in the bus stats
+ * @param topics EVENT_BIT() of every event type to receive
+ * @param depth Queue length (default: EVENT_SUBSCRIBER_DEPTH)
+ * @return Subscriber handle, or NULL if the table is full or out of memory
  */
-bool sendEvent(EventType type, uint32_t data, void* ptr) {
-  if (!eventQueue) return false;
+EventSubscriber* subscribeEvents(const char* name, EventMask topics, uint8_t depth) {
+  if (!subscribeMutex || depth == 0) return NULL;
+  
+  EventSubscriber* subscriber = NULL;
+  xSemaphoreTake(subscribeMutex, portMAX_DELAY);
+  uint8_t index = subscriberCount.load(std::memory_order_relaxed);
+  if (index < EVENT_MAX_SUBSCRIBERS) {
+    QueueHandle_t queue = xQueueCreate(depth, sizeof(EventMessage));
+    if (queue) {
+      subscriber = &subscribers[index];
+      subscriber->name = name;
+      subscriber->queue = queue;
+      subscriber->depth = depth;
+      subscriberCount.store(index + 1, std::memory_order_release);
+      applyTopics(index, topics);
+    }
+  }
+  xSemaphoreGive(subscribeMutex);
+  return subscriber;
+}
+
+void setEventTopics(EventSubscriber* subscriber, EventMask topics) {
+  if (!subscriber || !subscribeMutex) return;
+  xSemaphoreTake(subscribeMutex, portMAX_DELAY);
+  applyTopics((uint8_t)(subscriber - subscribers), topics);
+  xSemaphoreGive(subscribeMutex);
+}
+
+// Queue one event for one subscriber. woken is NULL outside interrupts.
+static bool deliver(EventSubscriber& subscriber, const EventMessage& event, BaseType_t* woken) {
+  EventMask bit = EVENT_BIT(event.type);
+  bool coalesce = (EVENT_COALESCED & bit) != 0;
+  
+  // The data and payload are stored before the pending bit is tested, so
+  // a copy that is already queued, or one being received right now,
+  // carries them; the queued copy itself holds no payload reference
+  EventMessage queued = event;
+  retainPayload(event.payload);
+  if (coalesce) {
+    subscriber.latest[event.type].store(event.data, std::memory_order_relaxed);
+    releasePayload(subscriber.latestPayload[event.type].exchange(event.payload, std::memory_order_acq_rel));
+    if (subscriber.pending.fetch_or(bit, std::memory_order_acq_rel) & bit) {
+      subscriber.coalesced++;
+      return true;
+    }
+    queued.payload = EVENT_PAYLOAD_NONE;
+  }
+  
+  BaseType_t sent = woken ? xQueueSendFromISR(subscriber.queue, &queued, woken)
+                          : xQueueSend(subscriber.queue, &queued, 0);
+  if (sent != pdTRUE) {
+    if (coalesce) {
+      subscriber.pending.fetch_and(~bit, std::memory_order_acq_rel);
+      releasePayload(subscriber.latestPayload[event.type].exchange(EVENT_PAYLOAD_NONE, std::memory_order_acq_rel));
+    } else {
+      releasePayload(event.payload);
+    }
+    subscriber.dropped++;
+    return false;
+  }
+  
+  subscriber.queued++;
+  if (!woken) {
+    uint32_t depth = uxQueueMessagesWaiting(subscriber.queue);
+    if (depth > subscriber.highWater) subscriber.highWater = depth;
+  }
+  return true;
+}
+
+bool eventHasSubscribers(EventType type) {
+  return type < EVENT_TYPE_COUNT && topicSubscribers[type].load(std::memory_order_acquire) != 0;
+}
+
+static bool publish(EventType type, uint32_t data, EventPayload payload, BaseType_t* woken) {
+  busStats.published[type]++;
+  uint8_t targets = topicSubscribers[type].load(std::memory_order_acquire);
+  if (!targets) {
+    busStats.unheard++;
+    return true;
+  }
   
   EventMessage event = {
     .type = type,
     .data = data,
-    .ptr = ptr
+    .payload = payload
   };
   
-  return xQueueSend(eventQueue, &event, pdMS_TO_TICKS(EVENT_TIMEOUT_MS)) == pdTRUE;
+  bool delivered = true;
+  for (uint8_t i = 0; targets; i++, targets >>= 1) {
+    if ((targets & 1) && !deliver(subscribers[i], event, woken)) delivered = false;
+  }
+  return delivered;
 }
 
 /**
- * Receive an event message from the global event queue
+ * Publish an event to every subscriber of its topic
  * 
- * Blocks until an event is available or timeout expires.
- * Used by tasks to wait for inter-task communication events.
+ * Never blocks: a subscriber whose queue is full loses the event and its
+ * drop counter is incremented. Coalesced topics only update the data of a
+ * copy the subscriber has not received yet.
  * 
- * @param event Pointer to EventMessage structure to receive data
- * @param timeout Maximum time to wait (default: EVENT_TIMEOUT_MS)
- * @return true if event received, false on timeout or invalid parameters
+ * @param type Event type identifier from EventType enum
+ * @param data Optional 32-bit data payload (default: 0)
+ * @param payload Optional pool block (default: EVENT_PAYLOAD_NONE); the
+ *                caller keeps its reference and releases it afterwards
+ * @return true if every subscriber has the event queued, false if any dropped it
  */
-bool receiveEvent(EventMessage* event, TickType_t timeout) {
-  if (!eventQueue || !event) return false;
+bool publishEvent(EventType type, uint32_t data, EventPayload payload) {
+  if (type >= EVENT_TYPE_COUNT) return false;
   
-  return xQueueReceive(eventQueue, event, timeout) == pdTRUE;
+  uint32_t start = micros();
+  bool delivered = publish(type, data, payload, NULL);
+  uint32_t elapsed = micros() - start;
+  if (elapsed > busStats.maxPublishUs) busStats.maxPublishUs = elapsed;
+  return delivered;
 }
 
 /**
- * Send an event message from interrupt service routine context
+ * Publish an event from interrupt service routine context
  * 
- * ISR-safe version of sendEvent() that can be called from interrupt handlers.
- * Automatically yields to higher priority tasks if queue operation unblocks them.
+ * ISR-safe version of publishEvent(). Automatically yields to higher
+ * priority tasks if a queue operation unblocked one.
  * 
  * @param type Event type identifier from EventType enum
  * @param data Optional 32-bit data payload (default: 0)
- * @param ptr Optional pointer payload (default: nullptr)
- * @return true if event sent successfully, false if queue full or invalid
+ * @param payload Optional pool block (default: EVENT_PAYLOAD_NONE)
+ * @return true if every subscriber has the event queued, false if any dropped it
  */
-bool sendEventFromISR(EventType type, uint32_t data, void* ptr) {
-  if (!eventQueue) return false;
-  
-  EventMessage event = {
-    .type = type,
-    .data = data,
-    .ptr = ptr
-  };
+bool publishEventFromISR(EventType type, uint32_t data, EventPayload payload) {
+  if (type >= EVENT_TYPE_COUNT) return false;
   
   BaseType_t xHigherPriorityTaskWoken = pdFALSE;
-  BaseType_t result = xQueueSendFromISR(eventQueue, &event, &xHigherPriorityTaskWoken);
+  bool delivered = publish(type, data, payload, &xHigherPriorityTaskWoken);
   
   // Yield to higher priority task if queue operation unblocked one
   if (xHigherPriorityTaskWoken) {
     portYIELD_FROM_ISR();
   }
   
-  return result == pdTRUE;
-}
\ No newline at end of file
+  return delivered;
+}
+
+/**
+ * Receive the next event from a subscriber's queue
+ * 
+ * Blocks until an event is available or timeout expires. A coalesced
+ * event carries the data and payload of the latest publish of its topic.
+ * The caller owns the received payload and must release it.
+ * 
+ * @param subscriber Handle from subscribeEvents()
+ * @param event Pointer to EventMessage structure to receive data
+ * @param timeout Maximum time to wait
+ * @return true if event received, false on timeout or invalid parameters
+ */
+bool receiveEvent(EventSubscriber* subscriber, EventMessage* event, TickType_t timeout) {
+  if (!subscriber || !event) return false;
+  if (xQueueReceive(subscriber->queue, event, timeout) != pdTRUE) return false;
+  
+  EventMask bit = EVENT_BIT(event->type);
+  if (EVENT_COALESCED & bit) {
+    subscriber->pending.fetch_and(~bit, std::memory_order_acq_rel);
+    event->data = subscriber->latest[event->type].load(std::memory_order_relaxed);
+    event->payload = subscriber->latestPayload[event->type].exchange(EVENT_PAYLOAD_NONE, std::memory_order_acq_rel);
+  }
+  return true;
+}
+
+void getEventBusStats(EventBusStats* stats) {
+  if (!stats) return;
+  *stats = busStats;
+  stats->subscribers = subscriberCount.load(std::memory_order_acquire);
+}
+
+bool getEventSubscriberStats(uint8_t index, EventSubscriberStats* stats) {
+  if (!stats || index >= subscriberCount.load(std::memory_order_acquire)) return false;
+  const EventSubscriber& subscriber = subscribers[index];
+  stats->name = subscriber.name;
+  stats->topics = subscriber.topics;
+  stats->depth = subscriber.depth;
+  stats->queued = subscriber.queued;
+  stats->coalesced = subscriber.coalesced;
+  stats->dropped = subscriber.dropped;
+  stats->highWater = subscriber.highWater;
+  return true;
+}
+
+void printEventBusStats() {
+  EventBusStats stats;
+  getEventBusStats(&stats);
+  uint32_t total = 0;
+  for (int type = 0; type < EVENT_TYPE_COUNT; type++) total += stats.published[type];
+  Serial.printf("Event bus: %lu published, %lu with no subscriber, slowest publish %lu us\n",
+                (unsigned long)total, (unsigned long)stats.unheard, (unsigned long)stats.maxPublishUs);
+  
+  Serial.print(" ");
+  for (int type = 0; type < EVENT_TYPE_COUNT; type++) {
+    Serial.printf(" %s %lu", eventTypeName((EventType)type), (unsigned long)stats.published[type]);
+  }
+  Serial.println();
+  
+  EventSubscriberStats subscriber;
+  for (uint8_t i = 0; getEventSubscriberStats(i, &subscriber); i++) {
+    Serial.printf("  %-8s topics 0x%02lX, queued %lu, coalesced %lu, dropped %lu, high water %lu/%u\n",
+                  subscriber.name, (unsigned long)subscriber.topics, (unsigned long)subscriber.queued,
+                  (unsigned long)subscriber.coalesced, (unsigned long)subscriber.dropped,
+                  (unsigned long)subscriber.highWater, subscriber.depth);
+  }
+}
+
+const char* eventTypeName(EventType type) {
+  switch (type) {
+    case EVENT_SENSOR_DATA_READY:  return "data_ready";
+    case EVENT_DISTANCE_UPDATED:   return "distance";
+    case EVENT_LORA_SEND_REQUEST:  return "send_request";
+    case EVENT_LORA_SEND_COMPLETE: return "send_complete";
+    case EVENT_CONFIG_CHANGED:     return "config";
+    case EVENT_SYSTEM_ERROR:       return "error";
+    case EVENT_NOW_RX_READY:       return "now_rx";
+    case EVENT_HISTORY_REQUEST:    return "history";
+    default:                       return "?";
+  }
+}
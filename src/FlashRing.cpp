@@ -0,0 +1,217 @@
+/**
+ * FlashRing.cpp - Append-only page ring on a raw flash partition
+ * 
+ * Copyright (C) 2025 Michael Garcia, M&E Design
+ * Based on original .ino by Geoff Mcintyre of Mr.Industries (https://mr.industries/)
+ * 
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ * 
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU General Public License for more details.
+ * 
+ * You should have received a copy of the GNU General Public License
+ * along with this program. If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#include "FlashRing.h"
+#include "TelemetryFrame.h"
+#include <cstring>
+
+static_assert(FLASH_RING_SECTOR_SIZE % FLASH_RING_PAGE_SIZE == 0, "Pages must tile a sector");
+
+static void putU16(uint8_t* p, uint16_t v) {
+  p[0] = (uint8_t)v;
+  p[1] = (uint8_t)(v >> 8);
+}
+
+static void putU32(uint8_t* p, uint32_t v) {
+  putU16(p, (uint16_t)v);
+  putU16(p + 2, (uint16_t)(v >> 16));
+}
+
+static uint16_t getU16(const uint8_t* p) {
+  return (uint16_t)(p[0] | (p[1] << 8));
+}
+
+static uint32_t getU32(const uint8_t* p) {
+  return getU16(p) | ((uint32_t)getU16(p + 2) << 16);
+}
+
+// CRC over the header and payload with the crc field read as zero
+static uint16_t pageCrc(uint8_t* page, size_t used) {
+  uint16_t stored = getU16(&page[14]);
+  putU16(&page[14], 0);
+  uint16_t crc = telemetryCrc16(page, FLASH_RING_HEADER_SIZE + used);
+  putU16(&page[14], stored);
+  return crc;
+}
+
+static size_t pageOffset(uint32_t page) {
+  return (size_t)page * FLASH_RING_PAGE_SIZE;
+}
+
+// A page only needs its header checked: writes program it first
+bool flashRingBlank(FlashRing* ring, uint32_t page) {
+  uint8_t header[FLASH_RING_HEADER_SIZE];
+  if (esp_partition_read(ring->partition, pageOffset(page), header, sizeof(header)) != ESP_OK) {
+    return false;
+  }
+  for (size_t i = 0; i < sizeof(header); i++) {
+    if (header[i] != 0xFF) return false;
+  }
+  return true;
+}
+
+FlashPageState flashRingRead(FlashRing* ring, uint32_t page, uint8_t* buffer, FlashPageHeader* header) {
+  if (!ring->partition || page >= ring->pageCount ||
+      esp_partition_read(ring->partition, pageOffset(page), buffer, FLASH_RING_PAGE_SIZE) != ESP_OK) {
+    return FLASH_PAGE_CORRUPT;
+  }
+  
+  bool blank = true;
+  for (size_t i = 0; i < FLASH_RING_PAGE_SIZE && blank; i++) {
+    blank = buffer[i] == 0xFF;
+  }
+  if (blank) return FLASH_PAGE_BLANK;
+  
+  header->flags = buffer[3];
+  header->sequence = getU32(&buffer[4]);
+  header->eraseCount = getU32(&buffer[8]);
+  header->used = getU16(&buffer[12]);
+  if (getU16(&buffer[0]) != ring->magic || buffer[2] != FLASH_PAGE_VERSION ||
+      header->used > FLASH_RING_PAYLOAD_SIZE || pageCrc(buffer, header->used) != getU16(&buffer[14])) {
+    return FLASH_PAGE_CORRUPT;
+  }
+  return FLASH_PAGE_VALID;
+}
+
+bool flashRingMount(FlashRing* ring, const char* label, uint8_t subtype, uint16_t magic,
+                    FlashPageVisitor visit, void* context) {
+  const esp_partition_t* found = esp_partition_find_first(
+      ESP_PARTITION_TYPE_DATA, (esp_partition_subtype_t)subtype, label);
+  if (!found || found->size < FLASH_RING_SECTOR_SIZE * 2) {
+    return false;
+  }
+  
+  uint32_t sectors = found->size / FLASH_RING_SECTOR_SIZE;
+  if (sectors > FLASH_RING_MAX_SECTORS) sectors = FLASH_RING_MAX_SECTORS;
+  
+  memset(&ring->stats, 0, sizeof(ring->stats));
+  memset(ring->sectorEraseCount, 0, sizeof(ring->sectorEraseCount));
+  ring->partition = found;
+  ring->magic = magic;
+  ring->pageCount = sectors * FLASH_RING_PAGES_PER_SECTOR;
+  
+  // Recovery scan: resume after the newest valid page
+  uint8_t buffer[FLASH_RING_PAGE_SIZE];
+  unsigned long start = millis();
+  bool any = false;
+  uint32_t newest = 0;
+  uint32_t newestPage = 0;
+  for (uint32_t page = 0; page < ring->pageCount; page++) {
+    FlashPageHeader header;
+    FlashPageState state = flashRingRead(ring, page, buffer, &header);
+    if (state == FLASH_PAGE_CORRUPT) {
+      ring->stats.corruptPages++;
+    }
+    if (state != FLASH_PAGE_VALID) continue;
+    
+    ring->stats.recoveredPages++;
+    if (!any || header.sequence > newest) {
+      newest = header.sequence;
+      newestPage = page;
+      any = true;
+    }
+    uint32_t sector = page / FLASH_RING_PAGES_PER_SECTOR;
+    if (header.eraseCount > ring->sectorEraseCount[sector]) {
+      ring->sectorEraseCount[sector] = header.eraseCount;
+    }
+    if (visit) {
+      visit(page, &header, buffer, context);
+    }
+  }
+  
+  ring->headPage = any ? flashRingNext(ring, newestPage) : 0;
+  ring->nextSequence = any ? newest + 1 : 1;
+  ring->stats.recoveryMs = millis() - start;
+  return true;
+}
+
+bool flashRingAppend(FlashRing* ring, uint8_t flags, uint8_t* page, size_t used, uint32_t* pageOut) {
+  if (!ring->partition || used > FLASH_RING_PAYLOAD_SIZE) return false;
+  
+  for (uint32_t attempt = 0; attempt < ring->pageCount; attempt++) {
+    uint32_t target = ring->headPage;
+    uint32_t sector = target / FLASH_RING_PAGES_PER_SECTOR;
+    ring->headPage = flashRingNext(ring, target);
+    
+    if (target % FLASH_RING_PAGES_PER_SECTOR == 0) {
+      if (ring->beforeErase) {
+        ring->beforeErase(ring, target, ring->context);
+      }
+      ring->sectorEraseCount[sector]++;
+      ring->stats.sectorErases++;
+      if (esp_partition_erase_range(ring->partition, sector * FLASH_RING_SECTOR_SIZE,
+                                    FLASH_RING_SECTOR_SIZE) != ESP_OK) {
+        ring->stats.writeErrors++;
+        return false;
+      }
+    } else if (!flashRingBlank(ring, target)) {
+      ring->stats.skippedPages++;
+      continue;
+    }
+    
+    putU16(&page[0], ring->magic);
+    page[2] = FLASH_PAGE_VERSION;
+    page[3] = flags;
+    putU32(&page[4], ring->nextSequence);
+    putU32(&page[8], ring->sectorEraseCount[sector]);
+    putU16(&page[12], (uint16_t)used);
+    putU16(&page[14], pageCrc(page, used));
+    
+    if (esp_partition_write(ring->partition, pageOffset(target), page, FLASH_RING_PAGE_SIZE) != ESP_OK) {
+      ring->stats.writeErrors++;
+      return false;
+    }
+    
+    ring->nextSequence++;
+    ring->stats.pagesWritten++;
+    if (pageOut) *pageOut = target;
+    return true;
+  }
+  return false;
+}
+
+bool flashRingProgram(FlashRing* ring, uint32_t page, size_t offset, const void* data, size_t length) {
+  if (!ring->partition || page >= ring->pageCount || offset + length > FLASH_RING_PAGE_SIZE) return false;
+  if (esp_partition_write(ring->partition, pageOffset(page) + offset, data, length) != ESP_OK) {
+    ring->stats.writeErrors++;
+    return false;
+  }
+  return true;
+}
+
+uint32_t flashRingNext(const FlashRing* ring, uint32_t page) {
+  return page + 1 < ring->pageCount ? page + 1 : 0;
+}
+
+uint32_t flashRingPrevious(const FlashRing* ring, uint32_t page) {
+  return page > 0 ? page - 1 : ring->pageCount - 1;
+}
+
+void flashRingEraseCounts(const FlashRing* ring, uint32_t* minCount, uint32_t* maxCount) {
+  uint32_t sectors = ring->pageCount / FLASH_RING_PAGES_PER_SECTOR;
+  uint32_t lo = sectors ? ring->sectorEraseCount[0] : 0;
+  uint32_t hi = 0;
+  for (uint32_t s = 0; s < sectors; s++) {
+    if (ring->sectorEraseCount[s] < lo) lo = ring->sectorEraseCount[s];
+    if (ring->sectorEraseCount[s] > hi) hi = ring->sectorEraseCount[s];
+  }
+  if (minCount) *minCount = lo;
+  if (maxCount) *maxCount = hi;
+}
@@ -19,16 +19,15 @@
  */
 
 #include "GlobalContext.h"
+#include "LoRaLink.h"
 
 static GlobalContext g_context = {
-  .sensors = {0, 0.0, 0, 0.0, 0, 0, 0},
+  .sensors = {0, 0, 0, 0, 0, 0},
   .loraActive = false,
-  .nowSerial = nullptr,
+  .loraFrameFormat = LORA_DEFAULT_FRAME_FORMAT,
+  .loraBatchSamples = LORA_DEFAULT_BATCH_SAMPLES,
+  .loraBatchLatencyMs = LORA_DEFAULT_BATCH_LATENCY_MS,
   .nowSerialActive = false,
-  .peerMacAddress = {0},
-  .macAddressSet = false,
-  .receivedMessageBuffer = {0},
-  .receivedMessageLen = 0,
   .currentTime = 0
 };
 
@@ -37,11 +36,11 @@ GlobalContext& getGlobalContext() {
 }
 
 void initializeGlobalContext() {
-  g_context.sensors = {0, 0.0, 0, 0.0, 0, 0, 0};
+  g_context.sensors = {0, 0, 0, 0, 0, 0};
   g_context.loraActive = false;
-  g_context.nowSerial = nullptr;
+  g_context.loraFrameFormat = LORA_DEFAULT_FRAME_FORMAT;
+  g_context.loraBatchSamples = LORA_DEFAULT_BATCH_SAMPLES;
+  g_context.loraBatchLatencyMs = LORA_DEFAULT_BATCH_LATENCY_MS;
   g_context.nowSerialActive = false;
-  g_context.macAddressSet = false;
-  g_context.receivedMessageLen = 0;
   g_context.currentTime = 0;
 }
\ No newline at end of file
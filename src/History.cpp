@@ -0,0 +1,427 @@
+/**
+ * History.cpp - In-RAM sensor time series with rolled-up tiers
+ * 
+ * Copyright (C) 2025 Michael Garcia, M&E Design
+ * Based on original .ino by Geoff Mcintyre of Mr.Industries (https://mr.industries/)
+ * 
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ * 
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU General Public License for more details.
+ * 
+ * You should have received a copy of the GNU General Public License
+ * along with this program. If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#include "History.h"
+#include "SensorDataAccess.h"
+#include "freertos/FreeRTOS.h"
+#include "freertos/semphr.h"
+#include <cstring>
+
+#define HISTORY_MUTEX_TIMEOUT_MS 50
+
+static const uint8_t channelFlags[HISTORY_CHANNEL_COUNT] = {
+  TELEMETRY_FLAG_TEMPERATURE, TELEMETRY_FLAG_HUMIDITY, TELEMETRY_FLAG_LUX, TELEMETRY_FLAG_DISTANCE,
+};
+
+static uint16_t sampleField(const SensorSample& sample, int channel) {
+  switch (channel) {
+    case HISTORY_TEMPERATURE: return (uint16_t)sample.temperatureCenti;
+    case HISTORY_HUMIDITY:    return sample.humidityCenti;
+    case HISTORY_LUX:         return sample.lux;
+    default:                  return sample.distanceCenti;
+  }
+}
+
+// Stored fields back to their value; only temperature is signed
+static int32_t fieldValue(uint16_t field, int channel) {
+  return channel == HISTORY_TEMPERATURE ? (int32_t)(int16_t)field : (int32_t)field;
+}
+
+// Rounded to nearest, halves away from zero
+static int32_t roundedMean(int32_t sum, uint32_t count) {
+  int32_t half = (int32_t)(count / 2);
+  return (sum >= 0 ? sum + half : sum - half) / (int32_t)count;
+}
+
+// -----------------------------------------------------------------------------
+// Rolled-up tiers
+// -----------------------------------------------------------------------------
+
+static void closeBucket(HistoryTierRing* tier) {
+  HistoryAccumulator& acc = tier->open;
+  size_t slot;
+  if (tier->count < tier->capacity) {
+    slot = (tier->head + tier->count) % tier->capacity;
+    tier->count++;
+  } else {
+    slot = tier->head;
+    tier->head = (tier->head + 1) % tier->capacity;
+  }
+  
+  HistoryBucket& bucket = tier->buckets[slot];
+  bucket.startMs = acc.startMs;
+  for (int c = 0; c < HISTORY_CHANNEL_COUNT; c++) {
+    HistoryStat& stat = bucket.stats[c];
+    stat.count = acc.count[c];
+    stat.min = (uint16_t)acc.min[c];
+    stat.max = (uint16_t)acc.max[c];
+    stat.mean = acc.count[c] ? (uint16_t)roundedMean(acc.sum[c], acc.count[c]) : 0;
+  }
+  acc.open = false;
+}
+
+static void accumulate(HistoryTierRing* tier, const SensorSample& sample) {
+  HistoryAccumulator& acc = tier->open;
+  uint32_t start = sample.timestamp - sample.timestamp % tier->intervalMs;
+  if (acc.open && start != acc.startMs) closeBucket(tier);
+  if (!acc.open) {
+    memset(&acc, 0, sizeof(acc));
+    acc.open = true;
+    acc.startMs = start;
+  }
+  
+  for (int c = 0; c < HISTORY_CHANNEL_COUNT; c++) {
+    if (!(sample.flags & channelFlags[c])) continue;
+    int32_t value = fieldValue(sampleField(sample, c), c);
+    if (acc.count[c] == 0 || value < acc.min[c]) acc.min[c] = value;
+    if (acc.count[c] == 0 || value > acc.max[c]) acc.max[c] = value;
+    acc.sum[c] += value;
+    acc.count[c]++;
+  }
+}
+
+// -----------------------------------------------------------------------------
+// Store
+// -----------------------------------------------------------------------------
+
+void historyInit(HistoryStore* store) {
+  if (!store) return;
+  memset(store, 0, sizeof(*store));
+  store->tiers[HISTORY_MINUTE].buckets = store->minuteBuckets;
+  store->tiers[HISTORY_MINUTE].capacity = HISTORY_MINUTE_CAPACITY;
+  store->tiers[HISTORY_MINUTE].intervalMs = HISTORY_MINUTE_MS;
+  store->tiers[HISTORY_QUARTER].buckets = store->quarterBuckets;
+  store->tiers[HISTORY_QUARTER].capacity = HISTORY_QUARTER_CAPACITY;
+  store->tiers[HISTORY_QUARTER].intervalMs = HISTORY_QUARTER_MS;
+}
+
+void historyAppend(HistoryStore* store, const SensorSample& sample) {
+  if (!store) return;
+  
+  size_t slot;
+  if (store->rawCount < HISTORY_RAW_CAPACITY) {
+    slot = (store->rawHead + store->rawCount) % HISTORY_RAW_CAPACITY;
+    store->rawCount++;
+  } else {
+    slot = store->rawHead;
+    store->rawHead = (store->rawHead + 1) % HISTORY_RAW_CAPACITY;
+  }
+  store->rawTime[slot] = sample.timestamp;
+  for (int c = 0; c < HISTORY_CHANNEL_COUNT; c++) {
+    store->rawValue[slot][c] = sampleField(sample, c);
+  }
+  store->rawFlags[slot] = sample.flags;
+  
+  accumulate(&store->tiers[HISTORY_MINUTE], sample);
+  accumulate(&store->tiers[HISTORY_QUARTER], sample);
+  store->appended++;
+}
+
+size_t historyDepth(const HistoryStore* store, HistoryTier tier) {
+  if (!store || tier >= HISTORY_TIER_COUNT) return 0;
+  if (tier == HISTORY_RAW) return store->rawCount;
+  const HistoryTierRing& ring = store->tiers[tier];
+  return ring.count + (ring.open.open ? 1 : 0);
+}
+
+// Times are compared as signed differences so the search survives the
+// 49-day millis() wrap as long as the history spans less than half of it
+static bool notBefore(uint32_t time, uint32_t reference) {
+  return (int32_t)(time - reference) >= 0;
+}
+
+typedef bool (*HistoryVisitor)(const HistoryPoint& point, void* context);
+
+static uint32_t entryTime(const HistoryStore* store, HistoryTier tier, size_t index) {
+  if (tier == HISTORY_RAW) {
+    return store->rawTime[(store->rawHead + index) % HISTORY_RAW_CAPACITY];
+  }
+  const HistoryTierRing& ring = store->tiers[tier];
+  return ring.buckets[(ring.head + index) % ring.capacity].startMs;
+}
+
+// Visits the points in [fromMs, toMs] oldest first: binary search for the
+// first entry, then a walk that stops at toMs or when the visitor says so
+static void visitRange(const HistoryStore* store, HistoryTier tier, HistoryChannel channel,
+                       uint32_t fromMs, uint32_t toMs, HistoryVisitor visit, void* context) {
+  size_t count = tier == HISTORY_RAW ? store->rawCount : store->tiers[tier].count;
+  size_t low = 0, high = count;
+  while (low < high) {
+    size_t mid = (low + high) / 2;
+    if (notBefore(entryTime(store, tier, mid), fromMs)) {
+      high = mid;
+    } else {
+      low = mid + 1;
+    }
+  }
+  
+  HistoryPoint point;
+  for (size_t i = low; i < count; i++) {
+    if (tier == HISTORY_RAW) {
+      size_t slot = (store->rawHead + i) % HISTORY_RAW_CAPACITY;
+      point.timeMs = store->rawTime[slot];
+      if (!notBefore(toMs, point.timeMs)) return;
+      if (!(store->rawFlags[slot] & channelFlags[channel])) continue;
+      point.min = point.max = point.mean = fieldValue(store->rawValue[slot][channel], channel);
+      point.count = 1;
+    } else {
+      const HistoryTierRing& ring = store->tiers[tier];
+      const HistoryBucket& bucket = ring.buckets[(ring.head + i) % ring.capacity];
+      const HistoryStat& stat = bucket.stats[channel];
+      point.timeMs = bucket.startMs;
+      if (!notBefore(toMs, point.timeMs)) return;
+      if (stat.count == 0) continue;
+      point.min = fieldValue(stat.min, channel);
+      point.max = fieldValue(stat.max, channel);
+      point.mean = fieldValue(stat.mean, channel);
+      point.count = stat.count;
+    }
+    if (!visit(point, context)) return;
+  }
+  
+  // The open bucket is the newest, partial, point of its tier
+  if (tier != HISTORY_RAW) {
+    const HistoryAccumulator& acc = store->tiers[tier].open;
+    if (!acc.open || acc.count[channel] == 0) return;
+    if (!notBefore(acc.startMs, fromMs) || !notBefore(toMs, acc.startMs)) return;
+    point.timeMs = acc.startMs;
+    point.min = acc.min[channel];
+    point.max = acc.max[channel];
+    point.mean = roundedMean(acc.sum[channel], acc.count[channel]);
+    point.count = acc.count[channel];
+    visit(point, context);
+  }
+}
+
+struct QueryContext {
+  HistoryPoint* out;
+  size_t maxPoints;
+  size_t written;
+};
+
+static bool collectPoint(const HistoryPoint& point, void* context) {
+  QueryContext* query = (QueryContext*)context;
+  query->out[query->written++] = point;
+  return query->written < query->maxPoints;
+}
+
+size_t historyQuery(const HistoryStore* store, HistoryTier tier, HistoryChannel channel,
+                    uint32_t fromMs, uint32_t toMs, HistoryPoint* out, size_t maxPoints) {
+  if (!store || !out || maxPoints == 0 || tier >= HISTORY_TIER_COUNT ||
+      channel >= HISTORY_CHANNEL_COUNT) {
+    return 0;
+  }
+  QueryContext query = {out, maxPoints, 0};
+  visitRange(store, tier, channel, fromMs, toMs, collectPoint, &query);
+  return query.written;
+}
+
+struct SummaryContext {
+  HistoryPoint summary;
+  int64_t weightedSum;
+  uint32_t samples;
+};
+
+static bool summarizePoint(const HistoryPoint& point, void* context) {
+  SummaryContext* summary = (SummaryContext*)context;
+  HistoryPoint& total = summary->summary;
+  if (total.count == 0) {
+    total.timeMs = point.timeMs;
+    total.min = point.min;
+    total.max = point.max;
+  } else {
+    if (point.min < total.min) total.min = point.min;
+    if (point.max > total.max) total.max = point.max;
+  }
+  total.count++;
+  summary->weightedSum += (int64_t)point.mean * point.count;
+  summary->samples += point.count;
+  return true;
+}
+
+bool historySummary(const HistoryStore* store, HistoryTier tier, HistoryChannel channel,
+                    uint32_t fromMs, uint32_t toMs, HistoryPoint* out) {
+  if (!store || !out || tier >= HISTORY_TIER_COUNT || channel >= HISTORY_CHANNEL_COUNT) {
+    return false;
+  }
+  SummaryContext summary = {};
+  visitRange(store, tier, channel, fromMs, toMs, summarizePoint, &summary);
+  if (summary.samples == 0) return false;
+  
+  // count is the number of points; the mean is weighted by their samples
+  *out = summary.summary;
+  int64_t half = summary.samples / 2;
+  int64_t sum = summary.weightedSum;
+  out->mean = (int32_t)((sum >= 0 ? sum + half : sum - half) / (int64_t)summary.samples);
+  return true;
+}
+
+// -----------------------------------------------------------------------------
+// Shared store
+// -----------------------------------------------------------------------------
+
+static HistoryStore history;
+static SemaphoreHandle_t historyMutex = NULL;
+
+static bool lockHistory() {
+  return historyMutex && xSemaphoreTake(historyMutex, pdMS_TO_TICKS(HISTORY_MUTEX_TIMEOUT_MS));
+}
+
+static void unlockHistory() {
+  xSemaphoreGive(historyMutex);
+}
+
+bool initHistory() {
+  if (!historyMutex) {
+    historyMutex = xSemaphoreCreateMutex();
+    if (!historyMutex) return false;
+  }
+  historyInit(&history);
+  return true;
+}
+
+void captureHistorySample(uint8_t channels) {
+  SensorData data;
+  readSensorSnapshot(&data);
+  // The other fields are older readings, already in the history
+  data.flags &= channels;
+  if (data.flags == 0) return;
+  
+  // The snapshot is timed by the last sensor pass; a distance alone is
+  // timed on arrival, but never before the newest raw sample so the ring
+  // stays in time order
+  bool distanceOnly = data.flags == TELEMETRY_FLAG_DISTANCE;
+  uint32_t now = millis();
+  if (!lockHistory()) return;
+  if (distanceOnly) {
+    data.timestamp = now;
+    if (history.rawCount > 0) {
+      uint32_t newest = history.rawTime[(history.rawHead + history.rawCount - 1) % HISTORY_RAW_CAPACITY];
+      if (!notBefore(data.timestamp, newest)) data.timestamp = newest;
+    }
+  }
+  historyAppend(&history, data);
+  unlockHistory();
+}
+
+size_t queryHistory(HistoryTier tier, HistoryChannel channel, uint32_t fromMs, uint32_t toMs,
+                    HistoryPoint* out, size_t maxPoints) {
+  if (!lockHistory()) return 0;
+  size_t count = historyQuery(&history, tier, channel, fromMs, toMs, out, maxPoints);
+  unlockHistory();
+  return count;
+}
+
+bool summarizeHistory(HistoryTier tier, HistoryChannel channel, uint32_t fromMs, uint32_t toMs,
+                      HistoryPoint* out) {
+  if (!lockHistory()) return false;
+  bool ok = historySummary(&history, tier, channel, fromMs, toMs, out);
+  unlockHistory();
+  return ok;
+}
+
+void printHistoryStats() {
+  size_t depth[HISTORY_TIER_COUNT];
+  uint32_t oldest[HISTORY_TIER_COUNT];
+  uint32_t appended;
+  if (!lockHistory()) {
+    Serial.println("History: busy");
+    return;
+  }
+  for (int t = 0; t < HISTORY_TIER_COUNT; t++) {
+    depth[t] = historyDepth(&history, (HistoryTier)t);
+    size_t closed = t == HISTORY_RAW ? history.rawCount : history.tiers[t].count;
+    oldest[t] = closed > 0 ? entryTime(&history, (HistoryTier)t, 0)
+                           : history.tiers[t].open.startMs;
+  }
+  appended = history.appended;
+  unlockHistory();
+  
+  static const size_t capacity[HISTORY_TIER_COUNT] = {
+    HISTORY_RAW_CAPACITY, HISTORY_MINUTE_CAPACITY + 1, HISTORY_QUARTER_CAPACITY + 1,
+  };
+  Serial.printf("History: %lu samples appended, %u bytes of RAM\n", (unsigned long)appended,
+                (unsigned)HISTORY_MEMORY_BYTES);
+  unsigned long now = millis();
+  for (int t = 0; t < HISTORY_TIER_COUNT; t++) {
+    Serial.printf("  %-4s %4u/%-4u points", historyTierName((HistoryTier)t), (unsigned)depth[t],
+                  (unsigned)capacity[t]);
+    if (depth[t] > 0) {
+      Serial.printf(", oldest %lu s ago", (now - oldest[t]) / 1000);
+    }
+    Serial.println();
+  }
+}
+
+// -----------------------------------------------------------------------------
+// Names and units
+// -----------------------------------------------------------------------------
+
+static const char* const tierNames[HISTORY_TIER_COUNT] = {"raw", "1m", "15m"};
+static const char* const channelNames[HISTORY_CHANNEL_COUNT] = {"temp", "hum", "lux", "dist"};
+static const char* const channelUnits[HISTORY_CHANNEL_COUNT] = {" C", " %", " lx", " in"};
+
+const char* historyTierName(HistoryTier tier) {
+  return tier < HISTORY_TIER_COUNT ? tierNames[tier] : "?";
+}
+
+const char* historyChannelName(HistoryChannel channel) {
+  return channel < HISTORY_CHANNEL_COUNT ? channelNames[channel] : "?";
+}
+
+bool parseHistoryTier(const char* name, HistoryTier* tier) {
+  for (int t = 0; name && t < HISTORY_TIER_COUNT; t++) {
+    if (strcmp(name, tierNames[t]) == 0) {
+      *tier = (HistoryTier)t;
+      return true;
+    }
+  }
+  return false;
+}
+
+bool parseHistoryChannel(const char* name, HistoryChannel* channel) {
+  for (int c = 0; name && c < HISTORY_CHANNEL_COUNT; c++) {
+    if (strcmp(name, channelNames[c]) == 0) {
+      *channel = (HistoryChannel)c;
+      return true;
+    }
+  }
+  return false;
+}
+
+uint32_t historyTierIntervalMs(HistoryTier tier) {
+  if (tier == HISTORY_MINUTE) return HISTORY_MINUTE_MS;
+  if (tier == HISTORY_QUARTER) return HISTORY_QUARTER_MS;
+  return 1000;
+}
+
+uint8_t historyChannelFlag(HistoryChannel channel) {
+  return channel < HISTORY_CHANNEL_COUNT ? channelFlags[channel] : 0;
+}
+
+void printHistoryValue(HistoryChannel channel, int32_t value) {
+  if (channel == HISTORY_LUX) {
+    Serial.printf("%ld%s", (long)value, channelUnits[channel]);
+    return;
+  }
+  uint32_t magnitude = value < 0 ? (uint32_t)-value : (uint32_t)value;
+  Serial.printf("%s%lu.%02lu%s", value < 0 ? "-" : "", (unsigned long)(magnitude / 100),
+                (unsigned long)(magnitude % 100), channelUnits[channel]);
+}
@@ -0,0 +1,171 @@
+/**
+ * Htu21dfDriver.cpp - HTU21D-F temperature/humidity driver
+ * 
+ * Copyright (C) 2025 Michael Garcia, M&E Design
+ * Based on original .ino by Geoff Mcintyre of Mr.Industries (https://mr.industries/)
+ * 
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ * 
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU General Public License for more details.
+ * 
+ * You should have received a copy of the GNU General Public License
+ * along with this program. If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#include "Htu21dfDriver.h"
+#include "I2cBus.h"
+#include "Logger.h"
+
+static Adafruit_HTU21DF htu = Adafruit_HTU21DF();
+static bool htuPresent = false;
+
+typedef enum {
+  HTU_IDLE = 0,
+  HTU_CONVERTING,                // Trigger queued or done
+  HTU_FETCHING                   // Result read queued
+} HtuState;
+
+// Conversion state belongs to SensorTask. pending holds the channels still
+// to convert; current is the one in progress.
+static HtuState state = HTU_IDLE;
+static uint8_t pending = 0;
+static uint8_t current = 0;
+static unsigned long conversionStartMs = 0;
+static uint32_t conversionMs = 0;
+static uint8_t attempts = 0;
+
+static uint8_t valid = 0;
+static uint16_t temperatureRaw = 0;
+static uint16_t humidityRaw = 0;
+
+static I2cTransaction trigger;
+static I2cTransaction fetch;
+
+static void onTransactionDone(I2cTransaction*) {
+  sensorDriverNotify();
+}
+
+static uint8_t htuCrc8(const uint8_t* data, size_t length) {
+  uint8_t crc = 0;
+  while (length--) {
+    crc ^= *data++;
+    for (int bit = 0; bit < 8; bit++) {
+      crc = (crc & 0x80) ? (uint8_t)((crc << 1) ^ 0x31) : (uint8_t)(crc << 1);
+    }
+  }
+  return crc;
+}
+
+// HTU21D-F datasheet conversions in integer math, rounded to 0.01 units:
+// T = -46.85 + 175.72 * code / 2^16, RH = -6 + 125 * code / 2^16
+static int32_t htuTemperatureCenti(uint16_t raw) {
+  return (int32_t)(((uint32_t)raw * 17572 + 32768) >> 16) - 4685;
+}
+
+static int32_t htuHumidityCenti(uint16_t raw) {
+  return (int32_t)(((uint32_t)raw * 12500 + 32768) >> 16) - 600;
+}
+
+// Queue the trigger for the next pending conversion, temperature first.
+// The conversion is timed from the submit; if the result is fetched a
+// little early the device NACKs and the fetch is retried.
+static void triggerNext() {
+  state = HTU_IDLE;
+  while (pending && state == HTU_IDLE) {
+    bool temperature = pending & TELEMETRY_FLAG_TEMPERATURE;
+    current = temperature ? TELEMETRY_FLAG_TEMPERATURE : TELEMETRY_FLAG_HUMIDITY;
+    pending &= (uint8_t)~current;
+    trigger.writeData[0] = temperature ? HTU21DF_TRIGGER_TEMP_NOHOLD : HTU21DF_TRIGGER_HUM_NOHOLD;
+    if (i2cSubmit(&trigger)) {
+      conversionStartMs = millis();
+      conversionMs = temperature ? HTU21DF_TEMP_CONVERSION_MS : HTU21DF_HUM_CONVERSION_MS;
+      attempts = 0;
+      state = HTU_CONVERTING;
+    }
+  }
+}
+
+bool Htu21dfDriver::probe() {
+  // Only the fetch wakes the acquisition pass; the trigger is checked when
+  // the conversion time is up
+  trigger.address = HTU21DF_I2CADDR;
+  trigger.writeLength = 1;
+  fetch.address = HTU21DF_I2CADDR;
+  fetch.readLength = 3;
+  fetch.done = onTransactionDone;
+  
+  if (i2cBusLock()) {
+    htuPresent = htu.begin();
+    i2cBusUnlock();
+  }
+  if (!htuPresent) {
+    logWarn("HTU21D-F temp/humidity sensor not detected - readings will be zero");
+    return false;
+  }
+  logInfo("HTU21D-F temperature/humidity sensor initialized successfully");
+  return true;
+}
+
+void Htu21dfDriver::start(uint8_t channels) {
+  valid = 0;
+  pending = htuPresent ? (uint8_t)(channels & CHANNELS) : 0;
+  triggerNext();
+}
+
+uint32_t Htu21dfDriver::poll() {
+  while (state != HTU_IDLE) {
+    if (state == HTU_CONVERTING) {
+      unsigned long elapsed = millis() - conversionStartMs;
+      if (elapsed < conversionMs) return conversionMs - elapsed;
+      
+      I2cStatus status = i2cStatus(trigger);
+      if (status == I2C_PENDING) return SENSOR_POLL_BUS_MS;
+      if (status != I2C_DONE || !i2cSubmit(&fetch)) {
+        // Trigger not acknowledged, or the queue is full: drop the channel
+        triggerNext();
+        continue;
+      }
+      state = HTU_FETCHING;
+    }
+    
+    // No-hold-master read: the address is NACKed until the result is ready
+    I2cStatus status = i2cStatus(fetch);
+    if (status == I2C_PENDING) return SENSOR_POLL_BUS_MS;
+    if (status != I2C_DONE) {
+      if (++attempts < HTU21DF_POLL_ATTEMPTS) {
+        conversionStartMs = millis();
+        conversionMs = HTU21DF_POLL_INTERVAL_MS;
+        state = HTU_CONVERTING;
+        continue;
+      }
+    } else if (htuCrc8(fetch.readData, 2) == fetch.readData[2]) {
+      uint16_t raw = (uint16_t)((fetch.readData[0] << 8) | fetch.readData[1]) & 0xFFFC;
+      if (current == TELEMETRY_FLAG_TEMPERATURE) {
+        temperatureRaw = raw;
+      } else {
+        humidityRaw = raw;
+      }
+      valid |= current;
+    }
+    triggerNext();
+  }
+  return SENSOR_POLL_DONE;
+}
+
+void Htu21dfDriver::read(SensorSample* sample) {
+  if (valid & TELEMETRY_FLAG_TEMPERATURE) {
+    int32_t centi = htuTemperatureCenti(temperatureRaw);
+    if (centi >= -4000 && centi <= 8500) setSensorChannelValue(sample, SENSOR_CHANNEL_TEMPERATURE, centi);
+  }
+  if (valid & TELEMETRY_FLAG_HUMIDITY) {
+    int32_t centi = htuHumidityCenti(humidityRaw);
+    if (centi >= 0 && centi <= 10000) setSensorChannelValue(sample, SENSOR_CHANNEL_HUMIDITY, centi);
+  }
+  valid = 0;
+}
@@ -0,0 +1,208 @@
+/**
+ * I2cBus.cpp - I2C bus manager with an asynchronous transaction queue
+ * 
+ * Copyright (C) 2025 Michael Garcia, M&E Design
+ * Based on original .ino by Geoff Mcintyre of Mr.Industries (https://mr.industries/)
+ * 
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ * 
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU General Public License for more details.
+ * 
+ * You should have received a copy of the GNU General Public License
+ * along with this program. If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#include "I2cBus.h"
+#include "pins.h"
+#include "Logger.h"
+#include "PowerManager.h"
+#include "freertos/queue.h"
+#include "freertos/semphr.h"
+#include "freertos/task.h"
+#include <cstring>
+
+#define I2C_SCAN_FIRST 0x08            // 0x00-0x07 and 0x78-0x7F are reserved
+#define I2C_SCAN_LAST  0x77
+
+static QueueHandle_t i2cQueue = NULL;
+static SemaphoreHandle_t busMutex = NULL;
+static TaskHandle_t i2cTaskHandle = NULL;
+static I2cBusStats busStats = {};
+static uint32_t foundMap[4] = {};      // One bit per 7-bit address
+
+struct KnownDevice {
+  uint8_t address;
+  const char* name;
+};
+
+static const KnownDevice knownDevices[] = {
+  {0x29, "TSL2561 (ADDR low)"},
+  {0x39, "TSL2561"},
+  {0x40, "HTU21D-F"},
+  {0x49, "TSL2561 (ADDR high)"},
+};
+
+static const char* knownDeviceName(uint8_t address) {
+  for (size_t i = 0; i < sizeof(knownDevices) / sizeof(knownDevices[0]); i++) {
+    if (knownDevices[i].address == address) return knownDevices[i].name;
+  }
+  return "unknown";
+}
+
+static I2cStatus runTransaction(I2cTransaction* transaction) {
+  if (transaction->writeLength) {
+    Wire.beginTransmission(transaction->address);
+    Wire.write(transaction->writeData, transaction->writeLength);
+    if (Wire.endTransmission() != 0) return I2C_NACK;
+  }
+  if (transaction->readLength) {
+    uint8_t received = Wire.requestFrom(transaction->address, transaction->readLength);
+    for (uint8_t i = 0; i < received; i++) {
+      transaction->readData[i] = (uint8_t)Wire.read();
+    }
+    if (received != transaction->readLength) return I2C_NACK;
+  }
+  return I2C_DONE;
+}
+
+// Drains the queue in one bus hold, so transactions submitted together run
+// back to back. The power lock keeps the I2C clock steady for the burst.
+static void i2cTask(void* parameter) {
+  I2cTransaction* transaction;
+  while (true) {
+    if (xQueueReceive(i2cQueue, &transaction, portMAX_DELAY) != pdTRUE) continue;
+    
+    xSemaphoreTake(busMutex, portMAX_DELAY);
+    powerLockAcquire(POWER_LOCK_I2C);
+    do {
+      uint32_t start = micros();
+      I2cStatus status = runTransaction(transaction);
+      uint32_t end = micros();
+      
+      busStats.transactions++;
+      busStats.busyUs += end - start;
+      if (status != I2C_DONE) busStats.nacks++;
+      if (end - transaction->submittedUs > busStats.maxLatencyUs) {
+        busStats.maxLatencyUs = end - transaction->submittedUs;
+      }
+      
+      transaction->status.store(status, std::memory_order_release);
+      if (transaction->done) transaction->done(transaction);
+    } while (xQueueReceive(i2cQueue, &transaction, 0) == pdTRUE);
+    powerLockRelease(POWER_LOCK_I2C);
+    xSemaphoreGive(busMutex);
+  }
+}
+
+bool initI2cBus() {
+  if (i2cTaskHandle) return true;
+  
+  Wire.begin(PIN_I2C_SDA, PIN_I2C_SCL, I2C_BUS_CLOCK_HZ);
+  logInfo("I2C initialized - SDA: GPIO%d, SCL: GPIO%d, %lu kHz", PIN_I2C_SDA, PIN_I2C_SCL,
+          (unsigned long)(I2C_BUS_CLOCK_HZ / 1000));
+  
+  busMutex = xSemaphoreCreateMutex();
+  i2cQueue = xQueueCreate(I2C_QUEUE_LENGTH, sizeof(I2cTransaction*));
+  if (!busMutex || !i2cQueue ||
+      xTaskCreate(i2cTask, "I2cTask", I2C_TASK_STACK, NULL, I2C_TASK_PRIORITY, &i2cTaskHandle) != pdPASS) {
+    i2cTaskHandle = NULL;
+    logError("I2C bus manager not started - sensor transactions will fail");
+    return false;
+  }
+  return true;
+}
+
+uint8_t i2cBusScan() {
+  if (!i2cBusLock()) return 0;
+  memset(foundMap, 0, sizeof(foundMap));
+  uint8_t count = 0;
+  for (uint8_t address = I2C_SCAN_FIRST; address <= I2C_SCAN_LAST; address++) {
+    Wire.beginTransmission(address);
+    if (Wire.endTransmission() == 0) {
+      foundMap[address / 32] |= 1UL << (address % 32);
+      count++;
+    }
+  }
+  i2cBusUnlock();
+  
+  if (count == 0) {
+    logWarn("I2C scan: no devices found");
+  }
+  for (uint8_t address = I2C_SCAN_FIRST; address <= I2C_SCAN_LAST; address++) {
+    if (i2cDeviceFound(address)) logInfo("I2C scan: 0x%02X %s", address, knownDeviceName(address));
+  }
+  return count;
+}
+
+bool i2cDeviceFound(uint8_t address) {
+  return address < 128 && (foundMap[address / 32] & (1UL << (address % 32)));
+}
+
+bool i2cSubmit(I2cTransaction* transaction) {
+  if (!transaction) return false;
+  if (transaction->writeLength > I2C_MAX_WRITE || transaction->readLength > I2C_MAX_READ || !i2cQueue) {
+    transaction->status.store(I2C_FAILED, std::memory_order_release);
+    return false;
+  }
+  
+  transaction->submittedUs = micros();
+  transaction->status.store(I2C_PENDING, std::memory_order_release);
+  if (xQueueSend(i2cQueue, &transaction, 0) != pdTRUE) {
+    busStats.queueFull++;
+    transaction->status.store(I2C_FAILED, std::memory_order_release);
+    return false;
+  }
+  
+  uint32_t depth = uxQueueMessagesWaiting(i2cQueue);
+  if (depth > busStats.highWater) busStats.highWater = depth;
+  return true;
+}
+
+bool i2cBusLock() {
+  if (!busMutex) return true;           // Before initI2cBus(): nothing else uses the bus
+  if (xSemaphoreTake(busMutex, 0) != pdTRUE) {
+    busStats.lockWaits++;
+    if (xSemaphoreTake(busMutex, pdMS_TO_TICKS(I2C_LOCK_TIMEOUT_MS)) != pdTRUE) return false;
+  }
+  powerLockAcquire(POWER_LOCK_I2C);
+  return true;
+}
+
+void i2cBusUnlock() {
+  if (!busMutex) return;
+  powerLockRelease(POWER_LOCK_I2C);
+  xSemaphoreGive(busMutex);
+}
+
+void getI2cBusStats(I2cBusStats* stats) {
+  if (!stats) return;
+  *stats = busStats;
+}
+
+void printI2cBusStats() {
+  I2cBusStats stats;
+  getI2cBusStats(&stats);
+  Serial.printf("I2C bus: %lu kHz, %lu transactions, %lu NACKs, %lu ms busy\n",
+                (unsigned long)(I2C_BUS_CLOCK_HZ / 1000), (unsigned long)stats.transactions,
+                (unsigned long)stats.nacks, (unsigned long)(stats.busyUs / 1000));
+  Serial.printf("  queue high water %lu/%d, full %lu, max latency %lu us, lock waits %lu\n",
+                (unsigned long)stats.highWater, I2C_QUEUE_LENGTH, (unsigned long)stats.queueFull,
+                (unsigned long)stats.maxLatencyUs, (unsigned long)stats.lockWaits);
+}
+
+void printI2cScan() {
+  Serial.print("I2C devices:");
+  bool any = false;
+  for (uint8_t address = I2C_SCAN_FIRST; address <= I2C_SCAN_LAST; address++) {
+    if (!i2cDeviceFound(address)) continue;
+    Serial.printf(" 0x%02X (%s)", address, knownDeviceName(address));
+    any = true;
+  }
+  Serial.println(any ? "" : " none");
+}
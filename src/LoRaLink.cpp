@@ -22,38 +22,673 @@
 #include "GlobalContext.h"
 #include "SensorDataAccess.h"
 #include "Logger.h"
-#include <cmath>
+#include "TelemetryFrame.h"
+#include "EventQueue.h"
+#include "Backlog.h"
+#include "PowerManager.h"
+#include "freertos/semphr.h"
+#include <cstring>
+
+struct LoRaTxSlot {
+  uint8_t length;
+  bool backlog;           // Carries the batch from backlogPeek()
+  uint8_t data[LORA_MAX_PACKET_SIZE];
+};
+
+typedef enum {
+  BACKLOG_SETTLE_NONE,
+  BACKLOG_SETTLE_COMMIT,
+  BACKLOG_SETTLE_ABORT
+} BacklogSettle;
+
+// TX ring and in-flight state, guarded by txMutex. The TX-done ISR only
+// sets txDoneFlag and wakes CommsTask; the SPI work stays in task context.
+static LoRaTxSlot txRing[LORA_TX_QUEUE_DEPTH];
+static uint8_t txHead = 0;
+static uint8_t txCount = 0;
+static bool txInFlight = false;
+static unsigned long txStartMs = 0;
+static unsigned long txTimeoutMs = 0;
+static volatile bool txDoneFlag = false;
+static SemaphoreHandle_t txMutex = NULL;
+static LoRaTxStats txStats = {};
+
+// Outcome of the backlog frame, applied by serviceLoRaTx() outside txMutex
+static BacklogSettle backlogSettle = BACKLOG_SETTLE_NONE;
+static uint8_t linkFailures = 0;          // Consecutive failed or timed-out frames
+static bool linkDown = false;
+static unsigned long outageStartMs = 0;
+static unsigned long nextRetryMs = 0;
+static unsigned long retryDelayMs = LORA_RETRY_MIN_MS;
+
+static void IRAM_ATTR onLoRaTxDone() {
+  txDoneFlag = true;
+  publishEventFromISR(EVENT_LORA_SEND_COMPLETE);
+}
+
+// Drop everything queued; a backlog batch among it goes back to the
+// backlog. Caller holds txMutex.
+static void clearTxQueue() {
+  for (uint8_t i = 0; i < txCount; i++) {
+    if (txRing[(txHead + i) % LORA_TX_QUEUE_DEPTH].backlog) {
+      backlogSettle = BACKLOG_SETTLE_ABORT;
+    }
+  }
+  txHead = 0;
+  txCount = 0;
+  txInFlight = false;
+}
+
+static void settleBacklog() {
+  BacklogSettle settle = backlogSettle;
+  backlogSettle = BACKLOG_SETTLE_NONE;
+  if (settle == BACKLOG_SETTLE_COMMIT) {
+    backlogCommit();
+  } else if (settle == BACKLOG_SETTLE_ABORT) {
+    backlogAbort();
+  }
+}
+
+// Hub definition from the channel table: comma-separated names and
+// gateway type codes, in frame order
+static void describeSensorChannels(char* names, size_t namesSize, char* types, size_t typesSize) {
+  size_t n = 0;
+  size_t t = 0;
+  names[0] = '\0';
+  types[0] = '\0';
+  for (int c = 0; c < SENSOR_CHANNEL_COUNT; c++) {
+    const SensorChannelInfo& channel = sensorChannels[c];
+    const char* separator = c ? "," : "";
+    int written = snprintf(names + n, namesSize - n, "%s%s", separator, channel.name);
+    if (written > 0) n += (size_t)written < namesSize - n ? (size_t)written : namesSize - n - 1;
+    written = snprintf(types + t, typesSize - t, "%s%u", separator, channel.hubType);
+    if (written > 0) t += (size_t)written < typesSize - t ? (size_t)written : typesSize - t - 1;
+  }
+}
 
 bool initializeLoRa() {
-  Serial.println("\n========== Initializing LoRa ==========");
-  Serial.println("Pin Configuration:");
-  Serial.print("  SCK:  GPIO "); Serial.println(PIN_LORA_SCK);
-  Serial.print("  MISO: GPIO "); Serial.println(PIN_LORA_MISO);
-  Serial.print("  MOSI: GPIO "); Serial.println(PIN_LORA_MOSI);
-  Serial.print("  CS:   GPIO "); Serial.println(PIN_LORA_CS);
-  Serial.print("  RST:  GPIO "); Serial.println(PIN_LORA_RST);
-  Serial.print("  DIO0: GPIO "); Serial.println(PIN_LORA_DIO0);
-  Serial.println();
+  static bool pinsShown = false;
+  if (!pinsShown) {
+    Serial.println("\n========== Initializing LoRa ==========");
+    Serial.println("Pin Configuration:");
+    Serial.print("  SCK:  GPIO "); Serial.println(PIN_LORA_SCK);
+    Serial.print("  MISO: GPIO "); Serial.println(PIN_LORA_MISO);
+    Serial.print("  MOSI: GPIO "); Serial.println(PIN_LORA_MOSI);
+    Serial.print("  CS:   GPIO "); Serial.println(PIN_LORA_CS);
+    Serial.print("  RST:  GPIO "); Serial.println(PIN_LORA_RST);
+    Serial.print("  DIO0: GPIO "); Serial.println(PIN_LORA_DIO0);
+    Serial.println();
+    pinsShown = true;
+  }
   
   LoRa.setPins(PIN_LORA_CS, PIN_LORA_RST, PIN_LORA_DIO0);
   
+  if (!txMutex) {
+    txMutex = xSemaphoreCreateMutex();
+    if (!txMutex) {
+      logError("Failed to create LoRa TX queue mutex");
+      return false;
+    }
+  }
+  
+  // Re-initialization resets the radio, so drop anything still queued
+  if (xSemaphoreTake(txMutex, portMAX_DELAY)) {
+    clearTxQueue();
+    linkFailures = 0;
+    xSemaphoreGive(txMutex);
+  }
+  settleBacklog();
+  
   Serial.println("Attempting LoRa.begin(915E6)...");
+  powerLockAcquire(POWER_LOCK_LORA);
   if (!LoRa.begin(915E6)) {
+    powerLockRelease(POWER_LOCK_LORA);
     logError("LoRa initialization failed at 915MHz");
     logInfo("Check: wiring, pin definitions, 3.3V power, antenna connection");
     return false;
   }
   
+  LoRa.setSpreadingFactor(LORA_SPREADING_FACTOR);
+  LoRa.onTxDone(onLoRaTxDone);
+  // TX-done must also wake the chip from light sleep
+  powerWakeOnPin(PIN_LORA_DIO0);
+  powerLockRelease(POWER_LOCK_LORA);
+  
   logNetworkEvent("LoRa", "INITIALIZED", "915MHz ready for transmission");
   getGlobalContext().loraActive = true;
   
+  if (linkDown) {
+    unsigned long outageMs = millis() - outageStartMs;
+    txStats.lastOutageMs = outageMs;
+    logInfo("LoRa link restored after %lu s outage, backlog %u samples",
+            outageMs / 1000, (unsigned)backlogDepth());
+    linkDown = false;
+  }
+  retryDelayMs = LORA_RETRY_MIN_MS;
+  
   logInfo("Creating LoRa sensor hub configuration");
   delay(100);
   
-  createHub("Greenhouse", "Temperature,Humidity,Lux,Distance", "1,2,1,2");
+  char names[64];
+  char types[2 * SENSOR_CHANNEL_COUNT + 1];
+  describeSensorChannels(names, sizeof(names), types, sizeof(types));
+  createHub("Greenhouse", names, types);
+  return true;
+}
+
+// Print adapter that renders into a packet buffer, so the ASCII format keeps
+// the exact LoRa.print() formatting of the legacy packets.
+class PacketPrint : public Print {
+ public:
+  PacketPrint(uint8_t* buffer, size_t size) : buffer(buffer), size(size) {}
+
+  size_t write(uint8_t c) override {
+    if (length >= size) {
+      overflow = true;
+      return 0;
+    }
+    buffer[length++] = c;
+    return 1;
+  }
+
+  size_t finish() const { return overflow ? 0 : length; }
+
+ private:
+  uint8_t* buffer;
+  size_t size;
+  size_t length = 0;
+  bool overflow = false;
+};
+
+// Start the frame at the head of the ring; frames the radio refuses are
+// counted and discarded. Caller holds txMutex and the LoRa power lock.
+static void startNextFrame() {
+  while (!txInFlight && txCount > 0) {
+    const LoRaTxSlot& slot = txRing[txHead];
+    txDoneFlag = false;
+    
+    if (LoRa.beginPacket()) {
+      LoRa.write(slot.data, slot.length);
+      if (LoRa.endPacket(true)) {
+        txInFlight = true;
+        txStartMs = millis();
+        txTimeoutMs = 2 * (loraTimeOnAirUs(slot.length) / 1000) + LORA_TX_TIMEOUT_MARGIN_MS;
+        return;
+      }
+    }
+    
+    txStats.failed++;
+    linkFailures++;
+    if (slot.backlog) backlogSettle = BACKLOG_SETTLE_ABORT;
+    txHead = (txHead + 1) % LORA_TX_QUEUE_DEPTH;
+    txCount--;
+  }
+}
+
+static void retireHeadFrame() {
+  txHead = (txHead + 1) % LORA_TX_QUEUE_DEPTH;
+  txCount--;
+  txInFlight = false;
+}
+
+static bool enqueueFrame(const uint8_t* packet, size_t length, bool backlog) {
+  if (!packet || length == 0 || length > LORA_MAX_PACKET_SIZE || !txMutex) return false;
+  
+  uint32_t start = micros();
+  if (!xSemaphoreTake(txMutex, pdMS_TO_TICKS(10))) return false;
+  
+  if (txCount >= LORA_TX_QUEUE_DEPTH) {
+    txStats.dropped++;
+    xSemaphoreGive(txMutex);
+    return false;
+  }
+  
+  LoRaTxSlot& slot = txRing[(txHead + txCount) % LORA_TX_QUEUE_DEPTH];
+  memcpy(slot.data, packet, length);
+  slot.length = (uint8_t)length;
+  slot.backlog = backlog;
+  txCount++;
+  txStats.queued++;
+  if (txCount > txStats.maxDepth) txStats.maxDepth = txCount;
+  
+  powerLockAcquire(POWER_LOCK_LORA);
+  startNextFrame();
+  powerLockRelease(POWER_LOCK_LORA);
+  xSemaphoreGive(txMutex);
+  
+  uint32_t elapsed = micros() - start;
+  if (elapsed > txStats.maxEnqueueUs) txStats.maxEnqueueUs = elapsed;
   return true;
 }
 
+bool queueLoRaPacket(const uint8_t* packet, size_t length) {
+  return enqueueFrame(packet, length, false);
+}
+
+// The power lock is only held for the SPI work here; the chip may sleep
+// while a frame is on air, as DIO0 wakes it for TX-done
+void serviceLoRaTx() {
+  if (!txMutex || !xSemaphoreTake(txMutex, pdMS_TO_TICKS(10))) return;
+  powerLockAcquire(POWER_LOCK_LORA);
+  
+  bool completed = false;
+  bool finished = false;
+  uint8_t completedLength = 0;
+  unsigned long now = millis();
+  
+  if (txInFlight && txDoneFlag) {
+    txDoneFlag = false;
+    completedLength = txRing[txHead].length;
+    if (txRing[txHead].backlog) backlogSettle = BACKLOG_SETTLE_COMMIT;
+    completed = true;
+    txStats.sent++;
+    txStats.lastSentMs = now;
+    linkFailures = 0;
+    retireHeadFrame();
+    finished = true;
+  } else if (txInFlight && now - txStartMs > txTimeoutMs) {
+    // TX-done never arrived (DIO0 wiring, radio reset); put the radio back
+    // in standby so the next frame can start
+    LoRa.idle();
+    txStats.timeouts++;
+    linkFailures++;
+    if (txRing[txHead].backlog) backlogSettle = BACKLOG_SETTLE_ABORT;
+    retireHeadFrame();
+    finished = true;
+  }
+  
+  startNextFrame();
+  // Nothing left to send: the radio sleeps until the next beginPacket()
+  if (finished && !txInFlight) {
+    LoRa.sleep();
+  }
+  
+  // Repeated failures mean the radio is gone; stop queueing and let
+  // maintainLoRaLink() bring it back
+  bool wentDown = false;
+  if (linkFailures >= LORA_LINK_FAILURE_LIMIT && getGlobalContext().loraActive) {
+    clearTxQueue();
+    getGlobalContext().loraActive = false;
+    linkDown = true;
+    wentDown = true;
+    outageStartMs = now;
+    nextRetryMs = now + retryDelayMs;
+    linkFailures = 0;
+    txStats.outages++;
+  }
+  powerLockRelease(POWER_LOCK_LORA);
+  xSemaphoreGive(txMutex);
+  
+  settleBacklog();
+  if (wentDown) {
+    logNetworkEvent("LoRa", "LINK_DOWN", "repeated TX failures, buffering samples");
+  }
+  
+  if (completed) {
+    char details[32];
+    snprintf(details, sizeof(details), "%u bytes sent", (unsigned)completedLength);
+    logNetworkEvent("LoRa", "TX_DONE", details);
+  }
+}
+
+void getLoRaTxStats(LoRaTxStats* stats) {
+  if (!stats) return;
+  if (txMutex && xSemaphoreTake(txMutex, pdMS_TO_TICKS(10))) {
+    *stats = txStats;
+    stats->depth = txCount;
+    xSemaphoreGive(txMutex);
+  } else {
+    *stats = txStats;
+  }
+}
+
+void printLoRaTxStats() {
+  LoRaTxStats stats;
+  getLoRaTxStats(&stats);
+  Serial.printf("LoRa TX: queued %lu, sent %lu, dropped %lu, failed %lu, timeouts %lu\n",
+                (unsigned long)stats.queued, (unsigned long)stats.sent, (unsigned long)stats.dropped,
+                (unsigned long)stats.failed, (unsigned long)stats.timeouts);
+  if (stats.sent > 0) {
+    Serial.printf("LoRa last TX: %lu ms ago\n", (unsigned long)(millis() - stats.lastSentMs));
+  }
+  Serial.printf("LoRa TX queue: depth %u/%u (max %u), max enqueue %lu us\n",
+                stats.depth, LORA_TX_QUEUE_DEPTH, stats.maxDepth, (unsigned long)stats.maxEnqueueUs);
+  Serial.printf("LoRa link: %s, outages %lu, last outage %lu s, reconnect attempts %lu\n",
+                getGlobalContext().loraActive ? "up" : "down", (unsigned long)stats.outages,
+                (unsigned long)(stats.lastOutageMs / 1000), (unsigned long)stats.reconnectAttempts);
+}
+
+void maintainLoRaLink() {
+  if (getGlobalContext().loraActive) return;
+  
+  unsigned long now = millis();
+  if (!linkDown) {
+    // Never came up at boot; retry on the same schedule
+    linkDown = true;
+    outageStartMs = now;
+    nextRetryMs = now + retryDelayMs;
+    return;
+  }
+  if ((long)(now - nextRetryMs) < 0) return;
+  
+  txStats.reconnectAttempts++;
+  if (!initializeLoRa()) {
+    retryDelayMs = retryDelayMs * 2 > LORA_RETRY_MAX_MS ? LORA_RETRY_MAX_MS : retryDelayMs * 2;
+    nextRetryMs = millis() + retryDelayMs;
+  }
+}
+
+void drainBacklog(const char* hubName) {
+  GlobalContext& ctx = getGlobalContext();
+  if (!ctx.loraActive || !hubName || !txMutex) return;
+  
+  // One frame at a time, so a failure is settled before the next batch
+  if (!xSemaphoreTake(txMutex, pdMS_TO_TICKS(10))) return;
+  bool busy = txCount > 0 || backlogSettle != BACKLOG_SETTLE_NONE;
+  xSemaphoreGive(txMutex);
+  size_t depth = backlogDepth();
+  if (busy || depth == 0) return;
+  
+  LoRaFrameFormat format = getLoRaFrameFormat();
+  bool binary = format == LORA_FORMAT_BINARY;
+  bool batching = binary && ctx.loraBatchSamples > 1;
+  if (batching && depth < ctx.loraBatchSamples && backlogOldestAgeMs() < ctx.loraBatchLatencyMs) {
+    return;   // Let the batch fill
+  }
+  
+  // Only CommsTask drains, so the larger buffers stay off its stack
+  static BacklogSample samples[BACKLOG_BATCH_MAX];
+  static PeerState peers[PEER_TABLE_CAPACITY];
+  bool catchUp = depth > 1;
+  size_t count = backlogPeek(samples, binary && (batching || catchUp) ? BACKLOG_BATCH_MAX : 1);
+  if (count == 0) return;
+  
+  uint8_t packet[LORA_MAX_PACKET_SIZE];
+  size_t length;
+  size_t peerCount = 0;
+  const BacklogSample& first = samples[0];
+  
+  if (count == 1 && !catchUp && !first.earlierBoot &&
+      millis() - first.sample.timestamp <= 2 * LORA_TRANSMIT_INTERVAL) {
+    // Up to date: the regular frame, with the peer readings
+    peerCount = snapshotPeers(peers, PEER_TABLE_CAPACITY);
+    logSensorData(first.sample);
+    length = buildSensorPacket(format, hubName, first.sequence, first.sample,
+                               peers, peerCount, packet, sizeof(packet));
+  } else if (binary) {
+    if (batching) {
+      peerCount = snapshotPeers(peers, PEER_TABLE_CAPACITY);
+      logSensorData(first.sample);
+    }
+    length = buildBatchPacket(samples, count, peers, peerCount, packet, sizeof(packet));
+  } else {
+    // ASCII receivers only know PD> packets; replay them one per frame
+    length = buildSensorPacket(format, hubName, first.sequence, first.sample,
+                               NULL, 0, packet, sizeof(packet));
+  }
+  
+  if (length == 0 || !enqueueFrame(packet, length, true)) {
+    backlogAbort();
+  }
+}
+
+// A history upload in progress; only CommsTask touches it after the request
+struct HistoryUpload {
+  bool active;
+  HistoryTier tier;
+  HistoryChannel channel;
+  uint32_t cursorMs;          // Next point to send
+  uint32_t endMs;             // Time of the request
+  uint32_t points;
+  uint32_t frames;
+};
+
+static HistoryUpload historyUpload = {};
+
+bool requestHistoryUpload(HistoryTier tier, HistoryChannel channel, uint32_t fromMs) {
+  if (!getGlobalContext().loraActive || historyUpload.active) return false;
+  historyUpload.tier = tier;
+  historyUpload.channel = channel;
+  historyUpload.cursorMs = fromMs;
+  historyUpload.endMs = millis();
+  historyUpload.points = 0;
+  historyUpload.frames = 0;
+  historyUpload.active = true;
+  publishEvent(EVENT_HISTORY_REQUEST);
+  return true;
+}
+
+void serviceHistoryUpload() {
+  if (!historyUpload.active || !getGlobalContext().loraActive || !txMutex) return;
+  if (!xSemaphoreTake(txMutex, pdMS_TO_TICKS(10))) return;
+  bool busy = txCount > 0 || backlogSettle != BACKLOG_SETTLE_NONE;
+  xSemaphoreGive(txMutex);
+  if (busy) return;
+  
+  // Only CommsTask uploads, so the point buffer stays off its stack
+  static HistoryPoint points[TELEMETRY_MAX_HISTORY_POINTS];
+  size_t count = queryHistory(historyUpload.tier, historyUpload.channel, historyUpload.cursorMs,
+                              historyUpload.endMs, points, TELEMETRY_MAX_HISTORY_POINTS);
+  if (count == 0) {
+    historyUpload.active = false;
+    logInfo("History upload done: %s %s, %lu points in %lu frames",
+            historyTierName(historyUpload.tier), historyChannelName(historyUpload.channel),
+            (unsigned long)historyUpload.points, (unsigned long)historyUpload.frames);
+    return;
+  }
+  
+  uint8_t packet[LORA_MAX_PACKET_SIZE];
+  uint8_t encoded = 0;
+  size_t length = buildHistoryPacket(historyUpload.tier, historyUpload.channel, points, count,
+                                     packet, sizeof(packet), &encoded);
+  if (length == 0 || encoded == 0 || !queueLoRaPacket(packet, length)) return;
+  
+  historyUpload.cursorMs = points[encoded - 1].timeMs + 1;
+  historyUpload.points += encoded;
+  historyUpload.frames++;
+}
+
+static uint32_t msUntil(unsigned long now, unsigned long deadline) {
+  long remaining = (long)(deadline - now);
+  return remaining > 0 ? (uint32_t)remaining : 0;
+}
+
+uint32_t loraServiceDelayMs() {
+  GlobalContext& ctx = getGlobalContext();
+  unsigned long now = millis();
+  if (!ctx.loraActive) {
+    // maintainLoRaLink() schedules the first retry on its first call
+    return linkDown ? msUntil(now, nextRetryMs) : 0;
+  }
+  if (!txMutex || !xSemaphoreTake(txMutex, pdMS_TO_TICKS(10))) return LORA_SERVICE_RETRY_MS;
+  uint32_t delayMs = txInFlight ? msUntil(now, txStartMs + txTimeoutMs + 1) : UINT32_MAX;
+  bool busy = txCount > 0 || backlogSettle != BACKLOG_SETTLE_NONE;
+  xSemaphoreGive(txMutex);
+  if (busy) return delayMs;   // TX-done or the TX timeout comes first
+  
+  // Radio idle: whatever drainBacklog() left in the backlog is waiting for
+  // its batch to fill, or could not be queued and is retried
+  size_t depth = backlogDepth();
+  if (depth > 0) {
+    bool batching = getLoRaFrameFormat() == LORA_FORMAT_BINARY && ctx.loraBatchSamples > 1;
+    if (batching && depth < ctx.loraBatchSamples) {
+      uint32_t age = backlogOldestAgeMs();
+      delayMs = age < ctx.loraBatchLatencyMs ? ctx.loraBatchLatencyMs - age : 0;
+    } else {
+      delayMs = LORA_SERVICE_RETRY_MS;
+    }
+  }
+  if (historyUpload.active && delayMs > LORA_SERVICE_RETRY_MS) delayMs = LORA_SERVICE_RETRY_MS;
+  return delayMs;
+}
+
+void setLoRaFrameFormat(LoRaFrameFormat format) {
+  getGlobalContext().loraFrameFormat = (uint8_t)format;
+}
+
+LoRaFrameFormat getLoRaFrameFormat() {
+  return (LoRaFrameFormat)getGlobalContext().loraFrameFormat;
+}
+
+const char* loraFrameFormatName(LoRaFrameFormat format) {
+  return format == LORA_FORMAT_ASCII ? "ascii" : "binary";
+}
+
+bool setLoRaBatching(uint8_t samples, uint32_t maxLatencyMs) {
+  if (samples < 1 || samples > BACKLOG_BATCH_MAX || maxLatencyMs > LORA_BATCH_MAX_LATENCY_MS) {
+    return false;
+  }
+  GlobalContext& ctx = getGlobalContext();
+  ctx.loraBatchSamples = samples;
+  ctx.loraBatchLatencyMs = maxLatencyMs;
+  publishEvent(EVENT_CONFIG_CHANGED);   // CommsTask re-times a pending batch
+  return true;
+}
+
+void printLoRaBatching() {
+  GlobalContext& ctx = getGlobalContext();
+  if (ctx.loraBatchSamples <= 1) {
+    Serial.println("LoRa batching: off (one frame per sample)");
+    return;
+  }
+  Serial.printf("LoRa batching: %u samples or %lu s, whichever comes first%s\n",
+                ctx.loraBatchSamples, (unsigned long)(ctx.loraBatchLatencyMs / 1000),
+                getLoRaFrameFormat() == LORA_FORMAT_BINARY ? "" : " (binary format only)");
+}
+
+// Peer records for every peer heard within PEER_STALE_MS
+static uint8_t collectPeerReadings(const PeerState* peers, size_t peerCount,
+                                   TelemetryPeerReading* out, uint8_t maxRecords) {
+  uint8_t count = 0;
+  unsigned long now = millis();
+  for (size_t i = 0; peers && i < peerCount && count < maxRecords; i++) {
+    const PeerState& peer = peers[i];
+    unsigned long age = now - peer.lastSeen;
+    if (!peer.hasValue || age > PEER_STALE_MS) continue;
+    
+    TelemetryPeerReading& record = out[count++];
+    record.id = peerTelemetryId(peer.mac);
+    record.kind = peer.kind;
+    record.valueCenti = telemetryScaleDistance(peer.value);
+    record.ageSeconds = age / 1000 > 255 ? 255 : (uint8_t)(age / 1000);
+  }
+  return count;
+}
+
+size_t buildHistoryPacket(HistoryTier tier, HistoryChannel channel, const HistoryPoint* points,
+                          size_t count, uint8_t* buffer, size_t bufferSize, uint8_t* encodedPoints) {
+  if (!points || count == 0) return 0;
+  if (count > TELEMETRY_MAX_HISTORY_POINTS) count = TELEMETRY_MAX_HISTORY_POINTS;
+  
+  static TelemetryHistory frame;
+  frame.hubId = LORA_HUB_ID;
+  frame.channel = historyChannelFlag(channel);
+  frame.intervalSeconds = (uint16_t)(historyTierIntervalMs(tier) / 1000);
+  frame.pointCount = (uint8_t)count;
+  unsigned long now = millis();
+  for (size_t i = 0; i < count; i++) {
+    TelemetryHistoryPoint& out = frame.points[i];
+    out.ageMs = now - points[i].timeMs;
+    out.min = points[i].min;
+    out.max = points[i].max;
+    out.mean = points[i].mean;
+    out.count = points[i].count;
+  }
+  return encodeHistoryFrame(&frame, buffer, bufferSize, encodedPoints);
+}
+
+size_t buildBatchPacket(const BacklogSample* samples, size_t count, const PeerState* peers,
+                        size_t peerCount, uint8_t* buffer, size_t bufferSize) {
+  if (!samples || count == 0 || count > TELEMETRY_MAX_BATCH_SAMPLES) return 0;
+  
+  static TelemetryBatch batch;
+  batch.hubId = LORA_HUB_ID;
+  batch.sampleCount = (uint8_t)count;
+  unsigned long now = millis();
+  for (size_t i = 0; i < count; i++) {
+    const SensorSample& sample = samples[i].sample;
+    TelemetrySample& out = batch.samples[i];
+    out.sequence = samples[i].sequence;
+    out.ageMs = samples[i].earlierBoot ? TELEMETRY_AGE_UNKNOWN_MS : now - sample.timestamp;
+    out.flags = sample.flags;
+    out.temperatureCenti = sample.temperatureCenti;
+    out.humidityCenti = sample.humidityCenti;
+    out.lux = sample.lux;
+    out.distanceCenti = sample.distanceCenti;
+  }
+  batch.peerCount = collectPeerReadings(peers, peerCount, batch.peers, TELEMETRY_MAX_PEERS);
+  return encodeBatchFrame(&batch, buffer, bufferSize);
+}
+
+// Unsigned 0.01-unit value with the given number of decimals, rounded
+static void printFixed(PacketPrint& packet, uint32_t centi, uint8_t decimals) {
+  if (decimals == 1) centi = (centi + 5) / 10;
+  uint32_t unit = decimals == 1 ? 10 : 100;
+  packet.print(centi / unit);
+  packet.print(".");
+  if (decimals == 2 && centi % unit < 10) packet.print("0");
+  packet.print(centi % unit);
+}
+
+size_t buildSensorPacket(LoRaFrameFormat format, const char* hubName, uint16_t sequence,
+                         const SensorSample& sample, const PeerState* peers, size_t peerCount,
+                         uint8_t* buffer, size_t bufferSize) {
+  if (format == LORA_FORMAT_BINARY) {
+    TelemetryReading reading;
+    reading.hubId = LORA_HUB_ID;
+    reading.sequence = sequence;
+    reading.flags = sample.flags;
+    reading.temperatureCenti = sample.temperatureCenti;
+    reading.humidityCenti = sample.humidityCenti;
+    reading.lux = sample.lux;
+    reading.distanceCenti = sample.distanceCenti;
+    
+    reading.peerCount = collectPeerReadings(peers, peerCount, reading.peers, TELEMETRY_MAX_PEERS);
+    return encodeSensorFrame(&reading, buffer, bufferSize);
+  }
+  
+  // The PD> layout predates fixed point: each channel at its asciiDecimals,
+  // so whole degrees (truncated, as the gateway has always parsed them),
+  // humidity to 0.1 and distance to 0.01
+  PacketPrint packet(buffer, bufferSize);
+  packet.print("    ");
+  packet.print("PD");
+  packet.print(">");
+  packet.print(hubName);
+  packet.print(":");
+  for (int c = 0; c < SENSOR_CHANNEL_COUNT; c++) {
+    const SensorChannelInfo& channel = sensorChannels[c];
+    int32_t value = sensorChannelValue(sample, (SensorChannelId)c);
+    if (channel.decimals == 0) {
+      packet.print(value);
+    } else if (channel.asciiDecimals == 0) {
+      packet.print(value / 100);
+    } else {
+      printFixed(packet, (uint32_t)value, channel.asciiDecimals);
+    }
+    packet.print(",");
+  }
+  return packet.finish();
+}
+
+// Semtech AN1200.13 time-on-air, explicit header, in integer microseconds
+uint32_t loraTimeOnAirUs(size_t payloadLength, int spreadingFactor, long bandwidth,
+                         int codingRateDenom, int preambleLength, bool crc) {
+  uint32_t symbolUs = (uint32_t)(((uint64_t)1000000 << spreadingFactor) / (uint64_t)bandwidth);
+  int lowDataRate = symbolUs > 16000 ? 1 : 0;
+  
+  long num = 8L * (long)payloadLength - 4L * spreadingFactor + 28 + (crc ? 16 : 0);
+  long den = 4L * (spreadingFactor - 2 * lowDataRate);
+  long payloadSymbols = 8;
+  if (num > 0) {
+    payloadSymbols += ((num + den - 1) / den) * codingRateDenom;
+  }
+  
+  // Preamble is (n + 4.25) symbols; keep the quarter symbol in integer math
+  uint64_t quarterSymbols = (uint64_t)(preambleLength * 4 + 17) + (uint64_t)payloadSymbols * 4;
+  return (uint32_t)(quarterSymbols * symbolUs / 4);
+}
+
 void createHub(const char* hubName, const char* sensorNames, const char* types) {
   if (!getGlobalContext().loraActive) {
     Serial.println("ERROR: Cannot create hub - LoRa not active!");
@@ -65,22 +700,31 @@ void createHub(const char* hubName, const char* sensorNames, const char* types)
     return;
   }
   
-  if (!LoRa.beginPacket()) {
-    Serial.println("ERROR: Failed to begin LoRa packet");
-    return;
+  uint8_t packet[LORA_MAX_PACKET_SIZE];
+  size_t length;
+  
+  if (getLoRaFrameFormat() == LORA_FORMAT_BINARY) {
+    length = encodeHubInfoFrame(LORA_HUB_ID, hubName, sensorNames, types, packet, sizeof(packet));
+  } else {
+    PacketPrint ascii(packet, sizeof(packet));
+    ascii.print("    ");
+    ascii.print("CH");
+    ascii.print(">");
+    ascii.print(hubName);
+    ascii.print(":");
+    ascii.print(sensorNames);
+    ascii.print(":");
+    ascii.print(types);
+    length = ascii.finish();
   }
   
-  LoRa.print("    ");
-  LoRa.print("CH");
-  LoRa.print(">");
-  LoRa.print(hubName);
-  LoRa.print(":");
-  LoRa.print(sensorNames);
-  LoRa.print(":");
-  LoRa.print(types);
+  if (length == 0) {
+    Serial.println("ERROR: Hub definition too long for a LoRa packet");
+    return;
+  }
   
-  if (!LoRa.endPacket()) {
-    Serial.println("ERROR: Failed to send LoRa packet");
+  if (!queueLoRaPacket(packet, length)) {
+    Serial.println("ERROR: Failed to queue LoRa packet");
     return;
   }
   
@@ -103,44 +747,24 @@ void pushAllData(const char* hubName) {
     return;
   }
   
-  int temp;
-  float humidity, distance;
-  int lux;
-  
-  if (!getAllSensorData(&temp, &humidity, &lux, &distance)) {
-    Serial.println("ERROR: Failed to read sensor data");
-    return;
-  }
+  SensorData data;
+  readSensorSnapshot(&data);
   
   // Log structured sensor telemetry data
-  logSensorData(temp, humidity, lux, distance);
+  logSensorData(data);
   
-  if (!LoRa.beginPacket()) {
-    Serial.println("ERROR: Failed to begin LoRa packet");
-    return;
-  }
+  PeerState peers[PEER_TABLE_CAPACITY];
+  size_t peerCount = snapshotPeers(peers, PEER_TABLE_CAPACITY);
   
-  LoRa.print("    ");
-  LoRa.print("PD");
-  LoRa.print(">");
-  LoRa.print(hubName);
-  LoRa.print(":");
-  LoRa.print(temp);
-  LoRa.print(",");
-  LoRa.print(humidity, 1);
-  LoRa.print(",");
-  LoRa.print(lux);
-  LoRa.print(",");
-  LoRa.print(distance, 2);
-  LoRa.print(",");
-  
-  if (!LoRa.endPacket()) {
-    logError("LoRa packet transmission failed");
+  uint8_t packet[LORA_MAX_PACKET_SIZE];
+  size_t length = buildSensorPacket(getLoRaFrameFormat(), hubName, nextTelemetrySequence(),
+                                    data, peers, peerCount, packet, sizeof(packet));
+  if (length == 0) {
+    logError("LoRa packet too long for hub name: %s", hubName);
     return;
   }
   
-  logNetworkEvent("LoRa", "DATA_TX", "Sensor data transmitted successfully");
-  
-  getGlobalContext().sensors.lastLoRaTransmit = millis();
+  if (!queueLoRaPacket(packet, length)) {
+    logError("LoRa TX queue full - sensor frame dropped");
+  }
 }
-
@@ -0,0 +1,78 @@
+/**
+ * LogFrame.cpp - Binary log frame encoding
+ * 
+ * Copyright (C) 2025 Michael Garcia, M&E Design
+ * Based on original .ino by Geoff Mcintyre of Mr.Industries (https://mr.industries/)
+ * 
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ * 
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU General Public License for more details.
+ * 
+ * You should have received a copy of the GNU General Public License
+ * along with this program. If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#include "LogFrame.h"
+#include "TelemetryFrame.h"
+#include <string.h>
+
+size_t logPutVarint(uint8_t* buffer, size_t bufferSize, uint64_t value) {
+  size_t n = 0;
+  do {
+    if (n >= bufferSize) return 0;
+    uint8_t byte = (uint8_t)(value & 0x7F);
+    value >>= 7;
+    buffer[n++] = value ? (uint8_t)(byte | 0x80) : byte;
+  } while (value);
+  return n;
+}
+
+size_t logPutZigzag(uint8_t* buffer, size_t bufferSize, int64_t value) {
+  uint64_t zigzag = ((uint64_t)value << 1) ^ (uint64_t)(value >> 63);
+  return logPutVarint(buffer, bufferSize, zigzag);
+}
+
+// Appends the CRC, then COBS-encodes payload+CRC between two delimiters
+size_t logFrameWrap(const uint8_t* payload, size_t length, uint8_t* out, size_t outSize) {
+  if (!payload || !out || length + 2 > LOG_FRAME_MAX_PAYLOAD) return 0;
+
+  uint8_t data[LOG_FRAME_MAX_PAYLOAD];
+  memcpy(data, payload, length);
+  uint16_t crc = telemetryCrc16(data, length);
+  data[length++] = (uint8_t)(crc & 0xFF);
+  data[length++] = (uint8_t)(crc >> 8);
+
+  // Worst case: delimiters + one code byte per 254 data bytes + data
+  size_t needed = 2 + length + length / 254 + 1;
+  if (needed > outSize) return 0;
+
+  size_t pos = 0;
+  out[pos++] = LOG_FRAME_DELIMITER;
+
+  size_t codePos = pos++;
+  uint8_t code = 1;
+  for (size_t i = 0; i < length; i++) {
+    if (data[i] == 0) {
+      out[codePos] = code;
+      codePos = pos++;
+      code = 1;
+      continue;
+    }
+    out[pos++] = data[i];
+    if (++code == 0xFF) {
+      out[codePos] = code;
+      codePos = pos++;
+      code = 1;
+    }
+  }
+  out[codePos] = code;
+
+  out[pos++] = LOG_FRAME_DELIMITER;
+  return pos;
+}
@@ -0,0 +1,237 @@
+/**
+ * LogStorage.cpp - Persistent flash log ring implementation
+ * 
+ * Copyright (C) 2025 Michael Garcia, M&E Design
+ * Based on original .ino by Geoff Mcintyre of Mr.Industries (https://mr.industries/)
+ * 
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ * 
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU General Public License for more details.
+ * 
+ * You should have received a copy of the GNU General Public License
+ * along with this program. If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#include "LogStorage.h"
+#include "freertos/FreeRTOS.h"
+#include "freertos/semphr.h"
+#include <cstring>
+
+#define LOG_STORAGE_MUTEX_TIMEOUT_MS 200
+
+// Guarded by storageMutex
+static FlashRing ring;
+static bool mounted = false;
+static SemaphoreHandle_t storageMutex = NULL;
+static uint32_t eraseMarker = 0;          // Sequence of the newest erase marker
+static uint8_t pageBuffer[FLASH_RING_PAGE_SIZE];
+static size_t pageUsed = 0;
+static uint32_t pageRecords = 0;
+static unsigned long pageOpenedAt = 0;
+static uint8_t scanBuffer[FLASH_RING_PAGE_SIZE];
+static uint8_t dumpBuffer[FLASH_RING_PAGE_SIZE];  // Command task only
+static uint32_t statRecords = 0;
+static uint32_t statRecordBytes = 0;
+static uint32_t statDropped = 0;
+
+static bool lockStorage() {
+  return storageMutex && xSemaphoreTake(storageMutex, pdMS_TO_TICKS(LOG_STORAGE_MUTEX_TIMEOUT_MS));
+}
+
+static void unlockStorage() {
+  xSemaphoreGive(storageMutex);
+}
+
+static void resetPageBuffer() {
+  memset(pageBuffer, 0xFF, sizeof(pageBuffer));
+  pageUsed = 0;
+  pageRecords = 0;
+}
+
+// Program the RAM page; on failure its records are dropped so one bad
+// sector cannot stall the logger. Called with the lock held.
+static bool writePage(uint8_t flags) {
+  bool ok = flashRingAppend(&ring, flags, pageBuffer, pageUsed);
+  if (ok && (flags & LOG_PAGE_FLAG_ERASE)) {
+    eraseMarker = ring.nextSequence - 1;
+  }
+  if (!ok) {
+    statDropped += pageRecords;
+  }
+  resetPageBuffer();
+  return ok;
+}
+
+static void visitPage(uint32_t page, const FlashPageHeader* header, const uint8_t* data, void* context) {
+  if ((header->flags & LOG_PAGE_FLAG_ERASE) && header->sequence > eraseMarker) {
+    eraseMarker = header->sequence;
+  }
+}
+
+bool initLogStorage() {
+  if (mounted) return true;
+  
+  if (!storageMutex) {
+    storageMutex = xSemaphoreCreateMutex();
+    if (!storageMutex) return false;
+  }
+  
+  eraseMarker = 0;
+  if (!flashRingMount(&ring, LOG_STORAGE_PARTITION_LABEL, LOG_STORAGE_PARTITION_SUBTYPE,
+                      LOG_PAGE_MAGIC, visitPage, NULL)) {
+    return false;
+  }
+  resetPageBuffer();
+  mounted = true;
+  return true;
+}
+
+bool logStorageReady() {
+  return mounted;
+}
+
+bool logStorageAppend(const uint8_t* data, size_t length) {
+  if (!mounted || !data || length == 0) return false;
+  if (length > LOG_STORAGE_PAYLOAD_SIZE || !lockStorage()) {
+    statDropped++;
+    return false;
+  }
+  
+  if (pageUsed + length > LOG_STORAGE_PAYLOAD_SIZE) {
+    writePage(0);
+  }
+  if (pageUsed == 0) {
+    pageOpenedAt = millis();
+  }
+  memcpy(&pageBuffer[FLASH_RING_HEADER_SIZE + pageUsed], data, length);
+  pageUsed += length;
+  pageRecords++;
+  statRecords++;
+  statRecordBytes += length;
+  
+  unlockStorage();
+  return true;
+}
+
+uint32_t pollLogStorage() {
+  if (!mounted || pageUsed == 0) return UINT32_MAX;
+  uint32_t waited = millis() - pageOpenedAt;
+  if (waited < LOG_STORAGE_FLUSH_MS) return LOG_STORAGE_FLUSH_MS - waited;
+  flushLogStorage();
+  return UINT32_MAX;
+}
+
+bool flushLogStorage() {
+  if (!mounted || !lockStorage()) return false;
+  bool ok = pageUsed == 0 || writePage(0);
+  unlockStorage();
+  return ok;
+}
+
+bool eraseLogStorage() {
+  if (!mounted || !lockStorage()) return false;
+  resetPageBuffer();
+  bool ok = writePage(LOG_PAGE_FLAG_ERASE);
+  unlockStorage();
+  return ok;
+}
+
+void dumpLogStorage() {
+  if (!mounted) {
+    Serial.println("Log storage not available");
+    return;
+  }
+  
+  Serial.println("=== STORED LOGS ===");
+  uint32_t pages = 0;
+  uint32_t lastSequence = eraseMarker;
+  for (uint32_t i = 0; i < ring.pageCount; i++) {
+    FlashPageHeader header;
+    if (!lockStorage()) break;
+    // Start at the head: the pages after it are the oldest
+    FlashPageState state = flashRingRead(&ring, (ring.headPage + i) % ring.pageCount, dumpBuffer, &header);
+    unlockStorage();
+    
+    if (state != FLASH_PAGE_VALID || header.sequence <= lastSequence) continue;
+    lastSequence = header.sequence;
+    Serial.write(&dumpBuffer[FLASH_RING_HEADER_SIZE], header.used);
+    pages++;
+  }
+  
+  // Records still waiting in RAM
+  size_t pending = 0;
+  if (lockStorage()) {
+    pending = pageUsed;
+    memcpy(dumpBuffer, &pageBuffer[FLASH_RING_HEADER_SIZE], pending);
+    unlockStorage();
+  }
+  Serial.write(dumpBuffer, pending);
+  
+  Serial.printf("\n=== END (%lu pages + %u bytes pending) ===\n", (unsigned long)pages, (unsigned)pending);
+}
+
+void getLogStorageStats(LogStorageStats* out) {
+  if (!out) return;
+  memset(out, 0, sizeof(*out));
+  if (!mounted || !lockStorage()) return;
+  
+  out->ready = true;
+  out->partitionBytes = ring.partition->size;
+  out->pages = ring.pageCount;
+  out->recoveredPages = ring.stats.recoveredPages;
+  out->corruptPages = ring.stats.corruptPages;
+  out->recoveryMs = ring.stats.recoveryMs;
+  out->records = statRecords;
+  out->recordBytes = statRecordBytes;
+  out->droppedRecords = statDropped;
+  out->pagesWritten = ring.stats.pagesWritten;
+  out->sectorErases = ring.stats.sectorErases;
+  out->skippedPages = ring.stats.skippedPages;
+  out->writeErrors = ring.stats.writeErrors;
+  flashRingEraseCounts(&ring, &out->minEraseCount, &out->maxEraseCount);
+  uint32_t pageCount = ring.pageCount;
+  unlockStorage();
+  
+  // One page per lock, as in dumpLogStorage(), so the logger is never held
+  // up for a whole scan; pages written meanwhile may or may not be counted
+  for (uint32_t page = 0; page < pageCount; page++) {
+    FlashPageHeader header;
+    if (!lockStorage()) break;
+    FlashPageState state = flashRingRead(&ring, page, scanBuffer, &header);
+    uint32_t marker = eraseMarker;
+    unlockStorage();
+    
+    if (state != FLASH_PAGE_VALID || (header.flags & LOG_PAGE_FLAG_ERASE) || header.sequence <= marker) {
+      continue;
+    }
+    if (out->storedPages == 0 || header.sequence < out->oldestSequence) out->oldestSequence = header.sequence;
+    if (header.sequence > out->newestSequence) out->newestSequence = header.sequence;
+    out->storedPages++;
+  }
+}
+
+void printLogStorageStats() {
+  LogStorageStats s;
+  getLogStorageStats(&s);
+  if (!s.ready) {
+    Serial.println("Log storage: not available");
+    return;
+  }
+  
+  Serial.printf("Log storage: %lu/%lu pages stored (seq %lu..%lu), %u bytes pending\n",
+                (unsigned long)s.storedPages, (unsigned long)s.pages,
+                (unsigned long)s.oldestSequence, (unsigned long)s.newestSequence, (unsigned)pageUsed);
+  Serial.printf("Log storage writes: %lu records, %lu pages, %lu erases, %lu dropped, %lu errors\n",
+                (unsigned long)s.records, (unsigned long)s.pagesWritten, (unsigned long)s.sectorErases,
+                (unsigned long)s.droppedRecords, (unsigned long)s.writeErrors);
+  Serial.printf("Log storage wear: sector erases %lu..%lu of %lu; boot scan %lu valid, %lu corrupt in %lu ms\n",
+                (unsigned long)s.minEraseCount, (unsigned long)s.maxEraseCount,
+                (unsigned long)FLASH_RING_ENDURANCE, (unsigned long)s.recoveredPages,
+                (unsigned long)s.corruptPages, (unsigned long)s.recoveryMs);
+}
@@ -1,6 +1,6 @@
 /**
  * Logger.cpp - Logging and telemetry abstraction implementation
- * Version: 2.0.0
+ * Version: 2.2.0
  * 
  * Copyright (C) 2025 Michael Garcia, M&E Design
  * Based on original .ino by Geoff Mcintyre of Mr.Industries (https://mr.industries/)
@@ -20,7 +20,15 @@
  */
 
 #include "Logger.h"
+#include "LogFrame.h"
+#include "LogStorage.h"
+#include "freertos/FreeRTOS.h"
+#include "freertos/task.h"
+#include "freertos/semphr.h"
 #include <stdarg.h>
+#include <stddef.h>
+#include <string.h>
+#include <atomic>
 
 // -----------------------------------------------------------------------------
 // Internal logger state
@@ -28,10 +36,7 @@
 
 static LogLevel currentLogLevel = LOG_DEFAULT_LEVEL;
 static uint8_t  activeSinks     = LOG_DEFAULT_SINKS;
-
-// Single shared buffer for formatted log lines.
-// NOTE: Not thread/task-safe if used concurrently from multiple tasks.
-static char logBuffer[LOG_BUFFER_SIZE];
+static LogOutputFormat outputFormat = LOG_DEFAULT_OUTPUT;
 
 // Log level string representations for output formatting.
 // Assumes LogLevel is ordered: DEBUG, INFO, WARN, ERROR, CRITICAL.
@@ -41,157 +46,723 @@ static const char* logLevelStrings[] = {
 
 static const int LOG_LEVEL_COUNT = sizeof(logLevelStrings) / sizeof(logLevelStrings[0]);
 
+/**
+ * One log call, captured without formatting.
+ *
+ * The format pointer must stay valid (string literals do) and formatId is
+ * its logFormatId(), computed at the call site; arguments are
+ * packed in format order: integers and pointers as 8 bytes, floating point
+ * as a double, strings copied inline with their terminator.
+ */
+struct LogRecord {
+    uint32_t timestamp;
+    uint8_t level;
+    uint8_t truncated;
+    uint16_t argBytes;
+    uint32_t formatId;
+    const char* format;
+    uint8_t args[LOG_RECORD_ARG_BYTES];
+};
+
+// Bounded MPSC ring (Vyukov): each slot's sequence number tells producers
+// whether it is free and the consumer whether it is filled, so producers
+// only contend on one compare-and-swap of enqueuePos.
+struct LogSlot {
+    std::atomic<uint32_t> sequence;
+    LogRecord record;
+};
+
+static_assert((LOG_QUEUE_DEPTH & (LOG_QUEUE_DEPTH - 1)) == 0, "LOG_QUEUE_DEPTH must be a power of two");
+
+static LogSlot logRing[LOG_QUEUE_DEPTH];
+static std::atomic<uint32_t> enqueuePos{0};
+static uint32_t dequeuePos = 0;  // Logger task only
+static std::atomic<uint32_t> writtenCount{0};
+
+static TaskHandle_t loggerTaskHandle = NULL;
+static SemaphoreHandle_t loggerWake = NULL;
+
+static std::atomic<uint32_t> statQueued{0};
+static std::atomic<uint32_t> statDropped{0};
+static std::atomic<uint32_t> statTruncated{0};
+static std::atomic<uint32_t> statHighWater{0};
+static std::atomic<uint32_t> statMaxEnqueueUs{0};
+static std::atomic<uint32_t> statBytesOut{0};
+
+static void atomicMax(std::atomic<uint32_t>& target, uint32_t value) {
+    uint32_t current = target.load(std::memory_order_relaxed);
+    while (value > current &&
+           !target.compare_exchange_weak(current, value, std::memory_order_relaxed)) {
+    }
+}
+
 // -----------------------------------------------------------------------------
-// Internal helper: core formatting logic (va_list-based)
+// Format string walking (shared by packing and formatting)
 // -----------------------------------------------------------------------------
 
+enum LogArgKind {
+    ARG_NONE,       // "%%"
+    ARG_SIGNED,
+    ARG_UNSIGNED,
+    ARG_DOUBLE,
+    ARG_STRING,
+    ARG_POINTER,
+    ARG_INVALID     // Unsupported conversion, stop here
+};
+
+// Length modifiers, needed to pull the right type off the va_list
+enum LogArgSize { SIZE_INT, SIZE_CHAR, SIZE_SHORT, SIZE_LONG, SIZE_LONG_LONG, SIZE_SIZE_T, SIZE_LONG_DOUBLE };
+
+struct LogSpec {
+    const char* start;  // '%'
+    const char* end;    // One past the conversion character
+    LogArgKind kind;
+    LogArgSize size;
+    int starCount;      // '*' width/precision arguments preceding the value
+};
+
 /**
- * Internal var-arg logging core.
- *
- * - Clamps level to valid range before indexing logLevelStrings
- * - Checks for prefix truncation before calling vsnprintf
- * - Writes into logBuffer and outputs to all configured sinks
+ * Parse the conversion specification starting at '%'.
  */
-static void vlogMessage(LogLevel level, const char* format, va_list args) {
-    if (!format) {
-        return;
+static void parseSpec(const char* p, LogSpec* spec) {
+    spec->start = p++;
+    spec->starCount = 0;
+    spec->size = SIZE_INT;
+
+    while (*p && strchr("-+ #0", *p)) p++;
+    if (*p == '*') { spec->starCount++; p++; }
+    while (*p >= '0' && *p <= '9') p++;
+    if (*p == '.') {
+        p++;
+        if (*p == '*') { spec->starCount++; p++; }
+        while (*p >= '0' && *p <= '9') p++;
     }
 
-    // Filter by current level (safety double-check; wrappers do this too)
-    if (level < currentLogLevel) {
-        return;
+    if (*p == 'h') {
+        p++;
+        spec->size = SIZE_SHORT;
+        if (*p == 'h') { p++; spec->size = SIZE_CHAR; }
+    } else if (*p == 'l') {
+        p++;
+        spec->size = SIZE_LONG;
+        if (*p == 'l') { p++; spec->size = SIZE_LONG_LONG; }
+    } else if (*p == 'z' || *p == 'j' || *p == 't') {
+        spec->size = (*p == 'j') ? SIZE_LONG_LONG : SIZE_SIZE_T;
+        p++;
+    } else if (*p == 'L') {
+        p++;
+        spec->size = SIZE_LONG_DOUBLE;
+    }
+
+    switch (*p) {
+        case '%': spec->kind = ARG_NONE; break;
+        case 'd': case 'i': case 'c': spec->kind = ARG_SIGNED; break;
+        case 'u': case 'x': case 'X': case 'o': spec->kind = ARG_UNSIGNED; break;
+        case 'f': case 'F': case 'e': case 'E': case 'g': case 'G': case 'a': case 'A':
+            spec->kind = ARG_DOUBLE; break;
+        case 's': spec->kind = ARG_STRING; break;
+        case 'p': spec->kind = ARG_POINTER; break;
+        default: spec->kind = ARG_INVALID; return;
+    }
+    spec->end = p + 1;
+}
+
+// -----------------------------------------------------------------------------
+// Caller side: pack arguments into a record
+// -----------------------------------------------------------------------------
+
+static bool packBytes(LogRecord* record, const void* data, size_t length) {
+    if (record->argBytes + length > LOG_RECORD_ARG_BYTES) {
+        record->truncated = 1;
+        return false;
+    }
+    memcpy(&record->args[record->argBytes], data, length);
+    record->argBytes += (uint16_t)length;
+    return true;
+}
+
+static bool packInteger(LogRecord* record, LogArgKind kind, LogArgSize size, va_list* args) {
+    uint64_t value;
+    if (kind == ARG_SIGNED) {
+        int64_t v;
+        switch (size) {
+            case SIZE_LONG: v = va_arg(*args, long); break;
+            case SIZE_LONG_LONG: v = va_arg(*args, long long); break;
+            case SIZE_SIZE_T: v = (int64_t)va_arg(*args, size_t); break;
+            default: v = va_arg(*args, int); break;
+        }
+        value = (uint64_t)v;
+    } else {
+        switch (size) {
+            case SIZE_LONG: value = va_arg(*args, unsigned long); break;
+            case SIZE_LONG_LONG: value = va_arg(*args, unsigned long long); break;
+            case SIZE_SIZE_T: value = va_arg(*args, size_t); break;
+            default: value = va_arg(*args, unsigned int); break;
+        }
+    }
+    return packBytes(record, &value, sizeof(value));
+}
+
+/**
+ * Capture a log call into a stack-local record. Stops at the first
+ * argument that does not fit and marks the record truncated; the
+ * formatter then prints the rest of the format without arguments.
+ */
+static void packRecord(LogRecord* record, LogLevel level, uint32_t formatId, const char* format,
+                       va_list args) {
+    record->timestamp = millis();
+    record->level = (uint8_t)level;
+    record->truncated = 0;
+    record->argBytes = 0;
+    record->formatId = formatId;
+    record->format = format;
+
+    va_list ap;
+    va_copy(ap, args);
+    for (const char* p = format; *p; p++) {
+        if (*p != '%') continue;
+
+        LogSpec spec;
+        parseSpec(p, &spec);
+        if (spec.kind == ARG_INVALID) break;
+        p = spec.end - 1;
+
+        bool ok = true;
+        for (int i = 0; i < spec.starCount && ok; i++) {
+            ok = packInteger(record, ARG_SIGNED, SIZE_INT, &ap);
+        }
+        if (!ok) break;
+
+        switch (spec.kind) {
+            case ARG_SIGNED:
+            case ARG_UNSIGNED:
+                ok = packInteger(record, spec.kind, spec.size, &ap);
+                break;
+            case ARG_DOUBLE: {
+                double value = (spec.size == SIZE_LONG_DOUBLE) ? (double)va_arg(ap, long double)
+                                                               : va_arg(ap, double);
+                ok = packBytes(record, &value, sizeof(value));
+                break;
+            }
+            case ARG_POINTER: {
+                uint64_t value = (uint64_t)(uintptr_t)va_arg(ap, void*);
+                ok = packBytes(record, &value, sizeof(value));
+                break;
+            }
+            case ARG_STRING: {
+                const char* str = va_arg(ap, const char*);
+                if (!str) str = "(null)";
+                size_t room = LOG_RECORD_ARG_BYTES - record->argBytes;
+                size_t length = strnlen(str, room);
+                if (length >= room) {
+                    // Keep what fits so long details are cut rather than lost
+                    record->truncated = 1;
+                    if (room == 0) { ok = false; break; }
+                    length = room - 1;
+                }
+                memcpy(&record->args[record->argBytes], str, length);
+                record->args[record->argBytes + length] = '\0';
+                record->argBytes += (uint16_t)(length + 1);
+                break;
+            }
+            default:
+                break;
+        }
+        if (!ok) break;
     }
+    va_end(ap);
+}
+
+// -----------------------------------------------------------------------------
+// Logger task side: format a record
+// -----------------------------------------------------------------------------
 
-    // Clamp level to a safe range for indexing
-    int lvl = static_cast<int>(level);
+static uint64_t readU64(const LogRecord* record, size_t* pos) {
+    uint64_t value = 0;
+    if (*pos + sizeof(value) <= record->argBytes) {
+        memcpy(&value, &record->args[*pos], sizeof(value));
+    }
+    *pos += sizeof(value);
+    return value;
+}
+
+/**
+ * Rebuild the message text. Each conversion is rendered on its own with
+ * the length modifier normalized to the packed type, so the output is the
+ * same as formatting the original call with vsnprintf.
+ */
+static size_t formatRecord(const LogRecord* record, char* buffer, size_t bufferSize) {
+    int lvl = record->level;
     if (lvl < 0 || lvl >= LOG_LEVEL_COUNT) {
         lvl = static_cast<int>(LOG_ERROR);  // Fallback to ERROR label
     }
 
-    // Timestamp + level prefix
-    unsigned long timestamp = millis();
-    int prefixLen = snprintf(
-        logBuffer,
-        LOG_BUFFER_SIZE,
-        "[%lu] %s: ",
-        timestamp,
-        logLevelStrings[lvl]
-    );
+    int prefixLen = snprintf(buffer, bufferSize, "[%lu] %s: ",
+                             (unsigned long)record->timestamp, logLevelStrings[lvl]);
+    if (prefixLen < 0 || prefixLen >= (int)bufferSize) {
+        return 0;
+    }
 
-    // If prefix didn't fit or error occurred, bail out
-    if (prefixLen < 0 || prefixLen >= (int)LOG_BUFFER_SIZE) {
-        return;
+    size_t out = (size_t)prefixLen;
+    size_t pos = 0;
+    const char* p = record->format;
+
+    while (*p && out < bufferSize - 1) {
+        if (*p != '%') {
+            buffer[out++] = *p++;
+            continue;
+        }
+
+        LogSpec spec;
+        parseSpec(p, &spec);
+        if (spec.kind == ARG_INVALID) break;
+        p = spec.end;
+        if (spec.kind == ARG_NONE) {
+            buffer[out++] = '%';
+            continue;
+        }
+        if (pos >= record->argBytes) {
+            continue;  // Argument was truncated away
+        }
+
+        // Copy flags/width/precision, drop the length modifier and append
+        // the one matching the packed type
+        char fmt[24];
+        size_t fmtLen = 0;
+        char conversion = spec.end[-1];
+        for (const char* q = spec.start; q < spec.end - 1 && fmtLen < sizeof(fmt) - 4; q++) {
+            if (!strchr("hlzjtL", *q)) fmt[fmtLen++] = *q;
+        }
+
+        int star[2] = {0, 0};
+        for (int i = 0; i < spec.starCount; i++) {
+            star[i] = (int)(int64_t)readU64(record, &pos);
+        }
+
+        size_t room = bufferSize - out;
+        int written = 0;
+        switch (spec.kind) {
+            case ARG_SIGNED:
+            case ARG_UNSIGNED: {
+                uint64_t value = readU64(record, &pos);
+                if (conversion != 'c') { fmt[fmtLen++] = 'l'; fmt[fmtLen++] = 'l'; }
+                fmt[fmtLen++] = conversion;
+                fmt[fmtLen] = '\0';
+                if (conversion == 'c') {
+                    written = spec.starCount == 2 ? snprintf(&buffer[out], room, fmt, star[0], star[1], (int)value)
+                            : spec.starCount == 1 ? snprintf(&buffer[out], room, fmt, star[0], (int)value)
+                            : snprintf(&buffer[out], room, fmt, (int)value);
+                } else if (spec.kind == ARG_SIGNED) {
+                    long long v = (long long)value;
+                    written = spec.starCount == 2 ? snprintf(&buffer[out], room, fmt, star[0], star[1], v)
+                            : spec.starCount == 1 ? snprintf(&buffer[out], room, fmt, star[0], v)
+                            : snprintf(&buffer[out], room, fmt, v);
+                } else {
+                    unsigned long long v = (unsigned long long)value;
+                    written = spec.starCount == 2 ? snprintf(&buffer[out], room, fmt, star[0], star[1], v)
+                            : spec.starCount == 1 ? snprintf(&buffer[out], room, fmt, star[0], v)
+                            : snprintf(&buffer[out], room, fmt, v);
+                }
+                break;
+            }
+            case ARG_DOUBLE: {
+                uint64_t bits = readU64(record, &pos);
+                double v;
+                memcpy(&v, &bits, sizeof(v));
+                fmt[fmtLen++] = conversion;
+                fmt[fmtLen] = '\0';
+                written = spec.starCount == 2 ? snprintf(&buffer[out], room, fmt, star[0], star[1], v)
+                        : spec.starCount == 1 ? snprintf(&buffer[out], room, fmt, star[0], v)
+                        : snprintf(&buffer[out], room, fmt, v);
+                break;
+            }
+            case ARG_POINTER: {
+                void* v = (void*)(uintptr_t)readU64(record, &pos);
+                fmt[fmtLen++] = 'p';
+                fmt[fmtLen] = '\0';
+                written = snprintf(&buffer[out], room, fmt, v);
+                break;
+            }
+            case ARG_STRING: {
+                const char* v = (const char*)&record->args[pos];
+                pos += strnlen(v, record->argBytes - pos) + 1;
+                fmt[fmtLen++] = 's';
+                fmt[fmtLen] = '\0';
+                written = spec.starCount == 2 ? snprintf(&buffer[out], room, fmt, star[0], star[1], v)
+                        : spec.starCount == 1 ? snprintf(&buffer[out], room, fmt, star[0], v)
+                        : snprintf(&buffer[out], room, fmt, v);
+                break;
+            }
+            default:
+                break;
+        }
+        if (written > 0) {
+            out += ((size_t)written < room) ? (size_t)written : room - 1;
+        }
     }
 
-    // Format user message into remaining buffer space
-    vsnprintf(
-        logBuffer + prefixLen,
-        LOG_BUFFER_SIZE - (size_t)prefixLen,
-        format,
-        args
-    );
+    buffer[out] = '\0';
+    return out;
+}
+
+/**
+ * Binary encoding: same walk over the format as formatRecord(), but the
+ * packed arguments are re-encoded as varints instead of being rendered.
+ * Returns the framed wire length, or 0 if the record does not fit.
+ */
+static size_t encodeRecord(const LogRecord* record, uint8_t* out, size_t outSize) {
+    uint8_t payload[LOG_FRAME_MAX_PAYLOAD];
+    const size_t limit = sizeof(payload) - 2;  // Room for the CRC
+    size_t n = 0;
+
+    uint32_t id = record->formatId;
+    payload[n++] = LOG_FRAME_MAGIC;
+    for (int i = 0; i < 4; i++) payload[n++] = (uint8_t)(id >> (8 * i));
+    payload[n++] = (uint8_t)(record->level | (record->truncated ? LOG_FRAME_TRUNCATED : 0));
+    n += logPutVarint(&payload[n], limit - n, record->timestamp);
+
+    size_t pos = 0;
+    for (const char* p = record->format; *p && pos < record->argBytes; p++) {
+        if (*p != '%') continue;
+
+        LogSpec spec;
+        parseSpec(p, &spec);
+        if (spec.kind == ARG_INVALID) break;
+        p = spec.end - 1;
+
+        size_t written = 0;
+        for (int i = 0; i < spec.starCount; i++) {
+            written = logPutZigzag(&payload[n], limit - n, (int64_t)readU64(record, &pos));
+            if (!written) return 0;
+            n += written;
+        }
+
+        switch (spec.kind) {
+            case ARG_SIGNED:
+                written = logPutZigzag(&payload[n], limit - n, (int64_t)readU64(record, &pos));
+                break;
+            case ARG_UNSIGNED:
+            case ARG_POINTER:
+                written = logPutVarint(&payload[n], limit - n, readU64(record, &pos));
+                break;
+            case ARG_DOUBLE: {
+                uint64_t bits = readU64(record, &pos);
+                double v;
+                memcpy(&v, &bits, sizeof(v));
+                float f = (float)v;
+                if (limit - n < sizeof(f)) return 0;
+                memcpy(&payload[n], &f, sizeof(f));
+                written = sizeof(f);
+                break;
+            }
+            case ARG_STRING: {
+                const char* v = (const char*)&record->args[pos];
+                size_t length = strnlen(v, record->argBytes - pos);
+                pos += length + 1;
+                written = logPutVarint(&payload[n], limit - n, length);
+                if (!written || limit - n - written < length) return 0;
+                memcpy(&payload[n + written], v, length);
+                written += length;
+                break;
+            }
+            default:
+                continue;  // "%%" carries no argument
+        }
+        if (!written) return 0;
+        n += written;
+    }
+
+    return logFrameWrap(payload, n, out, outSize);
+}
+
+static void writeRecord(const LogRecord* record) {
+    // Encode and format lazily; both sinks reuse the result
+    uint8_t frame[LOG_FRAME_MAX_ENCODED];
+    size_t frameLength = 0;
+    bool binarySerial = (activeSinks & SINK_SERIAL) && outputFormat == LOG_OUTPUT_BINARY;
+    if (binarySerial || (activeSinks & SINK_STORAGE)) {
+        // Records too large for a frame fall back to text
+        frameLength = encodeRecord(record, frame, sizeof(frame));
+    }
+    char line[LOG_BUFFER_SIZE];
+    size_t lineLength = 0;
+    if (!frameLength || ((activeSinks & SINK_SERIAL) && !binarySerial)) {
+        lineLength = formatRecord(record, line, sizeof(line));
+    }
 
     // Output to active sinks
     if (activeSinks & SINK_SERIAL) {
-        Serial.println(logBuffer);
+        size_t length;
+        if (binarySerial && frameLength) {
+            Serial.write(frame, frameLength);
+            length = frameLength;
+        } else {
+            Serial.println(line);
+            length = lineLength + 2;  // CRLF
+        }
+        statBytesOut.fetch_add(length, std::memory_order_relaxed);
+    }
+
+    // Storage always keeps the compact frame; text lines stay decodable
+    // because tools/logdecode.py passes text through
+    if (activeSinks & SINK_STORAGE) {
+        if (frameLength) {
+            logStorageAppend(frame, frameLength);
+        } else {
+            if (lineLength > LOG_STORAGE_PAYLOAD_SIZE - 1) {
+                lineLength = LOG_STORAGE_PAYLOAD_SIZE - 1;
+            }
+            line[lineLength] = '\n';
+            logStorageAppend((const uint8_t*)line, lineLength + 1);
+        }
     }
 
     // Future:
-    // if (activeSinks & SINK_NETWORK) { sendToNetwork(logBuffer); }
-    // if (activeSinks & SINK_STORAGE) { writeToStorage(logBuffer); }
+    // if (activeSinks & SINK_NETWORK) { sendToNetwork(line); }
 }
 
 // -----------------------------------------------------------------------------
-// Public API
+// Ring operations
 // -----------------------------------------------------------------------------
 
-void initLogger(LogLevel minLevel, uint8_t sinks) {
-    currentLogLevel = minLevel;
-    activeSinks     = sinks;
+static bool pushRecord(const LogRecord* record) {
+    uint32_t pos = enqueuePos.load(std::memory_order_relaxed);
+    LogSlot* slot;
+    while (true) {
+        slot = &logRing[pos & (LOG_QUEUE_DEPTH - 1)];
+        uint32_t seq = slot->sequence.load(std::memory_order_acquire);
+        int32_t diff = (int32_t)(seq - pos);
+        if (diff == 0) {
+            if (enqueuePos.compare_exchange_weak(pos, pos + 1, std::memory_order_relaxed)) {
+                break;
+            }
+        } else if (diff < 0) {
+            return false;  // Full
+        } else {
+            pos = enqueuePos.load(std::memory_order_relaxed);
+        }
+    }
 
-    // Serial sink is assumed to be initialized elsewhere (e.g. setup/main)
-    // Future: initialize network / storage sinks here as needed.
+    memcpy(&slot->record, record, offsetof(LogRecord, args) + record->argBytes);
+    slot->sequence.store(pos + 1, std::memory_order_release);
+
+    uint32_t depth = pos + 1 - writtenCount.load(std::memory_order_relaxed);
+    atomicMax(statHighWater, depth);
+    return true;
 }
 
-void setLogLevel(LogLevel level) {
-    currentLogLevel = level;
+static bool popRecord(LogRecord* record) {
+    LogSlot* slot = &logRing[dequeuePos & (LOG_QUEUE_DEPTH - 1)];
+    if (slot->sequence.load(std::memory_order_acquire) != dequeuePos + 1) {
+        return false;
+    }
+    memcpy(record, &slot->record, sizeof(LogRecord));
+    slot->sequence.store(dequeuePos + LOG_QUEUE_DEPTH, std::memory_order_release);
+    dequeuePos++;
+    return true;
 }
 
-void setLogSinks(uint8_t sinks) {
-    activeSinks = sinks;
+static void loggerTask(void* parameter) {
+    LogRecord record;
+    uint32_t waitMs = UINT32_MAX;
+    while (true) {
+        // Sleeps until a record arrives or the storage page is due
+        xSemaphoreTake(loggerWake, waitMs == UINT32_MAX ? portMAX_DELAY : pdMS_TO_TICKS(waitMs));
+        while (popRecord(&record)) {
+            writeRecord(&record);
+            writtenCount.fetch_add(1, std::memory_order_release);
+        }
+        waitMs = pollLogStorage();
+    }
 }
 
+// -----------------------------------------------------------------------------
+// Internal helper: capture logic (va_list-based)
+// -----------------------------------------------------------------------------
+
 /**
- * Core logging entry point (printf-style)
+ * Internal var-arg logging core.
+ *
+ * - Captures the call into a stack-local record; no formatting or I/O
+ * - Pushes it to the logger task, counting a drop if the ring is full
+ * - Before the logger task exists the record is written directly
  */
-void logMessage(LogLevel level, const char* format, ...) {
-    // Filter early to avoid building messages we won't print
+static void vlogMessage(LogLevel level, uint32_t formatId, const char* format, va_list args) {
+    if (!format) {
+        return;
+    }
+
+    // Filter by current level (safety double-check; wrappers do this too)
     if (level < currentLogLevel) {
         return;
     }
 
-    va_list args;
-    va_start(args, format);
-    vlogMessage(level, format, args);
-    va_end(args);
+    uint32_t start = ESP.getCycleCount();
+
+    LogRecord record;
+    packRecord(&record, level, formatId, format, args);
+    if (record.truncated) {
+        statTruncated.fetch_add(1, std::memory_order_relaxed);
+    }
+
+    if (!loggerTaskHandle) {
+        writeRecord(&record);
+        return;
+    }
+
+    if (pushRecord(&record)) {
+        statQueued.fetch_add(1, std::memory_order_relaxed);
+        xSemaphoreGive(loggerWake);
+    } else {
+        statDropped.fetch_add(1, std::memory_order_relaxed);
+    }
+
+    atomicMax(statMaxEnqueueUs, (ESP.getCycleCount() - start) / ESP.getCpuFreqMHz());
 }
 
 // -----------------------------------------------------------------------------
-// Level-specific convenience wrappers
+// Public API
 // -----------------------------------------------------------------------------
 
-void logDebug(const char* format, ...) {
-    if (LOG_DEBUG < currentLogLevel) {
+// Mount the flash log ring; the sink is dropped if there is no partition
+static void startStorageSink() {
+    if (!(activeSinks & SINK_STORAGE) || logStorageReady()) {
+        return;
+    }
+    if (!initLogStorage()) {
+        activeSinks &= ~SINK_STORAGE;
+        Serial.println("WARNING: No log storage partition - storage sink disabled");
         return;
     }
 
-    va_list args;
-    va_start(args, format);
-    vlogMessage(LOG_DEBUG, format, args);
-    va_end(args);
+    LogStorageStats stats;
+    getLogStorageStats(&stats);
+    logInfo("Log storage: %lu pages recovered, %lu corrupt in %lu ms, newest seq %lu",
+            (unsigned long)stats.recoveredPages, (unsigned long)stats.corruptPages,
+            (unsigned long)stats.recoveryMs, (unsigned long)stats.newestSequence);
 }
 
-void logInfo(const char* format, ...) {
-    if (LOG_INFO < currentLogLevel) {
+void initLogger(LogLevel minLevel, uint8_t sinks) {
+    currentLogLevel = minLevel;
+    activeSinks     = sinks;
+
+    // Serial sink is assumed to be initialized elsewhere (e.g. setup/main)
+    // Future: initialize the network sink here as needed.
+    startStorageSink();
+
+    if (loggerTaskHandle) {
         return;
     }
 
-    va_list args;
-    va_start(args, format);
-    vlogMessage(LOG_INFO, format, args);
-    va_end(args);
+    for (uint32_t i = 0; i < LOG_QUEUE_DEPTH; i++) {
+        logRing[i].sequence.store(i, std::memory_order_relaxed);
+    }
+
+    loggerWake = xSemaphoreCreateBinary();
+    if (!loggerWake ||
+        xTaskCreate(loggerTask, "LoggerTask", LOGGER_TASK_STACK, NULL,
+                    LOGGER_TASK_PRIORITY, &loggerTaskHandle) != pdPASS) {
+        // Stay in direct mode; output is still correct, just not deferred
+        loggerTaskHandle = NULL;
+        Serial.println("WARNING: Logger task not started - logging synchronously");
+    }
+}
+
+void setLogLevel(LogLevel level) {
+    currentLogLevel = level;
+}
+
+void setLogSinks(uint8_t sinks) {
+    activeSinks = sinks;
+    startStorageSink();
+}
+
+void setLogOutputFormat(LogOutputFormat format) {
+    // Switch only between records so a frame is never split
+    flushLogger();
+    outputFormat = format;
 }
 
-void logWarn(const char* format, ...) {
-    if (LOG_WARN < currentLogLevel) {
+LogOutputFormat getLogOutputFormat() {
+    return outputFormat;
+}
+
+const char* logOutputFormatName(LogOutputFormat format) {
+    return format == LOG_OUTPUT_BINARY ? "binary" : "text";
+}
+
+void flushLogger(uint32_t timeoutMs) {
+    if (!loggerTaskHandle) {
         return;
     }
+    uint32_t target = enqueuePos.load(std::memory_order_acquire);
+    unsigned long start = millis();
+    while ((int32_t)(writtenCount.load(std::memory_order_acquire) - target) < 0 &&
+           millis() - start < timeoutMs) {
+        xSemaphoreGive(loggerWake);
+        vTaskDelay(pdMS_TO_TICKS(1));
+    }
+}
+
+void getLoggerStats(LoggerStats* stats) {
+    if (!stats) return;
+    stats->queued = statQueued.load(std::memory_order_relaxed);
+    stats->written = writtenCount.load(std::memory_order_relaxed);
+    stats->dropped = statDropped.load(std::memory_order_relaxed);
+    stats->truncated = statTruncated.load(std::memory_order_relaxed);
+    stats->highWater = statHighWater.load(std::memory_order_relaxed);
+    stats->maxEnqueueUs = statMaxEnqueueUs.load(std::memory_order_relaxed);
+    stats->bytesOut = statBytesOut.load(std::memory_order_relaxed);
+}
+
+void printLoggerStats() {
+    LoggerStats stats;
+    getLoggerStats(&stats);
+    Serial.printf("Logger: queued %lu, written %lu, dropped %lu, truncated %lu\n",
+                  (unsigned long)stats.queued, (unsigned long)stats.written,
+                  (unsigned long)stats.dropped, (unsigned long)stats.truncated);
+    Serial.printf("Logger ring: high water %lu/%u records, max log call %lu us\n",
+                  (unsigned long)stats.highWater, LOG_QUEUE_DEPTH, (unsigned long)stats.maxEnqueueUs);
+    Serial.printf("Logger output: %s, %lu bytes\n",
+                  logOutputFormatName(outputFormat), (unsigned long)stats.bytesOut);
+}
 
+void measureLogEncodingWithId(size_t* textBytes, size_t* binaryBytes, uint32_t formatId, const char* format, ...) {
+    LogRecord record;
     va_list args;
     va_start(args, format);
-    vlogMessage(LOG_WARN, format, args);
+    packRecord(&record, LOG_INFO, formatId, format, args);
     va_end(args);
-}
 
-void logError(const char* format, ...) {
-    if (LOG_ERROR < currentLogLevel) {
-        return;
-    }
+    char line[LOG_BUFFER_SIZE];
+    uint8_t frame[LOG_FRAME_MAX_ENCODED];
+    if (textBytes) *textBytes = formatRecord(&record, line, sizeof(line)) + 2;  // CRLF
+    if (binaryBytes) *binaryBytes = encodeRecord(&record, frame, sizeof(frame));
+}
 
+size_t encodeLogMessageWithId(uint8_t* frame, size_t frameSize, LogLevel level, uint32_t formatId,
+                              const char* format, ...) {
+    LogRecord record;
     va_list args;
     va_start(args, format);
-    vlogMessage(LOG_ERROR, format, args);
+    packRecord(&record, level, formatId, format, args);
     va_end(args);
+    return encodeRecord(&record, frame, frameSize);
 }
 
-void logCritical(const char* format, ...) {
-    if (LOG_CRITICAL < currentLogLevel) {
+/**
+ * Core logging entry point (printf-style); logDebug() .. logCritical()
+ * and logMessage() expand to it with the format id of their call site
+ */
+void logMessageWithId(LogLevel level, uint32_t formatId, const char* format, ...) {
+    // Filter early to avoid building messages we won't print
+    if (level < currentLogLevel) {
         return;
     }
 
     va_list args;
     va_start(args, format);
-    vlogMessage(LOG_CRITICAL, format, args);
+    vlogMessage(level, formatId, format, args);
     va_end(args);
 }
 
@@ -199,13 +770,22 @@ void logCritical(const char* format, ...) {
 // Structured helpers
 // -----------------------------------------------------------------------------
 
-void logSensorData(int temp, float humidity, int lux, float distance) {
+// Fixed-point fields go into the record as integers; the Logger Task puts
+// the decimal point back, so the caller never formats a float
+void logSensorData(const SensorSample& sample) {
+    uint32_t temp = sample.temperatureCenti < 0 ? (uint32_t)-sample.temperatureCenti
+                                                : (uint32_t)sample.temperatureCenti;
     logInfo(
-        "SENSOR_DATA temp=%d humidity=%.1f lux=%d distance=%.2f",
-        temp,
-        humidity,
-        lux,
-        distance
+        "SENSOR_DATA temp=%s%u.%02u humidity=%u.%02u lux=%u distance=%u.%02u flags=0x%x",
+        sample.temperatureCenti < 0 ? "-" : "",
+        (unsigned)(temp / 100),
+        (unsigned)(temp % 100),
+        (unsigned)(sample.humidityCenti / 100),
+        (unsigned)(sample.humidityCenti % 100),
+        (unsigned)sample.lux,
+        (unsigned)(sample.distanceCenti / 100),
+        (unsigned)(sample.distanceCenti % 100),
+        (unsigned)sample.flags
     );
 }
 
@@ -21,44 +21,133 @@
 #include "NowLink.h"
 #include "GlobalContext.h"
 #include "Config.h"
+#include "PeerTable.h"
 #include "SensorDataAccess.h"
 #include "Tasks.h"
 #include "EventQueue.h"
+#include "History.h"
 #include "Logger.h"
+#include "SignalFilter.h"
 #include "freertos/FreeRTOS.h"
 #include "freertos/semphr.h"
+#include <atomic>
 #include <cstring>
 
-bool initializeNowSerial(uint8_t* mac) {
+namespace {
+#if ESP_IDF_VERSION_MAJOR >= 5
+  void onNowDataRecv(const esp_now_recv_info_t* info, const uint8_t* data, int len);
+#else
+  void onNowDataRecv(const uint8_t* mac, const uint8_t* data, int len);
+#endif
+}
+
+static bool registerNowPeer(const uint8_t* mac) {
+  if (esp_now_is_peer_exist(mac)) return true;
+
+  esp_now_peer_info_t peerInfo = {};
+  memcpy(peerInfo.peer_addr, mac, 6);
+  peerInfo.channel = ESPNOW_WIFI_CHANNEL;
+  peerInfo.ifidx = ESPNOW_WIFI_IF;
+  peerInfo.encrypt = false;
+
+  if (esp_now_add_peer(&peerInfo) != ESP_OK) {
+    char details[48];
+    snprintf(details, sizeof(details), "Failed to add peer %02X:%02X:%02X:%02X:%02X:%02X",
+             mac[0], mac[1], mac[2], mac[3], mac[4], mac[5]);
+    logNetworkEvent("ESP-NOW", "PEER_ADD_FAILED", details);
+    return false;
+  }
+  return true;
+}
+
+// WiFi is only powered while there are peers to listen for; with the radio
+// on, the WiFi driver's power lock keeps the chip out of light sleep
+static void startWifi() {
+  WiFi.mode(ESPNOW_WIFI_MODE);
+  esp_wifi_set_channel(ESPNOW_WIFI_CHANNEL, WIFI_SECOND_CHAN_NONE);
+}
+
+static void stopWifi() {
+  GlobalContext& ctx = getGlobalContext();
+  if (ctx.nowSerialActive) {
+    esp_now_deinit();
+    ctx.nowSerialActive = false;
+  }
+  WiFi.mode(WIFI_OFF);
+  logNetworkEvent("ESP-NOW", "WIFI_OFF", "No peers configured");
+}
+
+bool initializeNowSerial() {
   GlobalContext& ctx = getGlobalContext();
+  if (ctx.nowSerialActive) return true;
+  if (WiFi.getMode() == WIFI_OFF) startWifi();
   
   Serial.println("\n--- Initializing ESP-NOW ---");
   Serial.print("My WiFi Mode: ");
   Serial.println("Station");
-  Serial.print("Attempting to connect to peer: ");
-  printMacAddress(mac);
 
   if (esp_now_init() != ESP_OK) {
     logNetworkEvent("ESP-NOW", "INIT_FAILED", "ESP-NOW initialization failed");
     return false;
   }
 
-  esp_now_peer_info_t peerInfo;
-  memcpy(peerInfo.peer_addr, mac, 6);
-  peerInfo.channel = ESPNOW_WIFI_CHANNEL;
-  peerInfo.encrypt = false;
-
-  if (esp_now_add_peer(&peerInfo) != ESP_OK) {
-    logNetworkEvent("ESP-NOW", "PEER_ADD_FAILED", "Failed to add peer");
+  if (esp_now_register_recv_cb(onNowDataRecv) != ESP_OK) {
+    logNetworkEvent("ESP-NOW", "INIT_FAILED", "Failed to register receive callback");
     return false;
   }
 
-  logNetworkEvent("ESP-NOW", "CONNECTED", "Peer communication established");
-  setMacAddress(mac);
+  // Register every known peer with the stack
+  PeerState peers[PEER_TABLE_CAPACITY];
+  size_t count = snapshotPeers(peers, PEER_TABLE_CAPACITY);
+  size_t registered = 0;
+  for (size_t i = 0; i < count; i++) {
+    if (registerNowPeer(peers[i].mac)) registered++;
+  }
+
+  char details[32];
+  snprintf(details, sizeof(details), "Listening for %u/%u peers", (unsigned)registered, (unsigned)count);
+  logNetworkEvent("ESP-NOW", "CONNECTED", details);
   ctx.nowSerialActive = true;
   return true;
 }
 
+bool addNowPeer(const uint8_t* mac) {
+  if (!mac) return false;
+  if (addPeer(mac) < 0) {
+    logNetworkEvent("ESP-NOW", "PEER_ADD_FAILED", "Peer table full");
+    return false;
+  }
+  if (!savePeerTable()) return false;
+  
+  if (!getGlobalContext().nowSerialActive) {
+    return initializeNowSerial();
+  }
+  return registerNowPeer(mac);
+}
+
+bool removeNowPeer(const uint8_t* mac) {
+  if (!mac || !removePeer(mac)) return false;
+  if (getGlobalContext().nowSerialActive && esp_now_is_peer_exist(mac)) {
+    esp_now_del_peer(mac);
+  }
+  bool saved = savePeerTable();
+  if (peerCount() == 0 && WiFi.getMode() != WIFI_OFF) stopWifi();
+  return saved;
+}
+
+void clearNowPeers() {
+  if (getGlobalContext().nowSerialActive) {
+    PeerState peers[PEER_TABLE_CAPACITY];
+    size_t count = snapshotPeers(peers, PEER_TABLE_CAPACITY);
+    for (size_t i = 0; i < count; i++) {
+      if (esp_now_is_peer_exist(peers[i].mac)) esp_now_del_peer(peers[i].mac);
+    }
+  }
+  clearPeers();
+  savePeerTable();
+  if (WiFi.getMode() != WIFI_OFF) stopWifi();
+}
+
 void initializeNowFromEEPROM() {
   Serial.print("\nWiFi Mode: ");
   Serial.println("Station");
@@ -83,76 +172,247 @@ void initializeNowFromEEPROM() {
   Serial.println(WiFi.macAddress());
   Serial.println("========================\n");
 
-  uint8_t storedMac[6];
-  if (loadMacFromEEPROM(storedMac)) {
-    Serial.print("Loaded peer MAC from EEPROM: ");
-    printMacAddress(storedMac);
-    initializeNowSerial(storedMac);
+  initPeerTable();
+  loadPeerTable();
+
+  // Older firmware stored a single peer MAC; fold it into the table once
+  uint8_t legacyMac[6];
+  if (loadMacFromEEPROM(legacyMac)) {
+    Serial.print("Migrating legacy peer MAC from EEPROM: ");
+    printMacAddress(legacyMac);
+    if (addPeer(legacyMac) >= 0 && savePeerTable()) {
+      clearLegacyMacInEEPROM();
+    }
+  }
+
+  if (peerCount() > 0) {
+    Serial.printf("Loaded %u peer(s) from EEPROM\n", (unsigned)peerCount());
+    printPeerTable();
+    initializeNowSerial();
   } else {
-    Serial.println("No MAC address found in EEPROM");
+    Serial.println("No peers found in EEPROM");
+    stopWifi();
   }
 }
 
-bool parseDistance(const char* message, float* distance) {
-  if (!message || !distance) return false;
+bool parseNowReading(const char* message, NowReading* reading) {
+  if (!message || !reading) return false;
   
+  float maxValue;
   if (strncmp(message, "DIST:", 5) == 0) {
-    char* endPtr;
-    float val = strtof(message + 5, &endPtr);
-    if (*endPtr != '\0' && *endPtr != '\r' && *endPtr != '\n') return false;
-    if (val < 0 || val > 1000) return false;
-    *distance = val;
-    return true;
-  }
-  return false;
+    reading->kind = PEER_KIND_DISTANCE;
+    maxValue = 1000.0f;
+  } else if (strncmp(message, "SOIL:", 5) == 0) {
+    reading->kind = PEER_KIND_SOIL;
+    maxValue = 100.0f;
+  } else {
+    return false;
+  }
+  
+  char* endPtr;
+  float val = strtof(message + 5, &endPtr);
+  if (endPtr == message + 5 || val < 0 || val > maxValue) return false;
+  
+  // Optional ",<sequence>" suffix from nodes that number their readings
+  reading->hasSequence = false;
+  if (*endPtr == ',') {
+    const char* seqStart = endPtr + 1;
+    unsigned long seq = strtoul(seqStart, &endPtr, 10);
+    if (endPtr == seqStart || seq > 0xFFFF) return false;
+    reading->sequence = (uint16_t)seq;
+    reading->hasSequence = true;
+  }
+  
+  if (*endPtr != '\0' && *endPtr != '\r' && *endPtr != '\n') return false;
+  reading->value = val;
+  return true;
+}
+
+bool parseDistance(const char* message, float* distance) {
+  if (!distance) return false;
+  NowReading reading;
+  if (!parseNowReading(message, &reading) || reading.kind != PEER_KIND_DISTANCE) return false;
+  *distance = reading.value;
+  return true;
 }
 
 namespace {
-  constexpr int MAX_BYTES_PER_LOOP = 32;
-  constexpr char MIN_PRINTABLE = 32;
-  constexpr char MAX_PRINTABLE = 126;
+  constexpr uint32_t RX_RING_MASK = NOW_RX_RING_SIZE - 1;
+  constexpr uint32_t RX_RECORD_HEADER = 1 + 1 + 6;  // payload length + RSSI + source MAC
 
-  inline bool isPrintableNowChar(char c) {
-    return (c != '\r') && (c >= MIN_PRINTABLE) && (c <= MAX_PRINTABLE);
-  }
+  static_assert((NOW_RX_RING_SIZE & RX_RING_MASK) == 0, "NOW_RX_RING_SIZE must be a power of two");
+
+  /**
+   * Single-producer/single-consumer receive ring
+   *
+   * The ESP-NOW receive callback (WiFi task) is the only writer of rxHead and
+   * CommsTask the only writer of rxTail, so no lock is needed. Each record is
+   * [length][rssi][mac x6][payload][NUL] and is stored contiguously; a length byte
+   * of 0 marks unused space at the end of the ring. The consumer frames
+   * lines directly in the ring and only releases the records afterwards.
+   */
+  uint8_t rxRing[NOW_RX_RING_SIZE];
+  std::atomic<uint32_t> rxHead{0};
+  std::atomic<uint32_t> rxTail{0};
+  NowRxStats rxStats = {};
 
-  void handleCompleteNowLine(GlobalContext &ctx) {
-    if (ctx.receivedMessageLen == 0 ||
-        ctx.receivedMessageLen >= (int)sizeof(ctx.receivedMessageBuffer)) {
-      ctx.receivedMessageLen = 0;
+  // Applied to every DIST reading in CommsTask; configured in SignalFilter.h
+  DistanceFilter distanceFilter;
+
+  void enqueueFrame(const uint8_t* mac, int8_t rssi, const uint8_t* data, int len) {
+    if (!mac || !data || len <= 0 || len > NOW_MAX_FRAME_SIZE) {
+      rxStats.oversize++;
       return;
     }
 
-    ctx.receivedMessageBuffer[ctx.receivedMessageLen] = '\0';
+    uint32_t head = rxHead.load(std::memory_order_relaxed);
+    uint32_t tail = rxTail.load(std::memory_order_acquire);
+    uint32_t index = head & RX_RING_MASK;
+    uint32_t recordSize = RX_RECORD_HEADER + (uint32_t)len + 1;
+    uint32_t skip = (index + recordSize > NOW_RX_RING_SIZE) ? NOW_RX_RING_SIZE - index : 0;
 
-    float distance = 0.0f;
-    if (!parseDistance(ctx.receivedMessageBuffer, &distance)) {
-      ctx.receivedMessageLen = 0;
+    if ((head - tail) + skip + recordSize > NOW_RX_RING_SIZE) {
+      rxStats.dropped++;
       return;
     }
 
-    if (setSensorDistance(distance)) {
-      logNetworkEvent("ESP-NOW", "DISTANCE_RX", nullptr);
-      logDebug("Distance sensor updated: %.2f inches", distance);
-      
-      // Broadcast distance update event to other tasks (distance in cm * 100)
-      sendEvent(EVENT_DISTANCE_UPDATED, (uint32_t)(distance * 100));
+    if (skip) {
+      rxRing[index] = 0;
+      head += skip;
+      index = 0;
     }
 
-    ctx.receivedMessageLen = 0;
+    rxRing[index] = (uint8_t)len;
+    rxRing[index + 1] = (uint8_t)rssi;
+    memcpy(&rxRing[index + 2], mac, 6);
+    memcpy(&rxRing[index + RX_RECORD_HEADER], data, len);
+    rxRing[index + RX_RECORD_HEADER + len] = '\0';
+    head += recordSize;
+    rxHead.store(head, std::memory_order_release);
+
+    rxStats.frames++;
+    if (head - tail > rxStats.highWater) rxStats.highWater = head - tail;
+
+    // Wake CommsTask; coalesced, so a burst costs one queued notification
+    publishEvent(EVENT_NOW_RX_READY);
+  }
+
+#if ESP_IDF_VERSION_MAJOR >= 5
+  void onNowDataRecv(const esp_now_recv_info_t* info, const uint8_t* data, int len) {
+    if (!info) return;
+    enqueueFrame(info->src_addr, info->rx_ctrl ? (int8_t)info->rx_ctrl->rssi : PEER_RSSI_UNKNOWN, data, len);
+  }
+#else
+  // IDF 4.x does not report RSSI to the receive callback
+  void onNowDataRecv(const uint8_t* mac, const uint8_t* data, int len) {
+    enqueueFrame(mac, PEER_RSSI_UNKNOWN, data, len);
+  }
+#endif
+
+  // Split a NUL-terminated frame payload into lines in place and parse each
+  // one; a trailing line without '\n' counts as complete since ESP-NOW
+  // frames are never split.
+  //
+  // Readings go straight into the sender's peer table slot as received;
+  // distances are also passed through the distance filter and the newest
+  // one is returned, filtered, for the legacy single-distance fields.
+  bool handleNowFrame(const uint8_t* mac, int8_t rssi, char* payload, size_t length, uint16_t* latestDistance) {
+    bool updated = false;
+    char* line = payload;
+    char* end = payload + length;
+
+    while (line < end) {
+      char* newline = (char*)memchr(line, '\n', end - line);
+      char* lineEnd = newline ? newline : end;
+      *lineEnd = '\0';
+
+      if (lineEnd > line) {
+        NowReading reading;
+        if (!parseNowReading(line, &reading)) {
+          rxStats.badLines++;
+        } else if (!recordPeerReading(mac, reading.kind, reading.value, rssi,
+                                      reading.hasSequence, reading.sequence)) {
+          rxStats.unknownPeer++;
+        } else {
+          rxStats.lines++;
+          if (reading.kind == PEER_KIND_DISTANCE) {
+            *latestDistance = distanceFilter.update(telemetryScaleDistance(reading.value));
+            updated = true;
+          }
+        }
+      }
+      line = lineEnd + 1;
+    }
+    return updated;
   }
 }
 
-void handleNowMessages() {
+bool handleNowMessages() {
   GlobalContext &ctx = getGlobalContext();
   
   // Fast exit if ESP-NOW not active
   if (!ctx.nowSerialActive) {
-    return;
+    return false;
   }
   
-  // ESP-NOW message handling is now done via callback
-  // This function is kept for compatibility but messages
-  // are processed in the ESP-NOW receive callback
+  uint32_t tail = rxTail.load(std::memory_order_relaxed);
+  uint32_t head = rxHead.load(std::memory_order_acquire);
+  uint32_t frames = 0;
+  uint16_t latestDistance = 0;
+  bool updated = false;
+  
+  // Drain a bounded batch; per-peer readings land in the peer table and
+  // only the newest distance is published to SensorData since each
+  // reading supersedes the previous one
+  while (tail != head && frames < NOW_RX_BATCH_MAX) {
+    uint32_t index = tail & RX_RING_MASK;
+    uint8_t length = rxRing[index];
+    if (length == 0) {
+      tail += NOW_RX_RING_SIZE - index;
+      continue;
+    }
+    
+    int8_t rssi = (int8_t)rxRing[index + 1];
+    const uint8_t* mac = &rxRing[index + 2];
+    char* payload = (char*)&rxRing[index + RX_RECORD_HEADER];
+    if (handleNowFrame(mac, rssi, payload, length, &latestDistance)) {
+      updated = true;
+    }
+    tail += RX_RECORD_HEADER + length + 1;
+    frames++;
+  }
+  
+  rxTail.store(tail, std::memory_order_release);
+  if (frames > rxStats.maxBatch) rxStats.maxBatch = frames;
+  
+  rxStats.outliers = distanceFilter.outliers();
+  bool pending = rxHead.load(std::memory_order_acquire) != tail;
+  
+  if (!updated) return pending;
+  if (setSensorDistance(latestDistance)) {
+    captureHistorySample(TELEMETRY_FLAG_DISTANCE);
+    logDebug("Distance sensor updated: %u.%02u inches (%lu frames)", latestDistance / 100,
+             latestDistance % 100, (unsigned long)frames);
+    
+    // Publish the distance (inches * 100); the peer, RSSI and sequence
+    // behind it are in the peer table
+    publishEvent(EVENT_DISTANCE_UPDATED, latestDistance);
+  }
+  return pending;
 }
 
+void getNowRxStats(NowRxStats* stats) {
+  if (!stats) return;
+  *stats = rxStats;
+}
+
+void printNowRxStats() {
+  NowRxStats stats;
+  getNowRxStats(&stats);
+  Serial.printf("ESP-NOW RX: frames %lu, lines %lu, bad %lu, unknown peer %lu, dropped %lu, oversize %lu\n",
+                (unsigned long)stats.frames, (unsigned long)stats.lines, (unsigned long)stats.badLines,
+                (unsigned long)stats.unknownPeer, (unsigned long)stats.dropped, (unsigned long)stats.oversize);
+  Serial.printf("ESP-NOW RX distance filter: %lu outliers replaced\n", (unsigned long)stats.outliers);
+  Serial.printf("ESP-NOW RX ring: high water %lu/%u bytes, max batch %lu frames\n",
+                (unsigned long)stats.highWater, NOW_RX_RING_SIZE, (unsigned long)stats.maxBatch);
+}
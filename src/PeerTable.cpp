@@ -0,0 +1,305 @@
+/**
+ * PeerTable.cpp - ESP-NOW multi-peer state table
+ * 
+ * Copyright (C) 2025 Michael Garcia, M&E Design
+ * Based on original .ino by Geoff Mcintyre of Mr.Industries (https://mr.industries/)
+ * 
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ * 
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU General Public License for more details.
+ * 
+ * You should have received a copy of the GNU General Public License
+ * along with this program. If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#include "PeerTable.h"
+#include "Config.h"
+#include "TelemetryFrame.h"
+#include "freertos/FreeRTOS.h"
+#include "freertos/semphr.h"
+#include <cstring>
+
+#define PEER_MUTEX_TIMEOUT_MS 50
+#define PEER_INDEX_EMPTY -1
+
+static_assert(PEER_INDEX_SIZE > PEER_TABLE_CAPACITY, "Peer index must never fill up");
+static_assert((PEER_INDEX_SIZE & (PEER_INDEX_SIZE - 1)) == 0, "PEER_INDEX_SIZE must be a power of two");
+
+// Peers occupy slots [0, count); the index holds slot numbers and is probed
+// linearly from the MAC hash. Guarded by peerTableMutex.
+static PeerState peers[PEER_TABLE_CAPACITY];
+static size_t count = 0;
+static int8_t peerIndex[PEER_INDEX_SIZE];
+static SemaphoreHandle_t peerTableMutex = NULL;
+
+// FNV-1a over the six MAC bytes
+static uint32_t hashMac(const uint8_t* mac) {
+  uint32_t hash = 2166136261u;
+  for (int i = 0; i < 6; i++) {
+    hash ^= mac[i];
+    hash *= 16777619u;
+  }
+  return hash;
+}
+
+static void indexInsert(const uint8_t* mac, int slot) {
+  uint32_t pos = hashMac(mac) & (PEER_INDEX_SIZE - 1);
+  while (peerIndex[pos] != PEER_INDEX_EMPTY) {
+    pos = (pos + 1) & (PEER_INDEX_SIZE - 1);
+  }
+  peerIndex[pos] = (int8_t)slot;
+}
+
+static void rebuildIndex() {
+  memset(peerIndex, PEER_INDEX_EMPTY, sizeof(peerIndex));
+  for (size_t i = 0; i < count; i++) {
+    indexInsert(peers[i].mac, (int)i);
+  }
+}
+
+// The index is never full, so probing always reaches an empty entry
+static int lookup(const uint8_t* mac) {
+  uint32_t pos = hashMac(mac) & (PEER_INDEX_SIZE - 1);
+  while (peerIndex[pos] != PEER_INDEX_EMPTY) {
+    int slot = peerIndex[pos];
+    if (memcmp(peers[slot].mac, mac, 6) == 0) return slot;
+    pos = (pos + 1) & (PEER_INDEX_SIZE - 1);
+  }
+  return -1;
+}
+
+static bool lockTable() {
+  return peerTableMutex && xSemaphoreTake(peerTableMutex, pdMS_TO_TICKS(PEER_MUTEX_TIMEOUT_MS));
+}
+
+static void unlockTable() {
+  xSemaphoreGive(peerTableMutex);
+}
+
+static void resetPeer(PeerState* peer, const uint8_t* mac) {
+  memset(peer, 0, sizeof(*peer));
+  memcpy(peer->mac, mac, 6);
+  peer->rssi = PEER_RSSI_UNKNOWN;
+}
+
+bool initPeerTable() {
+  if (!peerTableMutex) {
+    peerTableMutex = xSemaphoreCreateMutex();
+    if (!peerTableMutex) {
+      Serial.println("ERROR: Failed to create peer table mutex");
+      return false;
+    }
+  }
+  count = 0;
+  rebuildIndex();
+  return true;
+}
+
+int addPeer(const uint8_t* mac) {
+  if (!mac || !lockTable()) return -1;
+  int slot = lookup(mac);
+  if (slot < 0 && count < PEER_TABLE_CAPACITY) {
+    slot = (int)count++;
+    resetPeer(&peers[slot], mac);
+    indexInsert(mac, slot);
+  }
+  unlockTable();
+  return slot;
+}
+
+bool removePeer(const uint8_t* mac) {
+  if (!mac || !lockTable()) return false;
+  int slot = lookup(mac);
+  if (slot >= 0) {
+    memmove(&peers[slot], &peers[slot + 1], (count - slot - 1) * sizeof(PeerState));
+    count--;
+    rebuildIndex();
+  }
+  unlockTable();
+  return slot >= 0;
+}
+
+void clearPeers() {
+  if (!lockTable()) return;
+  count = 0;
+  rebuildIndex();
+  unlockTable();
+}
+
+int findPeer(const uint8_t* mac) {
+  if (!mac || !lockTable()) return -1;
+  int slot = lookup(mac);
+  unlockTable();
+  return slot;
+}
+
+size_t peerCount() {
+  return count;
+}
+
+bool recordPeerReading(const uint8_t* mac, uint8_t kind, float value, int8_t rssi,
+                       bool hasSequence, uint16_t sequence) {
+  if (!mac || !lockTable()) return false;
+  int slot = lookup(mac);
+  if (slot < 0) {
+    unlockTable();
+    return false;
+  }
+
+  PeerState& peer = peers[slot];
+  if (hasSequence) {
+    if (peer.sequenceValid) {
+      uint16_t delta = (uint16_t)(sequence - peer.lastSequence);
+      if (delta == 0) {
+        // Retransmission of a reading we already have
+        unlockTable();
+        return true;
+      }
+      // A backwards jump means the node restarted; only forward gaps count
+      if (delta < 0x8000) peer.missed += delta - 1;
+    }
+    peer.lastSequence = sequence;
+    peer.sequenceValid = true;
+  }
+
+  peer.kind = kind;
+  peer.value = value;
+  peer.hasValue = true;
+  peer.lastSeen = millis();
+  peer.rssi = rssi;
+  peer.readings++;
+  unlockTable();
+  return true;
+}
+
+size_t snapshotPeers(PeerState* out, size_t maxPeers) {
+  if (!out || !lockTable()) return 0;
+  size_t n = count < maxPeers ? count : maxPeers;
+  memcpy(out, peers, n * sizeof(PeerState));
+  unlockTable();
+  return n;
+}
+
+/**
+ * EEPROM layout at EEPROM_PEER_TABLE_ADDR:
+ * 'P' 'T' version count, then count x (mac[6], kind), then CRC-16 over
+ * everything before it
+ */
+#define PEER_TABLE_MAGIC0 'P'
+#define PEER_TABLE_MAGIC1 'T'
+#define PEER_TABLE_VERSION 1
+#define PEER_RECORD_SIZE 7
+
+static_assert(EEPROM_PEER_TABLE_ADDR + 4 + PEER_TABLE_CAPACITY * PEER_RECORD_SIZE + 2 <= EEPROM_SIZE,
+              "Peer table does not fit in EEPROM");
+
+bool savePeerTable() {
+  if (!lockTable()) return false;
+
+  uint8_t image[4 + PEER_TABLE_CAPACITY * PEER_RECORD_SIZE + 2];
+  size_t length = 0;
+  image[length++] = PEER_TABLE_MAGIC0;
+  image[length++] = PEER_TABLE_MAGIC1;
+  image[length++] = PEER_TABLE_VERSION;
+  image[length++] = (uint8_t)count;
+  for (size_t i = 0; i < count; i++) {
+    memcpy(&image[length], peers[i].mac, 6);
+    image[length + 6] = peers[i].kind;
+    length += PEER_RECORD_SIZE;
+  }
+  unlockTable();
+
+  uint16_t crc = telemetryCrc16(image, length);
+  image[length++] = (uint8_t)(crc & 0xFF);
+  image[length++] = (uint8_t)(crc >> 8);
+
+  for (size_t i = 0; i < length; i++) {
+    EEPROM.write(EEPROM_PEER_TABLE_ADDR + i, image[i]);
+  }
+  if (!EEPROM.commit()) {
+    Serial.println("ERROR: Failed to commit peer table to EEPROM");
+    return false;
+  }
+  return true;
+}
+
+bool loadPeerTable() {
+  uint8_t image[4 + PEER_TABLE_CAPACITY * PEER_RECORD_SIZE + 2];
+  for (size_t i = 0; i < 4; i++) {
+    image[i] = EEPROM.read(EEPROM_PEER_TABLE_ADDR + i);
+  }
+  if (image[0] != PEER_TABLE_MAGIC0 || image[1] != PEER_TABLE_MAGIC1 ||
+      image[2] != PEER_TABLE_VERSION || image[3] > PEER_TABLE_CAPACITY) {
+    return false;
+  }
+
+  size_t entries = image[3];
+  size_t length = 4 + entries * PEER_RECORD_SIZE;
+  for (size_t i = 4; i < length + 2; i++) {
+    image[i] = EEPROM.read(EEPROM_PEER_TABLE_ADDR + i);
+  }
+  uint16_t stored = (uint16_t)(image[length] | (image[length + 1] << 8));
+  if (telemetryCrc16(image, length) != stored) {
+    Serial.println("WARNING: Peer table in EEPROM is corrupt, ignoring it");
+    return false;
+  }
+
+  if (!lockTable()) return false;
+  count = 0;
+  rebuildIndex();
+  for (size_t i = 0; i < entries; i++) {
+    const uint8_t* record = &image[4 + i * PEER_RECORD_SIZE];
+    if (lookup(record) >= 0) continue;
+    resetPeer(&peers[count], record);
+    peers[count].kind = record[6];
+    indexInsert(record, (int)count);
+    count++;
+  }
+  unlockTable();
+  return true;
+}
+
+static const char* peerKindName(uint8_t kind) {
+  switch (kind) {
+    case PEER_KIND_DISTANCE: return "DIST";
+    case PEER_KIND_SOIL: return "SOIL";
+    default: return "-";
+  }
+}
+
+void printPeerTable() {
+  PeerState snapshot[PEER_TABLE_CAPACITY];
+  size_t n = snapshotPeers(snapshot, PEER_TABLE_CAPACITY);
+  unsigned long now = millis();
+
+  Serial.printf("Peers: %u/%u\n", (unsigned)n, PEER_TABLE_CAPACITY);
+  for (size_t i = 0; i < n; i++) {
+    const PeerState& peer = snapshot[i];
+    Serial.printf("  %02X:%02X:%02X:%02X:%02X:%02X  %-4s",
+                  peer.mac[0], peer.mac[1], peer.mac[2], peer.mac[3], peer.mac[4], peer.mac[5],
+                  peerKindName(peer.kind));
+    if (!peer.hasValue) {
+      Serial.println("  no data");
+      continue;
+    }
+    Serial.printf(" %8.2f  seen %5.1fs ago", peer.value, (now - peer.lastSeen) / 1000.0);
+    if (peer.rssi != PEER_RSSI_UNKNOWN) {
+      Serial.printf("  rssi %4d dBm", peer.rssi);
+    }
+    Serial.printf("  rx %lu", (unsigned long)peer.readings);
+    if (peer.sequenceValid) {
+      Serial.printf("  seq %u missed %lu", peer.lastSequence, (unsigned long)peer.missed);
+    }
+    Serial.println();
+  }
+}
+
+uint16_t peerTelemetryId(const uint8_t* mac) {
+  return (uint16_t)((mac[4] << 8) | mac[5]);
+}
@@ -0,0 +1,158 @@
+/**
+ * PowerManager.cpp - Frequency scaling, light sleep and power locks
+ * 
+ * Copyright (C) 2025 Michael Garcia, M&E Design
+ * Based on original .ino by Geoff Mcintyre of Mr.Industries (https://mr.industries/)
+ * 
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ * 
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU General Public License for more details.
+ * 
+ * You should have received a copy of the GNU General Public License
+ * along with this program. If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#include "PowerManager.h"
+#include "Logger.h"
+#include "freertos/FreeRTOS.h"
+#include <esp_idf_version.h>
+#include "esp_pm.h"
+#include "esp_sleep.h"
+#include "driver/gpio.h"
+#include "driver/uart.h"
+
+struct PowerLock {
+  const char* name;
+  esp_pm_lock_handle_t handle;   // NULL when the core has no power management
+  uint8_t depth;
+  uint32_t acquiredUs;
+  PowerLockStats stats;
+};
+
+static PowerLock locks[POWER_LOCK_COUNT] = {
+  {"i2c", NULL, 0, 0, {}},
+  {"lora", NULL, 0, 0, {}},
+};
+
+static portMUX_TYPE lockMux = portMUX_INITIALIZER_UNLOCKED;
+static PowerMode powerMode = POWER_MODE_OFF;
+static int wakePin = -1;
+
+static esp_err_t configurePower(PowerMode mode) {
+#if ESP_IDF_VERSION_MAJOR >= 5
+  esp_pm_config_t config = {};
+#else
+  esp_pm_config_esp32_t config = {};
+#endif
+  config.max_freq_mhz = POWER_MAX_FREQ_MHZ;
+  config.min_freq_mhz = mode == POWER_MODE_OFF ? POWER_MAX_FREQ_MHZ : POWER_MIN_FREQ_MHZ;
+  config.light_sleep_enable = mode == POWER_MODE_LIGHT_SLEEP;
+  return esp_pm_configure(&config);
+}
+
+bool initPowerManager() {
+  for (int i = 0; i < POWER_LOCK_COUNT; i++) {
+    if (!locks[i].handle &&
+        esp_pm_lock_create(ESP_PM_APB_FREQ_MAX, 0, locks[i].name, &locks[i].handle) != ESP_OK) {
+      locks[i].handle = NULL;
+    }
+  }
+
+  // The timer needs no setup: tickless idle always wakes for the next
+  // task timeout
+  uart_set_wakeup_threshold(UART_NUM_0, POWER_UART_WAKE_EDGES);
+  esp_sleep_enable_uart_wakeup(UART_NUM_0);
+  esp_sleep_enable_gpio_wakeup();
+
+  if (setPowerMode(POWER_MODE_LIGHT_SLEEP)) return true;
+  logWarn("Light sleep unavailable - core built without CONFIG_FREERTOS_USE_TICKLESS_IDLE");
+  if (setPowerMode(POWER_MODE_DFS)) return true;
+  logWarn("Power management unavailable - core built without CONFIG_PM_ENABLE");
+  return false;
+}
+
+bool setPowerMode(PowerMode mode) {
+  if (mode > POWER_MODE_LIGHT_SLEEP || configurePower(mode) != ESP_OK) return false;
+  powerMode = mode;
+  return true;
+}
+
+PowerMode getPowerMode() {
+  return powerMode;
+}
+
+void powerLockAcquire(PowerLockId id) {
+  if (id >= POWER_LOCK_COUNT) return;
+  PowerLock& lock = locks[id];
+  if (lock.handle) esp_pm_lock_acquire(lock.handle);
+
+  portENTER_CRITICAL(&lockMux);
+  if (lock.depth++ == 0) {
+    lock.acquiredUs = micros();
+    lock.stats.acquires++;
+  }
+  portEXIT_CRITICAL(&lockMux);
+}
+
+void powerLockRelease(PowerLockId id) {
+  if (id >= POWER_LOCK_COUNT) return;
+  PowerLock& lock = locks[id];
+
+  portENTER_CRITICAL(&lockMux);
+  bool held = lock.depth > 0;
+  if (held && --lock.depth == 0) {
+    uint32_t heldUs = micros() - lock.acquiredUs;
+    lock.stats.heldUs += heldUs;
+    if (heldUs > lock.stats.maxHeldUs) lock.stats.maxHeldUs = heldUs;
+  }
+  portEXIT_CRITICAL(&lockMux);
+
+  if (held && lock.handle) esp_pm_lock_release(lock.handle);
+}
+
+void powerWakeOnPin(uint8_t pin) {
+  if (gpio_wakeup_enable((gpio_num_t)pin, GPIO_INTR_HIGH_LEVEL) == ESP_OK) {
+    wakePin = pin;
+  }
+}
+
+void getPowerLockStats(PowerLockId id, PowerLockStats* stats) {
+  if (!stats || id >= POWER_LOCK_COUNT) return;
+  portENTER_CRITICAL(&lockMux);
+  *stats = locks[id].stats;
+  portEXIT_CRITICAL(&lockMux);
+}
+
+void printPowerStats() {
+  Serial.printf("Power: %s (%u-%u MHz), wake on timer, UART0", powerModeName(powerMode),
+                powerMode == POWER_MODE_OFF ? POWER_MAX_FREQ_MHZ : POWER_MIN_FREQ_MHZ, POWER_MAX_FREQ_MHZ);
+  if (wakePin >= 0) Serial.printf(", GPIO %d", wakePin);
+  Serial.println();
+
+  for (int i = 0; i < POWER_LOCK_COUNT; i++) {
+    PowerLockStats stats;
+    getPowerLockStats((PowerLockId)i, &stats);
+    Serial.printf("  %-4s lock: %lu acquires, held %lu ms (max %lu us)%s\n", locks[i].name,
+                  (unsigned long)stats.acquires, (unsigned long)(stats.heldUs / 1000),
+                  (unsigned long)stats.maxHeldUs, locks[i].handle ? "" : ", inactive");
+  }
+}
+
+const char* powerModeName(PowerMode mode) {
+  switch (mode) {
+    case POWER_MODE_OFF:         return "off";
+    case POWER_MODE_DFS:         return "dfs";
+    case POWER_MODE_LIGHT_SLEEP: return "sleep";
+    default:                     return "?";
+  }
+}
+
+const char* powerLockName(PowerLockId lock) {
+  return lock < POWER_LOCK_COUNT ? locks[lock].name : "?";
+}
@@ -0,0 +1,103 @@
+/**
+ * ReportFilter.cpp - Report-by-exception deadband filter implementation
+ * 
+ * Copyright (C) 2025 Michael Garcia, M&E Design
+ * Based on original .ino by Geoff Mcintyre of Mr.Industries (https://mr.industries/)
+ * 
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ * 
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU General Public License for more details.
+ * 
+ * You should have received a copy of the GNU General Public License
+ * along with this program. If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#include "ReportFilter.h"
+#include "TelemetryFrame.h"
+#include <string.h>
+
+static const char* const reasonNames[REPORT_REASON_COUNT] = {
+  "suppressed", "first", "unfiltered", "heartbeat", "validity",
+  "temperature", "humidity", "lux", "distance"
+};
+
+static uint32_t absDiff(int32_t a, int32_t b) {
+  return (uint32_t)(a > b ? a - b : b - a);
+}
+
+void reportDefaultDeadbands(ReportDeadbands* deadbands) {
+  if (!deadbands) return;
+  deadbands->enabled = true;
+  deadbands->temperatureCenti = REPORT_DEFAULT_TEMPERATURE_CENTI;
+  deadbands->humidityCenti = REPORT_DEFAULT_HUMIDITY_CENTI;
+  deadbands->luxPercent = REPORT_DEFAULT_LUX_PERCENT;
+  deadbands->luxMin = REPORT_DEFAULT_LUX_MIN;
+  deadbands->distanceCenti = REPORT_DEFAULT_DISTANCE_CENTI;
+  deadbands->heartbeatMs = REPORT_DEFAULT_HEARTBEAT_MS;
+}
+
+void reportFilterInit(ReportFilter* filter, const ReportDeadbands* deadbands) {
+  if (!filter) return;
+  memset(filter, 0, sizeof(*filter));
+  if (deadbands) {
+    filter->deadbands = *deadbands;
+  } else {
+    reportDefaultDeadbands(&filter->deadbands);
+  }
+}
+
+void reportFilterReset(ReportFilter* filter) {
+  if (filter) filter->hasReference = false;
+}
+
+static ReportReason classify(const ReportFilter* filter, const SensorSample* sample) {
+  const ReportDeadbands& bands = filter->deadbands;
+  const SensorSample& ref = filter->reference;
+  if (!filter->hasReference) return REPORT_FIRST;
+  if (!bands.enabled) return REPORT_DISABLED;
+  if (sample->timestamp - ref.timestamp >= bands.heartbeatMs) return REPORT_HEARTBEAT;
+  if (sample->flags != ref.flags) return REPORT_FLAGS;
+  
+  uint8_t flags = sample->flags;
+  if ((flags & TELEMETRY_FLAG_TEMPERATURE) &&
+      absDiff(sample->temperatureCenti, ref.temperatureCenti) > bands.temperatureCenti) {
+    return REPORT_TEMPERATURE;
+  }
+  if ((flags & TELEMETRY_FLAG_HUMIDITY) &&
+      absDiff(sample->humidityCenti, ref.humidityCenti) > bands.humidityCenti) {
+    return REPORT_HUMIDITY;
+  }
+  if (flags & TELEMETRY_FLAG_LUX) {
+    uint32_t band = (uint32_t)ref.lux * bands.luxPercent / 100;
+    if (band < bands.luxMin) band = bands.luxMin;
+    if (absDiff(sample->lux, ref.lux) > band) return REPORT_LUX;
+  }
+  if ((flags & TELEMETRY_FLAG_DISTANCE) &&
+      absDiff(sample->distanceCenti, ref.distanceCenti) > bands.distanceCenti) {
+    return REPORT_DISTANCE;
+  }
+  return REPORT_SUPPRESSED;
+}
+
+ReportReason reportFilterCheck(ReportFilter* filter, const SensorSample* sample) {
+  if (!filter || !sample) return REPORT_SUPPRESSED;
+  
+  ReportReason reason = classify(filter, sample);
+  filter->checked++;
+  filter->reasons[reason]++;
+  if (reason != REPORT_SUPPRESSED) {
+    filter->reference = *sample;
+    filter->hasReference = true;
+  }
+  return reason;
+}
+
+const char* reportReasonName(ReportReason reason) {
+  return reason < REPORT_REASON_COUNT ? reasonNames[reason] : "unknown";
+}
@@ -0,0 +1,260 @@
+/**
+ * SampleScheduler.cpp - Adaptive per-channel sensor sampling
+ * 
+ * Copyright (C) 2025 Michael Garcia, M&E Design
+ * Based on original .ino by Geoff Mcintyre of Mr.Industries (https://mr.industries/)
+ * 
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ * 
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU General Public License for more details.
+ * 
+ * You should have received a copy of the GNU General Public License
+ * along with this program. If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#include "SampleScheduler.h"
+#include "freertos/FreeRTOS.h"
+#include "freertos/semphr.h"
+#include <cstring>
+
+#define SAMPLE_MUTEX_TIMEOUT_MS 50
+
+// Periods and change bands per channel; lux changes with every cloud, so it
+// backs off least
+static const SampleRate sampleRates[SAMPLE_CHANNEL_COUNT] = {
+  {1000, 60000, 10, 0},     // Temperature: 0.10 °C
+  {1000, 60000, 25, 0},     // Humidity: 0.25 %RH
+  {1000, 8000, 5, 5},       // Lux: 5 %, at least 5 lx
+};
+
+// Scheduler channels are the first entries of the sensor channel table
+static_assert(SAMPLE_TEMPERATURE == (int)SENSOR_CHANNEL_TEMPERATURE && SAMPLE_HUMIDITY == (int)SENSOR_CHANNEL_HUMIDITY &&
+              SAMPLE_LUX == (int)SENSOR_CHANNEL_LUX, "sample channels must follow the sensor channel table");
+
+static uint8_t channelFlag(int channel) {
+  return sensorChannels[channel].flag;
+}
+
+struct SampleChannelState {
+  WheelTimer timer;
+  SampleChannelStats stats;
+  bool hasLast;
+  int32_t last;
+  uint8_t stable;
+};
+
+static TimerWheel wheel;
+static SampleChannelState channels[SAMPLE_CHANNEL_COUNT];
+static bool adaptive = true;
+static SemaphoreHandle_t schedulerMutex = NULL;
+static SemaphoreHandle_t wakeSignal = NULL;
+
+static bool lockScheduler() {
+  return schedulerMutex && xSemaphoreTake(schedulerMutex, pdMS_TO_TICKS(SAMPLE_MUTEX_TIMEOUT_MS));
+}
+
+static void unlockScheduler() {
+  xSemaphoreGive(schedulerMutex);
+}
+
+// Wheel time in ticks, counted from millis() differences because
+// millis() / SAMPLE_TICK_MS would jump back when millis() wraps. Caller
+// holds schedulerMutex.
+static uint32_t tickCount = 0;
+static uint32_t tickBaseMs = 0;
+
+static uint32_t nowTick() {
+  uint32_t ticks = (millis() - tickBaseMs) / SAMPLE_TICK_MS;
+  tickCount += ticks;
+  tickBaseMs += ticks * SAMPLE_TICK_MS;
+  return tickCount;
+}
+
+static int32_t channelValue(const SensorSample& sample, int channel) {
+  return sensorChannelValue(sample, (SensorChannelId)channel);
+}
+
+static bool changed(int channel, int32_t last, int32_t value) {
+  const SampleRate& rate = sampleRates[channel];
+  uint32_t band = rate.band;
+  if (rate.bandPercent) {
+    uint32_t relative = (uint32_t)abs(last) * rate.bandPercent / 100;
+    if (relative > band) band = relative;
+  }
+  return (uint32_t)abs(value - last) > band;
+}
+
+// Caller holds schedulerMutex
+static void resetPeriods() {
+  for (int c = 0; c < SAMPLE_CHANNEL_COUNT; c++) {
+    channels[c].stats.periodMs = sampleRates[c].minPeriodMs;
+    channels[c].stable = 0;
+  }
+}
+
+bool initSampleScheduler() {
+  if (!schedulerMutex) {
+    schedulerMutex = xSemaphoreCreateMutex();
+    wakeSignal = xSemaphoreCreateBinary();
+    if (!schedulerMutex || !wakeSignal) return false;
+  }
+
+  // Everything is read on the first pass
+  tickBaseMs = millis();
+  timerWheelInit(&wheel, nowTick());
+  for (int c = 0; c < SAMPLE_CHANNEL_COUNT; c++) {
+    SampleChannelState& state = channels[c];
+    memset(&state, 0, sizeof(state));
+    state.timer.id = (uint8_t)c;
+    timerWheelArm(&wheel, &state.timer, wheel.tick);
+  }
+  resetPeriods();
+  return true;
+}
+
+uint8_t sampleSchedulerDue() {
+  if (!lockScheduler()) return 0;
+  WheelTimer* expired[SAMPLE_CHANNEL_COUNT];
+  size_t count = timerWheelAdvance(&wheel, nowTick(), expired, SAMPLE_CHANNEL_COUNT);
+  uint8_t due = 0;
+  for (size_t i = 0; i < count; i++) {
+    due |= channelFlag(expired[i]->id);
+  }
+  unlockScheduler();
+  return due;
+}
+
+void sampleSchedulerUpdate(uint8_t due, const SensorSample& raw, const SensorSample& filtered) {
+  if (!lockScheduler()) return;
+  uint32_t tick = nowTick();
+
+  for (int c = 0; c < SAMPLE_CHANNEL_COUNT; c++) {
+    if (!(due & channelFlag(c))) continue;
+    SampleChannelState& state = channels[c];
+    const SampleRate& rate = sampleRates[c];
+
+    if (raw.flags & channelFlag(c)) {
+      int32_t value = channelValue(raw, c);
+      state.stats.readings++;
+      if (!adaptive) {
+        state.stats.periodMs = rate.minPeriodMs;
+      } else if (state.hasLast && changed(c, state.last, value)) {
+        if (state.stats.periodMs > rate.minPeriodMs) state.stats.speedUps++;
+        state.stats.periodMs = rate.minPeriodMs;
+        state.stable = 0;
+      } else if (changed(c, channelValue(filtered, c), value)) {
+        state.stable = 0;     // Filter still settling
+      } else if (++state.stable >= SAMPLE_STABLE_READINGS && state.stats.periodMs < rate.maxPeriodMs) {
+        state.stats.periodMs = state.stats.periodMs * 2 > rate.maxPeriodMs ? rate.maxPeriodMs
+                                                                            : state.stats.periodMs * 2;
+        state.stats.slowDowns++;
+        state.stable = 0;
+      }
+      state.last = value;
+      state.hasLast = true;
+    } else {
+      state.stable = 0;
+    }
+
+    // Re-armed from the tick it was due on, so a slow pass does not shift
+    // the channel's phase
+    uint32_t period = state.stats.periodMs / SAMPLE_TICK_MS;
+    uint32_t next = state.timer.expiresTick + period;
+    if ((int32_t)(next - tick) <= 0) next = tick + period;
+    timerWheelArm(&wheel, &state.timer, next);
+  }
+  unlockScheduler();
+}
+
+void sampleSchedulerWait() {
+  uint32_t waitMs = sampleRates[0].minPeriodMs;   // Lock busy: check again soon
+  if (lockScheduler()) {
+    uint32_t tick = nowTick();
+    uint32_t ahead = timerWheelNextExpiry(&wheel);
+    if (ahead != UINT32_MAX) {
+      int32_t ticks = (int32_t)(wheel.tick + ahead - tick);
+      int32_t ms = ticks * SAMPLE_TICK_MS - (int32_t)(millis() - tickBaseMs);
+      waitMs = ms > 0 ? (uint32_t)ms : 0;
+    }
+    unlockScheduler();
+  }
+
+  if (waitMs > 0) {
+    xSemaphoreTake(wakeSignal, pdMS_TO_TICKS(waitMs));
+  }
+}
+
+void sampleSchedulerWake() {
+  if (wakeSignal) xSemaphoreGive(wakeSignal);
+}
+
+void sampleSchedulerRequest(uint8_t due) {
+  if (!lockScheduler()) return;
+  uint32_t tick = nowTick();
+  for (int c = 0; c < SAMPLE_CHANNEL_COUNT; c++) {
+    if (due & channelFlag(c)) timerWheelArm(&wheel, &channels[c].timer, tick);
+  }
+  unlockScheduler();
+  sampleSchedulerWake();
+}
+
+void setSampleAdaptive(bool enabled) {
+  if (!lockScheduler()) return;
+  adaptive = enabled;
+
+  // Re-arm every channel at its minimum period from now; the wake lets
+  // SensorTask recompute its sleep
+  resetPeriods();
+  uint32_t tick = nowTick();
+  for (int c = 0; c < SAMPLE_CHANNEL_COUNT; c++) {
+    timerWheelArm(&wheel, &channels[c].timer, tick);
+  }
+  unlockScheduler();
+  sampleSchedulerWake();
+}
+
+bool getSampleAdaptive() {
+  return adaptive;
+}
+
+void getSampleChannelStats(SampleChannel channel, SampleChannelStats* stats) {
+  if (!stats || channel >= SAMPLE_CHANNEL_COUNT) return;
+  if (!lockScheduler()) {
+    memset(stats, 0, sizeof(*stats));
+    return;
+  }
+  *stats = channels[channel].stats;
+  unlockScheduler();
+}
+
+void printSampleScheduler() {
+  Serial.printf("Sampling: %s (period doubled after %u stable readings)\n",
+                adaptive ? "adaptive" : "fixed", SAMPLE_STABLE_READINGS);
+  for (int c = 0; c < SAMPLE_CHANNEL_COUNT; c++) {
+    SampleChannelStats stats;
+    getSampleChannelStats((SampleChannel)c, &stats);
+    const SampleRate& rate = sampleRates[c];
+    // Readings the minimum period would have taken since boot
+    uint32_t fixed = millis() / rate.minPeriodMs + 1;
+    Serial.printf("  %-4s period %5lu ms (%lu-%lu), %lu readings vs %lu fixed, faster %lu, slower %lu\n",
+                  sampleChannelName((SampleChannel)c), (unsigned long)stats.periodMs,
+                  (unsigned long)rate.minPeriodMs, (unsigned long)rate.maxPeriodMs,
+                  (unsigned long)stats.readings, (unsigned long)fixed, (unsigned long)stats.speedUps,
+                  (unsigned long)stats.slowDowns);
+  }
+}
+
+const char* sampleChannelName(SampleChannel channel) {
+  switch (channel) {
+    case SAMPLE_TEMPERATURE: return "temp";
+    case SAMPLE_HUMIDITY:    return "hum";
+    case SAMPLE_LUX:         return "lux";
+    default:                 return "?";
+  }
+}
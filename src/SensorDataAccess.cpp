@@ -21,111 +21,108 @@
 #include "SensorDataAccess.h"
 #include "Tasks.h"
 
+#include "SeqLock.h"
+
 #define MUTEX_TIMEOUT_MS 100
 
-bool getSensorTemperature(int* temp) {
-  if (!temp) return false;
-  if (xSemaphoreTake(sensorDataMutex, pdMS_TO_TICKS(MUTEX_TIMEOUT_MS))) {
-    *temp = getGlobalContext().sensors.temperature;
-    xSemaphoreGive(sensorDataMutex);
-    return true;
-  }
-  return false;
-}
+// Readers take lock-free snapshots through the sequence lock; writers are
+// serialized by sensorDataMutex and only hold it for the field updates.
+static SeqLock sensorDataSeq;
 
-bool getSensorHumidity(float* humidity) {
-  if (!humidity) return false;
-  if (xSemaphoreTake(sensorDataMutex, pdMS_TO_TICKS(MUTEX_TIMEOUT_MS))) {
-    *humidity = getGlobalContext().sensors.humidity;
-    xSemaphoreGive(sensorDataMutex);
-    return true;
-  }
-  return false;
-}
+// Writer hold time, measured with the cycle counter between acquiring and
+// releasing the writer lock
+static SensorLockStats lockStats = {};
+static uint32_t holdStartCycles = 0;
 
-bool getSensorLux(int* lux) {
-  if (!lux) return false;
-  if (xSemaphoreTake(sensorDataMutex, pdMS_TO_TICKS(MUTEX_TIMEOUT_MS))) {
-    *lux = getGlobalContext().sensors.lux;
-    xSemaphoreGive(sensorDataMutex);
-    return true;
+// Before createTasks() there is no mutex and setup() is the only writer
+bool beginSensorDataUpdate() {
+  if (sensorDataMutex && !xSemaphoreTake(sensorDataMutex, pdMS_TO_TICKS(MUTEX_TIMEOUT_MS))) {
+    return false;
   }
-  return false;
+  sensorDataSeq.beginWrite();
+  holdStartCycles = ESP.getCycleCount();
+  return true;
 }
 
-bool getSensorDistance(float* distance) {
-  if (!distance) return false;
-  if (xSemaphoreTake(sensorDataMutex, pdMS_TO_TICKS(MUTEX_TIMEOUT_MS))) {
-    *distance = getGlobalContext().sensors.distance;
+void endSensorDataUpdate() {
+  sensorDataSeq.endWrite();
+  
+  uint32_t holdUs = (ESP.getCycleCount() - holdStartCycles) / ESP.getCpuFreqMHz();
+  lockStats.updates++;
+  lockStats.lastHoldUs = holdUs;
+  lockStats.totalHoldUs += holdUs;
+  if (holdUs > lockStats.maxHoldUs) lockStats.maxHoldUs = holdUs;
+  
+  if (sensorDataMutex) {
     xSemaphoreGive(sensorDataMutex);
-    return true;
   }
-  return false;
 }
 
-bool getAllSensorData(int* temp, float* humidity, int* lux, float* distance) {
-  if (!temp || !humidity || !lux || !distance) return false;
-  if (xSemaphoreTake(sensorDataMutex, pdMS_TO_TICKS(MUTEX_TIMEOUT_MS))) {
-    GlobalContext& ctx = getGlobalContext();
-    *temp = ctx.sensors.temperature;
-    *humidity = ctx.sensors.humidity;
-    *lux = ctx.sensors.lux;
-    *distance = ctx.sensors.distance;
+void getSensorLockStats(SensorLockStats* stats) {
+  if (!stats) return;
+  if (sensorDataMutex && xSemaphoreTake(sensorDataMutex, pdMS_TO_TICKS(MUTEX_TIMEOUT_MS))) {
+    *stats = lockStats;
     xSemaphoreGive(sensorDataMutex);
-    return true;
+  } else {
+    *stats = lockStats;
   }
-  return false;
 }
 
-bool setSensorDistance(float distance) {
-  if (xSemaphoreTake(sensorDataMutex, pdMS_TO_TICKS(MUTEX_TIMEOUT_MS))) {
-    getGlobalContext().sensors.distance = distance;
-    getGlobalContext().sensors.lastDistanceUpdate = millis();
-    xSemaphoreGive(sensorDataMutex);
-    return true;
-  }
-  return false;
+void readSensorSnapshot(SensorData* dest) {
+  sensorDataSeq.read(dest, getGlobalContext().sensors);
 }
 
-bool updateSensorTimestamp(unsigned long* lastUpdate) {
-  if (!lastUpdate) return false;
-  if (xSemaphoreTake(sensorDataMutex, pdMS_TO_TICKS(MUTEX_TIMEOUT_MS))) {
-    *lastUpdate = millis();
-    xSemaphoreGive(sensorDataMutex);
-    return true;
-  }
-  return false;
+bool setSensorDistance(uint16_t distanceCenti) {
+  if (!beginSensorDataUpdate()) return false;
+  SensorData& data = getGlobalContext().sensors;
+  data.distanceCenti = distanceCenti;
+  data.flags |= TELEMETRY_FLAG_DISTANCE;
+  endSensorDataUpdate();
+  return true;
 }
 
 bool copySensorDataSafe(SensorData* dest) {
   if (!dest) return false;
-  if (xSemaphoreTake(sensorDataMutex, pdMS_TO_TICKS(MUTEX_TIMEOUT_MS))) {
-    *dest = getGlobalContext().sensors;
-    xSemaphoreGive(sensorDataMutex);
-    return true;
+  readSensorSnapshot(dest);
+  return true;
+}
+
+void printSensorLockStats() {
+  SensorLockStats stats;
+  getSensorLockStats(&stats);
+  Serial.printf("Sensor writer lock: %lu updates, hold last %lu us, max %lu us, avg %.1f us\n",
+                (unsigned long)stats.updates, (unsigned long)stats.lastHoldUs,
+                (unsigned long)stats.maxHoldUs,
+                stats.updates ? (double)stats.totalHoldUs / stats.updates : 0.0);
+}
+
+// Prints a fixed-point value with the given number of decimals without
+// going through float
+static void printFixedPoint(int32_t value, uint8_t decimals) {
+  if (decimals == 0) {
+    Serial.print(value);
+    return;
   }
-  return false;
+  uint32_t unit = decimals == 1 ? 10 : 100;
+  uint32_t magnitude = value < 0 ? (uint32_t)-value : (uint32_t)value;
+  Serial.printf("%s%lu.%0*lu", value < 0 ? "-" : "", (unsigned long)(magnitude / unit), (int)decimals,
+                (unsigned long)(magnitude % unit));
 }
 
 bool printSensorDataSafe() {
-  if (xSemaphoreTake(sensorDataMutex, pdMS_TO_TICKS(MUTEX_TIMEOUT_MS))) {
-    GlobalContext& ctx = getGlobalContext();
-    Serial.println("=== Current Sensor Values ===");
-    Serial.print("Temperature: ");
-    Serial.print(ctx.sensors.temperature);
-    Serial.println("°C");
-    Serial.print("Humidity: ");
-    Serial.print(ctx.sensors.humidity, 1);
-    Serial.println("%");
-    Serial.print("Lux: ");
-    Serial.println(ctx.sensors.lux);
-    Serial.print("Distance: ");
-    Serial.print(ctx.sensors.distance, 2);
-    Serial.println(" in");
-    Serial.println("============================\n");
-    xSemaphoreGive(sensorDataMutex);
-    return true;
+  SensorData snapshot;
+  readSensorSnapshot(&snapshot);
+  
+  Serial.println("=== Current Sensor Values ===");
+  for (int c = 0; c < SENSOR_CHANNEL_COUNT; c++) {
+    const SensorChannelInfo& channel = sensorChannels[c];
+    Serial.printf("%s: ", channel.name);
+    printFixedPoint(sensorChannelValue(snapshot, (SensorChannelId)c), channel.decimals);
+    Serial.print(channel.unit);
+    if (!(snapshot.flags & channel.flag)) Serial.print(" (no reading)");
+    Serial.println();
   }
-  Serial.println("Failed to access sensor data");
-  return false;
-}
\ No newline at end of file
+  Serial.printf("Sampled: %lu ms ago\n", (unsigned long)(millis() - snapshot.timestamp));
+  Serial.println("============================\n");
+  return true;
+}
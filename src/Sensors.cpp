@@ -23,63 +23,127 @@
 #include "SensorDataAccess.h"
 #include "Tasks.h"
 #include "Logger.h"
+#include "SignalFilter.h"
+#include "I2cBus.h"
 #include "freertos/FreeRTOS.h"
 #include "freertos/semphr.h"
-#include <cmath>
 
-static Adafruit_TSL2561_Unified tsl = Adafruit_TSL2561_Unified(TSL2561_ADDR_FLOAT, 12345);
-static Adafruit_HTU21DF htu = Adafruit_HTU21DF();
+// Given by driver transaction callbacks to end a wait in the acquisition
+// pass early
+static SemaphoreHandle_t acquireSignal = NULL;
 
-void initializeSensors() {
-  Wire.begin(PIN_I2C_SDA, PIN_I2C_SCL);
-  Serial.print("I2C initialized - SDA: GPIO");
-  Serial.print(PIN_I2C_SDA);
-  Serial.print(", SCL: GPIO");
-  Serial.println(PIN_I2C_SCL);
+void sensorDriverNotify() {
+  if (acquireSignal) xSemaphoreGive(acquireSignal);
+}
+
+void initializeSensors(bool scanBus) {
+  acquireSignal = xSemaphoreCreateBinary();
+  initI2cBus();
+  if (scanBus) i2cBusScan();
   
   logInfo("Initializing I2C environmental sensors");
   
-  if (!tsl.begin()) {
-    logWarn("TSL2561 light sensor not detected - readings will be zero");
-  } else {
-    configureTSL2561();
-    logInfo("TSL2561 light sensor initialized successfully");
-  }
-
-  if (!htu.begin()) {
-    logWarn("HTU21D-F temp/humidity sensor not detected - readings will be zero");
-  } else {
-    logInfo("HTU21D-F temperature/humidity sensor initialized successfully");
-  }
+  // Each driver logs whether it was found; a missing sensor's channels
+  // simply never get a reading
+  EnvironmentalSensors::probe();
 }
 
-void configureTSL2561() {
-  tsl.setGain(TSL2561_GAIN_16X);
-  tsl.setIntegrationTime(TSL2561_INTEGRATIONTIME_101MS);
-}
+// -----------------------------------------------------------------------------
+// Acquisition stage
+// -----------------------------------------------------------------------------
 
-void readEnvironmentalSensors() {
-  float temp_c = htu.readTemperature();
-  float humidity = htu.readHumidity();
+void acquireEnvironmentalSample(SensorSample* sample, uint8_t channels) {
+  if (!sample) return;
   
-  GlobalContext& ctx = getGlobalContext();
+  sample->flags = 0;
+  sample->temperatureCenti = 0;
+  sample->humidityCenti = 0;
+  sample->lux = 0;
+  sample->distanceCenti = 0;
   
-  if (!isnan(temp_c) && temp_c >= -40 && temp_c <= 85) {
-    ctx.sensors.temperature = (int)temp_c;
+  // Every driver starts its conversions, then the task sleeps until the
+  // soonest one needs attention or a bus transaction completes, so the
+  // conversions and the bus traffic of all sensors overlap
+  EnvironmentalSensors::start(channels);
+  uint32_t waitMs;
+  while ((waitMs = EnvironmentalSensors::poll()) != SENSOR_POLL_DONE) {
+    if (acquireSignal) {
+      xSemaphoreTake(acquireSignal, pdMS_TO_TICKS(waitMs));
+    } else {
+      vTaskDelay(pdMS_TO_TICKS(waitMs));
+    }
   }
+  EnvironmentalSensors::read(sample);
   
-  if (!isnan(humidity) && humidity >= 0 && humidity <= 100) {
-    ctx.sensors.humidity = humidity;
+  sample->timestamp = millis();
+}
+
+// -----------------------------------------------------------------------------
+// Publication stage
+// -----------------------------------------------------------------------------
+
+void publishEnvironmentalSample(const SensorSample& sample, uint8_t channels) {
+  if (!beginSensorDataUpdate()) {
+    logWarn("Sensor data update skipped - writer lock busy");
+    return;
   }
   
-  sensors_event_t event;
-  if (tsl.getEvent(&event)) {
-    if (event.light > 0 && event.light < 100000) {
-      ctx.sensors.lux = (int)event.light;
-    }
+  // Invalid fields keep their last value but lose their flag; channels not
+  // read in this pass, and the distance from ESP-NOW, are left alone
+  SensorData& data = getGlobalContext().sensors;
+  if (sample.flags & TELEMETRY_FLAG_TEMPERATURE) {
+    data.temperatureCenti = sample.temperatureCenti;
+  }
+  if (sample.flags & TELEMETRY_FLAG_HUMIDITY) {
+    data.humidityCenti = sample.humidityCenti;
+  }
+  if (sample.flags & TELEMETRY_FLAG_LUX) {
+    data.lux = sample.lux;
   }
   
-  ctx.sensors.lastEnvironmentalUpdate = millis();
+  channels &= SENSOR_CHANNELS_ENVIRONMENTAL;
+  data.flags = (uint8_t)((data.flags & ~channels) | (sample.flags & channels));
+  data.timestamp = sample.timestamp;
+  endSensorDataUpdate();
+}
+
+// -----------------------------------------------------------------------------
+// Filter stage
+// -----------------------------------------------------------------------------
+
+// Owned by SensorTask; the chains are configured in SignalFilter.h
+static TemperatureFilter temperatureFilter;
+static HumidityFilter humidityFilter;
+static LuxFilter luxFilter;
+
+void filterEnvironmentalSample(SensorSample* sample) {
+  if (!sample) return;
+  
+  // Fields without a reading are skipped, so a missed conversion neither
+  // enters the window nor resets it
+  if (sample->flags & TELEMETRY_FLAG_TEMPERATURE) {
+    sample->temperatureCenti = temperatureFilter.update(sample->temperatureCenti);
+  }
+  if (sample->flags & TELEMETRY_FLAG_HUMIDITY) {
+    sample->humidityCenti = humidityFilter.update(sample->humidityCenti);
+  }
+  if (sample->flags & TELEMETRY_FLAG_LUX) {
+    sample->lux = luxFilter.update(sample->lux);
+  }
+}
+
+void printSensorFilterStats() {
+  // The lux median has no rejection threshold, so it reports no outliers;
+  // the distance filter's count is in the ESP-NOW RX stats
+  Serial.printf("Filter outliers: temp %lu, hum %lu\n",
+                (unsigned long)temperatureFilter.outliers(), (unsigned long)humidityFilter.outliers());
+}
+
+void readEnvironmentalSensors(uint8_t channels) {
+  SensorSample sample;
+  acquireEnvironmentalSample(&sample, channels);
+  filterEnvironmentalSample(&sample);
+  publishEnvironmentalSample(sample, channels);
 }
 
 
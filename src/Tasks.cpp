@@ -26,9 +26,25 @@
 #include "NowLink.h"
 #include "Commands.h"
 #include "EventQueue.h"
+#include "Backlog.h"
+#include "History.h"
+#include "SampleScheduler.h"
+#include "Logger.h"
 
 SemaphoreHandle_t sensorDataMutex = NULL;
 
+// Given by the UART driver when serial input arrives
+static SemaphoreHandle_t serialRxSignal = NULL;
+
+// Written by CommsTask only
+static CommsTaskStats commsStats = {};
+
+// Everything that gives CommsTask work: send requests, TX-done, new
+// backlog samples, ESP-NOW frames, history requests and batching changes
+#define COMMS_EVENT_TOPICS (EVENT_BIT(EVENT_LORA_SEND_REQUEST) | EVENT_BIT(EVENT_LORA_SEND_COMPLETE) | \
+                            EVENT_BIT(EVENT_SENSOR_DATA_READY) | EVENT_BIT(EVENT_NOW_RX_READY) | \
+                            EVENT_BIT(EVENT_HISTORY_REQUEST) | EVENT_BIT(EVENT_CONFIG_CHANGED))
+
 void createTasks() {
   // Create mutex for sensor data protection
   sensorDataMutex = xSemaphoreCreateMutex();
@@ -49,7 +65,13 @@ void createTasks() {
     return;
   }
   
-  // Create command handling task
+  // Create command handling task; it sleeps until serial input arrives
+  serialRxSignal = xSemaphoreCreateBinary();
+  if (!serialRxSignal) {
+    Serial.println("CRITICAL: Failed to create serial RX semaphore");
+    return;
+  }
+  Serial.onReceive([]() { xSemaphoreGive(serialRxSignal); });
   if (xTaskCreate(commandTask, "CommandTask", COMMAND_TASK_STACK, NULL, COMMAND_TASK_PRIORITY, NULL) != pdPASS) {
     Serial.println("CRITICAL: Failed to create command task");
     return;
@@ -57,76 +79,121 @@ void createTasks() {
 }
 
 void sensorTask(void* parameter) {
-  TickType_t lastWakeTime = xTaskGetTickCount();
-  const TickType_t frequency = pdMS_TO_TICKS(ENVIRONMENTAL_SENSOR_INTERVAL);
-  
   while (true) {
-    // Acquire mutex for thread-safe sensor data access
-    if (xSemaphoreTake(sensorDataMutex, portMAX_DELAY)) {
-      readEnvironmentalSensors();
-      xSemaphoreGive(sensorDataMutex);
+    // Each channel runs on its own adaptive period; read only the ones due
+    uint8_t channels = sampleSchedulerDue();
+    if (channels) {
+      // Read sensors, filter and publish the new snapshot (locks
+      // internally); the scheduler adapts each period to the readings
+      SensorSample sample;
+      acquireEnvironmentalSample(&sample, channels);
+      SensorSample raw = sample;
+      filterEnvironmentalSample(&sample);
+      publishEnvironmentalSample(sample, channels);
+      sampleSchedulerUpdate(channels, raw, sample);
+      
+      // Every sample goes into the history tiers, reported or not
+      captureHistorySample(channels);
       
-      // Broadcast sensor data ready event to other tasks
-      sendEvent(EVENT_SENSOR_DATA_READY);
+      // Queue the sample for transmission unless it is within the report
+      // deadbands; a queued sample is kept until the radio sends it
+      captureBacklogSample();
+      
+      // Announce the new snapshot; subscribers that have not caught up
+      // get one notification carrying the channels of the latest pass.
+      // The sample itself is in SensorData for anyone who needs it.
+      publishEvent(EVENT_SENSOR_DATA_READY, channels);
     }
     
-    // Maintain precise 1Hz sampling rate using absolute timing
-    vTaskDelayUntil(&lastWakeTime, frequency);
+    // Sleep until the next channel's timer expires
+    sampleSchedulerWait();
   }
 }
 
 void commsTask(void* parameter) {
-  TickType_t lastLoRaTransmit = 0;
-  const TickType_t loraInterval = pdMS_TO_TICKS(LORA_TRANSMIT_INTERVAL);
   EventMessage event;
+  EventSubscriber* events = subscribeEvents("comms", COMMS_EVENT_TOPICS);
+  if (!events) {
+    logError("Comms task not subscribed to events - polling, send requests will be ignored");
+  }
   
+  uint32_t sleepMs = 0;
   while (true) {
-    // Update global timestamp for system timing
-    getGlobalContext().currentTime = millis();
+    // Sleep until there is work: an event, or the next LoRa deadline
+    unsigned long sleptAt = millis();
+    bool received = false;
+    if (events) {
+      received = receiveEvent(events, &event, pdMS_TO_TICKS(sleepMs));
+    } else {
+      vTaskDelay(pdMS_TO_TICKS(COMMS_POLL_MS));
+    }
     
-    // Process incoming ESP-NOW peer messages
-    handleNowMessages();
+    // Update global timestamp for system timing
+    unsigned long now = millis();
+    getGlobalContext().currentTime = now;
+    commsStats.wakeups++;
+    if (received) commsStats.eventWakeups++;
+    if (now - sleptAt > commsStats.longestSleepMs) commsStats.longestSleepMs = now - sleptAt;
     
-    // Process inter-task events with short timeout for responsiveness
-    if (receiveEvent(&event, pdMS_TO_TICKS(10))) {
+    if (received) {
       switch (event.type) {
-        case EVENT_SENSOR_DATA_READY:
-          // Environmental sensor data updated - available for transmission
-          break;
-        case EVENT_DISTANCE_UPDATED:
-          // Distance measurement received via ESP-NOW communication
-          break;
-        case EVENT_LORA_SEND_REQUEST:
+        case EVENT_LORA_SEND_REQUEST: {
           // Manual LoRa transmission requested via serial command
-          if (xSemaphoreTake(sensorDataMutex, pdMS_TO_TICKS(10))) {
-            pushAllData("Greenhouse");
-            sendEvent(EVENT_LORA_SEND_COMPLETE);
-            xSemaphoreGive(sensorDataMutex);
-          }
+          const LoRaSendRequest* request = payloadAs<LoRaSendRequest>(event.payload);
+          pushAllData(request ? request->hubName : "Greenhouse");
           break;
+        }
         default:
+          // The rest only wake the task for the service calls below:
+          // TX-done, a new backlog sample, ESP-NOW frames, a history
+          // request or new batching settings
           break;
       }
+      releasePayload(event.payload);
     }
     
-    // Perform periodic LoRa data transmission
-    TickType_t currentTick = xTaskGetTickCount();
-    if (getGlobalContext().loraActive && (currentTick - lastLoRaTransmit) >= loraInterval) {
-      if (xSemaphoreTake(sensorDataMutex, pdMS_TO_TICKS(10))) {
-        pushAllData("Greenhouse");
-        lastLoRaTransmit = currentTick;
-        xSemaphoreGive(sensorDataMutex);
-      }
-    }
+    // Process incoming ESP-NOW peer messages
+    bool nowPending = handleNowMessages();
+    
+    // Retire completed LoRa frames and start the next queued one
+    serviceLoRaTx();
+    
+    // Send the samples SensorTask captured, one frame at a time; after an
+    // outage this drains the backlog in batches
+    maintainLoRaLink();
+    drainBacklog("Greenhouse");
     
-    // Short delay to prevent task starvation
-    vTaskDelay(pdMS_TO_TICKS(10));
+    // Requested history uploads use whatever airtime is left
+    serviceHistoryUpload();
+    
+    // Frames left over from a full batch are drained right away
+    sleepMs = nowPending ? 0 : loraServiceDelayMs();
+    if (sleepMs > COMMS_MAX_SLEEP_MS) sleepMs = COMMS_MAX_SLEEP_MS;
   }
 }
 
 void commandTask(void* parameter) {
   while (true) {
-    handleSerialCommands();
-    vTaskDelay(pdMS_TO_TICKS(50));
+    // Input that arrived before the callback was set is handled on the
+    // first pass
+    while (Serial.available()) {
+      handleSerialCommands();
+    }
+    xSemaphoreTake(serialRxSignal, portMAX_DELAY);
   }
+}
+
+void getCommsTaskStats(CommsTaskStats* stats) {
+  if (!stats) return;
+  *stats = commsStats;
+}
+
+void printCommsTaskStats() {
+  CommsTaskStats stats;
+  getCommsTaskStats(&stats);
+  float seconds = millis() / 1000.0f;
+  Serial.printf("Comms task: %lu wakeups (%.2f/s), %lu on events, %lu on deadlines, longest sleep %lu ms\n",
+                (unsigned long)stats.wakeups, seconds > 0 ? stats.wakeups / seconds : 0.0f,
+                (unsigned long)stats.eventWakeups, (unsigned long)(stats.wakeups - stats.eventWakeups),
+                (unsigned long)stats.longestSleepMs);
 }
\ No newline at end of file
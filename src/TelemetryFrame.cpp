@@ -0,0 +1,433 @@
+/**
+ * TelemetryFrame.cpp - Binary LoRa telemetry frame encoder/decoder
+ * 
+ * Copyright (C) 2025 Michael Garcia, M&E Design
+ * Based on original .ino by Geoff Mcintyre of Mr.Industries (https://mr.industries/)
+ * 
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ * 
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU General Public License for more details.
+ * 
+ * You should have received a copy of the GNU General Public License
+ * along with this program. If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#include "TelemetryFrame.h"
+#include <string.h>
+#include <math.h>
+
+static void putU16(uint8_t* p, uint16_t v) {
+  p[0] = (uint8_t)(v & 0xFF);
+  p[1] = (uint8_t)(v >> 8);
+}
+
+static uint16_t getU16(const uint8_t* p) {
+  return (uint16_t)(p[0] | (p[1] << 8));
+}
+
+static void putU32(uint8_t* p, uint32_t v) {
+  putU16(p, (uint16_t)v);
+  putU16(p + 2, (uint16_t)(v >> 16));
+}
+
+static uint32_t getU32(const uint8_t* p) {
+  return getU16(p) | ((uint32_t)getU16(p + 2) << 16);
+}
+
+static long roundScaled(float value, float scale, long minValue, long maxValue) {
+  if (isnan(value)) return 0;
+  float scaled = value * scale;
+  if (scaled <= (float)minValue) return minValue;
+  if (scaled >= (float)maxValue) return maxValue;
+  return lroundf(scaled);
+}
+
+int16_t telemetryScaleTemperature(float celsius) {
+  return (int16_t)roundScaled(celsius, 100.0f, INT16_MIN, INT16_MAX);
+}
+
+uint16_t telemetryScaleHumidity(float percent) {
+  return (uint16_t)roundScaled(percent, 100.0f, 0, 10000);
+}
+
+uint16_t telemetryScaleLux(int lux) {
+  if (lux <= 0) return 0;
+  return lux > UINT16_MAX ? UINT16_MAX : (uint16_t)lux;
+}
+
+uint16_t telemetryScaleDistance(float inches) {
+  return (uint16_t)roundScaled(inches, 100.0f, 0, UINT16_MAX);
+}
+
+// CRC-16/CCITT-FALSE (poly 0x1021, init 0xFFFF), bitwise to keep flash usage
+// small; a sensor frame costs well under a microsecond either way.
+uint16_t telemetryCrc16(const uint8_t* data, size_t length) {
+  uint16_t crc = 0xFFFF;
+  while (length--) {
+    crc ^= (uint16_t)(*data++) << 8;
+    for (int i = 0; i < 8; i++) {
+      crc = (crc & 0x8000) ? (uint16_t)((crc << 1) ^ 0x1021) : (uint16_t)(crc << 1);
+    }
+  }
+  return crc;
+}
+
+static size_t finishFrame(uint8_t* buffer, size_t payloadEnd) {
+  putU16(&buffer[payloadEnd], telemetryCrc16(buffer, payloadEnd));
+  return payloadEnd + TELEMETRY_CRC_SIZE;
+}
+
+static bool checkFrame(const uint8_t* buffer, size_t length, uint8_t type) {
+  if (!buffer || length < TELEMETRY_HEADER_SIZE + TELEMETRY_CRC_SIZE) return false;
+  if (buffer[0] != TELEMETRY_FRAME_VERSION || buffer[1] != type) return false;
+  size_t crcOffset = length - TELEMETRY_CRC_SIZE;
+  return getU16(&buffer[crcOffset]) == telemetryCrc16(buffer, crcOffset);
+}
+
+size_t encodeSensorFrame(const TelemetryReading* reading, uint8_t* buffer, size_t bufferSize) {
+  if (!reading || !buffer || reading->peerCount > TELEMETRY_MAX_PEERS) return 0;
+  size_t needed = TELEMETRY_SENSOR_FRAME_SIZE + reading->peerCount * TELEMETRY_PEER_RECORD_SIZE;
+  if (bufferSize < needed) return 0;
+
+  buffer[0] = TELEMETRY_FRAME_VERSION;
+  buffer[1] = FRAME_TYPE_SENSOR_DATA;
+  putU16(&buffer[2], reading->hubId);
+  putU16(&buffer[4], reading->sequence);
+  buffer[6] = reading->flags;
+  putU16(&buffer[7], (uint16_t)reading->temperatureCenti);
+  putU16(&buffer[9], reading->humidityCenti);
+  putU16(&buffer[11], reading->lux);
+  putU16(&buffer[13], reading->distanceCenti);
+  buffer[15] = reading->peerCount;
+
+  size_t pos = 16;
+  for (uint8_t i = 0; i < reading->peerCount; i++) {
+    const TelemetryPeerReading& peer = reading->peers[i];
+    putU16(&buffer[pos], peer.id);
+    buffer[pos + 2] = peer.kind;
+    putU16(&buffer[pos + 3], peer.valueCenti);
+    buffer[pos + 5] = peer.ageSeconds;
+    pos += TELEMETRY_PEER_RECORD_SIZE;
+  }
+  return finishFrame(buffer, pos);
+}
+
+size_t encodeHubInfoFrame(uint16_t hubId, const char* name, const char* sensorNames,
+                          const char* types, uint8_t* buffer, size_t bufferSize) {
+  if (!name || !sensorNames || !types || !buffer) return 0;
+
+  const char* fields[] = {name, sensorNames, types};
+  size_t needed = TELEMETRY_HEADER_SIZE + TELEMETRY_CRC_SIZE;
+  for (const char* field : fields) needed += strlen(field) + 1;
+  if (needed > bufferSize || needed > TELEMETRY_MAX_FRAME_SIZE) return 0;
+
+  buffer[0] = TELEMETRY_FRAME_VERSION;
+  buffer[1] = FRAME_TYPE_HUB_INFO;
+  putU16(&buffer[2], hubId);
+
+  size_t pos = TELEMETRY_HEADER_SIZE;
+  for (const char* field : fields) {
+    size_t len = strlen(field) + 1;
+    memcpy(&buffer[pos], field, len);
+    pos += len;
+  }
+  return finishFrame(buffer, pos);
+}
+
+static size_t putVarint(uint8_t* p, uint32_t value) {
+  size_t n = 0;
+  while (value >= 0x80) {
+    p[n++] = (uint8_t)(value | 0x80);
+    value >>= 7;
+  }
+  p[n++] = (uint8_t)value;
+  return n;
+}
+
+static bool getVarint(const uint8_t* buffer, size_t end, size_t* pos, uint32_t* value) {
+  *value = 0;
+  for (int shift = 0; shift < 32 && *pos < end; shift += 7) {
+    uint8_t byte = buffer[(*pos)++];
+    *value |= (uint32_t)(byte & 0x7F) << shift;
+    if (!(byte & 0x80)) return true;
+  }
+  return false;
+}
+
+// Deltas wrap in 16 bits, so every value field costs at most 3 bytes
+static uint32_t zigzag16(uint16_t current, uint16_t previous) {
+  int32_t delta = (int16_t)(uint16_t)(current - previous);
+  return ((uint32_t)delta << 1) ^ (uint32_t)(delta >> 31);
+}
+
+static uint16_t unzigzag16(uint16_t previous, uint32_t value) {
+  int32_t delta = (int32_t)(value >> 1) ^ -(int32_t)(value & 1);
+  return (uint16_t)(previous + delta);
+}
+
+// Sample age in 0.1 s steps; unknown ages encode as zero deltas
+static uint16_t ageTenths(const TelemetrySample& sample) {
+  if (sample.ageMs == TELEMETRY_AGE_UNKNOWN_MS) return 0;
+  return (uint16_t)(sample.ageMs / 100);
+}
+
+size_t encodeBatchFrame(const TelemetryBatch* batch, uint8_t* buffer, size_t bufferSize) {
+  if (!batch || !buffer || batch->sampleCount == 0 || batch->sampleCount > TELEMETRY_MAX_BATCH_SAMPLES ||
+      batch->peerCount > TELEMETRY_MAX_PEERS) {
+    return 0;
+  }
+  size_t limit = bufferSize < TELEMETRY_MAX_FRAME_SIZE ? bufferSize : TELEMETRY_MAX_FRAME_SIZE;
+  size_t worst = TELEMETRY_BATCH_HEADER_SIZE + (batch->sampleCount - 1) * TELEMETRY_BATCH_DELTA_MAX +
+                 1 + TELEMETRY_CRC_SIZE;
+  if (limit < worst) return 0;
+
+  const TelemetrySample& first = batch->samples[0];
+  bool ageKnown = first.ageMs != TELEMETRY_AGE_UNKNOWN_MS;
+  uint32_t firstAge = ageKnown ? (first.ageMs + 500) / 1000 : TELEMETRY_AGE_UNKNOWN;
+  if (firstAge > TELEMETRY_AGE_UNKNOWN - 1 && ageKnown) firstAge = TELEMETRY_AGE_UNKNOWN - 1;
+
+  buffer[0] = TELEMETRY_FRAME_VERSION;
+  buffer[1] = FRAME_TYPE_BATCH;
+  putU16(&buffer[2], batch->hubId);
+  buffer[4] = batch->sampleCount;
+  putU16(&buffer[5], first.sequence);
+  putU16(&buffer[7], (uint16_t)firstAge);
+  buffer[9] = first.flags;
+  putU16(&buffer[10], (uint16_t)first.temperatureCenti);
+  putU16(&buffer[12], first.humidityCenti);
+  putU16(&buffer[14], first.lux);
+  putU16(&buffer[16], first.distanceCenti);
+
+  size_t pos = TELEMETRY_BATCH_HEADER_SIZE;
+  for (uint8_t i = 1; i < batch->sampleCount; i++) {
+    const TelemetrySample& prev = batch->samples[i - 1];
+    const TelemetrySample& cur = batch->samples[i];
+    pos += putVarint(&buffer[pos], zigzag16(cur.sequence, prev.sequence) << 4 | (cur.flags & 0x0F));
+    pos += putVarint(&buffer[pos], ageKnown ? zigzag16(ageTenths(prev), ageTenths(cur)) : 0);
+    pos += putVarint(&buffer[pos], zigzag16((uint16_t)cur.temperatureCenti, (uint16_t)prev.temperatureCenti));
+    pos += putVarint(&buffer[pos], zigzag16(cur.humidityCenti, prev.humidityCenti));
+    pos += putVarint(&buffer[pos], zigzag16(cur.lux, prev.lux));
+    pos += putVarint(&buffer[pos], zigzag16(cur.distanceCenti, prev.distanceCenti));
+  }
+
+  // Peers fill whatever room is left
+  size_t room = (limit - pos - 1 - TELEMETRY_CRC_SIZE) / TELEMETRY_PEER_RECORD_SIZE;
+  uint8_t peerCount = batch->peerCount < room ? batch->peerCount : (uint8_t)room;
+  buffer[pos++] = peerCount;
+  for (uint8_t i = 0; i < peerCount; i++) {
+    const TelemetryPeerReading& peer = batch->peers[i];
+    putU16(&buffer[pos], peer.id);
+    buffer[pos + 2] = peer.kind;
+    putU16(&buffer[pos + 3], peer.valueCenti);
+    buffer[pos + 5] = peer.ageSeconds;
+    pos += TELEMETRY_PEER_RECORD_SIZE;
+  }
+  return finishFrame(buffer, pos);
+}
+
+static uint32_t zigzag32(int32_t value) {
+  return ((uint32_t)value << 1) ^ (uint32_t)(value >> 31);
+}
+
+static int32_t unzigzag32(uint32_t value) {
+  return (int32_t)(value >> 1) ^ -(int32_t)(value & 1);
+}
+
+size_t encodeHistoryFrame(const TelemetryHistory* history, uint8_t* buffer, size_t bufferSize,
+                          uint8_t* encodedPoints) {
+  if (encodedPoints) *encodedPoints = 0;
+  if (!history || !buffer || history->pointCount == 0 || history->intervalSeconds == 0 ||
+      history->pointCount > TELEMETRY_MAX_HISTORY_POINTS) {
+    return 0;
+  }
+  size_t limit = bufferSize < TELEMETRY_MAX_FRAME_SIZE ? bufferSize : TELEMETRY_MAX_FRAME_SIZE;
+  if (limit < TELEMETRY_HISTORY_HEADER_SIZE + TELEMETRY_HISTORY_POINT_MAX + TELEMETRY_CRC_SIZE) return 0;
+
+  const TelemetryHistoryPoint& first = history->points[0];
+  uint32_t intervalMs = history->intervalSeconds * 1000UL;
+  buffer[0] = TELEMETRY_FRAME_VERSION;
+  buffer[1] = FRAME_TYPE_HISTORY;
+  putU16(&buffer[2], history->hubId);
+  buffer[4] = history->channel;
+  putU16(&buffer[5], history->intervalSeconds);
+  putU32(&buffer[7], (first.ageMs + 500) / 1000);
+
+  size_t pos = TELEMETRY_HISTORY_HEADER_SIZE;
+  uint8_t count = 0;
+  int32_t previousMean = 0;
+  uint32_t previousAgeMs = first.ageMs;
+  for (; count < history->pointCount; count++) {
+    const TelemetryHistoryPoint& point = history->points[count];
+    uint8_t record[TELEMETRY_HISTORY_POINT_MAX];
+    uint32_t gap = previousAgeMs >= point.ageMs ? (previousAgeMs - point.ageMs + intervalMs / 2) / intervalMs : 0;
+    size_t n = putVarint(record, gap);
+    n += putVarint(&record[n], zigzag32(point.mean - previousMean));
+    n += putVarint(&record[n], (uint32_t)(point.mean - point.min));
+    n += putVarint(&record[n], (uint32_t)(point.max - point.mean));
+    n += putVarint(&record[n], point.count);
+    if (pos + n + TELEMETRY_CRC_SIZE > limit) break;
+
+    memcpy(&buffer[pos], record, n);
+    pos += n;
+    previousMean = point.mean;
+    previousAgeMs = point.ageMs;
+  }
+  buffer[11] = count;
+  if (encodedPoints) *encodedPoints = count;
+  return finishFrame(buffer, pos);
+}
+
+uint8_t telemetryFrameType(const uint8_t* buffer, size_t length) {
+  if (!buffer || length < 2 || buffer[0] != TELEMETRY_FRAME_VERSION) return 0;
+  return buffer[1];
+}
+
+bool decodeSensorFrame(const uint8_t* buffer, size_t length, TelemetryReading* reading) {
+  if (!reading || length < TELEMETRY_SENSOR_FRAME_SIZE) return false;
+  if (!checkFrame(buffer, length, FRAME_TYPE_SENSOR_DATA)) return false;
+  uint8_t peerCount = buffer[15];
+  if (peerCount > TELEMETRY_MAX_PEERS ||
+      length != TELEMETRY_SENSOR_FRAME_SIZE + (size_t)peerCount * TELEMETRY_PEER_RECORD_SIZE) {
+    return false;
+  }
+
+  reading->hubId = getU16(&buffer[2]);
+  reading->sequence = getU16(&buffer[4]);
+  reading->flags = buffer[6];
+  reading->temperatureCenti = (int16_t)getU16(&buffer[7]);
+  reading->humidityCenti = getU16(&buffer[9]);
+  reading->lux = getU16(&buffer[11]);
+  reading->distanceCenti = getU16(&buffer[13]);
+  reading->peerCount = peerCount;
+
+  const uint8_t* record = &buffer[16];
+  for (uint8_t i = 0; i < peerCount; i++) {
+    reading->peers[i].id = getU16(&record[0]);
+    reading->peers[i].kind = record[2];
+    reading->peers[i].valueCenti = getU16(&record[3]);
+    reading->peers[i].ageSeconds = record[5];
+    record += TELEMETRY_PEER_RECORD_SIZE;
+  }
+  return true;
+}
+
+bool decodeHubInfoFrame(const uint8_t* buffer, size_t length, HubInfo* info) {
+  if (!info || !checkFrame(buffer, length, FRAME_TYPE_HUB_INFO)) return false;
+
+  const char* fields[3];
+  size_t pos = TELEMETRY_HEADER_SIZE;
+  size_t end = length - TELEMETRY_CRC_SIZE;
+  for (int i = 0; i < 3; i++) {
+    const void* nul = memchr(&buffer[pos], '\0', end - pos);
+    if (!nul) return false;
+    fields[i] = (const char*)&buffer[pos];
+    pos = (size_t)((const uint8_t*)nul - buffer) + 1;
+  }
+
+  info->hubId = getU16(&buffer[2]);
+  info->name = fields[0];
+  info->sensorNames = fields[1];
+  info->types = fields[2];
+  return true;
+}
+
+bool decodeBatchFrame(const uint8_t* buffer, size_t length, TelemetryBatch* batch) {
+  if (!batch || length < TELEMETRY_BATCH_HEADER_SIZE + 1 + TELEMETRY_CRC_SIZE) return false;
+  if (!checkFrame(buffer, length, FRAME_TYPE_BATCH)) return false;
+  uint8_t count = buffer[4];
+  if (count == 0 || count > TELEMETRY_MAX_BATCH_SAMPLES) return false;
+
+  batch->hubId = getU16(&buffer[2]);
+  batch->sampleCount = count;
+  TelemetrySample& first = batch->samples[0];
+  first.sequence = getU16(&buffer[5]);
+  uint16_t firstAge = getU16(&buffer[7]);
+  bool ageKnown = firstAge != TELEMETRY_AGE_UNKNOWN;
+  first.ageMs = ageKnown ? firstAge * 1000UL : TELEMETRY_AGE_UNKNOWN_MS;
+  first.flags = buffer[9];
+  first.temperatureCenti = (int16_t)getU16(&buffer[10]);
+  first.humidityCenti = getU16(&buffer[12]);
+  first.lux = getU16(&buffer[14]);
+  first.distanceCenti = getU16(&buffer[16]);
+
+  size_t pos = TELEMETRY_BATCH_HEADER_SIZE;
+  size_t end = length - TELEMETRY_CRC_SIZE;
+  int32_t offsetTenths = 0;   // Relative to the first sample
+  for (uint8_t i = 1; i < count; i++) {
+    const TelemetrySample& prev = batch->samples[i - 1];
+    TelemetrySample& cur = batch->samples[i];
+    uint32_t fields[6];
+    for (int f = 0; f < 6; f++) {
+      if (!getVarint(buffer, end, &pos, &fields[f])) return false;
+    }
+    cur.sequence = unzigzag16(prev.sequence, fields[0] >> 4);
+    cur.flags = (uint8_t)(fields[0] & 0x0F);
+    offsetTenths -= (int16_t)unzigzag16(0, fields[1]);
+    if (!ageKnown) {
+      cur.ageMs = TELEMETRY_AGE_UNKNOWN_MS;
+    } else {
+      int32_t age = (int32_t)first.ageMs + offsetTenths * 100;
+      cur.ageMs = age > 0 ? (uint32_t)age : 0;
+    }
+    cur.temperatureCenti = (int16_t)unzigzag16((uint16_t)prev.temperatureCenti, fields[2]);
+    cur.humidityCenti = unzigzag16(prev.humidityCenti, fields[3]);
+    cur.lux = unzigzag16(prev.lux, fields[4]);
+    cur.distanceCenti = unzigzag16(prev.distanceCenti, fields[5]);
+  }
+
+  if (pos >= end) return false;
+  uint8_t peerCount = buffer[pos++];
+  if (peerCount > TELEMETRY_MAX_PEERS || pos + (size_t)peerCount * TELEMETRY_PEER_RECORD_SIZE != end) {
+    return false;
+  }
+  batch->peerCount = peerCount;
+  for (uint8_t i = 0; i < peerCount; i++) {
+    batch->peers[i].id = getU16(&buffer[pos]);
+    batch->peers[i].kind = buffer[pos + 2];
+    batch->peers[i].valueCenti = getU16(&buffer[pos + 3]);
+    batch->peers[i].ageSeconds = buffer[pos + 5];
+    pos += TELEMETRY_PEER_RECORD_SIZE;
+  }
+  return true;
+}
+
+bool decodeHistoryFrame(const uint8_t* buffer, size_t length, TelemetryHistory* history) {
+  if (!history || length < TELEMETRY_HISTORY_HEADER_SIZE + TELEMETRY_CRC_SIZE) return false;
+  if (!checkFrame(buffer, length, FRAME_TYPE_HISTORY)) return false;
+  uint8_t count = buffer[11];
+  uint16_t intervalSeconds = getU16(&buffer[5]);
+  if (count > TELEMETRY_MAX_HISTORY_POINTS || intervalSeconds == 0) return false;
+
+  history->hubId = getU16(&buffer[2]);
+  history->channel = buffer[4];
+  history->intervalSeconds = intervalSeconds;
+  history->pointCount = count;
+
+  size_t pos = TELEMETRY_HISTORY_HEADER_SIZE;
+  size_t end = length - TELEMETRY_CRC_SIZE;
+  uint32_t ageMs = getU32(&buffer[7]) * 1000UL;
+  int32_t mean = 0;
+  for (uint8_t i = 0; i < count; i++) {
+    uint32_t fields[5];
+    for (int f = 0; f < 5; f++) {
+      if (!getVarint(buffer, end, &pos, &fields[f])) return false;
+    }
+    uint32_t back = fields[0] * intervalSeconds * 1000UL;
+    ageMs = ageMs > back ? ageMs - back : 0;
+    mean += unzigzag32(fields[1]);
+
+    TelemetryHistoryPoint& point = history->points[i];
+    point.ageMs = ageMs;
+    point.mean = mean;
+    point.min = mean - (int32_t)fields[2];
+    point.max = mean + (int32_t)fields[3];
+    point.count = (uint16_t)fields[4];
+  }
+  return pos == end;
+}
@@ -0,0 +1,116 @@
+/**
+ * TimerWheel.cpp - Hashed timer wheel for per-channel timers
+ * 
+ * Copyright (C) 2025 Michael Garcia, M&E Design
+ * Based on original .ino by Geoff Mcintyre of Mr.Industries (https://mr.industries/)
+ * 
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ * 
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU General Public License for more details.
+ * 
+ * You should have received a copy of the GNU General Public License
+ * along with this program. If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#include "TimerWheel.h"
+#include <cstring>
+
+#define TIMER_WHEEL_MASK (TIMER_WHEEL_SLOTS - 1)
+
+static_assert((TIMER_WHEEL_SLOTS & TIMER_WHEEL_MASK) == 0, "TIMER_WHEEL_SLOTS must be a power of two");
+
+// Wrap-safe a <= b
+static bool tickReached(uint32_t a, uint32_t b) {
+  return (int32_t)(a - b) <= 0;
+}
+
+void timerWheelInit(TimerWheel* wheel, uint32_t nowTick) {
+  if (!wheel) return;
+  memset(wheel->slots, 0, sizeof(wheel->slots));
+  wheel->tick = nowTick;
+  wheel->armed = 0;
+}
+
+void timerWheelArm(TimerWheel* wheel, WheelTimer* timer, uint32_t expiresTick) {
+  if (!wheel || !timer) return;
+  if (timer->armed) timerWheelCancel(wheel, timer);
+
+  // Ticks already processed would never be visited again
+  if (tickReached(expiresTick, wheel->tick)) expiresTick = wheel->tick;
+
+  WheelTimer** slot = &wheel->slots[expiresTick & TIMER_WHEEL_MASK];
+  timer->expiresTick = expiresTick;
+  timer->next = *slot;
+  timer->armed = true;
+  *slot = timer;
+  wheel->armed++;
+}
+
+void timerWheelCancel(TimerWheel* wheel, WheelTimer* timer) {
+  if (!wheel || !timer || !timer->armed) return;
+
+  WheelTimer** link = &wheel->slots[timer->expiresTick & TIMER_WHEEL_MASK];
+  while (*link && *link != timer) link = &(*link)->next;
+  if (*link) {
+    *link = timer->next;
+    wheel->armed--;
+  }
+  timer->next = NULL;
+  timer->armed = false;
+}
+
+size_t timerWheelAdvance(TimerWheel* wheel, uint32_t nowTick, WheelTimer** expired, size_t maxExpired) {
+  if (!wheel || !expired || !tickReached(wheel->tick, nowTick)) return 0;
+
+  // After a full turn every slot has been seen once, so a long gap costs
+  // no more than TIMER_WHEEL_SLOTS visits
+  uint32_t elapsed = nowTick - wheel->tick + 1;
+  uint32_t visits = elapsed < TIMER_WHEEL_SLOTS ? elapsed : TIMER_WHEEL_SLOTS;
+  size_t count = 0;
+
+  for (uint32_t i = 0; i < visits; i++) {
+    WheelTimer** link = &wheel->slots[(wheel->tick + i) & TIMER_WHEEL_MASK];
+    while (*link) {
+      WheelTimer* timer = *link;
+      if (!tickReached(timer->expiresTick, nowTick)) {
+        link = &timer->next;   // A later turn
+        continue;
+      }
+      if (count == maxExpired) {
+        wheel->tick += i;      // Resume at this slot next time
+        return count;
+      }
+      *link = timer->next;
+      timer->next = NULL;
+      timer->armed = false;
+      wheel->armed--;
+      expired[count++] = timer;
+    }
+  }
+
+  wheel->tick = nowTick + 1;
+  return count;
+}
+
+uint32_t timerWheelNextExpiry(const TimerWheel* wheel) {
+  if (!wheel || wheel->armed == 0) return UINT32_MAX;
+
+  // A timer found k slots ahead is due in k ticks, or in whole turns more;
+  // the first one due this turn is the earliest
+  uint32_t earliest = UINT32_MAX;
+  for (uint32_t k = 0; k < TIMER_WHEEL_SLOTS; k++) {
+    for (const WheelTimer* timer = wheel->slots[(wheel->tick + k) & TIMER_WHEEL_MASK]; timer;
+         timer = timer->next) {
+      uint32_t delay = tickReached(timer->expiresTick, wheel->tick) ? 0 : timer->expiresTick - wheel->tick;
+      if (delay <= k) return delay;
+      if (delay < earliest) earliest = delay;
+    }
+  }
+  return earliest;
+}
@@ -0,0 +1,269 @@
+/**
+ * Tsl2561Driver.cpp - TSL2561 light sensor driver with auto-ranging
+ * 
+ * Copyright (C) 2025 Michael Garcia, M&E Design
+ * Based on original .ino by Geoff Mcintyre of Mr.Industries (https://mr.industries/)
+ * 
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ * 
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU General Public License for more details.
+ * 
+ * You should have received a copy of the GNU General Public License
+ * along with this program. If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#include "Tsl2561Driver.h"
+#include "I2cBus.h"
+#include "Logger.h"
+
+static Adafruit_TSL2561_Unified tsl = Adafruit_TSL2561_Unified(TSL2561_ADDR_FLOAT, 12345);
+static bool tslPresent = false;
+
+struct LightRangeConfig {
+  tsl2561IntegrationTime_t integration;
+  tsl2561Gain_t gain;
+  uint16_t integrationMs;
+  uint16_t clip;                 // Channel count the driver treats as clipped
+  uint32_t sensitivity;          // Counts per 65536 counts at 402 ms / 16x
+};
+
+// Sensitivities follow the driver's channel scales for 13 and 101 ms
+// (0x7517 and 0x0FE7 per 1024) and the 16x gain ratio
+static const LightRangeConfig lightRanges[LIGHT_RANGE_COUNT] = {
+  {TSL2561_INTEGRATIONTIME_13MS,  TSL2561_GAIN_1X,  14,  TSL2561_CLIPPING_13MS,  140},
+  {TSL2561_INTEGRATIONTIME_13MS,  TSL2561_GAIN_16X, 14,  TSL2561_CLIPPING_13MS,  2239},
+  {TSL2561_INTEGRATIONTIME_101MS, TSL2561_GAIN_1X,  101, TSL2561_CLIPPING_101MS, 1030},
+  {TSL2561_INTEGRATIONTIME_101MS, TSL2561_GAIN_16X, 101, TSL2561_CLIPPING_101MS, 16484},
+  {TSL2561_INTEGRATIONTIME_402MS, TSL2561_GAIN_1X,  402, TSL2561_CLIPPING_402MS, 4096},
+  {TSL2561_INTEGRATIONTIME_402MS, TSL2561_GAIN_16X, 402, TSL2561_CLIPPING_402MS, 65536},
+};
+
+#define LIGHT_RANGE_FIXED LIGHT_RANGE_101MS_16X
+
+// Ranging and conversion state belong to SensorTask; the command task only
+// flips the mode and copies the stats. The range survives deep sleep, so a
+// duty-cycled wake (DutyCycle.h) starts where the last one settled.
+static volatile bool lightAutoRange = true;
+RTC_DATA_ATTR static LightRange lightRange = LIGHT_RANGE_FIXED;
+static LightStats lightStats = {};
+
+typedef enum {
+  TSL_IDLE = 0,
+  TSL_INTEGRATING,               // Power-up queued or done
+  TSL_READING                    // Channel reads and power-down queued
+} TslState;
+
+static TslState state = TSL_IDLE;
+static bool autoRangePass = true;      // Mode latched at start()
+static unsigned long conversionStartMs = 0;
+static bool luxValid = false;
+static uint16_t luxValue = 0;
+
+static I2cTransaction powerOn;
+static I2cTransaction readBroadband;
+static I2cTransaction readIr;
+static I2cTransaction powerOff;
+
+static void onTransactionDone(I2cTransaction*) {
+  sensorDriverNotify();
+}
+
+static void setupTransaction(I2cTransaction* transaction, uint8_t command, uint8_t value, uint8_t readLength,
+                             I2cCallback done) {
+  transaction->address = TSL2561_ADDR_FLOAT;
+  transaction->writeData[0] = command;
+  transaction->writeData[1] = value;
+  transaction->writeLength = readLength ? 1 : 2;
+  transaction->readLength = readLength;
+  transaction->done = done;
+}
+
+// The Adafruit setters use Wire directly
+void configureTSL2561() {
+  const LightRangeConfig& config = lightRanges[lightRange];
+  if (!i2cBusLock()) {
+    logWarn("TSL2561 range change skipped - I2C bus busy");
+    return;
+  }
+  tsl.setGain(config.gain);
+  tsl.setIntegrationTime(config.integration);
+  i2cBusUnlock();
+  lightStats.range = lightRange;
+}
+
+// The Adafruit driver keeps its own copy of the range for calculateLux(),
+// so the range is always changed through it
+static void applyLightRange(LightRange range) {
+  if (range == lightRange) return;
+  lightRange = range;
+  configureTSL2561();
+  lightStats.rangeChanges++;
+}
+
+static LightRange selectLightRange(LightRange current, uint16_t broadband) {
+  // The reading scaled to 402 ms / 16x, then predicted for each range from
+  // the fastest integration up, the higher gain first
+  uint64_t full = (uint64_t)broadband * 65536 / lightRanges[current].sensitivity;
+  for (int r = LIGHT_RANGE_13MS_1X; r < LIGHT_RANGE_COUNT; r += 2) {
+    for (int g = 1; g >= 0; g--) {
+      const LightRangeConfig& config = lightRanges[r + g];
+      uint64_t predicted = full * config.sensitivity / 65536;
+      if (predicted >= LIGHT_MIN_COUNTS && predicted <= config.clip / 2u) return (LightRange)(r + g);
+    }
+  }
+  return full < LIGHT_MIN_COUNTS ? LIGHT_RANGE_402MS_16X : LIGHT_RANGE_13MS_1X;
+}
+
+static uint16_t channelCounts(const I2cTransaction& transaction) {
+  return (uint16_t)((transaction.readData[1] << 8) | transaction.readData[0]);
+}
+
+// The integration is timed from the submit; the queue adds well under
+// TSL2561_SETTLE_MS before the power-up reaches the sensor
+static void startConversion() {
+  conversionStartMs = millis();
+  state = i2cSubmit(&powerOn) ? TSL_INTEGRATING : TSL_IDLE;
+}
+
+bool Tsl2561Driver::probe() {
+  // Only the last transaction of each batch wakes the acquisition pass;
+  // the queue runs them in order
+  setupTransaction(&powerOn, TSL2561_COMMAND_BIT | TSL2561_REGISTER_CONTROL, TSL2561_CONTROL_POWERON, 0, NULL);
+  setupTransaction(&readBroadband, TSL2561_COMMAND_BIT | TSL2561_WORD_BIT | TSL2561_REGISTER_CHAN0_LOW, 0, 2, NULL);
+  setupTransaction(&readIr, TSL2561_COMMAND_BIT | TSL2561_WORD_BIT | TSL2561_REGISTER_CHAN1_LOW, 0, 2, NULL);
+  setupTransaction(&powerOff, TSL2561_COMMAND_BIT | TSL2561_REGISTER_CONTROL, TSL2561_CONTROL_POWEROFF, 0,
+                   onTransactionDone);
+  
+  if (i2cBusLock()) {
+    tslPresent = tsl.begin();
+    i2cBusUnlock();
+  }
+  if (!tslPresent) {
+    logWarn("TSL2561 light sensor not detected - readings will be zero");
+    return false;
+  }
+  configureTSL2561();
+  logInfo("TSL2561 light sensor initialized successfully");
+  return true;
+}
+
+void Tsl2561Driver::start(uint8_t channels) {
+  luxValid = false;
+  if (!tslPresent || !(channels & CHANNELS)) return;
+  
+  autoRangePass = lightAutoRange;
+  if (!autoRangePass) applyLightRange(LIGHT_RANGE_FIXED);
+  startConversion();
+}
+
+uint32_t Tsl2561Driver::poll() {
+  if (state == TSL_INTEGRATING) {
+    uint32_t waitMs = lightRanges[lightRange].integrationMs + TSL2561_SETTLE_MS;
+    unsigned long elapsed = millis() - conversionStartMs;
+    if (elapsed < waitMs) return waitMs - elapsed;
+    
+    I2cStatus status = i2cStatus(powerOn);
+    if (status == I2C_PENDING) return SENSOR_POLL_BUS_MS;
+    if (status != I2C_DONE) {
+      state = TSL_IDLE;
+      return SENSOR_POLL_DONE;
+    }
+    
+    // Both channels and the power-down go out back to back
+    i2cSubmit(&readBroadband);
+    i2cSubmit(&readIr);
+    i2cSubmit(&powerOff);
+    state = TSL_READING;
+  }
+  
+  if (state != TSL_READING) return SENSOR_POLL_DONE;
+  if (i2cStatus(readBroadband) == I2C_PENDING || i2cStatus(readIr) == I2C_PENDING ||
+      i2cStatus(powerOff) == I2C_PENDING) {
+    return SENSOR_POLL_BUS_MS;
+  }
+  state = TSL_IDLE;
+  
+  bool ok = i2cStatus(readBroadband) == I2C_DONE && i2cStatus(readIr) == I2C_DONE;
+  uint16_t broadband = channelCounts(readBroadband);
+  uint16_t ir = channelCounts(readIr);
+  
+  lightStats.conversions++;
+  lightStats.integrationMs += lightRanges[lightRange].integrationMs;
+  lightStats.rangeUses[lightRange]++;
+  if (!ok) return SENSOR_POLL_DONE;
+  
+  uint16_t clip = lightRanges[lightRange].clip;
+  if (broadband > clip || ir > clip) {
+    lightStats.saturated++;
+    // Rather than lose the reading, convert again in the least sensitive range
+    if (autoRangePass && lightRange != LIGHT_RANGE_13MS_1X) {
+      lightStats.retries++;
+      applyLightRange(LIGHT_RANGE_13MS_1X);
+      startConversion();
+      return state == TSL_IDLE ? SENSOR_POLL_DONE : lightRanges[lightRange].integrationMs + TSL2561_SETTLE_MS;
+    }
+  }
+  
+  // calculateLux() returns 65536 when a channel is clipped
+  uint32_t lux = tsl.calculateLux(broadband, ir);
+  if (lux > 0 && lux < 100000 && lux != 65536) {
+    luxValue = lux > UINT16_MAX ? UINT16_MAX : (uint16_t)lux;
+    luxValid = true;
+  }
+  if (autoRangePass) applyLightRange(selectLightRange(lightRange, broadband));
+  return SENSOR_POLL_DONE;
+}
+
+void Tsl2561Driver::read(SensorSample* sample) {
+  if (luxValid) setSensorChannelValue(sample, SENSOR_CHANNEL_LUX, luxValue);
+  luxValid = false;
+}
+
+void setLightAutoRange(bool enabled) {
+  lightAutoRange = enabled;
+}
+
+bool getLightAutoRange() {
+  return lightAutoRange;
+}
+
+void getLightStats(LightStats* stats) {
+  if (!stats) return;
+  *stats = lightStats;
+}
+
+void printLightStats() {
+  LightStats stats;
+  getLightStats(&stats);
+  unsigned long meanTenths = stats.conversions ? (unsigned long)((uint64_t)stats.integrationMs * 10 / stats.conversions) : 0;
+  unsigned long saturatedTenths = stats.conversions ? (unsigned long)((uint64_t)stats.saturated * 1000 / stats.conversions) : 0;
+  Serial.printf("Light: %s range, now %s; %lu conversions at %lu.%lu ms mean integration\n",
+                lightAutoRange ? "auto" : "fixed", lightRangeName(stats.range), (unsigned long)stats.conversions,
+                meanTenths / 10, meanTenths % 10);
+  Serial.printf("  saturated %lu (%lu.%lu%%), retried %lu, range changes %lu\n", (unsigned long)stats.saturated,
+                saturatedTenths / 10, saturatedTenths % 10, (unsigned long)stats.retries,
+                (unsigned long)stats.rangeChanges);
+  Serial.print("  uses:");
+  for (int r = 0; r < LIGHT_RANGE_COUNT; r++) {
+    Serial.printf(" %s %lu", lightRangeName((LightRange)r), (unsigned long)stats.rangeUses[r]);
+  }
+  Serial.println();
+}
+
+const char* lightRangeName(LightRange range) {
+  switch (range) {
+    case LIGHT_RANGE_13MS_1X:   return "13ms/1x";
+    case LIGHT_RANGE_13MS_16X:  return "13ms/16x";
+    case LIGHT_RANGE_101MS_1X:  return "101ms/1x";
+    case LIGHT_RANGE_101MS_16X: return "101ms/16x";
+    case LIGHT_RANGE_402MS_1X:  return "402ms/1x";
+    case LIGHT_RANGE_402MS_16X: return "402ms/16x";
+    default:                    return "?";
+  }
+}
@@ -34,22 +34,37 @@
 #include "Tasks.h"
 #include "EventQueue.h"
 #include "Logger.h"
+#include "Backlog.h"
+#include "History.h"
+#include "SampleScheduler.h"
+#include "PowerManager.h"
+#include "DutyCycle.h"
 
 /**
  * System initialization and task creation
  * 
  * Initializes all subsystems in proper order:
- * 1. Global state management
- * 2. Hardware interfaces (sensors, LoRa, ESP-NOW)
- * 3. Configuration management
- * 4. FreeRTOS task creation
+ * 1. Configuration management; a duty-cycled wake stops here
+ * 2. Global state management
+ * 3. Hardware interfaces (sensors, LoRa, ESP-NOW)
+ * 4. Power management
+ * 5. FreeRTOS task creation
  */
 void setup() {
   Serial.begin(115200);
+  
+  // Initialize EEPROM for persistent configuration. In duty-cycled mode a
+  // timer wake only takes a sample and goes back to deep sleep.
+  initializeConfig();
+  if (dutyCycleBoot()) {
+    runDutyCycle();
+  }
+  
   delay(1000);
 
-  // Initialize logging system for structured output and telemetry
-  initLogger(LOG_INFO, SINK_SERIAL);
+  // Initialize logging system for structured output and telemetry; records
+  // are also kept in the flash log ring so they survive a lost uplink
+  initLogger(LOG_INFO, SINK_SERIAL | SINK_STORAGE);
   
   logInfo("ESP32 Multi-Sensor Hub with ESP-NOW + LoRa");
   logInfo("Sensors: Temperature, Humidity, Light, Ultrasonic Distance");
@@ -58,22 +73,36 @@ void setup() {
   // Initialize centralized system state management
   initializeGlobalContext();
   
-  // Initialize FreeRTOS event queue for inter-task communication
-  if (!initEventQueue()) {
-    logCritical("Failed to create event queue - system halted");
+  // Initialize the publish/subscribe event bus for inter-task communication
+  if (!initEventBus()) {
+    logCritical("Failed to create event bus - system halted");
     return;
   }
-  logSystemEvent("EVENT_QUEUE_INIT", "Inter-task communication ready");
+  logSystemEvent("EVENT_BUS_INIT", "Inter-task communication ready");
   
   // Initialize I2C environmental sensors (TSL2561 light, HTU21D-F temp/humidity)
   initializeSensors();
   
-  // Initialize EEPROM for persistent MAC address storage
-  initializeConfig();
+  // Mount the store-and-forward backlog before anything can be transmitted
+  if (initBacklog()) {
+    logInfo("Backlog recovered %u unsent samples", (unsigned)backlogDepth());
+  } else {
+    logWarn("Backlog partition not found - samples buffered in RAM only");
+  }
+  size_t adopted = adoptDutyCycleSamples();
+  if (adopted > 0) {
+    logInfo("Backlog took %u samples from duty-cycled deep sleep", (unsigned)adopted);
+  }
+  if (!initHistory()) {
+    logError("Failed to create history mutex - history disabled");
+  }
+  if (!initSampleScheduler()) {
+    logError("Failed to create sample scheduler - sensors will not be sampled");
+  }
   
   // Initialize LoRa radio module for wireless data transmission
   if (!initializeLoRa()) {
-    logWarn("LoRa initialization failed - sensors will read but no transmission");
+    logWarn("LoRa initialization failed - samples will be buffered until it recovers");
     logInfo("Type 'lora' command to retry LoRa initialization");
   }
 
@@ -86,6 +115,11 @@ void setup() {
   // Perform initial environmental sensor reading
   readEnvironmentalSensors();
   
+  // Scale the clocks and light-sleep whenever every task is blocked
+  if (initPowerManager()) {
+    logSystemEvent("POWER_INIT", powerModeName(getPowerMode()));
+  }
+  
   // Create FreeRTOS tasks for concurrent sensor sampling and communication
   createTasks();
   
@@ -93,12 +127,11 @@ void setup() {
 }
 
 /**
- * Main loop - minimal implementation for FreeRTOS
+ * Main loop - unused under FreeRTOS
  * 
- * All system operations are handled by dedicated FreeRTOS tasks.
- * This loop only provides watchdog functionality.
+ * All system operations are handled by dedicated FreeRTOS tasks. The
+ * Arduino loop task deletes itself so it never wakes the chip.
  */
 void loop() {
-  // Yield to FreeRTOS scheduler - all work done in tasks
-  vTaskDelay(pdMS_TO_TICKS(1000));
+  vTaskDelete(NULL);
 }
\ No newline at end of file
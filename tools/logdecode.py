@@ -0,0 +1,268 @@
+#!/usr/bin/env python3
+#
+# logdecode.py - Decoder for the binary serial log mode
+#
+# Copyright (C) 2025 Michael Garcia, M&E Design
+# Based on original .ino by Geoff Mcintyre of Mr.Industries (https://mr.industries/)
+#
+# This program is free software: you can redistribute it and/or modify
+# it under the terms of the GNU General Public License as published by
+# the Free Software Foundation, either version 3 of the License, or
+# (at your option) any later version.
+#
+# This program is distributed in the hope that it will be useful,
+# but WITHOUT ANY WARRANTY; without even the implied warranty of
+# MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+# GNU General Public License for more details.
+#
+# You should have received a copy of the GNU General Public License
+# along with this program. If not, see <https://www.gnu.org/licenses/>.
+
+"""Turn the hub's binary log frames (see include/LogFrame.h) back into text.
+
+Frames are 0x00-delimited COBS blocks mixed with ordinary text output; text
+is passed through unchanged. Format strings are looked up by their FNV-1a
+id in a dictionary built from the C/C++ string literals in the source tree.
+
+    pio device monitor --raw | tools/logdecode.py
+    tools/logdecode.py /dev/ttyUSB0          # after: stty -F /dev/ttyUSB0 115200 raw
+    .pio/build/native/program | tools/logdecode.py
+"""
+
+import argparse
+import os
+import re
+import struct
+import sys
+
+LOG_FRAME_MAGIC = 0xB1
+LOG_FRAME_TRUNCATED = 0x80
+LEVELS = ["DEBUG", "INFO", "WARN", "ERROR", "CRIT"]
+
+SOURCE_EXTENSIONS = (".c", ".cpp", ".h", ".hpp", ".ino")
+STRING_RUN = re.compile(rb'"(?:[^"\\\n]|\\.)*"(?:\s*"(?:[^"\\\n]|\\.)*")*')
+STRING_PIECE = re.compile(rb'"((?:[^"\\\n]|\\.)*)"')
+CHAR_LITERAL = re.compile(rb"'(?:[^'\\\n]|\\.)+'")
+SPEC = re.compile(r"%([-+ #0]*)(\*|\d+)?(?:\.(\*|\d*))?(hh|h|ll|l|z|j|t|L)?([diouxXcfFeEgGaAsp%])")
+
+ESCAPES = {b"n": b"\n", b"t": b"\t", b"r": b"\r", b"0": b"\0", b"\\": b"\\",
+           b'"': b'"', b"'": b"'", b"a": b"\a", b"b": b"\b", b"f": b"\f", b"v": b"\v", b"?": b"?"}
+
+
+def fnv1a(data):
+    h = 2166136261
+    for byte in data:
+        h = ((h ^ byte) * 16777619) & 0xFFFFFFFF
+    return h
+
+
+def crc16(data):
+    crc = 0xFFFF
+    for byte in data:
+        crc ^= byte << 8
+        for _ in range(8):
+            crc = ((crc << 1) ^ 0x1021) if crc & 0x8000 else (crc << 1)
+            crc &= 0xFFFF
+    return crc
+
+
+def unescape(literal):
+    out = bytearray()
+    i = 0
+    while i < len(literal):
+        c = literal[i:i + 1]
+        if c != b"\\":
+            out += c
+            i += 1
+            continue
+        nxt = literal[i + 1:i + 2]
+        if nxt == b"x":
+            m = re.match(rb"[0-9a-fA-F]+", literal[i + 2:])
+            out.append(int(m.group(0), 16) & 0xFF)
+            i += 2 + len(m.group(0))
+        elif nxt.isdigit():
+            m = re.match(rb"[0-7]{1,3}", literal[i + 1:])
+            out.append(int(m.group(0), 8) & 0xFF)
+            i += 1 + len(m.group(0))
+        else:
+            out += ESCAPES.get(nxt, nxt)
+            i += 2
+    return bytes(out)
+
+
+def build_dictionary(roots):
+    formats = {}
+    for root in roots:
+        for dirpath, _, files in os.walk(root):
+            for name in files:
+                if not name.endswith(SOURCE_EXTENSIONS):
+                    continue
+                with open(os.path.join(dirpath, name), "rb") as f:
+                    source = CHAR_LITERAL.sub(b"''", f.read())
+                for run in STRING_RUN.finditer(source):
+                    text = b"".join(unescape(p) for p in STRING_PIECE.findall(run.group(0)))
+                    formats.setdefault(fnv1a(text), text.decode("utf-8", "replace"))
+    return formats
+
+
+def cobs_decode(block):
+    out = bytearray()
+    i = 0
+    while i < len(block):
+        code = block[i]
+        if code == 0 or i + code > len(block):
+            return None
+        out += block[i + 1:i + code]
+        i += code
+        if code < 0xFF and i < len(block):
+            out.append(0)
+    return bytes(out)
+
+
+class Reader:
+    def __init__(self, data, pos):
+        self.data = data
+        self.pos = pos
+
+    def more(self):
+        return self.pos < len(self.data)
+
+    def varint(self):
+        value = shift = 0
+        while True:
+            byte = self.data[self.pos]
+            self.pos += 1
+            value |= (byte & 0x7F) << shift
+            shift += 7
+            if not byte & 0x80:
+                return value
+
+    def zigzag(self):
+        v = self.varint()
+        return (v >> 1) ^ -(v & 1)
+
+    def float32(self):
+        value = struct.unpack_from("<f", self.data, self.pos)[0]
+        self.pos += 4
+        return value
+
+    def string(self):
+        length = self.varint()
+        value = self.data[self.pos:self.pos + length]
+        self.pos += length
+        return value.decode("utf-8", "replace")
+
+
+def render(fmt, reader):
+    """Mirror of formatRecord() in Logger.cpp."""
+    out = []
+    last = 0
+    for m in SPEC.finditer(fmt):
+        out.append(fmt[last:m.start()])
+        last = m.end()
+        flags, width, precision, _, conv = m.groups()
+        if conv == "%":
+            out.append("%")
+            continue
+        if not reader.more():
+            continue  # Argument was truncated away
+        if width == "*":
+            width = str(reader.zigzag())
+        if precision == "*":
+            precision = str(reader.zigzag())
+        spec = "%" + flags + (width or "") + ("." + precision if precision is not None else "")
+
+        if conv in "di":
+            out.append((spec + "d") % reader.zigzag())
+        elif conv == "c":
+            out.append((spec + "c") % chr(reader.zigzag() & 0xFF))
+        elif conv in "uxXo":
+            out.append((spec + ("d" if conv == "u" else conv)) % reader.varint())
+        elif conv == "p":
+            out.append("0x%x" % reader.varint())
+        elif conv in "aA":
+            out.append(float.hex(reader.float32()))
+        elif conv in "fFeEgG":
+            out.append((spec + conv) % reader.float32())
+        elif conv == "s":
+            out.append((spec + "s") % reader.string())
+    out.append(fmt[last:])
+    return "".join(out)
+
+
+def decode_frame(block, formats):
+    payload = cobs_decode(block)
+    if not payload or len(payload) < 9 or payload[0] != LOG_FRAME_MAGIC:
+        return None
+    body, crc = payload[:-2], struct.unpack("<H", payload[-2:])[0]
+    if crc16(body) != crc:
+        return None
+
+    format_id, level = struct.unpack_from("<IB", body, 1)
+    reader = Reader(body, 6)
+    try:
+        timestamp = reader.varint()
+        fmt = formats.get(format_id)
+        message = render(fmt, reader) if fmt is not None else "<unknown format 0x%08x>" % format_id
+    except (IndexError, struct.error, ValueError, TypeError):
+        return None
+    name = LEVELS[level & 0x7F] if (level & 0x7F) < len(LEVELS) else "ERROR"
+    return "[%d] %s: %s\n" % (timestamp, name, message)
+
+
+def decode_stream(stream, out, formats):
+    """Text passes straight through; 0x00 opens and closes a frame. A block
+    that fails to decode was really text (we joined mid-frame), which puts
+    the decoder back in step with the stream."""
+    in_frame = False
+    block = bytearray()
+    while True:
+        chunk = os.read(stream.fileno(), 4096)
+        if not chunk:
+            break
+        for byte in chunk:
+            if byte == 0:
+                if in_frame:
+                    line = decode_frame(bytes(block), formats)
+                    if line is not None:
+                        out.write(line.encode("utf-8"))
+                        in_frame = False
+                    else:
+                        out.write(bytes(block))
+                    block.clear()
+                else:
+                    in_frame = True
+            elif in_frame:
+                block.append(byte)
+            else:
+                out.write(bytes((byte,)))
+        out.flush()
+
+
+def main():
+    here = os.path.dirname(os.path.abspath(__file__))
+    repo = os.path.dirname(here)
+    parser = argparse.ArgumentParser(description=__doc__.splitlines()[0])
+    parser.add_argument("input", nargs="?", help="serial device or capture file (default: stdin)")
+    parser.add_argument("--source", action="append",
+                        help="source directory to scan for format strings (repeatable; "
+                             "default: src, include and lib of this repository)")
+    parser.add_argument("--dump", action="store_true", help="print the format dictionary and exit")
+    args = parser.parse_args()
+
+    roots = args.source or [os.path.join(repo, d) for d in ("src", "include", "lib")]
+    formats = build_dictionary(roots)
+    if args.dump:
+        for format_id, fmt in sorted(formats.items()):
+            print("%08x %r" % (format_id, fmt))
+        return
+
+    stream = open(args.input, "rb", buffering=0) if args.input else sys.stdin.buffer
+    try:
+        decode_stream(stream, sys.stdout.buffer, formats)
+    except KeyboardInterrupt:
+        pass
+
+
+if __name__ == "__main__":
+    main()